@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "cgmath.h"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cgmath::bench {
+
+// Inputs per benchmark; a power of two so latency chains can wrap with a mask
+constexpr size_t INPUT_COUNT = 1024;
+
+// run(iterations) repeats the measured work `iterations` times, each repetition covering
+// `items` items (values, elements, objects, rays or bytes depending on the benchmark)
+struct benchmark {
+  std::string name;  // "type/operation"
+  std::string mode;  // latency, throughput or batch
+  size_t items;
+  std::function<void(size_t)> run;
+};
+
+std::vector<benchmark>& registry();
+
+inline void add(std::string name, std::string mode, size_t items, std::function<void(size_t)> run) {
+  registry().push_back({std::move(name), std::move(mode), items, std::move(run)});
+}
+
+void register_types();
+void register_batch();
+void register_fast_math();
+void register_codec();
+void register_spatial();
+void register_parallel();
+void register_hierarchy();
+void register_gpu_layout();
+void register_decomposition();
+
+// matrix3x4 products, inverses and conversions against matrix4x4; the SSE point and direction
+// transforms of both and the matrix3x4 determinant against plain expressions
+bool check_matrix3x4();
+
+// vec/mat expressions against element loops and matrix4x4, including assignments that read
+// their own target
+bool check_vec_mat();
+
+// The compile-time scalar functions against double libm rounded to float; static_asserts pin
+// their constant-evaluated results
+bool check_constexpr_math();
+
+// Compares the cgmath::fast functions with libm, prints one line per function and width
+bool check_fast_math_accuracy();
+
+// Round trips through the vertex codecs at every kernel level, batch against scalar
+bool check_codec_accuracy();
+
+// Curve keys at every kernel level against the scalar encoders, round trips, radix_sort and
+// spatial_hash queries against brute force
+bool check_spatial();
+
+// parallel_for coverage and cache-line chunking, deterministic parallel_reduce, on real threads
+bool check_parallel();
+
+// Incremental transform hierarchy updates against full ones and parent-chain composition
+bool check_hierarchy();
+
+// Staging buffer layouts of every type, layout and order against an element-by-element loop
+bool check_gpu_layout();
+
+// to_chars of float and double types and write_text parsed back bit for bit, length bounds
+// and buffers too small for the text
+bool check_format();
+
+// BVH closest and any hits, built and refitted, against testing every triangle in double
+bool check_bvh();
+
+// Frustum sphere and box tests against the clip volume of their matrix in double, and the
+// batch classification, index lists and view masks at every kernel level against those tests
+bool check_frustum();
+
+// Linear-blend and dual-quaternion skinning against double precision, against each other where
+// they must agree, and threaded against serial
+bool check_skinning();
+
+// slerp, log and exp against double precision, and the batch matrix conversions and nlerp at
+// every kernel level against the members
+bool check_quaternions();
+
+// SoA conversions and kernels at every kernel level against the float3 and float4 members,
+// with zero-length and aliased elements
+bool check_soa();
+
+// Batch point, direction and vector transforms at every kernel level against the per-element
+// member functions
+bool check_transforms();
+
+// pack_writer/pack_file round trip, view type checks, checksums and rejection of truncated
+// or damaged files
+bool check_pack();
+
+// Bulk half conversions and relative_to_camera at every kernel level against the per-element
+// conversions, bit for bit
+bool check_precision();
+
+// The SoA, transform, quaternion and frustum batch functions at every kernel level against the
+// scalar level
+bool check_batch_kernels();
+
+// Packet triangle, slab and BVH queries at every kernel level against the scalar lanes, and
+// those against single rays
+bool check_ray_packets();
+
+// Eigen, SVD and polar factors of random and degenerate matrices at every kernel level
+bool check_decomposition();
+
+// Forces v to be materialized without generating any code for it
+template <typename T>
+inline void do_not_optimize(const T& v) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(v) : "memory");
+#else
+  static const void* volatile sink;
+  sink = &v;
+#endif
+}
+
+// Always zero, but the compiler cannot prove it. Latency chains fold their results into the
+// next input index through it, so each operation has to wait for the previous one.
+extern volatile uint32_t opaque_zero;
+
+template <typename R>
+inline uint32_t fold_bits(const R& r) noexcept {
+  uint32_t bits = 0;
+  if constexpr (sizeof(R) >= sizeof(bits)) {
+    std::memcpy(&bits, &r, sizeof(bits));
+  } else {
+    std::memcpy(&bits, &r, sizeof(R));
+  }
+  return bits;
+}
+
+// Deterministic inputs, so that runs compared against a baseline see the same data
+std::mt19937& rng();
+float uniform(float lo, float hi);
+
+inline void randomize(float& v) { v = uniform(-1.0f, 1.0f); }
+inline void randomize(int32_t& v) { v = static_cast<int32_t>(uniform(1.0f, 1000.0f)); }
+inline void randomize(uint32_t& v) { v = static_cast<uint32_t>(uniform(1.0f, 1000.0f)); }
+inline void randomize(float2& v) { v = {uniform(-1, 1), uniform(-1, 1)}; }
+inline void randomize(float3& v) { v = {uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)}; }
+inline void randomize(float4& v) { v = {uniform(-1, 1), uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)}; }
+inline void randomize(int2& v) { randomize(v.x); randomize(v.y); }
+inline void randomize(int3& v) { randomize(v.x); randomize(v.y); randomize(v.z); }
+inline void randomize(int4& v) { randomize(v.x); randomize(v.y); randomize(v.z); randomize(v.w); }
+inline void randomize(uint2& v) { randomize(v.x); randomize(v.y); }
+inline void randomize(uint3& v) { randomize(v.x); randomize(v.y); randomize(v.z); }
+inline void randomize(uint4& v) { randomize(v.x); randomize(v.y); randomize(v.z); randomize(v.w); }
+inline void randomize(vector2& v) { v = vector2(uniform(-1, 1), uniform(-1, 1)); }
+inline void randomize(vector3& v) { v = vector3(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)); }
+inline void randomize(vector4& v) { v = vector4(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)); }
+
+inline void randomize(quaternion& q) {
+  q = quaternion(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1), uniform(0.1f, 1)).normalized();
+}
+
+inline void randomize(dual_quaternion& d) {
+  quaternion r;
+  float3 t;
+  randomize(r);
+  randomize(t);
+  d = dual_quaternion::from_rotation_translation(r, t);
+}
+
+// Diagonally dominant, so determinants and inverses stay well conditioned
+template <typename M>
+inline void randomize_matrix(M& m) {
+  constexpr size_t rows = sizeof(m.m) / sizeof(m.m[0]);
+  constexpr size_t cols = sizeof(m.m[0]) / sizeof(float);
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t c = 0; c < cols; ++c) m.m[r][c] = uniform(-1, 1) + (r == c ? 4.0f : 0.0f);
+  }
+}
+
+inline void randomize(matrix3x3& m) { randomize_matrix(m); }
+inline void randomize(matrix3x4& m) { randomize_matrix(m); }
+inline void randomize(matrix4x3& m) { randomize_matrix(m); }
+inline void randomize(matrix4x4& m) { randomize_matrix(m); }
+
+template <typename T, size_t N>
+inline void randomize(vec<T, N>& v) {
+  for (T& x : v.v) randomize(x);
+}
+
+template <size_t R, size_t C>
+inline void randomize(mat<float, R, C>& m) {
+  for (size_t i = 0; i < R * C; ++i) m.e[i] = uniform(-1, 1) + (i / C == i % C ? 4.0f : 0.0f);
+}
+
+template <typename T>
+std::vector<T> random_values(size_t n) {
+  std::vector<T> v(n);
+  for (T& x : v) randomize(x);
+  return v;
+}
+
+// Registers `name` as a dependent chain (latency) and as independent ops over
+// INPUT_COUNT elements (throughput)
+template <typename A, typename Op>
+void unary(const std::string& name, Op op) {
+  using R = std::decay_t<decltype(op(std::declval<const A&>()))>;
+  std::vector<A> a = random_values<A>(INPUT_COUNT);
+
+  add(name, "latency", 1, [a, op](size_t iterations) {
+    const uint32_t mask = opaque_zero;
+    uint32_t index = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+      R r = op(a[index]);
+      index = (index + 1 + (fold_bits(r) & mask)) & (INPUT_COUNT - 1);
+    }
+    do_not_optimize(index);
+  });
+
+  std::vector<R> out(INPUT_COUNT);
+  add(name, "throughput", INPUT_COUNT, [a, op, out](size_t iterations) mutable {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < INPUT_COUNT; ++j) out[j] = op(a[j]);
+      do_not_optimize(out.data());
+    }
+  });
+}
+
+template <typename A, typename B, typename Op>
+void binary(const std::string& name, Op op) {
+  using R = std::decay_t<decltype(op(std::declval<const A&>(), std::declval<const B&>()))>;
+  std::vector<A> a = random_values<A>(INPUT_COUNT);
+  std::vector<B> b = random_values<B>(INPUT_COUNT);
+
+  add(name, "latency", 1, [a, b, op](size_t iterations) {
+    const uint32_t mask = opaque_zero;
+    uint32_t index = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+      R r = op(a[index], b[index]);
+      index = (index + 1 + (fold_bits(r) & mask)) & (INPUT_COUNT - 1);
+    }
+    do_not_optimize(index);
+  });
+
+  std::vector<R> out(INPUT_COUNT);
+  add(name, "throughput", INPUT_COUNT, [a, b, op, out](size_t iterations) mutable {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < INPUT_COUNT; ++j) out[j] = op(a[j], b[j]);
+      do_not_optimize(out.data());
+    }
+  });
+}
+
+} // namespace cgmath::bench
@@ -0,0 +1,1953 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <string>
+
+// Array kernels of the batch modules. Items are elements, objects, rays or bytes as noted;
+// the *_naive entries run the per-element member functions in a plain loop for comparison.
+// The --accuracy part checks the batch functions against per-element, double precision or
+// brute force references, and every kernel level against the scalar one.
+
+namespace cgmath::bench {
+
+namespace {
+
+constexpr size_t ELEMENT_COUNT = 16384;
+constexpr size_t OBJECT_COUNT = 65536;
+constexpr size_t BONE_COUNT = 64;
+constexpr size_t GRID_SIZE = 128;  // terrain cells per side, two triangles each
+constexpr size_t RAY_COUNT = 4096;
+
+float3_soa to_soa(const std::vector<float3>& v) {
+  float3_soa s(v.size());
+  aos_to_soa(v.data(), v.size(), s);
+  return s;
+}
+
+void register_soa() {
+  struct data {
+    std::vector<float3> aos = random_values<float3>(ELEMENT_COUNT);
+    std::vector<float3> aos_out = std::vector<float3>(ELEMENT_COUNT);
+    std::vector<vector3> vectors = random_values<vector3>(ELEMENT_COUNT);
+    std::vector<vector3> vectors_out = std::vector<vector3>(ELEMENT_COUNT);
+    float3_soa a = to_soa(random_values<float3>(ELEMENT_COUNT));
+    float3_soa b = to_soa(random_values<float3>(ELEMENT_COUNT));
+    float3_soa out = float3_soa(ELEMENT_COUNT);
+    float4_soa a4 = float4_soa(ELEMENT_COUNT);
+    float4_soa out4 = float4_soa(ELEMENT_COUNT);
+    std::vector<float> scalars = std::vector<float>(ELEMENT_COUNT);
+  };
+  auto d = std::make_shared<data>();
+  std::vector<float4> v4 = random_values<float4>(ELEMENT_COUNT);
+  aos_to_soa(v4.data(), v4.size(), d->a4);
+
+  auto batch = [](const char* name, std::function<void()> body) {
+    add(name, "batch", ELEMENT_COUNT, [body](size_t iterations) {
+      for (size_t i = 0; i < iterations; ++i) body();
+    });
+  };
+
+  batch("soa/aos_to_soa_float3", [d] { aos_to_soa(d->aos.data(), ELEMENT_COUNT, d->out); do_not_optimize(d->out.x[0]); });
+  batch("soa/soa_to_aos_float3", [d] { soa_to_aos(d->a, d->aos_out.data()); do_not_optimize(d->aos_out[0]); });
+  batch("soa/dot3", [d] { dot(d->a, d->b, d->scalars.data()); do_not_optimize(d->scalars[0]); });
+  batch("soa/dot3_naive", [d] {
+    for (size_t i = 0; i < ELEMENT_COUNT; ++i) d->scalars[i] = d->vectors[i].dot(d->vectors[ELEMENT_COUNT - 1 - i]);
+    do_not_optimize(d->scalars[0]);
+  });
+  batch("soa/cross3", [d] { cross(d->a, d->b, d->out); do_not_optimize(d->out.x[0]); });
+  batch("soa/length3", [d] { length(d->a, d->scalars.data()); do_not_optimize(d->scalars[0]); });
+  batch("soa/normalize3", [d] { normalize(d->a, d->out); do_not_optimize(d->out.x[0]); });
+  batch("soa/normalize3_naive", [d] {
+    for (size_t i = 0; i < ELEMENT_COUNT; ++i) d->vectors_out[i] = d->vectors[i].normalized();
+    do_not_optimize(d->vectors_out[0]);
+  });
+  batch("soa/normalize4", [d] { normalize(d->a4, d->out4); do_not_optimize(d->out4.x[0]); });
+  batch("soa/lerp3", [d] { lerp(d->a, d->b, 0.3f, d->out); do_not_optimize(d->out.x[0]); });
+  batch("soa/clamp3", [d] {
+    clamp(d->a, float3(-0.5f, -0.5f, -0.5f), float3(0.5f, 0.5f, 0.5f), d->out);
+    do_not_optimize(d->out.x[0]);
+  });
+
+  std::vector<matrix4x4> m = random_values<matrix4x4>(1);
+  const matrix4x4 xf = m[0];
+  batch("transform/points_aos", [d, xf] {
+    transform_points(xf, d->aos.data(), d->aos_out.data(), ELEMENT_COUNT);
+    do_not_optimize(d->aos_out[0]);
+  });
+  batch("transform/points_aos_non_temporal", [d, xf] {
+    transform_points(xf, d->aos.data(), d->aos_out.data(), ELEMENT_COUNT, store_mode::non_temporal);
+    do_not_optimize(d->aos_out[0]);
+  });
+  batch("transform/points_naive", [d, xf] {
+    for (size_t i = 0; i < ELEMENT_COUNT; ++i) d->aos_out[i] = xf.transform_point(d->aos[i]);
+    do_not_optimize(d->aos_out[0]);
+  });
+  batch("transform/points_soa", [d, xf] { transform_points(xf, d->a, d->out); do_not_optimize(d->out.x[0]); });
+  batch("transform/directions_aos", [d, xf] {
+    transform_directions(xf, d->aos.data(), d->aos_out.data(), ELEMENT_COUNT);
+    do_not_optimize(d->aos_out[0]);
+  });
+  batch("transform/directions_soa", [d, xf] { transform_directions(xf, d->a, d->out); do_not_optimize(d->out.x[0]); });
+
+  auto v = std::make_shared<std::vector<vector4>>(random_values<vector4>(ELEMENT_COUNT));
+  auto v_out = std::make_shared<std::vector<vector4>>(ELEMENT_COUNT);
+  batch("transform/vectors", [v, v_out, xf] {
+    transform_vectors(xf, v->data(), v_out->data(), ELEMENT_COUNT);
+    do_not_optimize((*v_out)[0]);
+  });
+  batch("transform/vectors_naive", [v, v_out, xf] {
+    for (size_t i = 0; i < ELEMENT_COUNT; ++i) (*v_out)[i] = xf * (*v)[i];
+    do_not_optimize((*v_out)[0]);
+  });
+}
+
+void register_quaternion_batch() {
+  struct data {
+    std::vector<quaternion> a = random_values<quaternion>(ELEMENT_COUNT);
+    std::vector<quaternion> b = random_values<quaternion>(ELEMENT_COUNT);
+    std::vector<quaternion> out = std::vector<quaternion>(ELEMENT_COUNT);
+    std::vector<float3> translations = random_values<float3>(ELEMENT_COUNT);
+    std::vector<matrix3x4> m34 = std::vector<matrix3x4>(ELEMENT_COUNT);
+    std::vector<matrix4x4> m44 = std::vector<matrix4x4>(ELEMENT_COUNT);
+  };
+  auto d = std::make_shared<data>();
+
+  add("quaternion/batch_to_matrix3x4", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      to_matrix3x4(d->a.data(), d->translations.data(), d->m34.data(), ELEMENT_COUNT);
+      do_not_optimize(d->m34[0]);
+    }
+  });
+  add("quaternion/batch_to_matrix3x4_naive", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) d->m34[j] = d->a[j].to_matrix3x4(d->translations[j]);
+      do_not_optimize(d->m34[0]);
+    }
+  });
+  add("quaternion/batch_to_matrix4x4", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      to_matrix4x4(d->a.data(), d->translations.data(), d->m44.data(), ELEMENT_COUNT);
+      do_not_optimize(d->m44[0]);
+    }
+  });
+  add("quaternion/batch_nlerp", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      nlerp(d->a.data(), d->b.data(), 0.3f, d->out.data(), ELEMENT_COUNT);
+      do_not_optimize(d->out[0]);
+    }
+  });
+  add("quaternion/batch_nlerp_naive", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) d->out[j] = nlerp(d->a[j], d->b[j], 0.3f);
+      do_not_optimize(d->out[0]);
+    }
+  });
+}
+
+void register_precision() {
+  struct data {
+    std::vector<float3> normals = random_values<float3>(ELEMENT_COUNT);
+    std::vector<float3> normals_out = std::vector<float3>(ELEMENT_COUNT);
+    std::vector<half3> halves = std::vector<half3>(ELEMENT_COUNT);
+    std::vector<double3> positions = std::vector<double3>(ELEMENT_COUNT);
+    std::vector<float3> relative = std::vector<float3>(ELEMENT_COUNT);
+    double3 camera = double3(6371000.0, 1250.5, -20000.25);
+  };
+  auto d = std::make_shared<data>();
+  for (size_t i = 0; i < ELEMENT_COUNT; ++i) d->positions[i] = d->camera + double3(d->normals[i]) * 5000.0;
+
+  add("half/to_half3", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      to_half(d->normals.data(), d->halves.data(), ELEMENT_COUNT);
+      do_not_optimize(d->halves[0]);
+    }
+  });
+  add("half/to_half3_naive", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) d->halves[j] = half3(d->normals[j]);
+      do_not_optimize(d->halves[0]);
+    }
+  });
+  add("half/to_float3", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      to_float(d->halves.data(), d->normals_out.data(), ELEMENT_COUNT);
+      do_not_optimize(d->normals_out[0]);
+    }
+  });
+  add("half/to_float3_naive", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) d->normals_out[j] = d->halves[j].to_float3();
+      do_not_optimize(d->normals_out[0]);
+    }
+  });
+  add("double3/relative_to_camera", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      relative_to_camera(d->positions.data(), d->camera, d->relative.data(), ELEMENT_COUNT);
+      do_not_optimize(d->relative[0]);
+    }
+  });
+  add("double3/relative_to_camera_naive", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) d->relative[j] = (d->positions[j] - d->camera).to_float3();
+      do_not_optimize(d->relative[0]);
+    }
+  });
+  add("double3/relative_to_camera_half3", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      relative_to_camera(d->positions.data(), d->camera, d->halves.data(), ELEMENT_COUNT);
+      do_not_optimize(d->halves[0]);
+    }
+  });
+}
+
+void register_skinning() {
+  struct data {
+    float3_soa positions = to_soa(random_values<float3>(ELEMENT_COUNT));
+    float3_soa normals = float3_soa(ELEMENT_COUNT);
+    float3_soa out_positions = float3_soa(ELEMENT_COUNT);
+    float3_soa out_normals = float3_soa(ELEMENT_COUNT);
+    std::vector<uint16_t> joints = std::vector<uint16_t>(ELEMENT_COUNT * SKIN_MAX_INFLUENCES);
+    std::vector<float> weights = std::vector<float>(ELEMENT_COUNT * SKIN_MAX_INFLUENCES);
+    std::vector<matrix3x4> palette = std::vector<matrix3x4>(BONE_COUNT);
+    std::vector<dual_quaternion> dq_palette = std::vector<dual_quaternion>(BONE_COUNT);
+  };
+  auto d = std::make_shared<data>();
+  std::vector<float3> n = random_values<float3>(ELEMENT_COUNT);
+  for (float3& v : n) v = v.normalized();
+  aos_to_soa(n.data(), n.size(), d->normals);
+  for (size_t i = 0; i < ELEMENT_COUNT * SKIN_MAX_INFLUENCES; ++i) {
+    d->joints[i] = static_cast<uint16_t>(rng()() % BONE_COUNT);
+    d->weights[i] = 1.0f / SKIN_MAX_INFLUENCES;
+  }
+  for (size_t i = 0; i < BONE_COUNT; ++i) {
+    quaternion q;
+    float3 t;
+    randomize(q);
+    randomize(t);
+    d->palette[i] = q.to_matrix3x4(t);
+  }
+  to_dual_quaternions(d->palette.data(), d->dq_palette.data(), BONE_COUNT);
+
+  auto input = [d] { return skin_input{d->positions, d->normals, d->joints.data(), d->weights.data()}; };
+  auto output = [d] { return skin_output{d->out_positions, d->out_normals}; };
+
+  add("skinning/linear", "batch", ELEMENT_COUNT, [d, input, output](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      skin_linear(input(), d->palette.data(), output());
+      do_not_optimize(d->out_positions.x[0]);
+    }
+  });
+  add("skinning/dual_quaternion", "batch", ELEMENT_COUNT, [d, input, output](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      skin_dual_quaternion(input(), d->dq_palette.data(), output());
+      do_not_optimize(d->out_positions.x[0]);
+    }
+  });
+  add("skinning/to_dual_quaternions", "batch", BONE_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      to_dual_quaternions(d->palette.data(), d->dq_palette.data(), BONE_COUNT);
+      do_not_optimize(d->dq_palette[0]);
+    }
+  });
+}
+
+void register_frustum() {
+  struct data {
+    frustum views[4];
+    std::vector<float4> spheres_aos = std::vector<float4>(OBJECT_COUNT);
+    float4_soa spheres = float4_soa(OBJECT_COUNT);
+    float3_soa centers = float3_soa(OBJECT_COUNT);
+    float3_soa extents = float3_soa(OBJECT_COUNT);
+    std::vector<uint32_t> visible = std::vector<uint32_t>(OBJECT_COUNT);
+    std::vector<cull_result> classes = std::vector<cull_result>(OBJECT_COUNT);
+    std::vector<uint64_t> masks = std::vector<uint64_t>(4 * cull_mask_words(OBJECT_COUNT));
+  };
+  auto d = std::make_shared<data>();
+  for (size_t v = 0; v < 4; ++v) {
+    d->views[v] = frustum::from_matrix(matrix4x4::perspective(1.0f + 0.1f * v, 16.0f / 9.0f, 0.1f, 50.0f + 50.0f * v));
+  }
+  // A cube of objects around the camera, roughly a fifth of them in view
+  for (size_t i = 0; i < OBJECT_COUNT; ++i) {
+    float4 s(uniform(-100, 100), uniform(-100, 100), uniform(-100, 100), uniform(0.5f, 3));
+    d->spheres_aos[i] = s;
+    d->spheres.set(i, s);
+    d->centers.set(i, float3(s.x, s.y, s.z));
+    d->extents.set(i, float3(s.w, s.w * 0.5f, s.w));
+  }
+
+  add("frustum/cull_spheres", "batch", OBJECT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) do_not_optimize(cull_spheres(d->views[0], d->spheres, d->visible.data()));
+  });
+  add("frustum/cull_spheres_naive", "batch", OBJECT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      size_t count = 0;
+      for (size_t j = 0; j < OBJECT_COUNT; ++j) {
+        const float4& s = d->spheres_aos[j];
+        if (d->views[0].test_sphere(float3(s.x, s.y, s.z), s.w) != cull_result::outside) {
+          d->visible[count++] = static_cast<uint32_t>(j);
+        }
+      }
+      do_not_optimize(count);
+    }
+  });
+  add("frustum/cull_aabbs", "batch", OBJECT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      do_not_optimize(cull_aabbs(d->views[0], d->centers, d->extents, d->visible.data()));
+    }
+  });
+  add("frustum/cull_aabbs_naive", "batch", OBJECT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      size_t count = 0;
+      for (size_t j = 0; j < OBJECT_COUNT; ++j) {
+        if (d->views[0].test_aabb(d->centers.get(j), d->extents.get(j)) != cull_result::outside) {
+          d->visible[count++] = static_cast<uint32_t>(j);
+        }
+      }
+      do_not_optimize(count);
+    }
+  });
+  add("frustum/classify_spheres", "batch", OBJECT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      classify_spheres(d->views[0], d->spheres, d->classes.data());
+      do_not_optimize(d->classes[0]);
+    }
+  });
+  add("frustum/classify_aabbs", "batch", OBJECT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      classify_aabbs(d->views[0], d->centers, d->extents, d->classes.data());
+      do_not_optimize(d->classes[0]);
+    }
+  });
+  add("frustum/cull_spheres_4_views", "batch", OBJECT_COUNT, [d](size_t iterations) {
+    const size_t words = cull_mask_words(OBJECT_COUNT);
+    uint64_t* masks[4] = {d->masks.data(), d->masks.data() + words, d->masks.data() + 2 * words,
+                          d->masks.data() + 3 * words};
+    for (size_t i = 0; i < iterations; ++i) {
+      cull_spheres(d->views, 4, d->spheres, masks);
+      do_not_optimize(d->masks[0]);
+    }
+  });
+}
+
+void register_bvh() {
+  struct data {
+    std::vector<float3> vertices;
+    std::vector<uint32_t> indices;
+    bvh tree;
+    std::vector<ray> rays;
+    std::vector<ray8> packets8;
+    std::vector<ray16> packets16;
+    std::vector<uint32_t> order;
+  };
+  auto d = std::make_shared<data>();
+
+  // Rolling heightfield, rays cast down onto it in scanline order so that neighbouring rays
+  // and packets stay coherent
+  for (size_t z = 0; z <= GRID_SIZE; ++z) {
+    for (size_t x = 0; x <= GRID_SIZE; ++x) {
+      float h = 4.0f * std::sin(x * 0.15f) * std::cos(z * 0.11f) + uniform(-0.2f, 0.2f);
+      d->vertices.push_back(float3(float(x), h, float(z)));
+    }
+  }
+  for (uint32_t z = 0; z < GRID_SIZE; ++z) {
+    for (uint32_t x = 0; x < GRID_SIZE; ++x) {
+      uint32_t i = z * (GRID_SIZE + 1) + x;
+      uint32_t quad[6] = {i, i + 1, i + uint32_t(GRID_SIZE) + 1, i + 1, i + uint32_t(GRID_SIZE) + 2,
+                          i + uint32_t(GRID_SIZE) + 1};
+      d->indices.insert(d->indices.end(), quad, quad + 6);
+    }
+  }
+  const size_t triangle_count = d->indices.size() / 3;
+  d->tree.build(d->vertices.data(), d->indices.data(), triangle_count, 1);
+
+  for (size_t i = 0; i < RAY_COUNT; ++i) {
+    float x = (i % 64) * 2.0f + uniform(0, 0.5f);
+    float z = (i / 64) * 2.0f + uniform(0, 0.5f);
+    float3 dir = float3(uniform(-0.2f, 0.2f), -1.0f, uniform(-0.2f, 0.2f)).normalized();
+    d->rays.push_back(ray{float3(x, 20.0f, z), dir});
+  }
+  for (size_t i = 0; i < RAY_COUNT; i += 8) d->packets8.push_back(ray8::from_rays(d->rays.data() + i, 8));
+  for (size_t i = 0; i < RAY_COUNT; i += 16) d->packets16.push_back(ray16::from_rays(d->rays.data() + i, 16));
+  d->order.resize(RAY_COUNT);
+
+  add("bvh/build", "batch", triangle_count, [d, triangle_count](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      bvh tree;
+      tree.build(d->vertices.data(), d->indices.data(), triangle_count, 1);
+      do_not_optimize(tree.nodes[0]);
+    }
+  });
+  add("bvh/refit", "batch", triangle_count, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      d->tree.refit(d->vertices.data(), d->indices.data());
+      do_not_optimize(d->tree.nodes[0]);
+    }
+  });
+  add("bvh/intersect", "batch", RAY_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      uint32_t hits = 0;
+      for (const ray& r : d->rays) {
+        ray_hit hit;
+        hits += d->tree.intersect(r, hit);
+      }
+      do_not_optimize(hits);
+    }
+  });
+  add("bvh/occluded", "batch", RAY_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      uint32_t hits = 0;
+      for (const ray& r : d->rays) hits += d->tree.occluded(r);
+      do_not_optimize(hits);
+    }
+  });
+  // Packets are copied per query since intersect shortens t_max
+  add("bvh/intersect_ray8", "batch", RAY_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      uint32_t hits = 0;
+      for (const ray8& p : d->packets8) {
+        ray8 r = p;
+        hit8 hit;
+        hits += intersect(d->tree, r, hit);
+      }
+      do_not_optimize(hits);
+    }
+  });
+  add("bvh/intersect_ray16", "batch", RAY_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      uint32_t hits = 0;
+      for (const ray16& p : d->packets16) {
+        ray16 r = p;
+        hit16 hit;
+        hits += intersect(d->tree, r, hit);
+      }
+      do_not_optimize(hits);
+    }
+  });
+  add("bvh/occluded_ray8", "batch", RAY_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      uint32_t hits = 0;
+      for (const ray8& p : d->packets8) hits += occluded(d->tree, p);
+      do_not_optimize(hits);
+    }
+  });
+  add("bvh/sort_rays", "batch", RAY_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      sort_rays(d->rays.data(), RAY_COUNT, d->order.data());
+      do_not_optimize(d->order[0]);
+    }
+  });
+}
+
+void register_text() {
+  auto values = std::make_shared<std::vector<float3>>(random_values<float3>(ELEMENT_COUNT));
+  auto matrices = std::make_shared<std::vector<matrix4x4>>(random_values<matrix4x4>(INPUT_COUNT));
+  auto text = std::make_shared<std::string>();
+
+  add("format/to_chars_float3", "batch", ELEMENT_COUNT, [values](size_t iterations) {
+    char buffer[64];
+    for (size_t i = 0; i < iterations; ++i) {
+      for (const float3& v : *values) do_not_optimize(v.to_chars(buffer, buffer + sizeof(buffer)).ptr);
+    }
+  });
+  add("format/snprintf_float3_naive", "batch", ELEMENT_COUNT, [values](size_t iterations) {
+    char buffer[64];
+    for (size_t i = 0; i < iterations; ++i) {
+      for (const float3& v : *values) {
+        do_not_optimize(std::snprintf(buffer, sizeof(buffer), "float3(%.9g, %.9g, %.9g)", v.x, v.y, v.z));
+      }
+    }
+  });
+  add("format/to_chars_matrix4x4", "batch", INPUT_COUNT, [matrices](size_t iterations) {
+    char buffer[TO_STRING_BUFFER_SIZE];
+    for (size_t i = 0; i < iterations; ++i) {
+      for (const matrix4x4& m : *matrices) do_not_optimize(m.to_chars(buffer, buffer + sizeof(buffer)).ptr);
+    }
+  });
+  add("format/write_text_csv", "batch", ELEMENT_COUNT, [values, text](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      text->clear();
+      write_text(*text, values->data(), ELEMENT_COUNT, text_format::csv);
+      do_not_optimize(text->data());
+    }
+  });
+  add("format/write_text_json", "batch", ELEMENT_COUNT, [values, text](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      text->clear();
+      write_text(*text, values->data(), ELEMENT_COUNT, text_format::json);
+      do_not_optimize(text->data());
+    }
+  });
+
+  // Bytes per second of the checksum pack_file::verify runs
+  auto bytes = std::make_shared<std::vector<float>>(random_values<float>(1 << 18));
+  add("pack/checksum", "batch", bytes->size() * sizeof(float), [bytes](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) do_not_optimize(pack_checksum(bytes->data(), bytes->size() * sizeof(float)));
+  });
+}
+
+} // namespace
+
+void register_batch() {
+  register_soa();
+  register_quaternion_batch();
+  register_precision();
+  register_skinning();
+  register_frustum();
+  register_bvh();
+  register_text();
+}
+
+namespace {
+
+// Every lane of a packet query: the hit mask, then t and primitive of the lanes that hit
+template <size_t N>
+struct packet_record {
+  std::vector<uint32_t> masks;
+  std::vector<float> t;
+  std::vector<uint32_t> primitives;
+
+  void add(uint32_t mask, const packet_hit<N>& hit) {
+    masks.push_back(mask);
+    for (size_t k = 0; k < N; ++k) {
+      t.push_back((mask >> k) & 1 ? hit.t[k] : 0.0f);
+      primitives.push_back((mask >> k) & 1 ? hit.primitive[k] : 0u);
+    }
+  }
+
+  void add(uint32_t mask, const float* t_enter) {
+    masks.push_back(mask);
+    for (size_t k = 0; k < N; ++k) t.push_back((mask >> k) & 1 ? t_enter[k] : 0.0f);
+  }
+
+  // Masks and primitives exactly, distances to 1e-5 of their size
+  size_t failures(const packet_record& reference) const {
+    size_t f = masks.size() != reference.masks.size() || t.size() != reference.t.size() ||
+               primitives != reference.primitives;
+    for (size_t i = 0; i < std::min(masks.size(), reference.masks.size()); ++i) f += masks[i] != reference.masks[i];
+    for (size_t i = 0; i < std::min(t.size(), reference.t.size()); ++i) {
+      const float tolerance = 1e-5f * std::fmax(1.0f, std::fabs(reference.t[i]));
+      f += t[i] != reference.t[i] && !(std::fabs(t[i] - reference.t[i]) <= tolerance);
+    }
+    return f;
+  }
+};
+
+// Triangle, slab, closest hit and any hit queries of every packet
+template <size_t N>
+void run_packets(const bvh& tree, const std::vector<ray>& rays, packet_record<N>& triangles, packet_record<N>& boxes,
+                 packet_record<N>& closest, packet_record<N>& any) {
+  for (size_t i = 0; i < rays.size(); i += N) {
+    // Every fourth packet is partly filled, leaving lanes inactive
+    const ray_packet<N> p = ray_packet<N>::from_rays(rays.data() + i, (i / N) % 4 == 3 ? N / 2 + 1 : N);
+
+    ray_packet<N> r = p;
+    packet_hit<N> hit;
+    uint32_t mask = 0;
+    for (size_t k = 0; k < 8; ++k) {
+      const size_t t = (i + k * 997) % tree.triangles.size();
+      mask |= intersect_triangle(r, tree.triangles[t], uint32_t(t), hit);
+    }
+    triangles.add(mask, hit);
+
+    alignas(64) float t_enter[N];
+    const bvh_node& node = tree.nodes[(i / N) % tree.nodes.size()];
+    boxes.add(intersect_aabb(p, node.min, node.max, t_enter), t_enter);
+
+    r = p;
+    hit = packet_hit<N>();
+    closest.add(intersect(tree, r, hit), hit);
+    any.masks.push_back(occluded(tree, p));
+  }
+}
+
+// Outputs of a family of batch functions, flattened to compare them between kernel levels
+struct batch_outputs {
+  std::vector<float> values;    // to 1e-5 of max(1, |value|)
+  std::vector<uint64_t> exact;  // classes, indices and masks
+
+  void add(const float* v, size_t n) { values.insert(values.end(), v, v + n); }
+
+  template <typename T>
+  void add_exact(const T* v, size_t n) {
+    for (size_t i = 0; i < n; ++i) exact.push_back(static_cast<uint64_t>(v[i]));
+  }
+
+  size_t failures(const batch_outputs& reference) const {
+    size_t f = values.size() != reference.values.size() || exact.size() != reference.exact.size();
+    for (size_t i = 0; i < std::min(values.size(), reference.values.size()); ++i) {
+      f += !(std::fabs(values[i] - reference.values[i]) <= 1e-5f * std::fmax(1.0f, std::fabs(reference.values[i])));
+    }
+    for (size_t i = 0; i < std::min(exact.size(), reference.exact.size()); ++i) f += exact[i] != reference.exact[i];
+    return f;
+  }
+};
+
+// Not a multiple of any register width, so every kernel leaves a scalar tail
+constexpr size_t CHECK_COUNT = 1003;
+
+batch_outputs soa_outputs() {
+  const size_t n = CHECK_COUNT;
+  const std::vector<float3> a = random_values<float3>(n), b = random_values<float3>(n);
+  const std::vector<vector3> v3 = random_values<vector3>(n);
+  const std::vector<float4> a4 = random_values<float4>(n), b4 = random_values<float4>(n);
+  const std::vector<vector4> v4 = random_values<vector4>(n);
+  batch_outputs o;
+  float3_soa x(n), y(n), out(n);
+  float4_soa x4(n), y4(n), out4(n);
+  std::vector<float> scalars(n);
+  std::vector<float3> aos(n);
+  std::vector<float4> aos4(n);
+  const auto add3 = [&](const float3_soa& s) {
+    o.add(s.x.data(), n);
+    o.add(s.y.data(), n);
+    o.add(s.z.data(), n);
+  };
+  const auto add4 = [&](const float4_soa& s) {
+    o.add(s.x.data(), n);
+    o.add(s.y.data(), n);
+    o.add(s.z.data(), n);
+    o.add(s.w.data(), n);
+  };
+
+  aos_to_soa(v3.data(), n, out);
+  add3(out);
+  aos_to_soa(v4.data(), n, out4);
+  add4(out4);
+  aos_to_soa(a.data(), n, x);
+  aos_to_soa(b.data(), n, y);
+  aos_to_soa(a4.data(), n, x4);
+  aos_to_soa(b4.data(), n, y4);
+  add3(x);
+  add4(x4);
+  soa_to_aos(x, aos.data());
+  o.add(&aos[0].x, 3 * n);
+  soa_to_aos(x4, aos4.data());
+  o.add(&aos4[0].x, 4 * n);
+
+  dot(x, y, scalars.data());
+  o.add(scalars.data(), n);
+  dot(x4, y4, scalars.data());
+  o.add(scalars.data(), n);
+  length(x, scalars.data());
+  o.add(scalars.data(), n);
+  length(x4, scalars.data());
+  o.add(scalars.data(), n);
+  cross(x, y, out);
+  add3(out);
+  normalize(x, out);
+  add3(out);
+  normalize(x4, out4);
+  add4(out4);
+  lerp(x, y, 0.3f, out);
+  add3(out);
+  lerp(x4, y4, 0.7f, out4);
+  add4(out4);
+  clamp(x, float3(-0.5f, -0.2f, 0.0f), float3(0.5f, 0.4f, 0.6f), out);
+  add3(out);
+  clamp(x4, float4(-0.5f, -0.2f, 0.0f, -1.0f), float4(0.5f, 0.4f, 0.6f, 0.1f), out4);
+  add4(out4);
+  return o;
+}
+
+batch_outputs transform_outputs() {
+  const size_t n = CHECK_COUNT;
+  const matrix4x4 m = random_values<matrix4x4>(1)[0];
+  const matrix3x4 m34 = random_values<matrix3x4>(1)[0];
+  const std::vector<float3> p = random_values<float3>(n);
+  const std::vector<vector4> v = random_values<vector4>(n);
+  float3_soa in(n), out(n);
+  aos_to_soa(p.data(), n, in);
+  std::vector<float3> aos(n);
+  std::vector<vector4> vectors(n);
+  batch_outputs o;
+  for (store_mode mode : {store_mode::normal, store_mode::non_temporal}) {
+    transform_points(m, p.data(), aos.data(), n, mode);
+    o.add(&aos[0].x, 3 * n);
+    transform_directions(m, p.data(), aos.data(), n, mode);
+    o.add(&aos[0].x, 3 * n);
+    transform_points(m34, p.data(), aos.data(), n, mode);
+    o.add(&aos[0].x, 3 * n);
+    transform_directions(m34, p.data(), aos.data(), n, mode);
+    o.add(&aos[0].x, 3 * n);
+    transform_points(m, in, out, mode);
+    o.add(out.x.data(), n);
+    o.add(out.y.data(), n);
+    o.add(out.z.data(), n);
+    transform_directions(m34, in, out, mode);
+    o.add(out.x.data(), n);
+    o.add(out.y.data(), n);
+    o.add(out.z.data(), n);
+    transform_vectors(m, v.data(), vectors.data(), n, mode);
+    o.add(vectors[0].vector4_f32, 4 * n);
+  }
+  return o;
+}
+
+batch_outputs quaternion_outputs() {
+  const size_t n = CHECK_COUNT;
+  const std::vector<quaternion> a = random_values<quaternion>(n), b = random_values<quaternion>(n);
+  const std::vector<float3> t = random_values<float3>(n);
+  std::vector<matrix3x4> m34(n);
+  std::vector<matrix4x4> m44(n);
+  std::vector<quaternion> q(n);
+  batch_outputs o;
+  for (const float3* translations : {t.data(), static_cast<const float3*>(nullptr)}) {
+    to_matrix3x4(a.data(), translations, m34.data(), n);
+    for (const matrix3x4& m : m34) o.add(&m.m[0][0], 12);
+    to_matrix4x4(a.data(), translations, m44.data(), n);
+    for (const matrix4x4& m : m44) o.add(&m.m[0][0], 16);
+  }
+  nlerp(a.data(), b.data(), 0.3f, q.data(), n);
+  for (const quaternion& r : q) {
+    const float c[4] = {r.v.vec.x, r.v.vec.y, r.v.vec.z, r.v.vec.w};
+    o.add(c, 4);
+  }
+  return o;
+}
+
+batch_outputs frustum_outputs() {
+  const size_t n = CHECK_COUNT;
+  frustum views[3];
+  for (size_t v = 0; v < 3; ++v) {
+    views[v] = frustum::from_matrix(matrix4x4::perspective(1.0f + 0.2f * v, 16.0f / 9.0f, 0.1f, 30.0f + 20.0f * v));
+  }
+  float4_soa spheres(n);
+  float3_soa centers(n), extents(n);
+  for (size_t i = 0; i < n; ++i) {
+    const float4 s(uniform(-40, 40), uniform(-40, 40), uniform(-60, 10), uniform(0.5f, 4));
+    spheres.set(i, s);
+    centers.set(i, float3(s.x, s.y, s.z));
+    extents.set(i, float3(s.w, s.w * 0.5f, s.w * 2.0f));
+  }
+  std::vector<cull_result> classes(n);
+  std::vector<uint32_t> visible(n);
+  const size_t words = cull_mask_words(n);
+  std::vector<uint64_t> masks(3 * words);
+  uint64_t* const mask_rows[3] = {masks.data(), masks.data() + words, masks.data() + 2 * words};
+  batch_outputs o;
+  classify_spheres(views[0], spheres, classes.data());
+  o.add_exact(classes.data(), n);
+  classify_aabbs(views[1], centers, extents, classes.data());
+  o.add_exact(classes.data(), n);
+  size_t count = cull_spheres(views[2], spheres, visible.data());
+  o.add_exact(&count, 1);
+  o.add_exact(visible.data(), count);
+  count = cull_aabbs(views[0], centers, extents, visible.data());
+  o.add_exact(&count, 1);
+  o.add_exact(visible.data(), count);
+  cull_spheres(views, 3, spheres, mask_rows);
+  o.add_exact(masks.data(), masks.size());
+  cull_aabbs(views, 3, centers, extents, mask_rows);
+  o.add_exact(masks.data(), masks.size());
+  return o;
+}
+
+// Floats on and either side of every halfway point between finite halves, the overflow and
+// subnormal edges, specials and random bit patterns
+std::vector<float> half_test_floats() {
+  std::vector<float> f = {0.0f, -0.0f, 65504.0f, 65519.996f, 65520.0f, 1e-8f, 2.98e-8f, 6.1e-5f, 1e30f};
+  const uint32_t specials[] = {0x7f800000, 0xff800000, 0x7fc00000, 0xffc00001, 0x7f800001, 0x7fbfe000};
+  for (uint32_t bits : specials) {
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    f.push_back(v);
+  }
+  for (uint16_t h = 0; h < 0x7bff; ++h) {
+    const float mid = 0.5f * (detail::half_bits_to_float(h) + detail::half_bits_to_float(uint16_t(h + 1)));
+    for (float v : {mid, std::nextafter(mid, 0.0f), std::nextafter(mid, 1e9f)}) {
+      f.push_back(v);
+      f.push_back(-v);
+    }
+  }
+  for (size_t i = 0; i < 65536; ++i) {
+    const uint32_t bits = uint32_t(rng()());
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    f.push_back(v);
+  }
+  // Whole float3s, with a tail for every register width
+  f.resize(f.size() / 48 * 48 + 3 * 7);
+  return f;
+}
+
+uint32_t float_bits(float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+
+bool report_bits(const char* name, const char* level, size_t samples, size_t failures) {
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", name, level, samples, failures,
+              failures == 0 ? "ok" : "FAIL");
+  return failures == 0;
+}
+
+std::vector<unsigned char> read_file(const std::string& path) {
+  std::vector<unsigned char> bytes;
+  if (std::FILE* f = std::fopen(path.c_str(), "rb")) {
+    unsigned char buffer[4096];
+    for (size_t n; (n = std::fread(buffer, 1, sizeof(buffer), f)) > 0;) bytes.insert(bytes.end(), buffer, buffer + n);
+    std::fclose(f);
+  }
+  return bytes;
+}
+
+bool write_file(const std::string& path, const std::vector<unsigned char>& bytes) {
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+template <typename T>
+bool same_array(const pack_view<T>& view, const std::vector<T>& v) {
+  return view.size == v.size() && reinterpret_cast<uintptr_t>(view.data) % PACK_DATA_ALIGNMENT == 0 &&
+         std::memcmp(view.data, v.data(), v.size() * sizeof(T)) == 0;
+}
+
+// Largest difference of batch results to per-element references, relative to max(1, |reference|)
+struct reference_error {
+  double error = 0.0;
+  size_t samples = 0;
+
+  void add(float value, float reference) {
+    const double e = std::fabs(double(value) - reference) / std::fmax(1.0, std::fabs(reference));
+    if (!(e <= error)) error = e;  // a NaN sticks
+    ++samples;
+  }
+
+  void add(const float3& value, const float3& reference) {
+    add(value.x, reference.x);
+    add(value.y, reference.y);
+    add(value.z, reference.z);
+  }
+
+  void add(const float4& value, const float4& reference) {
+    add(float3(value.x, value.y, value.z), float3(reference.x, reference.y, reference.z));
+    add(value.w, reference.w);
+  }
+
+  void add(const vector4& value, const vector4& reference) {
+    for (int i = 0; i < 4; ++i) add(value.vector4_f32[i], reference.vector4_f32[i]);
+  }
+
+  void add(const quaternion& value, const quaternion& reference) { add(value.v, reference.v); }
+
+  void add(const float* value, const float* reference, size_t n) {
+    for (size_t i = 0; i < n; ++i) add(value[i], reference[i]);
+  }
+
+  bool report(const char* name, const char* level, double bound = 1e-5) const {
+    const bool ok = error <= bound;
+    std::printf("%-18s %-7s %8zu samples  max error %9.3g  bound %7.3g  %s\n", name, level, samples, error, bound,
+                ok ? "ok" : "FAIL");
+    return ok;
+  }
+};
+
+// check(level name) at every kernel level of this machine, then back to the active one
+template <typename Check>
+bool at_every_level(Check check) {
+  bool ok = true;
+  const cpu_isa host = active_isa();
+  for (cpu_isa isa : {cpu_isa::scalar, cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+    if (set_isa(isa) != isa) continue;
+    ok = check(isa_name(isa)) && ok;
+  }
+  set_isa(host);
+  return ok;
+}
+
+// Double precision references of the quaternion functions
+struct quaternion_d {
+  double x, y, z, w;
+
+  explicit quaternion_d(const quaternion& q) : x(q.v.vec.x), y(q.v.vec.y), z(q.v.vec.z), w(q.v.vec.w) {}
+  quaternion_d(double _x, double _y, double _z, double _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+  quaternion to_float() const { return quaternion(float(x), float(y), float(z), float(w)); }
+};
+
+quaternion slerp_reference(const quaternion& qa, const quaternion& qb, double t) {
+  const quaternion_d a(qa);
+  quaternion_d b(qb);
+  double c = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+  if (c < 0.0) {
+    b = quaternion_d(-b.x, -b.y, -b.z, -b.w);
+    c = -c;
+  }
+  const double theta = std::acos(std::fmin(c, 1.0));
+  const double s0 = theta > 0.0 ? std::sin((1.0 - t) * theta) / std::sin(theta) : 1.0 - t;
+  const double s1 = theta > 0.0 ? std::sin(t * theta) / std::sin(theta) : t;
+  return quaternion_d(a.x * s0 + b.x * s1, a.y * s0 + b.y * s1, a.z * s0 + b.z * s1, a.w * s0 + b.w * s1).to_float();
+}
+
+quaternion log_reference(const quaternion& q) {
+  const quaternion_d d(q);
+  const double s = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+  const double k = s > 0.0 ? std::atan2(s, d.w) / s : 1.0;
+  return quaternion_d(d.x * k, d.y * k, d.z * k, std::log(std::sqrt(s * s + d.w * d.w))).to_float();
+}
+
+quaternion exp_reference(const quaternion& q) {
+  const quaternion_d d(q);
+  const double angle = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+  const double e = std::exp(d.w);
+  const double k = angle > 0.0 ? e * std::sin(angle) / angle : e;
+  return quaternion_d(d.x * k, d.y * k, d.z * k, e * std::cos(angle)).to_float();
+}
+
+// q * p * conj(q) for a unit q, as quaternion::rotate
+double3 rotate_reference(const quaternion_d& q, const double3& p) {
+  const double3 u(q.x, q.y, q.z);
+  const double3 t = u.cross(p) * 2.0;
+  return p + t * q.w + u.cross(t);
+}
+
+struct skin_case {
+  float3_soa positions, normals;
+  std::vector<uint16_t> joints;
+  std::vector<float> weights;
+  std::vector<bool> rigid;  // every influence has the same rotation, where both methods agree
+
+  skin_input input() const { return {positions, normals, joints.data(), weights.data()}; }
+};
+
+// Clip-space containment of p under m in double: how far inside (positive) or outside
+// (negative) the nearest clip plane it is, relative to the size of the clip coordinates
+double clip_margin(const matrix4x4& m, const float3& p, clip_depth depth) {
+  double c[4];
+  for (int r = 0; r < 4; ++r) {
+    c[r] = double(m.m[r][0]) * p.x + double(m.m[r][1]) * p.y + double(m.m[r][2]) * p.z + m.m[r][3];
+  }
+  double margin = std::fmin(std::fmin(c[3] - c[0], c[3] + c[0]), std::fmin(c[3] - c[1], c[3] + c[1]));
+  margin = std::fmin(margin, std::fmin(depth == clip_depth::zero_to_one ? c[2] : c[2] + c[3], c[3] - c[2]));
+  return margin / (std::fabs(c[0]) + std::fabs(c[1]) + std::fabs(c[2]) + std::fabs(c[3]));
+}
+
+struct cull_view {
+  matrix4x4 clip;
+  clip_depth depth;
+  frustum planes;
+};
+
+// Points on the surface of a sphere or box that clip_margin places clearly inside or outside
+// bound what a classification may say: none inside means outside is fine, one outside rules
+// out inside, and for boxes all corners inside means inside
+size_t classification_errors(const cull_view& v, const std::vector<float3>& surface,
+                             const std::vector<float3>& corners, cull_result r) {
+  constexpr double EDGE = 1e-4;
+  bool any_inside = false, any_outside = false, corners_inside = !corners.empty();
+  for (const float3& p : surface) {
+    const double margin = clip_margin(v.clip, p, v.depth);
+    any_inside = any_inside || margin > EDGE;
+    any_outside = any_outside || margin < -EDGE;
+  }
+  for (const float3& p : corners) corners_inside = corners_inside && clip_margin(v.clip, p, v.depth) > EDGE;
+  return (any_inside && r == cull_result::outside) + (any_outside && r == cull_result::inside) +
+         (corners_inside && r != cull_result::inside);
+}
+
+// Closest and any hit of one ray by testing every triangle in double. Hits within EDGE of a
+// triangle edge or the ray's end points could go either way in float and make the ray
+// ambiguous; those rays are not compared.
+struct brute_force_hit {
+  static constexpr double EDGE = 1e-5;
+
+  bool ambiguous = false;
+  double t = INFINITY, u = 0.0, v = 0.0;
+  std::vector<uint32_t> primitives;  // every triangle hit at t
+
+  brute_force_hit(const ray& r, const std::vector<float3>& vertices, const std::vector<uint32_t>& indices) {
+    const double3 o(r.origin), d(r.direction);
+    const size_t count = indices.empty() ? vertices.size() / 3 : indices.size() / 3;
+    double near_t = INFINITY;
+    for (size_t i = 0; i < count; ++i) {
+      const auto vertex = [&](size_t k) { return double3(vertices[indices.empty() ? 3 * i + k : indices[3 * i + k]]); };
+      const double3 a = vertex(0), e1 = vertex(1) - a, e2 = vertex(2) - a;
+      const double3 p = d.cross(e2);
+      const double det = e1.dot(p);
+      if (det == 0.0) continue;
+      const double3 s = o - a, q = s.cross(e1);
+      const double hu = s.dot(p) / det, hv = d.dot(q) / det, ht = e2.dot(q) / det;
+      const double margin = std::fmin(std::fmin(hu, hv), 1.0 - hu - hv);
+      const double te = EDGE * std::fmax(1.0, std::fabs(ht));
+      if (margin < -EDGE || ht < r.t_min - te || ht > r.t_max + te) continue;
+      if (margin <= EDGE || ht <= r.t_min + te || ht >= r.t_max - te) {
+        near_t = std::fmin(near_t, ht);
+      } else if (ht < t - te) {
+        t = ht;
+        u = hu;
+        v = hv;
+        primitives.assign(1, uint32_t(i));
+      } else if (ht <= t + te) {
+        primitives.push_back(uint32_t(i));
+      }
+    }
+    ambiguous = (near_t < INFINITY && near_t <= t + EDGE * std::fmax(1.0, std::fabs(t))) || primitives.size() > 1;
+  }
+
+  bool hit() const { return !primitives.empty(); }
+};
+
+size_t bvh_errors(const bvh& tree, const std::vector<ray>& rays, const std::vector<float3>& vertices,
+                  const std::vector<uint32_t>& indices, size_t& samples) {
+  size_t failures = 0;
+  for (const ray& r : rays) {
+    const brute_force_hit reference(r, vertices, indices);
+    if (reference.ambiguous) continue;
+    ++samples;
+    ray_hit hit;
+    const bool found = tree.intersect(r, hit);
+    failures += found != reference.hit() || tree.occluded(r) != reference.hit();
+    if (!found || !reference.hit()) continue;
+    failures += hit.primitive != reference.primitives[0] ||
+                std::fabs(hit.t - reference.t) > 1e-5 * std::fmax(1.0, reference.t) ||
+                std::fabs(hit.u - reference.u) > 1e-4 || std::fabs(hit.v - reference.v) > 1e-4;
+
+    // A hit already closer than anything in the tree stays as it is
+    ray_hit closer = hit;
+    closer.t = 0.5f * hit.t;
+    closer.primitive = 7;
+    failures += tree.intersect(r, closer) || closer.primitive != 7;
+  }
+  return failures;
+}
+
+// A unit quad in the plane where coordinate `axis` is 0, with rays along the axis from both
+// sides. The rays start on the quad's edges and corners, so every box they meet has them in a
+// face plane with a zero direction component; the last two pass just outside and miss.
+struct face_scene {
+  std::vector<float3> vertices;
+  std::vector<ray> rays;
+  std::vector<bool> hits;
+
+  explicit face_scene(int axis) {
+    const auto point = [axis](float a, float u, float v) {
+      return axis == 0 ? float3(a, u, v) : axis == 1 ? float3(v, a, u) : float3(u, v, a);
+    };
+    const float quad[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+    for (const auto& q : quad) vertices.push_back(point(0.0f, q[0], q[1]));
+    const float starts[11][2] = {{0, 0},   {0.5f, 0}, {1, 0}, {0, 0.5f}, {0.5f, 0.5f}, {1, 0.5f},
+                                 {0, 1},   {0.5f, 1}, {1, 1}, {0.5f, 1.25f}, {1.25f, 0.5f}};
+    for (float side : {1.0f, -1.0f}) {
+      for (size_t i = 0; i < 11; ++i) {
+        ray r;
+        r.origin = point(side, starts[i][0], starts[i][1]);
+        r.direction = point(-side, 0.0f, 0.0f);
+        rays.push_back(r);
+        hits.push_back(i < 9);
+      }
+    }
+  }
+};
+
+// Every number in text, in order. Type names and other words are skipped; JSON nulls read
+// as NaN.
+template <typename T>
+std::vector<T> parse_numbers(const std::string& text) {
+  std::vector<T> v;
+  for (size_t i = 0; i < text.size();) {
+    const size_t end = std::min(text.find_first_of(" ,()|[]\n", i), text.size());
+    T x;
+    const std::from_chars_result r = std::from_chars(text.data() + i, text.data() + end, x);
+    if (end > i && r.ec == std::errc() && r.ptr == text.data() + end) {
+      v.push_back(x);
+    } else if (text.compare(i, end - i, "null") == 0) {
+      v.push_back(std::numeric_limits<T>::quiet_NaN());
+    }
+    i = end + 1;
+  }
+  return v;
+}
+
+// Bit for bit, any NaN matching any other
+template <typename T>
+bool same_value(T a, T b) {
+  return (std::isnan(a) && std::isnan(b)) || std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+template <typename T>
+std::string chars(const T& value) {
+  char buffer[TO_STRING_BUFFER_SIZE];
+  return std::string(buffer, value.to_chars(buffer, buffer + sizeof(buffer)).ptr);
+}
+
+} // namespace
+
+bool check_ray_packets() {
+  bool ok = true;
+
+  // A soup of small random triangles and rays from one side, against the scalar lanes
+  std::vector<float3> soup(3 * 20000);
+  for (size_t i = 0; i < soup.size(); i += 3) {
+    const float3 c(uniform(-10, 10), uniform(-10, 10), uniform(-10, 10));
+    for (size_t k = 0; k < 3; ++k) soup[i + k] = c + float3(uniform(-0.5f, 0.5f), uniform(-0.5f, 0.5f), uniform(-0.5f, 0.5f));
+  }
+  bvh tree;
+  tree.build(soup.data(), nullptr, soup.size() / 3, 1);
+  std::vector<ray> rays(RAY_COUNT);
+  for (ray& r : rays) {
+    r.origin = float3(uniform(-12, 12), uniform(-12, 12), -15.0f);
+    r.direction = float3(uniform(-0.5f, 0.5f), uniform(-0.5f, 0.5f), 1.0f);
+    r.t_max = uniform(0, 1) < 0.25f ? uniform(5, 30) : INFINITY;
+  }
+
+  // Closest and any hits of the scalar packets also match single rays
+  packet_record<16> t16, b16, c16, a16;
+  packet_record<8> t8, b8, c8, a8;
+  const cpu_isa host = active_isa();
+  set_isa(cpu_isa::scalar);
+  run_packets(tree, rays, t16, b16, c16, a16);
+  run_packets(tree, rays, t8, b8, c8, a8);
+  size_t failures = 0;
+  for (size_t i = 0; i < rays.size(); ++i) {
+    const bool active = (i / 16) % 4 != 3 || i % 16 <= 8;
+    ray_hit hit;
+    const bool h = active && tree.intersect(rays[i], hit);
+    failures += h != bool((c16.masks[i / 16] >> (i % 16)) & 1) || (h && hit.primitive != c16.primitives[i]);
+    failures += (active && tree.occluded(rays[i])) != bool((a16.masks[i / 16] >> (i % 16)) & 1);
+  }
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "ray16 single", "scalar", rays.size(), failures,
+              failures == 0 ? "ok" : "FAIL");
+  ok = failures == 0 && ok;
+
+  for (cpu_isa isa : {cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+    if (set_isa(isa) != isa) continue;
+    packet_record<16> x16[4];
+    packet_record<8> x8[4];
+    run_packets(tree, rays, x16[0], x16[1], x16[2], x16[3]);
+    run_packets(tree, rays, x8[0], x8[1], x8[2], x8[3]);
+    failures = x16[0].failures(t16) + x16[1].failures(b16) + x16[2].failures(c16) + x16[3].failures(a16);
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "ray16 packets", isa_name(isa), rays.size(), failures,
+                failures == 0 ? "ok" : "FAIL");
+    ok = failures == 0 && ok;
+    failures = x8[0].failures(t8) + x8[1].failures(b8) + x8[2].failures(c8) + x8[3].failures(a8);
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "ray8 packets", isa_name(isa), rays.size(), failures,
+                failures == 0 ? "ok" : "FAIL");
+    ok = failures == 0 && ok;
+  }
+
+  // Rays in the face planes of the boxes, from the edges and corners of axis-aligned quads. The
+  // scalar lanes match single rays, and every level matches the scalar lanes.
+  const face_scene faces[3] = {face_scene(0), face_scene(1), face_scene(2)};
+  bvh quads[3];
+  std::vector<ray> face_rays[3];
+  packet_record<16> s16[3][4];
+  packet_record<8> s8[3][4];
+  set_isa(cpu_isa::scalar);
+  failures = 0;
+  for (size_t axis = 0; axis < 3; ++axis) {
+    quads[axis].build(faces[axis].vertices.data(), nullptr, 2);
+    for (size_t i = 0; i < 32; ++i) face_rays[axis].push_back(faces[axis].rays[i % faces[axis].rays.size()]);
+    run_packets(quads[axis], face_rays[axis], s16[axis][0], s16[axis][1], s16[axis][2], s16[axis][3]);
+    run_packets(quads[axis], face_rays[axis], s8[axis][0], s8[axis][1], s8[axis][2], s8[axis][3]);
+    const auto lane_failures = [&](const std::vector<uint32_t>& masks, size_t n) {
+      size_t f = 0;
+      for (size_t i = 0; i < face_rays[axis].size(); ++i) {
+        const bool active = (i / n) % 4 != 3 || i % n <= n / 2;
+        ray_hit hit;
+        const bool h = quads[axis].intersect(face_rays[axis][i], hit);
+        f += h != faces[axis].hits[i % faces[axis].rays.size()] || (h && hit.t != 1.0f);
+        f += (active && h) != bool((masks[i / n] >> (i % n)) & 1);
+      }
+      return f;
+    };
+    for (size_t k = 1; k < 4; ++k) {
+      failures += lane_failures(s16[axis][k].masks, 16) + lane_failures(s8[axis][k].masks, 8);
+    }
+    for (float t : s16[axis][2].t) failures += t != 0.0f && t != 1.0f;
+  }
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "ray faces single", "scalar", size_t(3 * 32), failures,
+              failures == 0 ? "ok" : "FAIL");
+  ok = failures == 0 && ok;
+
+  for (cpu_isa isa : {cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+    if (set_isa(isa) != isa) continue;
+    failures = 0;
+    for (size_t axis = 0; axis < 3; ++axis) {
+      packet_record<16> x16[4];
+      packet_record<8> x8[4];
+      run_packets(quads[axis], face_rays[axis], x16[0], x16[1], x16[2], x16[3]);
+      run_packets(quads[axis], face_rays[axis], x8[0], x8[1], x8[2], x8[3]);
+      for (size_t k = 0; k < 4; ++k) failures += x16[k].failures(s16[axis][k]) + x8[k].failures(s8[axis][k]);
+    }
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "ray faces packets", isa_name(isa), size_t(3 * 32),
+                failures, failures == 0 ? "ok" : "FAIL");
+    ok = failures == 0 && ok;
+  }
+  set_isa(host);
+  return ok;
+}
+
+bool check_batch_kernels() {
+  struct family {
+    const char* name;
+    batch_outputs (*run)();
+  };
+  const family families[] = {{"soa kernels", soa_outputs},
+                             {"transform kernels", transform_outputs},
+                             {"quaternion kernels", quaternion_outputs},
+                             {"frustum kernels", frustum_outputs}};
+  bool ok = true;
+  const cpu_isa host = active_isa();
+  for (const family& f : families) {
+    // The same inputs at every level, against the scalar tails
+    const std::mt19937 state = rng();
+    set_isa(cpu_isa::scalar);
+    const batch_outputs reference = f.run();
+    for (cpu_isa isa : {cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+      if (set_isa(isa) != isa) continue;
+      rng() = state;
+      const size_t failures = f.run().failures(reference);
+      std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", f.name, isa_name(isa), CHECK_COUNT, failures,
+                  failures == 0 ? "ok" : "FAIL");
+      ok = failures == 0 && ok;
+    }
+  }
+  set_isa(host);
+  return ok;
+}
+
+bool check_precision() {
+  const std::vector<float> floats = half_test_floats();
+  std::vector<half> halves(65536);
+  for (size_t i = 0; i < halves.size(); ++i) halves[i] = half::from_bits(uint16_t(i));
+
+  const size_t n = CHECK_COUNT;
+  const double3 camera(6371000.0, 1250.5, -20000.25);
+  std::vector<double3> positions(n);
+  std::vector<double4> points(n);
+  for (size_t i = 0; i < n; ++i) {
+    positions[i] = camera + double3(uniform(-1e4f, 1e4f), uniform(-1e4f, 1e4f), uniform(-1e4f, 1e4f));
+    points[i] = double4(positions[i], uniform(-1, 1));
+  }
+
+  bool ok = true;
+  const cpu_isa host = active_isa();
+  for (cpu_isa isa : {cpu_isa::scalar, cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+    if (set_isa(isa) != isa) continue;
+    const char* level = isa_name(isa);
+
+    // Bit for bit against the scalar conversions, both as plain arrays and as float3/half3
+    std::vector<half> h(floats.size());
+    size_t failures = 0;
+    to_half(floats.data(), h.data(), floats.size());
+    for (size_t i = 0; i < floats.size(); ++i) failures += h[i].bits != detail::float_to_half_bits(floats[i]);
+    std::vector<half3> h3(floats.size() / 3);
+    to_half(reinterpret_cast<const float3*>(floats.data()), h3.data(), h3.size());
+    for (size_t i = 0; i < h3.size(); ++i) failures += !(h3[i] == half3(h[3 * i], h[3 * i + 1], h[3 * i + 2]));
+    ok = report_bits("to_half", level, floats.size() + 3 * h3.size(), failures) && ok;
+
+    std::vector<float> f(halves.size());
+    failures = 0;
+    to_float(halves.data(), f.data(), halves.size());
+    for (size_t i = 0; i < halves.size(); ++i) {
+      failures += float_bits(f[i]) != float_bits(detail::half_bits_to_float(halves[i].bits));
+    }
+    std::vector<float3> f3(halves.size() / 3);
+    to_float(reinterpret_cast<const half3*>(halves.data()), f3.data(), f3.size());
+    for (size_t i = 0; i < f3.size(); ++i) {
+      failures += float_bits(f3[i].x) != float_bits(f[3 * i]) || float_bits(f3[i].y) != float_bits(f[3 * i + 1]) ||
+                  float_bits(f3[i].z) != float_bits(f[3 * i + 2]);
+    }
+    ok = report_bits("to_float", level, halves.size() + 3 * f3.size(), failures) && ok;
+
+    // Exactly the per-element double subtraction and rounding
+    std::vector<float3> relative(n);
+    std::vector<half3> relative_half(n);
+    std::vector<float4> relative4(n);
+    relative_to_camera(positions.data(), camera, relative.data(), n);
+    relative_to_camera(positions.data(), camera, relative_half.data(), n);
+    relative_to_camera(points.data(), camera, relative4.data(), n);
+    failures = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const float3 r = (positions[i] - camera).to_float3();
+      const float4 r4 = (points[i] - double4(camera, 0.0)).to_float4();
+      failures += !(relative[i] == r) + !(relative_half[i] == half3(r)) + !(relative4[i] == r4);
+    }
+    ok = report_bits("relative_to_camera", level, 3 * n, failures) && ok;
+  }
+  set_isa(host);
+  return ok;
+}
+
+bool check_pack() {
+  const std::string path = (std::filesystem::temp_directory_path() / "cgmath_bench_check.pack").string();
+  const std::vector<float3> positions = random_values<float3>(CHECK_COUNT);
+  const std::vector<matrix4x4> bones = random_values<matrix4x4>(17);
+  const std::vector<uint16_t> indices = {0, 1, 2, 2, 1, 3, 65535};
+  const std::vector<float4> padded = random_values<float4>(9);
+  size_t cases = 0, failures = 0;
+  const auto expect = [&](bool passed) {
+    ++cases;
+    failures += !passed;
+  };
+
+  pack_writer writer;
+  expect(writer.add("positions", positions.data(), positions.size()));
+  expect(writer.add("bones", bones.data(), bones.size()));
+  expect(writer.add("indices", indices.data(), indices.size()));
+  expect(writer.add("empty", positions.data(), 0));
+  // float3 elements written with a 16 byte stride, which a float3 view must refuse
+  expect(writer.add_raw("strided", uint32_t(pack_type::float3), sizeof(float4), alignof(float4), padded.data(),
+                        padded.size()));
+  expect(!writer.add("positions", indices.data(), indices.size()));
+  expect(!writer.add("", indices.data(), indices.size()));
+  expect(!writer.add("a name of thirty-two characters.", indices.data(), indices.size()));
+  expect(!writer.add_raw("unaligned", uint32_t(pack_type::f32), 4, 0, padded.data(), 4));
+  expect(!writer.add_raw("unaligned", uint32_t(pack_type::f32), 4, 48, padded.data(), 4));
+
+  // Round trip: same bits, aligned in place, and views refused on any mismatch
+  pack_file pack;
+  expect(writer.save(path.c_str()) && pack.open(path.c_str()) && pack.array_count() == 5);
+  if (pack.is_open()) {
+    expect(same_array(pack.get<float3>("positions"), positions));
+    expect(same_array(pack.get<matrix4x4>("bones"), bones));
+    expect(same_array(pack.get<uint16_t>("indices"), indices));
+    expect(pack.find("empty") && pack.get<float3>("empty").empty());
+    expect(pack.get<float4>("positions").empty() && pack.get<float>("positions").empty());
+    expect(pack.get<uint32_t>("indices").empty() && pack.get<matrix3x4>("bones").empty());
+    expect(pack.get<float3>("strided").empty() && pack.get<float3>("missing").empty());
+    for (size_t i = 0; i < pack.array_count(); ++i) expect(pack.verify(pack.entry(i)));
+  }
+  const std::vector<unsigned char> bytes = read_file(path);
+  const uint64_t positions_offset = pack.is_open() ? pack.find("positions")->offset : 0;
+  pack.close();
+
+  // A flipped data byte still opens but fails the checksum of its array only
+  std::vector<unsigned char> corrupt = bytes;
+  corrupt[positions_offset + 100] ^= 0x10;
+  expect(write_file(path, corrupt) && pack.open(path.c_str()));
+  if (pack.is_open()) {
+    expect(!pack.verify(*pack.find("positions")) && pack.verify(*pack.find("bones")));
+    pack.close();
+  }
+
+  // Truncated files and damaged headers or directories are rejected by open
+  const auto rejected = [&](std::vector<unsigned char> b) {
+    expect(write_file(path, b) && !pack.open(path.c_str()) && !pack.is_open());
+  };
+  pack_header header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  rejected({});
+  rejected(std::vector<unsigned char>(bytes.begin(), bytes.begin() + 32));
+  rejected(std::vector<unsigned char>(bytes.begin(), bytes.end() - 1));
+  rejected(std::vector<unsigned char>(bytes.begin(), bytes.begin() + static_cast<ptrdiff_t>(header.directory_offset)));
+  const auto patched = [&](size_t offset, const void* value, size_t size) {
+    std::vector<unsigned char> b = bytes;
+    std::memcpy(b.data() + offset, value, size);
+    return b;
+  };
+  const uint32_t wrong = 0x04030201;
+  const uint64_t huge = uint64_t(1) << 40;
+  const size_t first = static_cast<size_t>(header.directory_offset);
+  rejected(patched(0, "CGMPACX", 7));
+  rejected(patched(offsetof(pack_header, version), &wrong, sizeof(wrong)));
+  rejected(patched(offsetof(pack_header, byte_order), &wrong, sizeof(wrong)));
+  rejected(patched(offsetof(pack_header, array_count), &wrong, sizeof(wrong)));
+  rejected(patched(offsetof(pack_header, directory_offset), &huge, sizeof(huge)));
+  rejected(patched(first + offsetof(pack_entry, offset), &huge, sizeof(huge)));
+  rejected(patched(first + offsetof(pack_entry, count), &huge, sizeof(huge)));
+  rejected(patched(first + PACK_NAME_SIZE - 1, "x", 1));
+
+  // Without checksums every array verifies, damaged or not
+  expect(writer.save(path.c_str(), false));
+  corrupt = read_file(path);
+  corrupt[positions_offset + 100] ^= 0x10;
+  expect(write_file(path, corrupt) && pack.open(path.c_str()) && pack.verify(*pack.find("positions")));
+  pack.close();
+
+  // An alignment past PACK_DATA_ALIGNMENT pads the gaps with more zeros than one block
+  pack_writer paged;
+  const std::vector<float> page = random_values<float>(CHECK_COUNT);
+  expect(paged.add("a", indices.data(), indices.size()));
+  expect(paged.add_raw("b", uint32_t(pack_type::f32), 4, 4096, page.data(), page.size()));
+  expect(paged.save(path.c_str()) && pack.open(path.c_str()) && pack.array_count() == 2);
+  if (pack.is_open()) {
+    expect(pack.find("b") && pack.find("b")->offset % 4096 == 0);
+    expect(same_array(pack.get<uint16_t>("a"), indices) && same_array(pack.get<float>("b"), page));
+    for (size_t i = 0; i < pack.array_count(); ++i) expect(pack.verify(pack.entry(i)));
+    pack.close();
+  }
+  std::remove(path.c_str());
+
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "pack round trip", "-", cases, failures,
+              failures == 0 ? "ok" : "FAIL");
+  return failures == 0;
+}
+
+bool check_transforms() {
+  const size_t n = CHECK_COUNT;
+  const matrix4x4 m = random_values<matrix4x4>(1)[0];
+  const matrix3x4 m34 = random_values<matrix3x4>(1)[0];
+  const std::vector<float3> p = random_values<float3>(n);
+  const std::vector<vector4> v = random_values<vector4>(n);
+  const float3_soa in = to_soa(p);
+
+  return at_every_level([&](const char* level) {
+    reference_error points, directions, vectors;
+    std::vector<float3> out(n);
+    std::vector<vector4> out4(n);
+    float3_soa soa_out(n);
+    for (store_mode mode : {store_mode::normal, store_mode::non_temporal}) {
+      transform_points(m, p.data(), out.data(), n, mode);
+      for (size_t i = 0; i < n; ++i) points.add(out[i], m.transform_point(p[i]));
+      transform_points(m34, p.data(), out.data(), n, mode);
+      for (size_t i = 0; i < n; ++i) points.add(out[i], m34.transform_point(p[i]));
+      transform_directions(m, p.data(), out.data(), n, mode);
+      for (size_t i = 0; i < n; ++i) directions.add(out[i], m.transform_direction(p[i]));
+      transform_directions(m34, p.data(), out.data(), n, mode);
+      for (size_t i = 0; i < n; ++i) directions.add(out[i], m34.transform_direction(p[i]));
+
+      // SoA streams, also from an element off the stream alignment
+      transform_points(m, in, soa_out, mode);
+      for (size_t i = 0; i < n; ++i) points.add(soa_out.get(i), m.transform_point(p[i]));
+      const const_float3_soa_view tail = const_float3_soa_view(in).subview(1, n);
+      transform_points(m34, tail, float3_soa_view(soa_out).subview(1, n), mode);
+      for (size_t i = 1; i < n; ++i) points.add(soa_out.get(i), m34.transform_point(p[i]));
+      transform_directions(m, tail, float3_soa_view(soa_out).subview(1, n), mode);
+      for (size_t i = 1; i < n; ++i) directions.add(soa_out.get(i), m.transform_direction(p[i]));
+      transform_directions(m34, in, soa_out, mode);
+      for (size_t i = 0; i < n; ++i) directions.add(soa_out.get(i), m34.transform_direction(p[i]));
+
+      transform_vectors(m, v.data(), out4.data(), n, mode);
+      for (size_t i = 0; i < n; ++i) vectors.add(out4[i], m * v[i]);
+    }
+
+    // In place
+    out = p;
+    transform_points(m, out.data(), out.data(), n);
+    for (size_t i = 0; i < n; ++i) points.add(out[i], m.transform_point(p[i]));
+
+    bool ok = points.report("transform_points", level);
+    ok = directions.report("transform_dirs", level) && ok;
+    return vectors.report("transform_vectors", level) && ok;
+  });
+}
+
+bool check_soa() {
+  const size_t n = CHECK_COUNT;
+  std::vector<float3> a = random_values<float3>(n), b = random_values<float3>(n);
+  std::vector<float4> a4 = random_values<float4>(n), b4 = random_values<float4>(n);
+  // Zero-length elements normalize to zero
+  a[5] = float3();
+  a4[7] = float4();
+  const float3 lo(-0.5f, -0.2f, 0.0f), hi(0.5f, 0.4f, 0.6f);
+  const float4 lo4(-0.5f, -0.2f, 0.0f, -1.0f), hi4(0.5f, 0.4f, 0.6f, 0.1f);
+  const float t = 0.3f;
+
+  return at_every_level([&](const char* level) {
+    reference_error layout, products, lengths, results;
+    float3_soa x(n), y(n), out(n);
+    float4_soa x4(n), y4(n), out4(n);
+    std::vector<float> scalars(n);
+    std::vector<float3> back(n);
+    std::vector<float4> back4(n);
+
+    aos_to_soa(a.data(), n, x);
+    aos_to_soa(b.data(), n, y);
+    aos_to_soa(a4.data(), n, x4);
+    aos_to_soa(b4.data(), n, y4);
+    soa_to_aos(x, back.data());
+    soa_to_aos(x4, back4.data());
+    for (size_t i = 0; i < n; ++i) {
+      layout.add(x.get(i), a[i]);
+      layout.add(x4.get(i), a4[i]);
+      layout.add(back[i], a[i]);
+      layout.add(back4[i], a4[i]);
+    }
+
+    dot(x, y, scalars.data());
+    for (size_t i = 0; i < n; ++i) products.add(scalars[i], a[i].dot(b[i]));
+    dot(x4, y4, scalars.data());
+    for (size_t i = 0; i < n; ++i) products.add(scalars[i], a4[i].dot(b4[i]));
+    cross(x, y, out);
+    for (size_t i = 0; i < n; ++i) products.add(out.get(i), a[i].cross(b[i]));
+
+    length(x, scalars.data());
+    for (size_t i = 0; i < n; ++i) lengths.add(scalars[i], a[i].length());
+    length(x4, scalars.data());
+    for (size_t i = 0; i < n; ++i) lengths.add(scalars[i], a4[i].length());
+    normalize(x, out);
+    for (size_t i = 0; i < n; ++i) lengths.add(out.get(i), a[i].normalized());
+    normalize(x4, out4);
+    for (size_t i = 0; i < n; ++i) lengths.add(out4.get(i), a4[i].normalized());
+
+    lerp(x, y, t, out);
+    for (size_t i = 0; i < n; ++i) results.add(out.get(i), a[i] + (b[i] - a[i]) * t);
+    lerp(x4, y4, t, out4);
+    for (size_t i = 0; i < n; ++i) results.add(out4.get(i), a4[i] + (b4[i] - a4[i]) * t);
+    clamp(x, lo, hi, out);
+    for (size_t i = 0; i < n; ++i) {
+      results.add(out.get(i), float3(std::fmin(std::fmax(a[i].x, lo.x), hi.x), std::fmin(std::fmax(a[i].y, lo.y), hi.y),
+                                     std::fmin(std::fmax(a[i].z, lo.z), hi.z)));
+    }
+    clamp(x4, lo4, hi4, out4);
+    for (size_t i = 0; i < n; ++i) {
+      results.add(out4.get(i), float4(std::fmin(std::fmax(a4[i].x, lo4.x), hi4.x),
+                                      std::fmin(std::fmax(a4[i].y, lo4.y), hi4.y),
+                                      std::fmin(std::fmax(a4[i].z, lo4.z), hi4.z),
+                                      std::fmin(std::fmax(a4[i].w, lo4.w), hi4.w)));
+    }
+
+    // Outputs aliasing their inputs
+    normalize(x, x);
+    lerp(x4, y4, t, y4);
+    for (size_t i = 0; i < n; ++i) {
+      results.add(x.get(i), a[i].normalized());
+      results.add(y4.get(i), a4[i] + (b4[i] - a4[i]) * t);
+    }
+
+    bool ok = layout.report("soa layout", level, 0.0);
+    ok = products.report("soa dot/cross", level) && ok;
+    ok = lengths.report("soa length/norm", level) && ok;
+    return results.report("soa lerp/clamp", level) && ok;
+  });
+}
+
+bool check_quaternions() {
+  const size_t n = CHECK_COUNT;
+  std::vector<quaternion> a = random_values<quaternion>(n), b = random_values<quaternion>(n);
+  const std::vector<float3> translations = random_values<float3>(n);
+  const std::vector<float3> axes = random_values<float3>(n);
+  for (size_t i = 0; i < n; ++i) {
+    // Both hemispheres, and every fourth pair within the nlerp fallback of slerp or close to it
+    if (i % 3 == 1) a[i] = -a[i];
+    if (i % 4 == 2) b[i] = a[i] * quaternion::from_axis_angle(axes[i].normalized(), uniform(1e-6f, 0.1f));
+  }
+  a[0] = quaternion();
+  a[1] = quaternion(0.0f, 0.0f, 0.0f, -1.0f);
+  a[2] = quaternion(0.0f, 1.0f, 0.0f, 0.0f);
+  a[3] = quaternion::from_axis_angle(float3(0.0f, 0.0f, 1.0f), 1e-6f);
+  b[4] = a[4];
+  b[5] = -a[5];
+
+  // The scalar functions have no kernel levels
+  reference_error slerps, logs, exps;
+  for (size_t i = 0; i < n; ++i) {
+    for (float t : {0.0f, 0.25f, 0.5f, 0.9f, 1.0f}) slerps.add(slerp(a[i], b[i], t), slerp_reference(a[i], b[i], t));
+    logs.add(a[i].log(), log_reference(a[i]));
+    // exp(log(q)) is the same rotation; for q = -1 the axis is lost and it comes back as +1
+    const quaternion round_trip = a[i].log().exp();
+    logs.add(round_trip, round_trip.dot(a[i]) < 0.0f ? -a[i] : a[i]);
+    const quaternion pure(uniform(-3, 3), uniform(-3, 3), uniform(-3, 3), uniform(-1, 1));
+    exps.add(pure.exp(), exp_reference(pure));
+    exps.add(a[i].log().exp(), exp_reference(a[i].log()));
+  }
+  bool ok = slerps.report("quaternion slerp", "-");
+  ok = logs.report("quaternion log", "-") && ok;
+  ok = exps.report("quaternion exp", "-") && ok;
+
+  return at_every_level([&](const char* level) {
+    reference_error matrices, nlerps;
+    std::vector<matrix3x4> m34(n);
+    std::vector<matrix4x4> m44(n);
+    std::vector<quaternion> q(n);
+    for (const float3* t : {translations.data(), static_cast<const float3*>(nullptr)}) {
+      to_matrix3x4(a.data(), t, m34.data(), n);
+      to_matrix4x4(a.data(), t, m44.data(), n);
+      for (size_t i = 0; i < n; ++i) {
+        const float3 translation = t ? t[i] : float3();
+        const matrix3x4 r34 = a[i].to_matrix3x4(translation);
+        const matrix4x4 r44 = a[i].to_matrix4x4(translation);
+        matrices.add(&m34[i].m[0][0], &r34.m[0][0], 12);
+        matrices.add(&m44[i].m[0][0], &r44.m[0][0], 16);
+      }
+    }
+    for (float t : {0.0f, 0.3f, 1.0f}) {
+      nlerp(a.data(), b.data(), t, q.data(), n);
+      for (size_t i = 0; i < n; ++i) nlerps.add(q[i], nlerp(a[i], b[i], t));
+    }
+    bool level_ok = matrices.report("quaternion matrix", level);
+    return nlerps.report("quaternion nlerp", level) && level_ok;
+  }) && ok;
+}
+
+bool check_skinning() {
+  // Bones 0-7 are random rigid transforms, 8-15 share one rotation with different translations
+  constexpr size_t bones = 16;
+  std::vector<quaternion> rotations = random_values<quaternion>(bones);
+  std::vector<float3> translations(bones);
+  for (size_t b = 0; b < bones; ++b) {
+    if (b >= 8) rotations[b] = rotations[8];
+    translations[b] = float3(uniform(-2, 2), uniform(-2, 2), uniform(-2, 2));
+  }
+  std::vector<matrix3x4> palette(bones);
+  for (size_t b = 0; b < bones; ++b) palette[b] = rotations[b].to_matrix3x4(translations[b]);
+  std::vector<dual_quaternion> dq_palette(bones);
+  to_dual_quaternions(palette.data(), dq_palette.data(), bones);
+
+  // Single bones, one bone four times, any four bones, and four bones of the shared rotation
+  const size_t n = CHECK_COUNT;
+  skin_case c{to_soa(random_values<float3>(n)), float3_soa(n), std::vector<uint16_t>(n * SKIN_MAX_INFLUENCES),
+              std::vector<float>(n * SKIN_MAX_INFLUENCES), std::vector<bool>(n)};
+  for (size_t i = 0; i < n; ++i) {
+    c.normals.set(i, float3(uniform(-1, 1), uniform(-1, 1), uniform(0.1f, 1)).normalized());
+    uint16_t* joint = &c.joints[i * SKIN_MAX_INFLUENCES];
+    float* weight = &c.weights[i * SKIN_MAX_INFLUENCES];
+    float sum = 0.0f;
+    for (size_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+      joint[k] = static_cast<uint16_t>(i % 4 == 3 ? 8 + rng()() % 8 : rng()() % bones);
+      if (i % 4 == 1) joint[k] = joint[0];
+      weight[k] = i % 4 == 0 ? (k == 0 ? 1.0f : 0.0f) : uniform(0.05f, 1);
+      sum += weight[k];
+    }
+    for (size_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) weight[k] /= sum;
+    c.rigid[i] = i % 4 != 2;
+  }
+
+  float3_soa lbs_positions(n), lbs_normals(n), dq_positions(n), dq_normals(n), positions(n), normals(n);
+  skin_linear(c.input(), palette.data(), skin_output{lbs_positions, lbs_normals});
+  skin_dual_quaternion(c.input(), dq_palette.data(), skin_output{dq_positions, dq_normals});
+
+  // Each method against its definition in double, and the two against each other where the
+  // influences share a rotation
+  reference_error linear, dual, agree, convert;
+  for (size_t i = 0; i < n; ++i) {
+    const double3 p(c.positions.get(i)), normal(c.normals.get(i));
+    const uint16_t* joint = &c.joints[i * SKIN_MAX_INFLUENCES];
+    const float* weight = &c.weights[i * SKIN_MAX_INFLUENCES];
+
+    double3 lp, ln;
+    for (size_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+      const quaternion_d q(rotations[joint[k]]);
+      lp += (rotate_reference(q, p) + double3(translations[joint[k]])) * weight[k];
+      ln += rotate_reference(q, normal) * weight[k];
+    }
+    linear.add(lbs_positions.get(i), lp.to_float3());
+    linear.add(lbs_normals.get(i), ln.normalized().to_float3());
+
+    const quaternion_d pivot(dq_palette[joint[0]].real);
+    quaternion_d real(0, 0, 0, 0), du(0, 0, 0, 0);
+    for (size_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+      const quaternion_d r(dq_palette[joint[k]].real), d(dq_palette[joint[k]].dual);
+      const double w = pivot.x * r.x + pivot.y * r.y + pivot.z * r.z + pivot.w * r.w < 0.0 ? -weight[k] : weight[k];
+      real = quaternion_d(real.x + r.x * w, real.y + r.y * w, real.z + r.z * w, real.w + r.w * w);
+      du = quaternion_d(du.x + d.x * w, du.y + d.y * w, du.z + d.z * w, du.w + d.w * w);
+    }
+    const double len = std::sqrt(real.x * real.x + real.y * real.y + real.z * real.z + real.w * real.w);
+    real = quaternion_d(real.x / len, real.y / len, real.z / len, real.w / len);
+    du = quaternion_d(du.x / len, du.y / len, du.z / len, du.w / len);
+    // Translation 2 * dual * conj(real)
+    const double3 t = (double3(du.x, du.y, du.z) * real.w - double3(real.x, real.y, real.z) * du.w -
+                       double3(du.x, du.y, du.z).cross(double3(real.x, real.y, real.z))) * 2.0;
+    dual.add(dq_positions.get(i), (rotate_reference(real, p) + t).to_float3());
+    dual.add(dq_normals.get(i), rotate_reference(real, normal).to_float3());
+
+    if (c.rigid[i]) {
+      agree.add(lbs_positions.get(i), dq_positions.get(i));
+      agree.add(lbs_normals.get(i), dq_normals.get(i));
+    }
+  }
+  for (size_t b = 0; b < bones; ++b) {
+    const matrix3x4 m = dq_palette[b].to_matrix3x4();
+    convert.add(&m.m[0][0], &palette[b].m[0][0], 12);
+  }
+
+  // Threads and sub-ranges write exactly the serial results
+  size_t mismatches = 0;
+  const auto compare = [&](const float3_soa& a, const float3_soa& b) {
+    for (size_t i = 0; i < n; ++i) mismatches += !(a.get(i) == b.get(i));
+  };
+  skin_linear(c.input(), palette.data(), skin_output{positions, normals}, 3);
+  compare(positions, lbs_positions);
+  compare(normals, lbs_normals);
+  skin_dual_quaternion(c.input(), dq_palette.data(), skin_output{positions, normals}, 0, n / 2);
+  skin_dual_quaternion(c.input(), dq_palette.data(), skin_output{positions, normals}, n / 2, n);
+  compare(positions, dq_positions);
+  compare(normals, dq_normals);
+
+  bool ok = linear.report("skin linear", "-");
+  ok = dual.report("skin dual quat", "-") && ok;
+  ok = agree.report("skin lbs vs dq", "-") && ok;
+  ok = convert.report("to_dual_quats", "-") && ok;
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "skin threads", "-", 4 * n, mismatches,
+              mismatches == 0 ? "ok" : "FAIL");
+  return mismatches == 0 && ok;
+}
+
+bool check_frustum() {
+  const matrix4x4 view = matrix4x4::look_at(float3(3, 2, 10), float3(0, 0, 0), float3(0, 1, 0));
+  std::vector<cull_view> views;
+  for (clip_depth depth : {clip_depth::zero_to_one, clip_depth::minus_one_to_one}) {
+    views.push_back({matrix4x4::perspective(1.0f, 16.0f / 9.0f, 0.5f, 40.0f, depth) * view, depth, {}});
+    views.push_back({matrix4x4::orthographic(-12, 8, -5, 7, 1.0f, 30.0f, depth) * view, depth, {}});
+  }
+  for (cull_view& v : views) v.planes = frustum::from_matrix(v.clip, v.depth);
+
+  const size_t n = CHECK_COUNT;
+  float4_soa spheres(n);
+  float3_soa centers(n), extents(n);
+  for (size_t i = 0; i < n; ++i) {
+    const float r = uniform(0.2f, 4);
+    const float3 c(uniform(-30, 30), uniform(-30, 30), uniform(-30, 30));
+    spheres.set(i, float4(c.x, c.y, c.z, r));
+    centers.set(i, c);
+    extents.set(i, float3(r, r * 0.5f, uniform(0.1f, 2)));
+  }
+
+  // The member tests against the clip volume, through points of every bound
+  size_t samples = 0, failures = 0;
+  for (const cull_view& v : views) {
+    for (size_t i = 0; i < n; ++i) {
+      const float4 s = spheres.get(i);
+      const float3 c = centers.get(i), e = extents.get(i);
+      std::vector<float3> surface, corners;
+      for (int k = 0; k < 27; ++k) {
+        const float3 d(float(k % 3) - 1.0f, float(k / 3 % 3) - 1.0f, float(k / 9) - 1.0f);
+        surface.push_back(k == 13 ? c : c + d.normalized() * s.w);
+      }
+      failures += classification_errors(v, surface, {}, v.planes.test_sphere(c, s.w));
+      surface.clear();
+      for (int k = 0; k < 27; ++k) {
+        const float3 p =
+            c + float3((float(k % 3) - 1.0f) * e.x, (float(k / 3 % 3) - 1.0f) * e.y, (float(k / 9) - 1.0f) * e.z);
+        surface.push_back(p);
+        if (k % 3 != 1 && k / 3 % 3 != 1 && k / 9 != 1) corners.push_back(p);
+      }
+      failures += classification_errors(v, surface, corners, v.planes.test_aabb(c, e));
+      // A point is a sphere of radius zero
+      const double margin = clip_margin(v.clip, c, v.depth);
+      const cull_result point = v.planes.test_sphere(c, 0.0f);
+      failures += (margin > 1e-4 && point != cull_result::inside) + (margin < -1e-4 && point != cull_result::outside);
+      samples += 3;
+    }
+  }
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "frustum planes", "-", samples, failures,
+              failures == 0 ? "ok" : "FAIL");
+  const bool ok = failures == 0;
+
+  // The batch functions against the member tests, object by object
+  return at_every_level([&](const char* level) {
+    size_t mismatches = 0;
+    std::vector<cull_result> classes(n);
+    std::vector<uint32_t> visible(n);
+    const size_t words = cull_mask_words(n);
+    std::vector<uint64_t> masks(views.size() * words);
+    std::vector<uint64_t*> rows;
+    std::vector<frustum> planes;
+    for (size_t v = 0; v < views.size(); ++v) {
+      rows.push_back(masks.data() + v * words);
+      planes.push_back(views[v].planes);
+    }
+
+    for (const cull_view& v : views) {
+      classify_spheres(v.planes, spheres, classes.data());
+      for (size_t i = 0; i < n; ++i) {
+        const float4 s = spheres.get(i);
+        mismatches += classes[i] != v.planes.test_sphere(float3(s.x, s.y, s.z), s.w);
+      }
+      size_t count = cull_spheres(v.planes, spheres, visible.data()), k = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (classes[i] != cull_result::outside) mismatches += k >= count || visible[k++] != i;
+      }
+      mismatches += k != count;
+
+      classify_aabbs(v.planes, centers, extents, classes.data());
+      for (size_t i = 0; i < n; ++i) mismatches += classes[i] != v.planes.test_aabb(centers.get(i), extents.get(i));
+      count = cull_aabbs(v.planes, centers, extents, visible.data());
+      k = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (classes[i] != cull_result::outside) mismatches += k >= count || visible[k++] != i;
+      }
+      mismatches += k != count;
+    }
+
+    cull_spheres(planes.data(), planes.size(), spheres, rows.data());
+    for (size_t v = 0; v < views.size(); ++v) {
+      for (size_t i = 0; i < n; ++i) {
+        const float4 s = spheres.get(i);
+        const bool expected = views[v].planes.test_sphere(float3(s.x, s.y, s.z), s.w) != cull_result::outside;
+        mismatches += expected != ((rows[v][i / 64] >> (i % 64)) & 1);
+      }
+    }
+    cull_aabbs(planes.data(), planes.size(), centers, extents, rows.data());
+    for (size_t v = 0; v < views.size(); ++v) {
+      for (size_t i = 0; i < n; ++i) {
+        const bool expected = views[v].planes.test_aabb(centers.get(i), extents.get(i)) != cull_result::outside;
+        mismatches += expected != ((rows[v][i / 64] >> (i % 64)) & 1);
+      }
+    }
+
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "frustum batch", level, 4 * views.size() * n, mismatches,
+                mismatches == 0 ? "ok" : "FAIL");
+    return mismatches == 0;
+  }) && ok;
+}
+
+bool check_bvh() {
+  // A soup of overlapping random triangles and an indexed heightfield with shared edges
+  std::vector<float3> soup(3 * 3000);
+  for (size_t i = 0; i < soup.size(); i += 3) {
+    const float3 c(uniform(-10, 10), uniform(-10, 10), uniform(-10, 10));
+    const float size = uniform(0, 1) < 0.1f ? 6.0f : 1.0f;
+    for (size_t k = 0; k < 3; ++k) {
+      soup[i + k] = c + float3(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+    }
+  }
+  constexpr uint32_t grid = 24;
+  std::vector<float3> terrain;
+  std::vector<uint32_t> indices;
+  for (uint32_t z = 0; z <= grid; ++z) {
+    for (uint32_t x = 0; x <= grid; ++x) {
+      terrain.push_back(float3(float(x), 2.0f * std::sin(x * 0.4f + z * 0.3f), float(z)));
+    }
+  }
+  for (uint32_t z = 0; z < grid; ++z) {
+    for (uint32_t x = 0; x < grid; ++x) {
+      const uint32_t i = z * (grid + 1) + x;
+      const uint32_t quad[6] = {i, i + 1, i + grid + 1, i + 1, i + grid + 2, i + grid + 1};
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+  }
+
+  // From outside and inside the scene, clipped windows, and axis-aligned directions whose
+  // slab tests divide by zero
+  const auto make_rays = [](const float3& lo, const float3& hi) {
+    std::vector<ray> rays(2000);
+    for (size_t i = 0; i < rays.size(); ++i) {
+      ray& r = rays[i];
+      r.origin = float3(uniform(lo.x, hi.x), uniform(lo.y, hi.y), uniform(lo.z, hi.z));
+      r.direction = float3(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1));
+      if (i % 5 == 1) r.direction = float3(0.0f, i % 2 ? -1.0f : 1.0f, 0.0f);
+      if (i % 5 == 2) r.direction = float3(uniform(-1, 1), 0.0f, 0.0f);
+      if (i % 7 == 3) {
+        r.t_min = uniform(0, 5);
+        r.t_max = r.t_min + uniform(0, 10);
+      }
+    }
+    return rays;
+  };
+  const std::vector<ray> soup_rays = make_rays(float3(-15, -15, -15), float3(15, 15, 15));
+  std::vector<ray> terrain_rays = make_rays(float3(-2, -3, -2), float3(grid + 2.0f, 5, grid + 2.0f));
+
+  size_t samples = 0, failures = 0;
+  bvh tree;
+  tree.build(soup.data(), nullptr, soup.size() / 3);
+  failures += bvh_errors(tree, soup_rays, soup, {}, samples);
+  tree.build(terrain.data(), indices.data(), indices.size() / 3);
+  failures += bvh_errors(tree, terrain_rays, terrain, indices, samples);
+
+  // Refit after the heightfield changed shape
+  for (float3& v : terrain) v.y = 3.0f * std::cos(v.x * 0.25f) * std::sin(v.z * 0.35f);
+  tree.refit(terrain.data(), indices.data());
+  failures += bvh_errors(tree, terrain_rays, terrain, indices, samples);
+
+  // Rays in the face planes of the boxes reach the edges and corners of axis-aligned quads
+  for (int axis = 0; axis < 3; ++axis) {
+    const face_scene faces(axis);
+    tree.build(faces.vertices.data(), nullptr, 2);
+    for (size_t i = 0; i < faces.rays.size(); ++i) {
+      ray_hit hit;
+      const bool found = tree.intersect(faces.rays[i], hit);
+      failures += found != faces.hits[i] || tree.occluded(faces.rays[i]) != faces.hits[i];
+      failures += found && hit.t != 1.0f;
+    }
+    samples += faces.rays.size();
+  }
+
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "bvh brute force", "-", samples, failures,
+              failures == 0 ? "ok" : "FAIL");
+  return failures == 0;
+}
+
+bool check_format() {
+  // The longest values, boundaries, specials and random bit patterns of every class
+  std::vector<float> floats = {0.0f, -0.0f, 1.0f / 3.0f, 0.1f, -1.17549435e-38f, 1.17549435e-38f, 1e-45f,
+                               3.40282347e38f, -3.40282347e38f, 16777217.0f, 123456789.0f, 9.999999e-5f,
+                               INFINITY, -INFINITY, NAN};
+  for (size_t i = 0; i < 40000; ++i) {
+    const uint32_t bits = uint32_t(rng()());
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    floats.push_back(v);
+  }
+  for (size_t i = 0; i < 10000; ++i) floats.push_back(uniform(-1000, 1000));
+  floats.resize(floats.size() / 16 * 16);
+  std::vector<double> doubles = {0.0, -2.2250738585072014e-308, 1.7976931348623157e308, 5e-324, 0.1, 1.0 / 3.0};
+  for (size_t i = 0; i < 30000; ++i) {
+    const uint64_t bits = uint64_t(rng()()) << 32 | rng()();
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    doubles.push_back(v);
+  }
+  doubles.resize(doubles.size() / 16 * 16);
+
+  size_t samples = 0, failures = 0;
+  const auto compare = [&](const auto& parsed, const auto* expected, size_t n) {
+    samples += n;
+    failures += parsed.size() != n;
+    for (size_t i = 0; i < std::min(n, parsed.size()); ++i) failures += !same_value(parsed[i], expected[i]);
+  };
+
+  // Tuples and row blocks parse back to the same bits, within the documented lengths
+  for (size_t i = 0; i < floats.size(); i += 16) {
+    const float* v = &floats[i];
+    compare(parse_numbers<float>(chars(float4(v[0], v[1], v[2], v[3]))), v, 4);
+    const matrix4x4 m(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10], v[11], v[12], v[13], v[14],
+                      v[15]);
+    compare(parse_numbers<float>(chars(m)), v, 16);
+    for (size_t k = 0; k < 16; ++k) {
+      char buffer[32];
+      const size_t length = size_t(format_tuple(buffer, buffer + sizeof(buffer), "", v + k, 1).ptr - buffer);
+      failures += length > 2 + FORMAT_FLOAT_CHARS;
+    }
+  }
+  for (size_t i = 0; i < doubles.size(); i += 16) {
+    const double* v = &doubles[i];
+    compare(parse_numbers<double>(chars(double3(v[0], v[1], v[2]))), v, 3);
+    dmatrix4x4 m;
+    std::memcpy(m.m, v, sizeof(m.m));
+    const std::string text = chars(m);
+    compare(parse_numbers<double>(text), v, 16);
+    failures += text != m.to_string() || text.size() >= TO_STRING_BUFFER_SIZE;
+    for (size_t k = 0; k < 16; ++k) {
+      char buffer[32];
+      const size_t length = size_t(format_tuple(buffer, buffer + sizeof(buffer), "", v + k, 1).ptr - buffer);
+      failures += length > 2 + FORMAT_DOUBLE_CHARS;
+    }
+  }
+
+  // Every buffer short of the full text fails with ptr at last, the exact size succeeds
+  const matrix4x4 longest(-1.17549435e-38f, -3.40282347e38f, -1.17549435e-38f, -1.17549435e-38f, -1.17549435e-38f,
+                          -1.17549435e-38f, -1.17549435e-38f, -1.17549435e-38f, -1.17549435e-38f, -1.17549435e-38f,
+                          -1.17549435e-38f, -1.17549435e-38f, -1.17549435e-38f, -1.17549435e-38f, -1.17549435e-38f,
+                          -1.17549435e-38f);
+  const std::string full = chars(longest);
+  for (size_t size = 0; size <= full.size(); ++size) {
+    char buffer[TO_STRING_BUFFER_SIZE];
+    const std::to_chars_result r = longest.to_chars(buffer, buffer + size);
+    failures += size < full.size() ? r.ec != std::errc::value_too_large || r.ptr != buffer + size
+                                   : r.ec != std::errc() || std::string(buffer, r.ptr) != full;
+    ++samples;
+  }
+
+  // Bulk CSV keeps every value, JSON writes the non-finite ones as null
+  const size_t count = floats.size() / 3;
+  std::string text;
+  write_text(text, reinterpret_cast<const float3*>(floats.data()), count, text_format::csv);
+  compare(parse_numbers<float>(text), floats.data(), 3 * count);
+  std::vector<float> finite(floats.begin(), floats.begin() + 3 * count);
+  for (float& v : finite) v = std::isfinite(v) ? v : NAN;
+  text.clear();
+  write_text(text, reinterpret_cast<const float3*>(floats.data()), count, text_format::json);
+  compare(parse_numbers<float>(text), finite.data(), 3 * count);
+
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "to_chars", "-", samples, failures,
+              failures == 0 ? "ok" : "FAIL");
+  return failures == 0;
+}
+
+} // namespace cgmath::bench
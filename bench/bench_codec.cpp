@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+// Vertex codecs: batch encode/decode against the scalar members, and the round-trip error
+// check behind the table in vertex_codec.h
+
+namespace cgmath::bench {
+
+namespace {
+
+// Elements per batch run, as in bench_batch.cpp
+constexpr size_t ELEMENT_COUNT = 16384;
+
+// Accuracy samples per codec and kernel level
+constexpr size_t SAMPLE_COUNT = size_t(1) << 20;
+
+std::vector<float3> unit_vectors(size_t n) {
+  std::vector<float3> v;
+  // The axes, diagonals and signed zeros hit the fold edges of the octahedron
+  for (float x : {-1.0f, -0.0f, 0.0f, 1.0f}) {
+    for (float y : {-1.0f, -0.0f, 0.0f, 1.0f}) {
+      for (float z : {-1.0f, -0.0f, 0.0f, 1.0f}) {
+        if (x != 0.0f || y != 0.0f || z != 0.0f) v.push_back(float3(x, y, z).normalized());
+      }
+    }
+  }
+  while (v.size() < n) {
+    float3 p = {uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)};
+    float l = p.length();
+    if (l > 0.01f && l <= 1.0f) v.push_back(p / l);
+  }
+  return v;
+}
+
+std::vector<quaternion> unit_quaternions(size_t n) {
+  std::vector<quaternion> v = {quaternion(0, 0, 0, 1), quaternion(0, 0, 0, -1), quaternion(1, 0, 0, 0),
+                               quaternion(0.5f, 0.5f, 0.5f, 0.5f), quaternion(-0.5f, 0.5f, -0.5f, 0.5f)};
+  while (v.size() < n) {
+    quaternion q(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1), uniform(-1, 1));
+    if (q.length() > 0.01f) v.push_back(q.normalized());
+  }
+  return v;
+}
+
+double angle_degrees(const float3& a, const float3& b) {
+  const double x = double(a.y) * b.z - double(a.z) * b.y;
+  const double y = double(a.z) * b.x - double(a.x) * b.z;
+  const double z = double(a.x) * b.y - double(a.y) * b.x;
+  const double d = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+  return std::atan2(std::sqrt(x * x + y * y + z * z), d) * (180.0 / 3.14159265358979323846);
+}
+
+// Worst round-trip error of one codec at one kernel level, plus how many batch results
+// differ from the scalar members: encodings must match bit for bit, decodings within
+// a few ULP (the kernels may contract to FMA)
+struct codec_accuracy {
+  std::string name;
+  double bound;
+  const char* unit;
+  double worst = 0.0;
+  size_t samples = 0;
+  size_t encode_mismatches = 0;
+  size_t decode_mismatches = 0;
+
+  void add(double e) {
+    ++samples;
+    if (e > worst || e != e) worst = e;
+  }
+
+  void compare(float got, float scalar) {
+    if (!(std::fabs(got - scalar) <= 4.0f * 1.1920929e-7f * std::fmax(std::fabs(scalar), 1.0f))) ++decode_mismatches;
+  }
+
+  bool report(cpu_isa isa) const {
+    bool ok = worst <= bound && encode_mismatches == 0 && decode_mismatches == 0;
+    std::printf("%-12s %-7s %8zu samples  max %9.3g %-7s bound %7.3g  mismatches %zu / %zu  %s\n", name.c_str(),
+                isa_name(isa), samples, worst, unit, bound, encode_mismatches, decode_mismatches, ok ? "ok" : "FAIL");
+    return ok;
+  }
+};
+
+template <typename Code>
+bool same_bits(const Code& a, const Code& b) {
+  return std::memcmp(&a, &b, sizeof(Code)) == 0;
+}
+
+template <typename Oct>
+bool check_octahedral(const std::string& name, double bound, const std::vector<float3>& in, cpu_isa isa) {
+  std::vector<Oct> codes(in.size());
+  std::vector<float3> out(in.size());
+  encode(in.data(), codes.data(), in.size());
+  decode(codes.data(), out.data(), in.size());
+
+  codec_accuracy a{name, bound, "degrees"};
+  for (size_t i = 0; i < in.size(); ++i) {
+    const float3 scalar = codes[i].decode();
+    if (!same_bits(codes[i], Oct::encode(in[i]))) ++a.encode_mismatches;
+    a.compare(out[i].x, scalar.x);
+    a.compare(out[i].y, scalar.y);
+    a.compare(out[i].z, scalar.z);
+    a.add(angle_degrees(in[i], out[i]));
+  }
+  return a.report(isa);
+}
+
+// Error in quantization steps of the bounds: half a step, plus the rounding of the float
+// reciprocal scale near the far end of the range
+template <typename Q>
+bool check_fixed3(const std::string& name, bool is_signed, float steps, const std::vector<float3>& in,
+                  const quantization_bounds& b, cpu_isa isa) {
+  std::vector<Q> codes(in.size());
+  std::vector<float3> out(in.size());
+  encode(in.data(), b, codes.data(), in.size());
+  decode(codes.data(), b, out.data(), in.size());
+
+  float3 offset, scale;
+  b.decode_transform(is_signed, steps, offset, scale);
+  const float s[3] = {scale.x, scale.y, scale.z};
+  codec_accuracy a{name, 0.505, "steps"};
+  for (size_t i = 0; i < in.size(); ++i) {
+    const float3 scalar = codes[i].decode(b);
+    if (!same_bits(codes[i], Q::encode(in[i], b))) ++a.encode_mismatches;
+    a.compare(out[i].x, scalar.x);
+    a.compare(out[i].y, scalar.y);
+    a.compare(out[i].z, scalar.z);
+    const float p[3] = {in[i].x, in[i].y, in[i].z}, q[3] = {out[i].x, out[i].y, out[i].z};
+    double e = 0.0;
+    for (int k = 0; k < 3; ++k) {
+      // Less the rounding of the decoded float itself, which is coarser than a step far from the origin
+      const double ulp = std::nextafter(std::fabs(q[k]), INFINITY) - std::fabs(q[k]);
+      const double d = std::fmax(std::fabs(double(q[k]) - p[k]) - ulp, 0.0);
+      e = std::fmax(e, s[k] > 0.0f ? d / s[k] : std::fabs(q[k] - p[k]));
+    }
+    a.add(e);
+  }
+  return a.report(isa);
+}
+
+bool check_quaternions(const std::vector<quaternion>& in, cpu_isa isa) {
+  std::vector<packed_quaternion> codes(in.size());
+  std::vector<quaternion> out(in.size());
+  encode(in.data(), codes.data(), in.size());
+  decode(codes.data(), out.data(), in.size());
+
+  codec_accuracy a{"quaternion", 2.1e-3, "abs"};
+  for (size_t i = 0; i < in.size(); ++i) {
+    const quaternion scalar = codes[i].decode();
+    if (!same_bits(codes[i], packed_quaternion::encode(in[i]))) ++a.encode_mismatches;
+    const auto& g = out[i].v.vec;
+    const auto& r = in[i].v.vec;
+    a.compare(g.x, scalar.v.vec.x);
+    a.compare(g.y, scalar.v.vec.y);
+    a.compare(g.z, scalar.v.vec.z);
+    a.compare(g.w, scalar.v.vec.w);
+    // q and -q are the same rotation; the encoding may pick either
+    const float sign = out[i].dot(in[i]) < 0.0f ? -1.0f : 1.0f;
+    double e = std::fabs(g.x * sign - r.x);
+    e = std::fmax(e, std::fabs(g.y * sign - r.y));
+    e = std::fmax(e, std::fabs(g.z * sign - r.z));
+    e = std::fmax(e, std::fabs(g.w * sign - r.w));
+    a.add(e);
+  }
+  return a.report(isa);
+}
+
+// Colors slightly outside [0, 1] as well, compared with the clamped input
+bool check_rgb10a2(const std::vector<float4>& in, cpu_isa isa) {
+  std::vector<rgb10a2> codes(in.size());
+  std::vector<float4> out(in.size());
+  encode(in.data(), codes.data(), in.size());
+  decode(codes.data(), out.data(), in.size());
+
+  codec_accuracy a{"rgb10a2", 0.501, "steps"};
+  for (size_t i = 0; i < in.size(); ++i) {
+    const float4 scalar = codes[i].decode();
+    if (!same_bits(codes[i], rgb10a2::encode(in[i]))) ++a.encode_mismatches;
+    a.compare(out[i].x, scalar.x);
+    a.compare(out[i].y, scalar.y);
+    a.compare(out[i].z, scalar.z);
+    a.compare(out[i].w, scalar.w);
+    const float p[4] = {in[i].x, in[i].y, in[i].z, in[i].w}, q[4] = {out[i].x, out[i].y, out[i].z, out[i].w};
+    double e = 0.0;
+    for (int k = 0; k < 4; ++k) {
+      const double steps = k < 3 ? 1023.0 : 3.0;
+      e = std::fmax(e, std::fabs(double(q[k]) - std::fmin(std::fmax(p[k], 0.0f), 1.0f)) * steps);
+    }
+    a.add(e);
+  }
+  return a.report(isa);
+}
+
+template <typename Encode>
+void codec_batch(const std::string& name, Encode encode_run) {
+  add(name, "batch", ELEMENT_COUNT, [encode_run](size_t iterations) mutable {
+    for (size_t i = 0; i < iterations; ++i) encode_run();
+  });
+}
+
+} // namespace
+
+void register_codec() {
+  struct data {
+    std::vector<float3> normals = unit_vectors(ELEMENT_COUNT);
+    std::vector<float3> positions = random_values<float3>(ELEMENT_COUNT);
+    std::vector<quaternion> rotations = unit_quaternions(ELEMENT_COUNT);
+    std::vector<float4> colors = std::vector<float4>(ELEMENT_COUNT);
+    std::vector<float3> out3 = std::vector<float3>(ELEMENT_COUNT);
+    std::vector<float4> out4 = std::vector<float4>(ELEMENT_COUNT);
+    std::vector<quaternion> out_rotations = std::vector<quaternion>(ELEMENT_COUNT);
+    std::vector<oct16> o16 = std::vector<oct16>(ELEMENT_COUNT);
+    std::vector<oct24> o24 = std::vector<oct24>(ELEMENT_COUNT);
+    std::vector<oct32> o32 = std::vector<oct32>(ELEMENT_COUNT);
+    std::vector<unorm16x3> u16 = std::vector<unorm16x3>(ELEMENT_COUNT);
+    std::vector<snorm16x3> s16 = std::vector<snorm16x3>(ELEMENT_COUNT);
+    std::vector<snorm8x3> s8 = std::vector<snorm8x3>(ELEMENT_COUNT);
+    std::vector<packed_quaternion> packed = std::vector<packed_quaternion>(ELEMENT_COUNT);
+    std::vector<rgb10a2> rgb = std::vector<rgb10a2>(ELEMENT_COUNT);
+    quantization_bounds bounds;
+  };
+  auto d = std::make_shared<data>();
+  for (float4& c : d->colors) c = {uniform(0, 1), uniform(0, 1), uniform(0, 1), uniform(0, 1)};
+  d->bounds = quantization_bounds::of(d->positions.data(), ELEMENT_COUNT);
+  encode(d->normals.data(), d->o16.data(), ELEMENT_COUNT);
+  encode(d->normals.data(), d->o24.data(), ELEMENT_COUNT);
+  encode(d->normals.data(), d->o32.data(), ELEMENT_COUNT);
+  encode(d->positions.data(), d->bounds, d->u16.data(), ELEMENT_COUNT);
+  encode(d->positions.data(), d->bounds, d->s16.data(), ELEMENT_COUNT);
+  encode(d->positions.data(), d->bounds, d->s8.data(), ELEMENT_COUNT);
+  encode(d->rotations.data(), d->packed.data(), ELEMENT_COUNT);
+  encode(d->colors.data(), d->rgb.data(), ELEMENT_COUNT);
+
+  const auto n = ELEMENT_COUNT;
+  codec_batch("codec/oct16_encode", [d, n] { encode(d->normals.data(), d->o16.data(), n); do_not_optimize(d->o16[0]); });
+  codec_batch("codec/oct16_encode_naive", [d, n] {
+    for (size_t j = 0; j < n; ++j) d->o16[j] = oct16::encode(d->normals[j]);
+    do_not_optimize(d->o16[0]);
+  });
+  codec_batch("codec/oct16_decode", [d, n] { decode(d->o16.data(), d->out3.data(), n); do_not_optimize(d->out3[0]); });
+  codec_batch("codec/oct16_decode_naive", [d, n] {
+    for (size_t j = 0; j < n; ++j) d->out3[j] = d->o16[j].decode();
+    do_not_optimize(d->out3[0]);
+  });
+  codec_batch("codec/oct24_encode", [d, n] { encode(d->normals.data(), d->o24.data(), n); do_not_optimize(d->o24[0]); });
+  codec_batch("codec/oct24_decode", [d, n] { decode(d->o24.data(), d->out3.data(), n); do_not_optimize(d->out3[0]); });
+  codec_batch("codec/oct32_encode", [d, n] { encode(d->normals.data(), d->o32.data(), n); do_not_optimize(d->o32[0]); });
+  codec_batch("codec/oct32_decode", [d, n] { decode(d->o32.data(), d->out3.data(), n); do_not_optimize(d->out3[0]); });
+
+  codec_batch("codec/unorm16_encode", [d, n] {
+    encode(d->positions.data(), d->bounds, d->u16.data(), n);
+    do_not_optimize(d->u16[0]);
+  });
+  codec_batch("codec/unorm16_encode_naive", [d, n] {
+    for (size_t j = 0; j < n; ++j) d->u16[j] = unorm16x3::encode(d->positions[j], d->bounds);
+    do_not_optimize(d->u16[0]);
+  });
+  codec_batch("codec/unorm16_decode", [d, n] {
+    decode(d->u16.data(), d->bounds, d->out3.data(), n);
+    do_not_optimize(d->out3[0]);
+  });
+  codec_batch("codec/unorm16_decode_naive", [d, n] {
+    for (size_t j = 0; j < n; ++j) d->out3[j] = d->u16[j].decode(d->bounds);
+    do_not_optimize(d->out3[0]);
+  });
+  codec_batch("codec/snorm16_decode", [d, n] {
+    decode(d->s16.data(), d->bounds, d->out3.data(), n);
+    do_not_optimize(d->out3[0]);
+  });
+  codec_batch("codec/snorm8_encode", [d, n] {
+    encode(d->positions.data(), d->bounds, d->s8.data(), n);
+    do_not_optimize(d->s8[0]);
+  });
+  codec_batch("codec/snorm8_decode", [d, n] {
+    decode(d->s8.data(), d->bounds, d->out3.data(), n);
+    do_not_optimize(d->out3[0]);
+  });
+
+  codec_batch("codec/quaternion_encode", [d, n] {
+    encode(d->rotations.data(), d->packed.data(), n);
+    do_not_optimize(d->packed[0]);
+  });
+  codec_batch("codec/quaternion_encode_naive", [d, n] {
+    for (size_t j = 0; j < n; ++j) d->packed[j] = packed_quaternion::encode(d->rotations[j]);
+    do_not_optimize(d->packed[0]);
+  });
+  codec_batch("codec/quaternion_decode", [d, n] {
+    decode(d->packed.data(), d->out_rotations.data(), n);
+    do_not_optimize(d->out_rotations[0]);
+  });
+  codec_batch("codec/quaternion_decode_naive", [d, n] {
+    for (size_t j = 0; j < n; ++j) d->out_rotations[j] = d->packed[j].decode();
+    do_not_optimize(d->out_rotations[0]);
+  });
+
+  codec_batch("codec/rgb10a2_encode", [d, n] { encode(d->colors.data(), d->rgb.data(), n); do_not_optimize(d->rgb[0]); });
+  codec_batch("codec/rgb10a2_decode", [d, n] { decode(d->rgb.data(), d->out4.data(), n); do_not_optimize(d->out4[0]); });
+  codec_batch("codec/rgb10a2_decode_naive", [d, n] {
+    for (size_t j = 0; j < n; ++j) d->out4[j] = d->rgb[j].decode();
+    do_not_optimize(d->out4[0]);
+  });
+}
+
+bool check_codec_accuracy() {
+  // The bounds match the table in vertex_codec.h
+  const std::vector<float3> normals = unit_vectors(SAMPLE_COUNT);
+  const std::vector<quaternion> rotations = unit_quaternions(SAMPLE_COUNT);
+
+  // A mesh far from the origin with one nearly flat axis, and a box with an exactly flat one
+  std::vector<float3> mesh(SAMPLE_COUNT), flat(SAMPLE_COUNT);
+  for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+    mesh[i] = {uniform(-50, 50) + 1000.0f, uniform(-3, 3), uniform(-0.01f, 0.01f) - 20.0f};
+    flat[i] = {uniform(0, 1), 7.0f, uniform(-1, 0)};
+  }
+  const quantization_bounds mesh_bounds = quantization_bounds::of(mesh.data(), mesh.size());
+  const quantization_bounds flat_bounds = quantization_bounds::of(flat.data(), flat.size());
+
+  std::vector<float4> colors(SAMPLE_COUNT);
+  for (float4& c : colors) c = {uniform(-0.1f, 1.1f), uniform(0, 1), uniform(0, 1), uniform(-0.1f, 1.1f)};
+
+  bool ok = true;
+  const cpu_isa host = active_isa();
+  for (cpu_isa isa : {cpu_isa::scalar, cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+    if (set_isa(isa) != isa) continue;
+    ok = check_octahedral<oct16>("oct16", 1.0, normals, isa) && ok;
+    ok = check_octahedral<oct24>("oct24", 0.062, normals, isa) && ok;
+    ok = check_octahedral<oct32>("oct32", 0.0039, normals, isa) && ok;
+    ok = check_fixed3<unorm16x3>("unorm16", false, 65535.0f, mesh, mesh_bounds, isa) && ok;
+    ok = check_fixed3<snorm16x3>("snorm16", true, 32767.0f, mesh, mesh_bounds, isa) && ok;
+    ok = check_fixed3<snorm8x3>("snorm8", true, 127.0f, mesh, mesh_bounds, isa) && ok;
+    ok = check_fixed3<unorm16x3>("unorm16 flat", false, 65535.0f, flat, flat_bounds, isa) && ok;
+    ok = check_quaternions(rotations, isa) && ok;
+    ok = check_rgb10a2(colors, isa) && ok;
+  }
+  set_isa(host);
+  return ok;
+}
+
+} // namespace cgmath::bench
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+// 3x3 eigen-decomposition, SVD and polar decomposition, one matrix per call and over SoA
+// streams of 16384 matrices. The --accuracy part checks the factors of random and degenerate
+// matrices at every kernel level.
+
+namespace cgmath::bench {
+
+namespace {
+
+constexpr size_t MATRIX_COUNT = 16384;
+
+struct matrix3x3_soa {
+  soa_stream m[9];
+
+  explicit matrix3x3_soa(size_t n) {
+    for (soa_stream& s : m) s.resize(n);
+  }
+
+  explicit matrix3x3_soa(const std::vector<matrix3x3>& in) : matrix3x3_soa(in.size()) {
+    for (size_t i = 0; i < in.size(); ++i) {
+      for (size_t k = 0; k < 9; ++k) m[k][i] = in[i].m[k / 3][k % 3];
+    }
+  }
+
+  matrix3x3 get(size_t i) const {
+    matrix3x3 r;
+    for (size_t k = 0; k < 9; ++k) r.m[k / 3][k % 3] = m[k][i];
+    return r;
+  }
+
+  matrix3x3_soa_view view() {
+    matrix3x3_soa_view v;
+    for (size_t k = 0; k < 9; ++k) v.m[k] = m[k].data();
+    v.size = m[0].size();
+    return v;
+  }
+
+  const_matrix3x3_soa_view const_view() const {
+    const_matrix3x3_soa_view v;
+    for (size_t k = 0; k < 9; ++k) v.m[k] = m[k].data();
+    v.size = m[0].size();
+    return v;
+  }
+};
+
+} // namespace
+
+void register_decomposition() {
+  unary<matrix3x3>("matrix3x3/eigen_symmetric", [](const matrix3x3& m) { return eigen_symmetric(m).values; });
+  unary<matrix3x3>("matrix3x3/svd", [](const matrix3x3& m) { return svd(m).sigma; });
+  unary<matrix3x3>("matrix3x3/polar", [](const matrix3x3& m) { return polar(m).rotation; });
+
+  struct data {
+    matrix3x3_soa in = matrix3x3_soa(random_values<matrix3x3>(MATRIX_COUNT));
+    matrix3x3_soa a = matrix3x3_soa(MATRIX_COUNT);
+    matrix3x3_soa b = matrix3x3_soa(MATRIX_COUNT);
+    float3_soa values = float3_soa(MATRIX_COUNT);
+  };
+  auto d = std::make_shared<data>();
+  add("decomposition/eigen_symmetric_soa", "batch", MATRIX_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      eigen_symmetric(d->in.const_view(), d->values, d->a.view());
+      do_not_optimize(d->values.x[0]);
+    }
+  });
+  add("decomposition/svd_soa", "batch", MATRIX_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      svd(d->in.const_view(), d->a.view(), d->values, d->b.view());
+      do_not_optimize(d->values.x[0]);
+    }
+  });
+  add("decomposition/polar_soa", "batch", MATRIX_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      polar(d->in.const_view(), d->a.view(), d->b.view());
+      do_not_optimize(d->a.m[0][0]);
+    }
+  });
+}
+
+namespace {
+
+// Residuals in double, relative to the largest entry of the input
+double max_entry(const matrix3x3& m) {
+  double r = 0.0;
+  for (int i = 0; i < 9; ++i) r = std::fmax(r, std::fabs(m.m[i / 3][i % 3]));
+  return r;
+}
+
+// |a * diag(d) * b^T - m| / scale
+double product_error(const matrix3x3& a, const float3& d, const matrix3x3& b, const matrix3x3& m, double scale) {
+  const double w[3] = {d.x, d.y, d.z};
+  double e = 0.0;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      double x = 0.0;
+      for (int k = 0; k < 3; ++k) x += double(a.m[r][k]) * w[k] * b.m[c][k];
+      e = std::fmax(e, std::fabs(x - m.m[r][c]));
+    }
+  }
+  return scale > 0.0 ? e / scale : e;
+}
+
+// |m^T m - I| and |det(m) - 1|
+double rotation_error(const matrix3x3& m) {
+  double e = 0.0;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      double x = 0.0;
+      for (int k = 0; k < 3; ++k) x += double(m.m[k][r]) * m.m[k][c];
+      e = std::fmax(e, std::fabs(x - (r == c ? 1.0 : 0.0)));
+    }
+  }
+  return std::fmax(e, std::fabs(double(m.determinant()) - 1.0));
+}
+
+std::vector<matrix3x3> test_matrices() {
+  std::vector<matrix3x3> m;
+  m.push_back(matrix3x3());
+  m.push_back(matrix3x3(1, 0, 0, 0, 1, 0, 0, 0, 1));
+  m.push_back(matrix3x3(-1, 0, 0, 0, 1, 0, 0, 0, 1));
+  m.push_back(matrix3x3(2, 0, 0, 0, 2, 0, 0, 0, -3));
+  m.push_back(matrix3x3(0, 0, 5, 0, 3, 0, 1, 0, 0));
+  m.push_back(matrix3x3(1, 2, 3, 2, 4, 6, 3, 6, 9));                  // rank 1
+  m.push_back(matrix3x3(1, 2, 3, 4, 5, 6, 7, 8, 9));                  // rank 2
+  m.push_back(matrix3x3(1, 1e-4f, 0, 0, 1, 1e-4f, 0, 0, 1));          // nearly repeated
+  m.push_back(matrix3x3(1e-20f, 0, 0, 0, 2e-20f, 0, 0, 0, 3e-20f));
+  m.push_back(matrix3x3(1e18f, 2e18f, 0, 0, 1e18f, 0, 3e18f, 0, 1e18f));
+  for (size_t i = 0; i < 20000; ++i) {
+    matrix3x3 a;
+    for (int k = 0; k < 9; ++k) a.m[k / 3][k % 3] = uniform(-1, 1);
+    if (i % 4 == 1) a = a * 1e3f;
+    if (i % 4 == 2) {
+      // Stretched rotations, as deformation gradients are
+      const matrix3x3 q = random_values<quaternion>(1)[0].to_matrix3x3();
+      const matrix3x3 s(uniform(0.5f, 2), 0, 0, 0, uniform(0.5f, 2), 0, 0, 0, uniform(0.5f, 2));
+      a = q * s;
+    }
+    if (i % 4 == 3) a.m[2][0] = a.m[2][1] = a.m[2][2] = 0.0f;  // rank 2
+    m.push_back(a);
+  }
+  return m;
+}
+
+struct decomposition_errors {
+  double product = 0.0, rotation = 0.0, order = 0.0;
+
+  void add(double p, double r, bool ordered) {
+    product = std::fmax(product, p);
+    rotation = std::fmax(rotation, r);
+    order += ordered ? 0.0 : 1.0;
+  }
+
+  bool report(const char* name, const char* level, size_t samples) const {
+    const double bound = 1e-5;
+    const bool ok = product <= bound && rotation <= bound && order == 0.0;
+    std::printf("%-18s %-7s %8zu samples  product %9.3g  rotation %9.3g  bound %7.3g  unordered %g  %s\n", name, level,
+                samples, product, rotation, bound, order, ok ? "ok" : "FAIL");
+    return ok;
+  }
+};
+
+bool check_level(const std::vector<matrix3x3>& in, const char* level) {
+  const size_t n = in.size();
+  const matrix3x3_soa m(in);
+  matrix3x3_soa a(n), b(n);
+  float3_soa v(n);
+  bool ok = true;
+
+  // Eigen-decomposition of m + m^T
+  std::vector<matrix3x3> sym(n);
+  for (size_t i = 0; i < n; ++i) sym[i] = in[i] + in[i].transpose();
+  eigen_symmetric(matrix3x3_soa(sym).const_view(), v, a.view());
+  decomposition_errors e;
+  for (size_t i = 0; i < n; ++i) {
+    const float3 w(v.x[i], v.y[i], v.z[i]);
+    const matrix3x3 vectors = a.get(i);
+    e.add(product_error(vectors, w, vectors, sym[i], max_entry(sym[i])), rotation_error(vectors),
+          w.x >= w.y && w.y >= w.z);
+  }
+  ok = e.report("eigen_symmetric", level, n) && ok;
+
+  svd(m.const_view(), a.view(), v, b.view());
+  e = {};
+  for (size_t i = 0; i < n; ++i) {
+    const float3 s(v.x[i], v.y[i], v.z[i]);
+    const matrix3x3 u = a.get(i), w = b.get(i);
+    const double scale = max_entry(in[i]), det = in[i].determinant();
+    const bool sign = std::fabs(det) <= 1e-4 * scale * scale * scale || (s.z < 0.0f) == (det < 0.0);
+    e.add(product_error(u, s, w, in[i], scale), std::fmax(rotation_error(u), rotation_error(w)),
+          s.x >= s.y && s.y >= std::fabs(s.z) && sign);
+  }
+  ok = e.report("svd", level, n) && ok;
+
+  polar(m.const_view(), a.view(), b.view());
+  e = {};
+  for (size_t i = 0; i < n; ++i) {
+    const matrix3x3 r = a.get(i), s = b.get(i);
+    double p = max_entry(r * s - in[i]);
+    const double scale = max_entry(in[i]);
+    const bool symmetric = s.m[0][1] == s.m[1][0] && s.m[0][2] == s.m[2][0] && s.m[1][2] == s.m[2][1];
+    e.add(scale > 0.0 ? p / scale : p, rotation_error(r), symmetric);
+  }
+  ok = e.report("polar", level, n) && ok;
+  return ok;
+}
+
+} // namespace
+
+bool check_decomposition() {
+  const std::vector<matrix3x3> in = test_matrices();
+  bool ok = true;
+
+  // Single calls against the factors' identities
+  decomposition_errors e;
+  for (const matrix3x3& m : in) {
+    const svd3 s = svd(m);
+    e.add(product_error(s.u, s.sigma, s.v, m, max_entry(m)), std::fmax(rotation_error(s.u), rotation_error(s.v)),
+          s.sigma.x >= s.sigma.y && s.sigma.y >= std::fabs(s.sigma.z));
+  }
+  ok = e.report("svd single", "-", in.size()) && ok;
+
+  const cpu_isa host = active_isa();
+  for (cpu_isa isa : {cpu_isa::scalar, cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+    if (set_isa(isa) != isa) continue;
+    ok = check_level(in, isa_name(isa)) && ok;
+  }
+  set_isa(host);
+  return ok;
+}
+
+} // namespace cgmath::bench
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+#include "fast_math.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace cgmath::bench {
+
+namespace {
+
+template <typename V> V load(const float* p) noexcept;
+template <> float load<float>(const float* p) noexcept { return *p; }
+template <typename V> void store(float* p, V v) noexcept;
+template <> void store<float>(float* p, float v) noexcept { *p = v; }
+#ifdef __SSE2__
+template <> __m128 load<__m128>(const float* p) noexcept { return _mm_loadu_ps(p); }
+template <> void store<__m128>(float* p, __m128 v) noexcept { _mm_storeu_ps(p, v); }
+#endif
+#ifdef __AVX2__
+template <> __m256 load<__m256>(const float* p) noexcept { return _mm256_loadu_ps(p); }
+template <> void store<__m256>(float* p, __m256 v) noexcept { _mm256_storeu_ps(p, v); }
+#endif
+
+// INPUT_COUNT values of x in [lo, hi) and y in [-1, 1), mapped a register of V at a time
+template <typename V, typename Op>
+void math_batch(const std::string& name, float lo, float hi, Op op) {
+  constexpr size_t width = sizeof(V) / sizeof(float);
+  std::vector<float> x(INPUT_COUNT), y(INPUT_COUNT), out(INPUT_COUNT);
+  for (float& v : x) v = uniform(lo, hi);
+  for (float& v : y) v = uniform(-1.0f, 1.0f);
+  add(name, "batch", INPUT_COUNT, [x, y, out, op](size_t iterations) mutable {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < INPUT_COUNT; j += width) store<V>(out.data() + j, op(load<V>(y.data() + j), load<V>(x.data() + j)));
+      do_not_optimize(out.data());
+    }
+  });
+}
+
+// math/<fn>_libm against math/<fn>_fast and the 4- and 8-wide forms; op(y, x) ignores y
+// except for atan2
+template <typename Libm, typename Fast>
+void math(const std::string& fn, float lo, float hi, Libm libm, Fast fast) {
+  math_batch<float>("math/" + fn + "_libm", lo, hi, libm);
+  math_batch<float>("math/" + fn + "_fast", lo, hi, fast);
+#ifdef __SSE2__
+  math_batch<__m128>("math/" + fn + "_fast4", lo, hi, fast);
+#endif
+#ifdef __AVX2__
+  math_batch<__m256>("math/" + fn + "_fast8", lo, hi, fast);
+#endif
+}
+
+// Accuracy against libm in double precision, in units in the last place of the float result
+
+double ulp_of(double ref) {
+  if (!std::isfinite(ref)) return 1.0;
+  double a = std::fabs(ref);
+  int e = a < 1.17549435e-38 ? -126 : std::ilogb(a);
+  if (e < -126) e = -126;
+  return std::ldexp(1.0, e - 23);
+}
+
+double ulp_error(float got, double ref) {
+  if (std::isnan(ref)) return std::isnan(got) ? 0.0 : INFINITY;
+  if (std::isinf(ref) || std::isinf(got)) {
+    // Overflow boundary: a float that rounds to inf is exact
+    if (static_cast<float>(ref) == got) return 0.0;
+    return INFINITY;
+  }
+  return std::fabs(got - ref) / ulp_of(ref);
+}
+
+// Worst error over the samples, in ULP or as an absolute difference
+struct accuracy {
+  std::string name;
+  double bound;
+  bool absolute;
+  double worst = 0.0;
+  float worst_x = 0.0f, worst_y = 0.0f;
+  size_t samples = 0;
+
+  void add(float got, double ref, float x, float y = 0.0f) {
+    double e = absolute ? std::fabs(got - ref) : ulp_error(got, ref);
+    ++samples;
+    if (e > worst || e != e) {
+      worst = e;
+      worst_x = x;
+      worst_y = y;
+    }
+  }
+
+  bool report() const {
+    bool ok = worst <= bound;
+    std::printf("%-10s %10zu samples  max %9.3g %s  bound %7.3g  at (%.9g, %.9g)  %s\n", name.c_str(), samples, worst,
+                absolute ? "abs" : "ULP", bound, worst_x, worst_y, ok ? "ok" : "FAIL");
+    return ok;
+  }
+};
+
+// Checks every width compiled in over the same inputs; width 1 goes through the float overload.
+// fast(lane) maps a register of inputs, the lane count follows from its type.
+template <typename Fast>
+bool check_widths(const std::string& name, double bound, bool absolute, size_t count, const std::vector<double>& expected,
+                  const float* xs, const float* ys, Fast fast) {
+  bool ok = true;
+  auto run = [&](auto zero, size_t width, const char* suffix) {
+    accuracy acc{name + suffix, bound, absolute};
+    for (size_t i = 0; i + width <= count; i += width) {
+      float r[8];
+      fast(zero, xs + i, ys ? ys + i : nullptr, r);
+      for (size_t k = 0; k < width; ++k) acc.add(r[k], expected[i + k], xs[i + k], ys ? ys[i + k] : 0.0f);
+    }
+    ok = acc.report() && ok;
+  };
+  run(0.0f, 1, "");
+#ifdef __SSE2__
+  run(_mm_setzero_ps(), 4, " x4");
+#endif
+#ifdef __AVX2__
+  run(_mm256_setzero_ps(), 8, " x8");
+#endif
+  return ok;
+}
+
+template <typename Fast, typename Ref>
+bool check_unary(const char* name, double bound, const std::vector<float>& xs, Fast fast, Ref ref, bool absolute = false) {
+  std::vector<double> expected(xs.size());
+  for (size_t i = 0; i < xs.size(); ++i) expected[i] = ref(static_cast<double>(xs[i]));
+  return check_widths(name, bound, absolute, xs.size(), expected, xs.data(), nullptr, [fast](auto zero, const float* x, const float*, float* r) {
+    using V = decltype(zero);
+    store<V>(r, fast(load<V>(x)));
+  });
+}
+
+template <typename Fast, typename Ref>
+bool check_binary(const char* name, double bound, const std::vector<float>& ys, const std::vector<float>& xs, Fast fast,
+                  Ref ref) {
+  std::vector<double> expected(xs.size());
+  for (size_t i = 0; i < xs.size(); ++i) expected[i] = ref(static_cast<double>(ys[i]), static_cast<double>(xs[i]));
+  return check_widths(name, bound, false, xs.size(), expected, ys.data(), xs.data(), [fast](auto zero, const float* y, const float* x, float* r) {
+    using V = decltype(zero);
+    store<V>(r, fast(load<V>(y), load<V>(x)));
+  });
+}
+
+// Every `step`-th float bit pattern in [lo, hi] plus lo and hi, both signs when `negative`
+std::vector<float> sweep(float lo, float hi, uint32_t step, bool negative) {
+  std::vector<float> xs;
+  uint32_t a, b;
+  std::memcpy(&a, &lo, sizeof(a));
+  std::memcpy(&b, &hi, sizeof(b));
+  for (uint64_t bits = a; bits <= b; bits += step) {
+    float x;
+    uint32_t u = static_cast<uint32_t>(bits);
+    std::memcpy(&x, &u, sizeof(x));
+    xs.push_back(x);
+    if (negative) xs.push_back(-x);
+  }
+  xs.push_back(hi);
+  while (xs.size() % 8) xs.push_back(lo);
+  return xs;
+}
+
+} // namespace
+
+void register_fast_math() {
+  math("rsqrt", 0.01f, 100.0f, [](float, float x) { return 1.0f / std::sqrt(x); }, [](auto, auto x) { return fast::rsqrt(x); });
+  math("sin", -10.0f, 10.0f, [](float, float x) { return std::sin(x); }, [](auto, auto x) { return fast::sin(x); });
+  math("cos", -10.0f, 10.0f, [](float, float x) { return std::cos(x); }, [](auto, auto x) { return fast::cos(x); });
+  math("atan2", -1.0f, 1.0f, [](float y, float x) { return std::atan2(y, x); }, [](auto y, auto x) { return fast::atan2(y, x); });
+  math("exp2", -20.0f, 20.0f, [](float, float x) { return std::exp2(x); }, [](auto, auto x) { return fast::exp2(x); });
+  math("exp", -20.0f, 20.0f, [](float, float x) { return std::exp(x); }, [](auto, auto x) { return fast::exp(x); });
+  math("log2", 0.001f, 1000.0f, [](float, float x) { return std::log2(x); }, [](auto, auto x) { return fast::log2(x); });
+  math("log", 0.001f, 1000.0f, [](float, float x) { return std::log(x); }, [](auto, auto x) { return fast::log(x); });
+}
+
+bool check_fast_math_accuracy() {
+  // The bounds match the table in fast_math.h
+  bool ok = true;
+  ok = check_unary("rsqrt", 4.0, sweep(1.17549435e-38f, 3.40282347e+38f, 61, false),
+                   [](auto x) { return fast::rsqrt(x); }, [](double x) { return 1.0 / std::sqrt(x); }) && ok;
+  const std::vector<float> angles = sweep(1e-30f, 1.57079637f, 37, true);
+  ok = check_unary("sin", 2.0, angles, [](auto x) { return fast::sin(x); }, [](double x) { return std::sin(x); }) && ok;
+  ok = check_unary("cos", 2.0, angles, [](auto x) { return fast::cos(x); }, [](double x) { return std::cos(x); }) && ok;
+  const std::vector<float> wide = sweep(1.57079637f, 8192.0f, 7, true);
+  ok = check_unary("sin abs", 1.5e-7, wide, [](auto x) { return fast::sin(x); }, [](double x) { return std::sin(x); }, true) && ok;
+  ok = check_unary("cos abs", 1.5e-7, wide, [](auto x) { return fast::cos(x); }, [](double x) { return std::cos(x); }, true) && ok;
+  const std::vector<float> exponents = sweep(1e-30f, 160.0f, 37, true);
+  ok = check_unary("exp2", 2.0, exponents, [](auto x) { return fast::exp2(x); }, [](double x) { return std::exp2(x); }) && ok;
+  ok = check_unary("exp", 2.0, exponents, [](auto x) { return fast::exp(x); }, [](double x) { return std::exp(x); }) && ok;
+  const std::vector<float> positive = sweep(1.4e-45f, 3.40282347e+38f, 61, false);
+  ok = check_unary("log2", 2.0, positive, [](auto x) { return fast::log2(x); }, [](double x) { return std::log2(x); }) && ok;
+  ok = check_unary("log", 2.0, positive, [](auto x) { return fast::log(x); }, [](double x) { return std::log(x); }) && ok;
+
+  // atan2 over pairs spread across magnitudes and quadrants, plus the axes and signed zeros
+  std::vector<float> ys, xs;
+  for (size_t i = 0; i < (size_t(1) << 22); ++i) {
+    float m = std::ldexp(1.0f, static_cast<int>(uniform(-20.0f, 20.0f)));
+    ys.push_back(uniform(-1.0f, 1.0f) * m);
+    xs.push_back(uniform(-1.0f, 1.0f) * (i % 4 ? m : 1.0f));
+  }
+  for (float y : {0.0f, -0.0f, 1.0f, -1.0f, 1e-30f}) {
+    for (float x : {0.0f, -0.0f, 1.0f, -1.0f, 1e30f, -1e30f}) {
+      ys.push_back(y);
+      xs.push_back(x);
+    }
+  }
+  while (xs.size() % 8) {
+    ys.push_back(1.0f);
+    xs.push_back(1.0f);
+  }
+  ok = check_binary("atan2", 4.0, ys, xs, [](auto y, auto x) { return fast::atan2(y, x); },
+                    [](double y, double x) { return std::atan2(y, x); }) && ok;
+  return ok;
+}
+
+} // namespace cgmath::bench
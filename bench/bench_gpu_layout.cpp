@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+// Staging buffer writes of 100k elements per array in each layout. The *_naive entries are
+// the element-by-element loop an upload path would otherwise run. The --accuracy part checks
+// every type, layout and order against that loop.
+
+namespace cgmath::bench {
+
+namespace {
+
+constexpr size_t ARRAY_COUNT = 100000;
+
+// Reference layout: float i of element e in the buffer, padding zero
+template <typename T>
+void naive(const T* in, float* out, size_t n, const gpu_layout_options& o);
+
+template <>
+void naive(const float2* in, float* out, size_t n, const gpu_layout_options& o) {
+  const size_t stride = gpu_stride<float2>(o) / 4;
+  for (size_t e = 0; e < n; ++e) {
+    float* d = out + e * stride;
+    for (size_t i = 0; i < stride; ++i) d[i] = i == 0 ? in[e].x : i == 1 ? in[e].y : 0.0f;
+  }
+}
+
+template <>
+void naive(const float3* in, float* out, size_t n, const gpu_layout_options&) {
+  for (size_t e = 0; e < n; ++e) {
+    float* d = out + e * 4;
+    d[0] = in[e].x;
+    d[1] = in[e].y;
+    d[2] = in[e].z;
+    d[3] = 0.0f;
+  }
+}
+
+// Vectors of 16 bytes, each a column (column_major) or a row of the source
+template <typename M>
+void naive_matrix(const M* in, float* out, size_t n, size_t rows, size_t cols, const gpu_layout_options& o) {
+  const bool columns = o.order == matrix_order::column_major;
+  const size_t vectors = columns ? cols : rows;
+  for (size_t e = 0; e < n; ++e) {
+    float* d = out + e * vectors * 4;
+    for (size_t v = 0; v < vectors; ++v) {
+      for (size_t k = 0; k < 4; ++k) {
+        const size_t r = columns ? k : v, c = columns ? v : k;
+        d[v * 4 + k] = r < rows && c < cols ? in[e].m[r][c] : 0.0f;
+      }
+    }
+  }
+}
+
+template <>
+void naive(const matrix3x3* in, float* out, size_t n, const gpu_layout_options& o) {
+  naive_matrix(in, out, n, 3, 3, o);
+}
+
+template <>
+void naive(const matrix3x4* in, float* out, size_t n, const gpu_layout_options& o) {
+  naive_matrix(in, out, n, 3, 4, o);
+}
+
+template <>
+void naive(const matrix4x4* in, float* out, size_t n, const gpu_layout_options& o) {
+  naive_matrix(in, out, n, 4, 4, o);
+}
+
+gpu_layout_options options(matrix_order order, store_mode mode = store_mode::normal, size_t thread_count = 1) {
+  gpu_layout_options o;
+  o.order = order;
+  o.mode = mode;
+  o.thread_count = thread_count;
+  return o;
+}
+
+template <typename T>
+void add_layouts(const std::string& type, bool has_order) {
+  struct data {
+    std::vector<T> in = random_values<T>(ARRAY_COUNT);
+    std::vector<float, aligned_allocator<float, 64>> out = std::vector<float, aligned_allocator<float, 64>>(ARRAY_COUNT * 16);
+  };
+  auto d = std::make_shared<data>();
+  const auto add_one = [&](const std::string& name, const gpu_layout_options& o, bool reference) {
+    add("gpu_layout/" + type + "_" + name, "batch", ARRAY_COUNT, [d, o, reference](size_t iterations) {
+      for (size_t i = 0; i < iterations; ++i) {
+        if (reference) {
+          naive(d->in.data(), d->out.data(), ARRAY_COUNT, o);
+        } else {
+          to_gpu_layout(d->in.data(), d->out.data(), ARRAY_COUNT, o);
+        }
+        do_not_optimize(d->out[0]);
+      }
+    });
+  };
+  add_one("naive", options(matrix_order::column_major), true);
+  add_one("column_major", options(matrix_order::column_major), false);
+  if (has_order) add_one("row_major", options(matrix_order::row_major), false);
+  add_one("column_major_stream", options(matrix_order::column_major, store_mode::non_temporal), false);
+  add_one("column_major_threads", options(matrix_order::column_major, store_mode::normal, 0), false);
+}
+
+} // namespace
+
+void register_gpu_layout() {
+  add_layouts<float3>("float3", false);
+  add_layouts<matrix3x3>("matrix3x3", true);
+  add_layouts<matrix3x4>("matrix3x4", true);
+  add_layouts<matrix4x4>("matrix4x4", true);
+}
+
+namespace {
+
+// Every combination against naive, written into a buffer at a 4-byte offset too so that
+// non_temporal falls back to normal stores; padding must come out zero over garbage
+template <typename T>
+size_t check_type(size_t& samples) {
+  constexpr size_t n = 1001;
+  const std::vector<T> in = random_values<T>(n);
+  std::vector<float, aligned_allocator<float, 64>> expected(n * 16 + 2), out(n * 16 + 2);
+  size_t failures = 0;
+  for (gpu_layout layout : {gpu_layout::std140, gpu_layout::std430}) {
+    for (matrix_order order : {matrix_order::column_major, matrix_order::row_major}) {
+      for (store_mode mode : {store_mode::normal, store_mode::non_temporal}) {
+        for (size_t thread_count : {1, 3, 0}) {
+          for (size_t offset : {0, 1}) {
+            gpu_layout_options o = options(order, mode, thread_count);
+            o.layout = layout;
+            naive(in.data(), expected.data(), n, o);
+            std::fill(out.begin(), out.end(), -7.0f);
+            const size_t bytes = to_gpu_layout(in.data(), out.data() + offset, n, o);
+            failures += bytes != n * gpu_stride<T>(o);
+            failures += std::memcmp(out.data() + offset, expected.data(), bytes) != 0;
+            failures += out[offset + bytes / 4] != -7.0f;
+            ++samples;
+          }
+        }
+      }
+    }
+  }
+  return failures;
+}
+
+} // namespace
+
+bool check_gpu_layout() {
+  size_t samples = 0;
+  const size_t failures = check_type<float2>(samples) + check_type<float3>(samples) + check_type<matrix3x3>(samples) +
+                          check_type<matrix3x4>(samples) + check_type<matrix4x4>(samples);
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", "gpu_layout", "-", samples, failures,
+              failures == 0 ? "ok" : "FAIL");
+  return failures == 0;
+}
+
+} // namespace cgmath::bench
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+// Transform hierarchy updates: everything recomputed against the incremental update after 5%
+// of the nodes, all leaves, moved. Items are nodes of the scene. The --accuracy part checks incremental
+// updates against full ones and against world matrices composed up the parent chain.
+
+namespace cgmath::bench {
+
+namespace {
+
+// A few levels of random branching, about what a scene of characters and props looks like
+std::vector<uint32_t> random_parents(size_t n) {
+  std::vector<uint32_t> parents(n);
+  for (size_t i = 0; i < n; ++i) {
+    parents[i] = i < 8 ? NO_PARENT : uint32_t(uniform(float(i / 6), float(i / 3)));
+  }
+  return parents;
+}
+
+std::vector<matrix3x4> random_locals(size_t n) {
+  std::vector<matrix3x4> locals(n);
+  for (size_t i = 0; i < n; ++i) {
+    const quaternion q = quaternion(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1), uniform(0.1f, 1)).normalized();
+    locals[i] = q.to_matrix3x4(float3(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)));
+  }
+  return locals;
+}
+
+void register_scene(size_t n, const char* full, const char* incremental) {
+  struct data {
+    transform_hierarchy h;
+    std::vector<uint32_t> moved;
+    std::vector<matrix3x4> poses;
+  };
+  auto d = std::make_shared<data>();
+  const std::vector<uint32_t> parents = random_parents(n);
+  d->h.build(parents.data(), random_locals(n).data(), n);
+  d->h.update();
+  // Nodes past n / 3 have no children, so the 5% that move are also the 5% recomputed
+  d->moved.resize(n / 20);
+  for (uint32_t& id : d->moved) id = uint32_t(uniform(float(n / 3), float(n - 1)));
+  d->poses = random_locals(d->moved.size());
+
+  add(full, "batch", n, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t k = 0; k < d->moved.size(); ++k) d->h.set_local(d->moved[k], d->poses[k]);
+      d->h.update_all();
+      do_not_optimize(d->h.world[0]);
+    }
+  });
+  add(incremental, "batch", n, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t k = 0; k < d->moved.size(); ++k) d->h.set_local(d->moved[k], d->poses[k]);
+      d->h.update();
+      do_not_optimize(d->h.world[0]);
+    }
+  });
+}
+
+// parent * child written out per element
+matrix3x4 compose(const matrix3x4& a, const matrix3x4& b) {
+  matrix3x4 r;
+  for (int row = 0; row < 3; ++row) {
+    for (int c = 0; c < 4; ++c) {
+      r.m[row][c] = a.m[row][0] * b.m[0][c] + a.m[row][1] * b.m[1][c] + a.m[row][2] * b.m[2][c];
+      if (c == 3) r.m[row][c] += a.m[row][3];
+    }
+  }
+  return r;
+}
+
+} // namespace
+
+void register_hierarchy() {
+  register_scene(100000, "hierarchy/full_100k", "hierarchy/incremental_100k");
+  register_scene(1000000, "hierarchy/full_1m", "hierarchy/incremental_1m");
+}
+
+bool check_hierarchy() {
+  bool ok = true;
+  const auto report = [&](const char* name, size_t samples, size_t failures) {
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", name, "-", samples, failures,
+                failures == 0 ? "ok" : "FAIL");
+    ok = ok && failures == 0;
+  };
+
+  // Incremental updates after rounds of random edits give the same matrices as full ones, on
+  // one and on four threads, and as composing up the parent chain of every node
+  const size_t n = 200000;
+  std::vector<uint32_t> parents = random_parents(n);
+  // Shuffled ids, parents do not have to come first
+  std::vector<uint32_t> shuffle(n);
+  for (size_t i = 0; i < n; ++i) shuffle[i] = uint32_t(i);
+  for (size_t i = n - 1; i > 0; --i) std::swap(shuffle[i], shuffle[size_t(uniform(0, float(i)))]);
+  std::vector<uint32_t> shuffled(n);
+  for (size_t i = 0; i < n; ++i) shuffled[shuffle[i]] = parents[i] == NO_PARENT ? NO_PARENT : shuffle[parents[i]];
+  const std::vector<matrix3x4> locals = random_locals(n);
+
+  transform_hierarchy incremental, full;
+  size_t failures = !incremental.build(shuffled.data(), locals.data(), n) || !full.build(shuffled.data(), locals.data(), n);
+  incremental.update(1);
+  for (int round = 0; round < 5; ++round) {
+    const size_t edits = round == 4 ? 1 : n / 50 << round;
+    for (size_t k = 0; k < edits; ++k) {
+      const uint32_t id = uint32_t(uniform(0, float(n - 1)));
+      const matrix3x4 m = random_locals(1)[0];
+      incremental.set_local(id, m);
+      full.set_local(id, m);
+    }
+    incremental.update(round % 2 ? 4 : 1);
+    full.update_all(round % 2 ? 1 : 4);
+    failures += incremental.world != full.world;
+  }
+  // Reference world matrices composed top down along the parent chain of every id
+  std::vector<matrix3x4> expected(n);
+  std::vector<uint8_t> done(n, 0);
+  for (size_t start = 0; start < n; ++start) {
+    std::vector<uint32_t> chain;
+    for (uint32_t id = uint32_t(start); id != NO_PARENT && !done[id]; id = shuffled[id]) chain.push_back(id);
+    for (size_t k = chain.size(); k-- > 0;) {
+      const uint32_t id = chain[k], p = shuffled[id];
+      expected[id] = p == NO_PARENT ? full.local_matrix(id) : compose(expected[p], full.local_matrix(id));
+      done[id] = 1;
+    }
+  }
+  for (size_t id = 0; id < n; ++id) {
+    const matrix3x4& w = incremental.world_matrix(uint32_t(id));
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 4; ++c) failures += std::fabs(w.m[r][c] - expected[id].m[r][c]) > 1e-4f * (1.0f + std::fabs(expected[id].m[r][c]));
+    }
+  }
+  report("hierarchy update", n, failures);
+
+  // A cycle and an out of range parent are refused
+  const uint32_t cycle[] = {NO_PARENT, 2, 1}, range[] = {NO_PARENT, 5};
+  transform_hierarchy h;
+  report("hierarchy build", 2, size_t(h.build(cycle, nullptr, 3)) + size_t(h.build(range, nullptr, 2)));
+  return ok;
+}
+
+} // namespace cgmath::bench
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+// Batch kernels on 10M element arrays through parallel_for, on one thread and on every thread
+// of the default scheduler. The arrays are allocated by the first run that needs them. The
+// --accuracy part runs loops on a scheduler with real threads, whatever the host has.
+
+namespace cgmath::bench {
+
+namespace {
+
+constexpr size_t LARGE_COUNT = 10000000;
+
+// Starts a thread per worker on every run, so loops are concurrent even on one core
+struct spawning_scheduler final : scheduler {
+  size_t threads;
+  std::atomic<size_t> runs{0};
+
+  explicit spawning_scheduler(size_t t) : threads(t) {}
+
+  size_t concurrency() const noexcept override { return threads; }
+
+  void run(size_t count, void (*work)(void*, size_t), void* context) override {
+    ++runs;
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < count; ++i) workers.emplace_back([=] { work(context, i); });
+    work(context, 0);
+    for (auto& w : workers) w.join();
+  }
+};
+
+struct large_data {
+  std::vector<float3> points;
+  std::vector<float3> out;
+  float3_soa vectors;
+  float4_soa spheres;
+  std::vector<uint64_t> mask;
+  frustum view;
+
+  void points_ready() {
+    if (!points.empty()) return;
+    points = random_values<float3>(LARGE_COUNT);
+    out.resize(LARGE_COUNT);
+  }
+
+  void vectors_ready() {
+    if (vectors.size() != 0) return;
+    vectors.resize(LARGE_COUNT);
+    for (size_t i = 0; i < LARGE_COUNT; ++i) vectors.set(i, {uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)});
+  }
+
+  void spheres_ready() {
+    if (spheres.size() != 0) return;
+    spheres.resize(LARGE_COUNT);
+    for (size_t i = 0; i < LARGE_COUNT; ++i) spheres.set(i, {uniform(-100, 100), uniform(-100, 100), uniform(-100, 100), 1});
+    mask.resize(cull_mask_words(LARGE_COUNT));
+    view = frustum::from_matrix(matrix4x4::perspective(1.0f, 16.0f / 9.0f, 0.1f, 100.0f));
+  }
+};
+
+parallel_options threads(size_t thread_count) {
+  parallel_options o;
+  o.thread_count = thread_count;
+  return o;
+}
+
+void add_scaling(const char* name, const std::shared_ptr<large_data>& d,
+                 void (*body)(large_data&, const parallel_options&)) {
+  for (size_t t : {size_t(1), size_t(0)}) {
+    const std::string full = std::string(name) + (t == 1 ? "_1thread" : "");
+    add(full, "batch", LARGE_COUNT, [d, body, t](size_t iterations) {
+      for (size_t i = 0; i < iterations; ++i) body(*d, threads(t));
+    });
+  }
+}
+
+} // namespace
+
+void register_parallel() {
+  auto d = std::make_shared<large_data>();
+
+  add_scaling("parallel/transform_points_10m", d, [](large_data& d, const parallel_options& o) {
+    d.points_ready();
+    static const matrix4x4 m = matrix4x4::rotation(float3(0, 0.6f, 0.8f), 0.5f);
+    parallel_options aos = o;
+    aos.element_size = sizeof(float3);
+    parallel_for(0, LARGE_COUNT, [&](size_t b, size_t e) {
+      transform_points(m, d.points.data() + b, d.out.data() + b, e - b);
+    }, aos);
+    do_not_optimize(d.out[0]);
+  });
+  add_scaling("parallel/normalize_10m", d, [](large_data& d, const parallel_options& o) {
+    d.vectors_ready();
+    float3_soa_view v = d.vectors;
+    parallel_for(0, LARGE_COUNT, [&](size_t b, size_t e) { normalize(v.subview(b, e), v.subview(b, e)); }, o);
+    do_not_optimize(d.vectors.x[0]);
+  });
+  // One bit per sphere: chunks of 16384 spheres start on mask words
+  add_scaling("parallel/cull_spheres_10m", d, [](large_data& d, const parallel_options& o) {
+    d.spheres_ready();
+    parallel_options bits = o;
+    bits.element_size = 1;
+    const const_float4_soa_view s = d.spheres;
+    parallel_for(0, LARGE_COUNT, [&](size_t b, size_t e) {
+      uint64_t* mask = d.mask.data() + b / 64;
+      cull_spheres(&d.view, 1, s.subview(b, e), &mask);
+    }, bits);
+    do_not_optimize(d.mask[0]);
+  });
+  add_scaling("parallel/bounds_reduce_10m", d, [](large_data& d, const parallel_options& o) {
+    d.points_ready();
+    struct box {
+      float3 min, max;
+    };
+    parallel_options fixed = o;
+    fixed.mode = partition::deterministic;
+    fixed.element_size = sizeof(float3);
+    const box b = parallel_reduce(
+        size_t(0), LARGE_COUNT, box{float3(INFINITY, INFINITY, INFINITY), float3(-INFINITY, -INFINITY, -INFINITY)},
+        [&](size_t first, size_t last) {
+          box r{d.points[first], d.points[first]};
+          for (size_t i = first + 1; i < last; ++i) {
+            const float3& p = d.points[i];
+            r.min = {std::min(r.min.x, p.x), std::min(r.min.y, p.y), std::min(r.min.z, p.z)};
+            r.max = {std::max(r.max.x, p.x), std::max(r.max.y, p.y), std::max(r.max.z, p.z)};
+          }
+          return r;
+        },
+        [](const box& a, const box& c) {
+          return box{{std::min(a.min.x, c.min.x), std::min(a.min.y, c.min.y), std::min(a.min.z, c.min.z)},
+                     {std::max(a.max.x, c.max.x), std::max(a.max.y, c.max.y), std::max(a.max.z, c.max.z)}};
+        },
+        fixed);
+    do_not_optimize(b);
+  });
+}
+
+bool check_parallel() {
+  bool ok = true;
+  const auto report = [&](const char* name, size_t samples, size_t failures) {
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", name, "-", samples, failures,
+                failures == 0 ? "ok" : "FAIL");
+    ok = ok && failures == 0;
+  };
+
+  // Every index exactly once, chunks on cache lines, for awkward sizes and thread counts
+  size_t loops = 0, failures = 0;
+  for (size_t thread_count : {1, 2, 3, 8, 33}) {
+    spawning_scheduler s(thread_count);
+    for (size_t n : {0, 1, 15, 16, 17, 1000, 65537, 1000003}) {
+      for (size_t grain : {0, 1, 100}) {
+        for (partition mode : {partition::dynamic, partition::deterministic}) {
+          parallel_options o;
+          o.grain = grain;
+          o.mode = mode;
+          o.executor = &s;
+          std::unique_ptr<std::atomic<uint8_t>[]> hits(new std::atomic<uint8_t>[n + 1]());
+          std::atomic<size_t> misaligned{0};
+          parallel_for(7, 7 + n, [&](size_t b, size_t e) {
+            if ((b - 7) % 16 != 0) ++misaligned;
+            for (size_t i = b; i < e; ++i) ++hits[i - 7];
+          }, o);
+          size_t bad = misaligned;
+          for (size_t i = 0; i < n; ++i) bad += hits[i] != 1;
+          failures += bad != 0;
+          ++loops;
+        }
+      }
+    }
+  }
+  report("parallel_for", loops, failures);
+
+  // Deterministic float sums agree bit for bit across thread counts; nested loops run inline
+  std::vector<float> values(1000003);
+  for (float& v : values) v = uniform(-1, 1) * (uniform(0, 1) < 0.01f ? 1e6f : 1.0f);
+  const auto sum = [&](size_t thread_count) {
+    spawning_scheduler s(thread_count);
+    parallel_options o;
+    o.mode = partition::deterministic;
+    o.executor = &s;
+    return parallel_reduce(
+        size_t(0), values.size(), 0.0f,
+        [&](size_t b, size_t e) {
+          float r = 0;
+          for (size_t i = b; i < e; ++i) r += values[i];
+          return r;
+        },
+        [](float a, float b) { return a + b; }, o);
+  };
+  const float expected = sum(1);
+  failures = 0;
+  for (size_t thread_count : {2, 3, 8, 33}) {
+    const float r = sum(thread_count);
+    failures += std::memcmp(&r, &expected, sizeof(float)) != 0;
+  }
+  std::atomic<size_t> nested{0};
+  spawning_scheduler s(4);
+  parallel_options o;
+  o.executor = &s;
+  parallel_options tasks = o;
+  tasks.element_size = 0;
+  parallel_for(0, 64, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; ++i) parallel_for(0, 100, [&](size_t b2, size_t e2) { nested += e2 - b2; }, o);
+  }, tasks);
+  failures += nested != 6400;
+  report("parallel_reduce", 5, failures);
+
+  // The BVH build and write_text run on the default scheduler: the same closest hits and text
+  // as on the calling thread alone, and no threads of their own
+  std::vector<float3> soup(3 * 50000);
+  for (size_t i = 0; i < soup.size(); i += 3) {
+    const float3 c(uniform(-10, 10), uniform(-10, 10), uniform(-10, 10));
+    for (size_t k = 0; k < 3; ++k) soup[i + k] = c + float3(uniform(-0.3f, 0.3f), uniform(-0.3f, 0.3f), uniform(-0.3f, 0.3f));
+  }
+  bvh serial;
+  serial.build(soup.data(), nullptr, soup.size() / 3, 1);
+  std::string serial_text;
+  write_text(serial_text, soup.data(), soup.size(), text_format::json, 1);
+  spawning_scheduler pool(4);
+  set_default_scheduler(&pool);
+  failures = 0;
+  size_t samples = 0;
+  for (size_t thread_count : {0, 2, 3}) {
+    const size_t runs = pool.runs;
+    bvh tree;
+    tree.build(soup.data(), nullptr, soup.size() / 3, thread_count);
+    failures += tree.nodes.size() != serial.nodes.size();
+    for (size_t i = 0; i < 2000; ++i) {
+      ray r;
+      r.origin = float3(uniform(-12, 12), uniform(-12, 12), -15.0f);
+      r.direction = float3(uniform(-0.5f, 0.5f), uniform(-0.5f, 0.5f), 1.0f);
+      ray_hit a, b;
+      failures += serial.intersect(r, a) != tree.intersect(r, b) || a.t != b.t || a.primitive != b.primitive;
+    }
+    std::string text;
+    write_text(text, soup.data(), soup.size(), text_format::json, thread_count);
+    failures += text != serial_text;
+    failures += pool.runs == runs;
+    samples += 2002;
+  }
+  set_default_scheduler(nullptr);
+  report("parallel users", samples, failures);
+  return ok;
+}
+
+} // namespace cgmath::bench
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+
+// Space-filling curve keys and the radix sort behind spatial_order, and the spatial hash grid.
+// Keys are exact, so the --accuracy part checks batch against scalar keys, round trips and
+// sort order; grid queries are checked against brute force.
+
+namespace cgmath::bench {
+
+namespace {
+
+constexpr size_t ELEMENT_COUNT = 16384;
+
+// Points per spatial_order run: large enough that the sort runs threaded
+constexpr size_t CLOUD_COUNT = size_t(1) << 20;
+
+// Particles per grid rebuild, about 8 per cell and 33 within one cell size of each other
+constexpr size_t PARTICLE_COUNT = size_t(1) << 20;
+constexpr float PARTICLE_BOX = 50.0f;
+
+// One line per check like the other --accuracy output; level is the kernel level or "-"
+bool report(const char* name, const char* level, size_t samples, size_t failures) {
+  std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", name, level, samples, failures,
+              failures == 0 ? "ok" : "FAIL");
+  return failures == 0;
+}
+
+std::vector<float3> cloud(size_t n) {
+  std::vector<float3> p(n);
+  // Off-center, with the corners and points outside the bounds passed to the keys
+  for (float3& v : p) v = {uniform(-10, 30), uniform(-1, 1), uniform(1000, 1001)};
+  p[0] = {-10, -1, 1000};
+  p[1] = {30, 1, 1001};
+  return p;
+}
+
+// The cell morton_keys computes for p, written out per element
+uint3 cell_of(const float3& p, const float3& min, const float3& max) {
+  const float3 c = p - min, e = max - min;
+  return {uint32_t(std::min(std::max(c.x * (2097152.0f / e.x), 0.0f), 2097151.0f)),
+          uint32_t(std::min(std::max(c.y * (2097152.0f / e.y), 0.0f), 2097151.0f)),
+          uint32_t(std::min(std::max(c.z * (2097152.0f / e.z), 0.0f), 2097151.0f))};
+}
+
+// The grid the spatial hash replaces: one vector per occupied cell
+using cell_map = std::unordered_map<int3, std::vector<uint32_t>>;
+
+void build_map(cell_map& map, const float3* points, size_t n) {
+  map.clear();
+  for (size_t i = 0; i < n; ++i) {
+    map[int3(int32_t(std::floor(points[i].x)), int32_t(std::floor(points[i].y)), int32_t(std::floor(points[i].z)))]
+        .push_back(uint32_t(i));
+  }
+}
+
+// Brute force reference for spatial_hash queries, sorted
+std::vector<uint32_t> within(const std::vector<float3>& points, const float3& p, float radius) {
+  std::vector<uint32_t> r;
+  for (size_t i = 0; i < points.size(); ++i) {
+    const float3 d = points[i] - p;
+    if (d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius) r.push_back(uint32_t(i));
+  }
+  return r;
+}
+
+} // namespace
+
+void register_spatial() {
+  struct data {
+    std::vector<float3> points = cloud(ELEMENT_COUNT);
+    std::vector<uint64_t> keys = std::vector<uint64_t>(ELEMENT_COUNT);
+    std::vector<float3> big = cloud(CLOUD_COUNT);
+    std::vector<uint32_t> order = std::vector<uint32_t>(CLOUD_COUNT);
+    float3 min = float3(-10, -1, 1000), max = float3(30, 1, 1001);
+  };
+  auto d = std::make_shared<data>();
+
+  add("morton/keys", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      morton_keys(d->points.data(), ELEMENT_COUNT, d->min, d->max, d->keys.data());
+      do_not_optimize(d->keys[0]);
+    }
+  });
+  add("morton/keys_naive", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) d->keys[j] = morton_encode(cell_of(d->points[j], d->min, d->max));
+      do_not_optimize(d->keys[0]);
+    }
+  });
+  add("morton/hilbert_keys", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      hilbert_keys(d->points.data(), ELEMENT_COUNT, d->min, d->max, d->keys.data());
+      do_not_optimize(d->keys[0]);
+    }
+  });
+  add("morton/hilbert_keys_naive", "batch", ELEMENT_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) d->keys[j] = hilbert_encode(cell_of(d->points[j], d->min, d->max));
+      do_not_optimize(d->keys[0]);
+    }
+  });
+
+  // The whole reorder of a 1M point cloud: bounds, keys and the (key, index) sort
+  add("morton/spatial_order_1m", "batch", CLOUD_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      spatial_order(d->big.data(), CLOUD_COUNT, d->order.data());
+      do_not_optimize(d->order[0]);
+    }
+  });
+  add("morton/spatial_order_1m_1thread", "batch", CLOUD_COUNT, [d](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      spatial_order(d->big.data(), CLOUD_COUNT, d->order.data(), space_curve::morton, 1);
+      do_not_optimize(d->order[0]);
+    }
+  });
+  add("morton/spatial_order_1m_std_sort", "batch", CLOUD_COUNT, [d](size_t iterations) {
+    std::vector<uint64_t> keys(CLOUD_COUNT);
+    for (size_t i = 0; i < iterations; ++i) {
+      morton_keys(d->big.data(), CLOUD_COUNT, d->min, d->max, keys.data());
+      std::iota(d->order.begin(), d->order.end(), 0u);
+      std::stable_sort(d->order.begin(), d->order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+      do_not_optimize(d->order[0]);
+    }
+  });
+
+  // Spatial hash rebuilds of 1M particles and 27-cell queries around ELEMENT_COUNT of them,
+  // against an unordered_map of per-cell vectors
+  struct grid_data {
+    std::vector<float3> particles = std::vector<float3>(PARTICLE_COUNT);
+    spatial_hash grid;
+    cell_map map;
+  };
+  auto g = std::make_shared<grid_data>();
+  for (float3& p : g->particles) p = {uniform(0, PARTICLE_BOX), uniform(0, PARTICLE_BOX), uniform(0, PARTICLE_BOX)};
+  g->grid.build(g->particles.data(), PARTICLE_COUNT, 1.0f);
+
+  add("grid/build_1m", "batch", PARTICLE_COUNT, [g](size_t iterations) {
+    spatial_hash grid;
+    for (size_t i = 0; i < iterations; ++i) {
+      grid.build(g->particles.data(), PARTICLE_COUNT, 1.0f);
+      do_not_optimize(grid.indices[0]);
+    }
+  });
+  add("grid/build_1m_1thread", "batch", PARTICLE_COUNT, [g](size_t iterations) {
+    spatial_hash grid;
+    for (size_t i = 0; i < iterations; ++i) {
+      grid.build(g->particles.data(), PARTICLE_COUNT, 1.0f, 1);
+      do_not_optimize(grid.indices[0]);
+    }
+  });
+  add("grid/build_1m_unordered_map", "batch", PARTICLE_COUNT, [g](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      build_map(g->map, g->particles.data(), PARTICLE_COUNT);
+      do_not_optimize(g->map.size());
+    }
+  });
+  add("grid/query", "batch", ELEMENT_COUNT, [g](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      size_t found = 0;
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) {
+        g->grid.for_each_within(g->particles[j], 1.0f, [&](uint32_t, float) { ++found; });
+      }
+      do_not_optimize(found);
+    }
+  });
+  // The same queries around the particles in grid order, as a simulation step visits them
+  add("grid/query_grid_order", "batch", ELEMENT_COUNT, [g](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      size_t found = 0;
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) {
+        g->grid.for_each_within(g->grid.positions[j], 1.0f, [&](uint32_t, float) { ++found; });
+      }
+      do_not_optimize(found);
+    }
+  });
+  add("grid/query_unordered_map", "batch", ELEMENT_COUNT, [g](size_t iterations) {
+    build_map(g->map, g->particles.data(), PARTICLE_COUNT);
+    for (size_t i = 0; i < iterations; ++i) {
+      size_t found = 0;
+      for (size_t j = 0; j < ELEMENT_COUNT; ++j) {
+        const float3 p = g->particles[j];
+        const int3 c(int32_t(std::floor(p.x)), int32_t(std::floor(p.y)), int32_t(std::floor(p.z)));
+        for (int32_t z = c.z - 1; z <= c.z + 1; ++z) {
+          for (int32_t y = c.y - 1; y <= c.y + 1; ++y) {
+            for (int32_t x = c.x - 1; x <= c.x + 1; ++x) {
+              const auto it = g->map.find(int3(x, y, z));
+              if (it == g->map.end()) continue;
+              for (uint32_t k : it->second) {
+                const float3 d = g->particles[k] - p;
+                found += d.x * d.x + d.y * d.y + d.z * d.z <= 1.0f;
+              }
+            }
+          }
+        }
+      }
+      do_not_optimize(found);
+    }
+    g->map.clear();
+  });
+}
+
+bool check_spatial() {
+  bool ok = true;
+  const cpu_isa host = active_isa();
+
+  // Round trips of the scalar encoders, including the extremes of every axis
+  std::vector<uint3> cells;
+  for (uint32_t v : {0u, 1u, 2097150u, 2097151u}) cells.push_back({v, 2097151u - v, v});
+  for (size_t i = 0; i < 100000; ++i) cells.push_back({uint32_t(rng()() >> 11), uint32_t(rng()() >> 11), uint32_t(rng()() >> 11)});
+  size_t failures = 0;
+  for (const uint3& c : cells) {
+    const uint3 m = morton_decode3(morton_encode(c)), h = hilbert_decode3(hilbert_encode(c));
+    if (m.x != c.x || m.y != c.y || m.z != c.z || h.x != c.x || h.y != c.y || h.z != c.z) ++failures;
+    const uint2 p{uint32_t(rng()()), uint32_t(rng()())};
+    const uint2 q = morton_decode2(morton_encode(p));
+    if (q.x != p.x || q.y != p.y) ++failures;
+    const int3 s{int32_t(c.x) - (1 << 20), int32_t(c.y) - (1 << 20), int32_t(c.z) - (1 << 20)};
+    const int3 t = morton_decode3_signed(morton_encode(s));
+    if (t.x != s.x || t.y != s.y || t.z != s.z) ++failures;
+  }
+  ok = report("curve round trip", "-", cells.size(), failures) && ok;
+
+  // Consecutive Hilbert keys are face neighbours
+  failures = 0;
+  for (size_t i = 0; i < 100000; ++i) {
+    const uint64_t key = (uint64_t(rng()()) << 32 | rng()()) & ((uint64_t(1) << 63) - 2);
+    const uint3 a = hilbert_decode3(key), b = hilbert_decode3(key + 1);
+    const uint32_t d = (a.x > b.x ? a.x - b.x : b.x - a.x) + (a.y > b.y ? a.y - b.y : b.y - a.y) +
+                       (a.z > b.z ? a.z - b.z : b.z - a.z);
+    if (d != 1) ++failures;
+  }
+  ok = report("hilbert adjacency", "-", 100000, failures) && ok;
+
+  // Batch keys against the scalar tail at every kernel level; the last points fall outside
+  // the bounds and one is NaN, all clamp into the box
+  std::vector<float3> points = cloud(ELEMENT_COUNT + 7);
+  points[ELEMENT_COUNT] = {-100, 5, 2000};
+  points[ELEMENT_COUNT + 1] = {NAN, 0, 1000.5f};
+  std::swap(points[2], points[ELEMENT_COUNT]);
+  std::swap(points[3], points[ELEMENT_COUNT + 1]);
+  const float3 min(-10, -1, 1000), max(30, 1, 1001);
+  std::vector<uint64_t> expected_m(points.size()), expected_h(points.size()), keys(points.size());
+  set_isa(cpu_isa::scalar);
+  morton_keys(points.data(), points.size(), min, max, expected_m.data());
+  hilbert_keys(points.data(), points.size(), min, max, expected_h.data());
+  for (cpu_isa isa : {cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+    if (set_isa(isa) != isa) continue;
+    morton_keys(points.data(), points.size(), min, max, keys.data());
+    failures = 0;
+    for (size_t i = 0; i < keys.size(); ++i) failures += keys[i] != expected_m[i];
+    ok = report("morton_keys", isa_name(isa), keys.size(), failures) && ok;
+    hilbert_keys(points.data(), points.size(), min, max, keys.data());
+    failures = 0;
+    for (size_t i = 0; i < keys.size(); ++i) failures += keys[i] != expected_h[i];
+    ok = report("hilbert_keys", isa_name(isa), keys.size(), failures) && ok;
+  }
+  set_isa(host);
+
+  // Threaded radix sort against std::stable_sort, with few distinct high bytes
+  for (size_t threads : {size_t(1), size_t(4)}) {
+    const size_t n = 1000003;
+    std::vector<uint64_t> sorted(n);
+    for (uint64_t& k : sorted) k = (uint64_t(rng()() & 0x3) << 56) | (uint64_t(rng()()) << 8) | (rng()() & 0xf);
+    std::vector<uint32_t> values(n);
+    std::iota(values.begin(), values.end(), 0u);
+    std::vector<uint32_t> expected = values;
+    std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return sorted[a] < sorted[b]; });
+    const std::vector<uint64_t> original = sorted;
+    radix_sort(sorted.data(), values.data(), n, threads);
+    failures = 0;
+    for (size_t i = 0; i < n; ++i) failures += values[i] != expected[i] || sorted[i] != original[expected[i]];
+    ok = report(threads == 1 ? "radix_sort" : "radix_sort x4", "-", n, failures) && ok;
+  }
+
+  // Grid queries against brute force, with negative coordinates, radii below and above the
+  // cell size, and a small table whose rows wrap around it
+  for (size_t n : {size_t(20000), size_t(300)}) {
+    std::vector<float3> particles(n);
+    for (float3& p : particles) p = {uniform(-5, 5), uniform(-5, 5), uniform(-5, 5)};
+    spatial_hash grid;
+    grid.build(particles.data(), n, 0.7f);
+    std::vector<uint32_t> found(n);
+    size_t queries = 0;
+    failures = 0;
+    for (float radius : {0.3f, 0.7f, 2.5f, 20.0f}) {
+      for (size_t i = 0; i < 500; ++i, ++queries) {
+        const float3 p = i % 2 ? particles[i % n] : float3(uniform(-6, 6), uniform(-6, 6), uniform(-6, 6));
+        const std::vector<uint32_t> expected = within(particles, p, radius);
+        const size_t count = grid.query(p, radius, found.data(), found.size());
+        std::sort(found.begin(), found.begin() + count);
+        failures += !std::equal(found.begin(), found.begin() + count, expected.begin(), expected.end());
+      }
+    }
+    ok = report(n > 1000 ? "grid query" : "grid query small", "-", queries, failures) && ok;
+  }
+
+  // The build does not depend on the thread count
+  {
+    std::vector<float3> particles(300000);
+    for (float3& p : particles) p = {uniform(0, 40), uniform(0, 40), uniform(0, 40)};
+    spatial_hash one, four;
+    one.build(particles.data(), particles.size(), 1.0f, 1);
+    four.build(particles.data(), particles.size(), 1.0f, 4);
+    failures = one.cell_start != four.cell_start || one.indices != four.indices;
+    for (size_t e = 0; e < one.size(); ++e) failures += !(one.positions[e] == particles[one.indices[e]]);
+    ok = report("grid build x4", "-", particles.size(), failures) && ok;
+  }
+  return ok;
+}
+
+} // namespace cgmath::bench
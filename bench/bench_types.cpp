@@ -0,0 +1,433 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Per-type operators: one latency and one throughput entry each. The *_naive entries are
+// plain loops over the same data, kept as a reference for the SIMD paths.
+
+namespace cgmath::bench {
+
+namespace {
+
+// Vector-like float types share most of their operators
+template <typename V>
+void float_vector(const std::string& type) {
+  binary<V, V>(type + "/add", [](const V& a, const V& b) { return a + b; });
+  binary<V, V>(type + "/sub", [](const V& a, const V& b) { return a - b; });
+  binary<V, float>(type + "/mul_scalar", [](const V& a, float s) { return a * s; });
+  binary<V, float>(type + "/div_scalar", [](const V& a, float s) { return a / (s + 2.0f); });
+  unary<V>(type + "/length", [](const V& a) { return a.length(); });
+  unary<V>(type + "/normalized", [](const V& a) { return a.normalized(); });
+}
+
+template <typename V>
+void integer_vector(const std::string& type) {
+  using S = std::decay_t<decltype(V().x)>;
+  binary<V, V>(type + "/add", [](const V& a, const V& b) { return a + b; });
+  binary<V, V>(type + "/sub", [](const V& a, const V& b) { return a - b; });
+  binary<V, S>(type + "/mul_scalar", [](const V& a, S s) { return a * s; });
+  binary<V, S>(type + "/mod_scalar", [](const V& a, S s) { return a % s; });
+}
+
+template <typename M>
+void matrix_common(const std::string& type) {
+  binary<M, M>(type + "/add", [](const M& a, const M& b) { return a + b; });
+  binary<M, M>(type + "/sub", [](const M& a, const M& b) { return a - b; });
+  binary<M, float>(type + "/mul_scalar", [](const M& a, float s) { return a * s; });
+  unary<M>(type + "/transpose", [](const M& a) { return a.transpose(); });
+}
+
+matrix4x4 mul_naive(const matrix4x4& a, const matrix4x4& b) noexcept {
+  matrix4x4 r;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      float s = 0.0f;
+      for (int k = 0; k < 4; ++k) s += a.m[i][k] * b.m[k][j];
+      r.m[i][j] = s;
+    }
+  }
+  return r;
+}
+
+float3 transform_point_naive(const matrix4x4& m, const float3& p) noexcept {
+  const float v[3] = {p.x, p.y, p.z};
+  float r[3];
+  for (int i = 0; i < 3; ++i) r[i] = m.m[i][0] * v[0] + m.m[i][1] * v[1] + m.m[i][2] * v[2] + m.m[i][3];
+  return {r[0], r[1], r[2]};
+}
+
+float max_difference(const matrix3x4& a, const matrix3x4& b) noexcept {
+  float d = 0.0f;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) d = std::max(d, std::fabs(a.m[r][c] - b.m[r][c]));
+  }
+  return d;
+}
+
+} // namespace
+
+void register_types() {
+  // Cost of the latency harness itself: load, fold and index update around an identity op
+  unary<float>("harness/identity", [](float a) { return a; });
+
+  float_vector<float2>("float2");
+  float_vector<float3>("float3");
+  binary<float3, float3>("float3/dot", [](const float3& a, const float3& b) { return a.dot(b); });
+  binary<float3, float3>("float3/cross", [](const float3& a, const float3& b) { return a.cross(b); });
+  binary<float3, float3>("float3/axpby", [](const float3& a, const float3& b) { return a * 0.5f + b * 0.25f - a; });
+  float_vector<float4>("float4");
+  binary<float4, float4>("float4/dot", [](const float4& a, const float4& b) { return a.dot(b); });
+
+  integer_vector<int2>("int2");
+  integer_vector<int3>("int3");
+  integer_vector<int4>("int4");
+  integer_vector<uint2>("uint2");
+  integer_vector<uint3>("uint3");
+  integer_vector<uint4>("uint4");
+
+  float_vector<vector2>("vector2");
+  unary<vector2>("vector2/perpendicular", [](const vector2& a) { return a.perpendicular(); });
+  binary<vector2, vector2>("vector2/dot", [](const vector2& a, const vector2& b) { return a.dot(b); });
+  binary<vector2, vector2>("vector2/distance", [](const vector2& a, const vector2& b) { return a.distance(b); });
+  binary<vector2, vector2>("vector2/clamp", [](const vector2& a, const vector2& b) { return a.clamp(b, b + 1.0f); });
+
+  float_vector<vector3>("vector3");
+  unary<vector3>("vector3/normalized_fast", [](const vector3& a) { return a.normalized_fast(); });
+  binary<vector3, vector3>("vector3/dot", [](const vector3& a, const vector3& b) { return a.dot(b); });
+  binary<vector3, vector3>("vector3/cross", [](const vector3& a, const vector3& b) { return a.cross(b); });
+  binary<vector3, vector3>("vector3/distance", [](const vector3& a, const vector3& b) { return a.distance(b); });
+  binary<vector3, vector3>("vector3/clamp", [](const vector3& a, const vector3& b) { return a.clamp(b, b + 1.0f); });
+
+  float_vector<vector4>("vector4");
+  unary<vector4>("vector4/normalized_fast", [](const vector4& a) { return a.normalized_fast(); });
+  binary<vector4, vector4>("vector4/dot", [](const vector4& a, const vector4& b) { return a.dot(b); });
+  binary<vector4, vector4>("vector4/distance", [](const vector4& a, const vector4& b) { return a.distance(b); });
+  binary<vector4, vector4>("vector4/clamp", [](const vector4& a, const vector4& b) { return a.clamp(b, b + 1.0f); });
+
+  binary<quaternion, quaternion>("quaternion/add", [](const quaternion& a, const quaternion& b) { return a + b; });
+  binary<quaternion, quaternion>("quaternion/sub", [](const quaternion& a, const quaternion& b) { return a - b; });
+  binary<quaternion, float>("quaternion/mul_scalar", [](const quaternion& a, float s) { return a * s; });
+  unary<quaternion>("quaternion/negate", [](const quaternion& a) { return -a; });
+  binary<quaternion, quaternion>("quaternion/mul", [](const quaternion& a, const quaternion& b) { return a * b; });
+  binary<quaternion, quaternion>("quaternion/dot", [](const quaternion& a, const quaternion& b) { return a.dot(b); });
+  unary<quaternion>("quaternion/length", [](const quaternion& a) { return a.length(); });
+  unary<quaternion>("quaternion/normalized", [](const quaternion& a) { return a.normalized(); });
+  unary<quaternion>("quaternion/conjugate", [](const quaternion& a) { return a.conjugate(); });
+  unary<quaternion>("quaternion/inverse", [](const quaternion& a) { return a.inverse(); });
+  binary<quaternion, float3>("quaternion/rotate_float3", [](const quaternion& q, const float3& p) { return q.rotate(p); });
+  binary<quaternion, vector3>("quaternion/rotate_vector3", [](const quaternion& q, const vector3& p) { return q.rotate(p); });
+  unary<quaternion>("quaternion/log", [](const quaternion& a) { return a.log(); });
+  unary<quaternion>("quaternion/exp", [](const quaternion& a) { return a.exp(); });
+  unary<quaternion>("quaternion/to_matrix3x3", [](const quaternion& a) { return a.to_matrix3x3(); });
+  unary<quaternion>("quaternion/to_matrix3x4", [](const quaternion& a) { return a.to_matrix3x4(); });
+  unary<quaternion>("quaternion/to_matrix4x4", [](const quaternion& a) { return a.to_matrix4x4(); });
+  binary<float3, float>("quaternion/from_axis_angle",
+                        [](const float3& axis, float angle) { return quaternion::from_axis_angle(axis, angle); });
+  unary<quaternion>("quaternion/from_matrix",
+                    [](const quaternion& a) { return quaternion::from_matrix(a.to_matrix3x3()); });
+  binary<quaternion, quaternion>("quaternion/nlerp",
+                                 [](const quaternion& a, const quaternion& b) { return nlerp(a, b, 0.3f); });
+  binary<quaternion, quaternion>("quaternion/slerp",
+                                 [](const quaternion& a, const quaternion& b) { return slerp(a, b, 0.3f); });
+
+  using dq = dual_quaternion;
+  binary<dq, dq>("dual_quaternion/add", [](const dq& a, const dq& b) { return a + b; });
+  binary<dq, float>("dual_quaternion/mul_scalar", [](const dq& a, float s) { return a * s; });
+  unary<dq>("dual_quaternion/normalized", [](const dq& a) { return a.normalized(); });
+  unary<dq>("dual_quaternion/translation", [](const dq& a) { return a.translation(); });
+  binary<dq, float3>("dual_quaternion/transform_point", [](const dq& a, const float3& p) { return a.transform_point(p); });
+  binary<dq, float3>("dual_quaternion/transform_direction",
+                     [](const dq& a, const float3& d) { return a.transform_direction(d); });
+  unary<dq>("dual_quaternion/to_matrix3x4", [](const dq& a) { return a.to_matrix3x4(); });
+  binary<quaternion, float3>("dual_quaternion/from_rotation_translation",
+                             [](const quaternion& r, const float3& t) { return dq::from_rotation_translation(r, t); });
+  unary<dq>("dual_quaternion/from_matrix", [](const dq& a) { return dq::from_matrix(a.to_matrix3x4()); });
+
+  matrix_common<matrix3x3>("matrix3x3");
+  binary<matrix3x3, matrix3x3>("matrix3x3/mul", [](const matrix3x3& a, const matrix3x3& b) { return a * b; });
+  unary<matrix3x3>("matrix3x3/determinant", [](const matrix3x3& a) { return a.determinant(); });
+  unary<matrix3x3>("matrix3x3/inverse", [](const matrix3x3& a) { return a.inverse(); });
+
+  matrix_common<matrix3x4>("matrix3x4");
+  binary<matrix3x4, matrix3x4>("matrix3x4/mul", [](const matrix3x4& a, const matrix3x4& b) { return a * b; });
+  binary<matrix3x4, float3>("matrix3x4/transform_point", [](const matrix3x4& m, const float3& p) { return m.transform_point(p); });
+  binary<matrix3x4, float3>("matrix3x4/transform_direction",
+                            [](const matrix3x4& m, const float3& d) { return m.transform_direction(d); });
+  unary<matrix3x4>("matrix3x4/inverse", [](const matrix3x4& a) { return a.inverse(); });
+  unary<matrix3x4>("matrix3x4/inverse_rigid", [](const matrix3x4& a) { return a.inverse_rigid(); });
+  unary<matrix3x4>("matrix3x4/to_matrix4x4", [](const matrix3x4& a) { return a.to_matrix4x4(); });
+  matrix_common<matrix4x3>("matrix4x3");
+
+  matrix_common<matrix4x4>("matrix4x4");
+  binary<matrix4x4, matrix4x4>("matrix4x4/mul", [](const matrix4x4& a, const matrix4x4& b) { return a * b; });
+  binary<matrix4x4, matrix4x4>("matrix4x4/mul_naive", mul_naive);
+  binary<matrix4x4, vector4>("matrix4x4/mul_vector4", [](const matrix4x4& m, const vector4& v) { return m * v; });
+  binary<matrix4x4, float3>("matrix4x4/transform_point", [](const matrix4x4& m, const float3& p) { return m.transform_point(p); });
+  binary<matrix4x4, float3>("matrix4x4/transform_point_naive", transform_point_naive);
+  binary<matrix4x4, float3>("matrix4x4/transform_direction",
+                            [](const matrix4x4& m, const float3& d) { return m.transform_direction(d); });
+  unary<matrix4x4>("matrix4x4/determinant", [](const matrix4x4& a) { return a.determinant(); });
+  unary<matrix4x4>("matrix4x4/inverse", [](const matrix4x4& a) { return a.inverse(); });
+  unary<matrix4x4>("matrix4x4/inverse_affine", [](const matrix4x4& a) { return a.inverse_affine(); });
+
+  // The generic templates; axpby is one fused expression, products are unrolled per shape
+  using vec3 = vec<float, 3>;
+  using mat4 = mat<float, 4, 4>;
+  using mat34 = mat<float, 3, 4>;
+  binary<vec3, vec3>("vec3/add", [](const vec3& a, const vec3& b) { return vec3(a + b); });
+  binary<vec3, vec3>("vec3/dot", [](const vec3& a, const vec3& b) { return dot(a, b); });
+  binary<vec3, vec3>("vec3/axpby", [](const vec3& a, const vec3& b) { return vec3(a * 0.5f + b * 0.25f - a); });
+  binary<mat4, mat4>("mat4x4/mul", [](const mat4& a, const mat4& b) { return a * b; });
+  binary<mat4, vec<float, 4>>("mat4x4/mul_vec4", [](const mat4& m, const vec<float, 4>& v) { return m * v; });
+  binary<mat34, mat4>("mat3x4/mul_mat4x4", [](const mat34& a, const mat4& b) { return a * b; });
+}
+
+bool check_matrix3x4() {
+  bool ok = true;
+  const auto report = [&](const char* name, size_t samples, size_t failures) {
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", name, "-", samples, failures,
+                failures == 0 ? "ok" : "FAIL");
+    ok = ok && failures == 0;
+  };
+
+  // Products and inverses against the same operations on matrix4x4, inverse_rigid against
+  // inverse on rotations, conversions and transposes round trip exactly
+  constexpr size_t count = 10000;
+  const std::vector<matrix3x4> a = random_values<matrix3x4>(count);
+  const std::vector<matrix3x4> b = random_values<matrix3x4>(count);
+  const std::vector<quaternion> q = random_values<quaternion>(count);
+  const std::vector<float3> p = random_values<float3>(count);
+  size_t product = 0, inverse = 0, rigid = 0, conversion = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const matrix3x4 ab = a[i] * b[i];
+    product += max_difference(ab, matrix3x4(a[i].to_matrix4x4() * b[i].to_matrix4x4())) > 1e-5f;
+    const float3 x = ab.transform_point(p[i]), y = a[i].transform_point(b[i].transform_point(p[i]));
+    product += (x - y).length() > 1e-4f;
+    product += (ab.transform_direction(p[i]) - a[i].transform_direction(b[i].transform_direction(p[i]))).length() > 1e-4f;
+
+    inverse += max_difference(a[i] * a[i].inverse(), matrix3x4::identity()) > 1e-5f;
+    inverse += max_difference(a[i].inverse(), matrix3x4(a[i].to_matrix4x4().inverse_affine())) > 1e-6f;
+
+    const matrix3x4 r = q[i].to_matrix3x4(p[i] * 10.0f);
+    // Translations reach 17, the rotations are orthonormal to rounding
+    rigid += max_difference(r.inverse_rigid(), r.inverse()) > 1e-5f * (1.0f + r.translation().length());
+    rigid += max_difference(r * r.inverse_rigid(), matrix3x4::identity()) > 1e-5f;
+
+    conversion += !(matrix3x4(a[i].to_matrix4x4()) == a[i]) || !(a[i].transpose().transpose() == a[i]);
+    conversion += a[i].transpose().m[3][1] != a[i].m[1][3] || a[i].transpose().m[2][0] != a[i].m[0][2];
+  }
+  report("matrix3x4 mul", count, product);
+
+  // The SSE transforms of matrix4x4 against the constexpr expressions they replace
+  size_t transform = 0;
+  const std::vector<matrix4x4> m = random_values<matrix4x4>(count);
+  for (size_t i = 0; i < count; ++i) {
+    const float3 x = m[i].transform_point(p[i]), y = transform_point_naive(m[i], p[i]);
+    const float3 d = m[i].transform_direction(p[i]);
+    const float3 e(m[i].m[0][0] * p[i].x + m[i].m[0][1] * p[i].y + m[i].m[0][2] * p[i].z,
+                   m[i].m[1][0] * p[i].x + m[i].m[1][1] * p[i].y + m[i].m[1][2] * p[i].z,
+                   m[i].m[2][0] * p[i].x + m[i].m[2][1] * p[i].y + m[i].m[2][2] * p[i].z);
+    transform += (x - y).length() > 1e-6f || (d - e).length() > 1e-6f;
+  }
+  constexpr matrix4x4 translate(1, 0, 0, 5, 0, 2, 0, 6, 0, 0, 3, 7, 0, 0, 0, 1);
+  constexpr float3 moved = translate.transform_point(float3(1, 1, 1));
+  static_assert(moved.x == 6 && moved.y == 8 && moved.z == 10, "transform_point must stay constexpr");
+  transform += !(translate.transform_point(float3(1, 1, 1)) == moved);
+  report("matrix4x4 point", count, transform);
+
+  // The same for matrix3x4, and its SSE determinant against one in double
+  transform = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const matrix3x4& x = a[i];
+    float3 e[2];
+    for (int k = 0; k < 2; ++k) {
+      const float w = k == 0 ? 1.0f : 0.0f;
+      e[k] = float3(x.m[0][0] * p[i].x + x.m[0][1] * p[i].y + x.m[0][2] * p[i].z + x.m[0][3] * w,
+                    x.m[1][0] * p[i].x + x.m[1][1] * p[i].y + x.m[1][2] * p[i].z + x.m[1][3] * w,
+                    x.m[2][0] * p[i].x + x.m[2][1] * p[i].y + x.m[2][2] * p[i].z + x.m[2][3] * w);
+    }
+    transform += (x.transform_point(p[i]) - e[0]).length() > 1e-6f || (x.transform_direction(p[i]) - e[1]).length() > 1e-6f;
+    double det = 0.0, scale = 0.0;
+    for (int c = 0; c < 3; ++c) {
+      const double l = double(x.m[1][(c + 1) % 3]) * x.m[2][(c + 2) % 3];
+      const double r = double(x.m[1][(c + 2) % 3]) * x.m[2][(c + 1) % 3];
+      det += x.m[0][c] * (l - r);
+      scale += std::fabs(x.m[0][c]) * (std::fabs(l) + std::fabs(r));
+    }
+    transform += std::fabs(x.determinant() - det) > 1e-6 * scale;
+  }
+  constexpr matrix3x4 affine(2, 0, 0, 5, 0, 3, 0, 6, 0, 0, 4, 7);
+  static_assert(affine.determinant() == 24 && affine.transform_point(float3(1, 1, 1)).z == 11,
+                "matrix3x4 transforms must stay constexpr");
+  transform += affine.determinant() != 24 || !(affine.transform_direction(float3(1, 1, 1)) == float3(2, 3, 4));
+  report("matrix3x4 point", count, transform);
+  report("matrix3x4 inverse", count, inverse);
+  report("matrix3x4 rigid", count, rigid);
+  report("matrix3x4 convert", count, conversion + (matrix3x4().inverse() == matrix3x4() ? 0 : 1));
+  return ok;
+}
+
+namespace {
+
+// Assignments evaluate their right-hand side before writing, also in constant expressions
+constexpr bool transpose_in_place() {
+  mat<float, 3, 3> m(1, 2, 3, 4, 5, 6, 7, 8, 9);
+  m = transpose(m);
+  return m(0, 1) == 4 && m(1, 0) == 2 && m(2, 0) == 3 && m(0, 2) == 7;
+}
+
+static_assert(transpose_in_place(), "m = transpose(m) must not read elements it has already written");
+
+// The constant-evaluated paths of the scalar functions, against double libm rounded to float
+static_assert(cgmath::sqrt(2.0f) == 1.41421354f && cgmath::sqrt(3.0f) == 1.73205078f, "constexpr sqrt");
+static_assert(cgmath::sqrt(0.0f) == 0.0f && cgmath::sqrt(2.25f) == 1.5f && cgmath::sqrt(-1.0f) != cgmath::sqrt(-1.0f),
+              "constexpr sqrt of zero, squares and negatives");
+static_assert(cgmath::sin(1.0f) == 0.841470957f && cgmath::cos(1.0f) == 0.540302277f, "constexpr sin and cos");
+static_assert(cgmath::sin(0.52359878f) == 0.5f && cgmath::sin(3.14159265f) == -8.74227766e-08f &&
+                  cgmath::cos(1.57079633f) == -4.37113883e-08f,
+              "constexpr sin and cos near multiples of pi/2");
+static_assert(cgmath::sin(1000.5f) == 0.995273948f && cgmath::sin(100000.0f) == 0.0357487984f,
+              "constexpr sin argument reduction");
+static_assert(cgmath::tan(0.5f) == 0.546302497f, "constexpr tan");
+static_assert(cgmath::exp(1.0f) == 2.71828175f && cgmath::log(10.0f) == 2.30258512f, "constexpr exp and log");
+
+// Units in the last place between two floats of the same sign
+uint32_t ulp_distance(float a, float b) {
+  int32_t x, y;
+  std::memcpy(&x, &a, sizeof(x));
+  std::memcpy(&y, &b, sizeof(y));
+  if ((x < 0) != (y < 0)) return a == b ? 0 : UINT32_MAX;
+  return x < y ? uint32_t(y - x) : uint32_t(x - y);
+}
+
+} // namespace
+
+bool check_vec_mat() {
+  bool ok = true;
+  const auto report = [&](const char* name, size_t samples, size_t failures) {
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", name, "-", samples, failures,
+                failures == 0 ? "ok" : "FAIL");
+    ok = ok && failures == 0;
+  };
+
+  using mat3 = mat<float, 3, 3>;
+  using mat4 = mat<float, 4, 4>;
+  using mat34 = mat<float, 3, 4>;
+  using vec4 = vec<float, 4>;
+
+  // Assignments whose right-hand side reads the target, against the same operations on copies
+  constexpr size_t count = 10000;
+  const std::vector<matrix4x4> a = random_values<matrix4x4>(count);
+  const std::vector<matrix4x4> b = random_values<matrix4x4>(count);
+  const std::vector<vector4> v = random_values<vector4>(count);
+  size_t aliasing = 0, product = 0;
+  {
+    mat3 m(1, 2, 3, 4, 5, 6, 7, 8, 9);
+    m = transpose(m);
+    aliasing += !(m(0, 0) == 1 && m(0, 1) == 4 && m(0, 2) == 7 && m(1, 0) == 2 && m(1, 1) == 5 && m(1, 2) == 8 &&
+                  m(2, 0) == 3 && m(2, 1) == 6 && m(2, 2) == 9);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    const mat4 x(a[i]);
+    mat4 m = x, plus = x, minus = x, t = x;
+    m = transpose(m) * 2.0f - m;
+    plus += transpose(plus);
+    minus -= transpose(minus);
+    t = transpose(transpose(t));
+    vec4 w(v[i]);
+    const vec4 w0 = w;
+    w = w * 2.0f + w;
+    w -= w * 0.5f;
+    for (size_t r = 0; r < 4; ++r) {
+      for (size_t c = 0; c < 4; ++c) {
+        aliasing += m(r, c) != x(c, r) * 2.0f - x(r, c);
+        aliasing += plus(r, c) != x(r, c) + x(c, r);
+        aliasing += minus(r, c) != x(r, c) - x(c, r);
+        aliasing += t(r, c) != x(r, c);
+      }
+      const float u = w0.v[r] * 2.0f + w0.v[r];
+      aliasing += w.v[r] != u - u * 0.5f;
+    }
+
+    // Products against sums in double and against matrix4x4, whose rows are the same
+    const mat4 y(b[i]);
+    const mat4 xy = x * y;
+    const vec4 xv = x * vec4(v[i]);
+    const mat34 top(a[i].m[0][0], a[i].m[0][1], a[i].m[0][2], a[i].m[0][3], a[i].m[1][0], a[i].m[1][1], a[i].m[1][2],
+                    a[i].m[1][3], a[i].m[2][0], a[i].m[2][1], a[i].m[2][2], a[i].m[2][3]);
+    const mat34 ty = top * y;
+    const matrix4x4 ref = a[i] * b[i];
+    for (size_t r = 0; r < 4; ++r) {
+      double s = 0.0;
+      for (size_t c = 0; c < 4; ++c) {
+        double e = 0.0;
+        for (size_t k = 0; k < 4; ++k) e += double(x(r, k)) * y(k, c);
+        product += std::fabs(xy(r, c) - e) > 1e-5;
+        product += std::fabs(xy(r, c) - ref.m[r][c]) > 1e-5f;
+        if (r < 3) product += ty(r, c) != xy(r, c);
+        s += double(x(r, c)) * v[i].vector4_f32[c];
+      }
+      product += std::fabs(xv.v[r] - s) > 1e-5;
+    }
+  }
+  report("vec/mat aliasing", count + 1, aliasing);
+  report("vec/mat product", count, product);
+  return ok;
+}
+
+bool check_constexpr_math() {
+  // The software versions, called at runtime, over sweeps of their domains. The documented
+  // error is none, or 1 ULP for atan2, pow, asin and acos that go through atan2.
+  std::vector<float> positive, angles, any, unit, bases, exponents;
+  for (size_t i = 0; i < 100000; ++i) {
+    positive.push_back(std::ldexp(uniform(1, 2), int(uniform(-140, 127))));
+    angles.push_back(std::ldexp(uniform(-2, 2), int(uniform(-20, 19))));
+    any.push_back(uniform(-1, 1) * std::ldexp(1.0f, int(uniform(-20, 8))));
+    unit.push_back(uniform(-1, 1));
+    bases.push_back(std::ldexp(uniform(1, 2), int(uniform(-10, 10))));
+    exponents.push_back(uniform(-12, 12));
+  }
+  bool ok = true;
+  const auto sweep = [&](const char* name, const std::vector<float>& xs, const std::vector<float>& ys, uint32_t bound,
+                         auto software, auto libm) {
+    size_t failures = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+      const float s = software(xs[i], ys[i]), r = static_cast<float>(libm(double(xs[i]), double(ys[i])));
+      failures += !(std::isnan(s) && std::isnan(r)) && ulp_distance(s, r) > bound;
+    }
+    std::printf("%-18s %-7s %8zu samples  failures %zu  %s\n", name, "-", xs.size(), failures,
+                failures == 0 ? "ok" : "FAIL");
+    ok = ok && failures == 0;
+  };
+  namespace ct = compile_time;
+  sweep("constexpr sqrt", positive, positive, 0, [](float x, float) { return ct::sqrt(x); },
+        [](double x, double) { return std::sqrt(x); });
+  sweep("constexpr sin", angles, angles, 0, [](float x, float) { return ct::sin(x); },
+        [](double x, double) { return std::sin(x); });
+  sweep("constexpr cos", angles, angles, 0, [](float x, float) { return ct::cos(x); },
+        [](double x, double) { return std::cos(x); });
+  sweep("constexpr tan", angles, angles, 0, [](float x, float) { return ct::tan(x); },
+        [](double x, double) { return std::tan(x); });
+  sweep("constexpr exp", any, any, 0, [](float x, float) { return ct::exp(x); },
+        [](double x, double) { return std::exp(x); });
+  sweep("constexpr log", positive, positive, 0, [](float x, float) { return ct::log(x); },
+        [](double x, double) { return std::log(x); });
+  sweep("constexpr atan2", any, angles, 1, [](float x, float y) { return ct::atan2(y, x); },
+        [](double x, double y) { return std::atan2(y, x); });
+  sweep("constexpr asin", unit, unit, 1, [](float x, float) { return ct::asin(x); },
+        [](double x, double) { return std::asin(x); });
+  sweep("constexpr acos", unit, unit, 1, [](float x, float) { return ct::acos(x); },
+        [](double x, double) { return std::acos(x); });
+  sweep("constexpr pow", bases, exponents, 1, [](float x, float y) { return ct::pow(x, y); },
+        [](double x, double y) { return std::pow(x, y); });
+  return ok;
+}
+
+} // namespace cgmath::bench
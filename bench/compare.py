@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) Yakiv Matiash
+#
+# Compares two cgmath_bench --json outputs and exits with 1 when any benchmark got slower
+# than the threshold allows.
+#
+#   cgmath_bench --json baseline.json        # before the upgrade
+#   cgmath_bench --json current.json         # after
+#   compare.py baseline.json current.json --threshold 0.10
+#
+# A change counts only when it exceeds both the relative threshold and --min-delta-ns, so
+# sub-nanosecond throughput numbers do not flag on timer noise.
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    results = {(b["name"], b["mode"]): b for b in data["benchmarks"]}
+    return data.get("context", {}), results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag cgmath_bench regressions against a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown that counts as a regression (default 0.10)")
+    parser.add_argument("--min-delta-ns", type=float, default=0.05,
+                        help="absolute change in ns per item below which differences are ignored")
+    parser.add_argument("--all", action="store_true", help="print unchanged benchmarks too")
+    args = parser.parse_args()
+
+    base_context, base = load(args.baseline)
+    cur_context, cur = load(args.current)
+
+    for key in ("compiler", "build", "simd", "dispatch"):
+        if base_context.get(key) != cur_context.get(key):
+            print(f"note: {key} differs: {base_context.get(key)} -> {cur_context.get(key)}")
+    if cur_context.get("build") == "debug":
+        print("warning: current results come from a debug build")
+
+    regressions, improvements, unchanged = [], [], []
+    for key, b in base.items():
+        c = cur.get(key)
+        if c is None:
+            continue
+        before, after = b["ns_per_item"], c["ns_per_item"]
+        ratio = after / before if before > 0 else 1.0
+        row = (key[0], key[1], before, after, ratio)
+        if abs(after - before) < args.min_delta_ns:
+            unchanged.append(row)
+        elif ratio > 1.0 + args.threshold:
+            regressions.append(row)
+        elif ratio < 1.0 / (1.0 + args.threshold):
+            improvements.append(row)
+        else:
+            unchanged.append(row)
+
+    def table(title, rows):
+        if not rows:
+            return
+        print(f"\n{title} ({len(rows)})")
+        print(f"  {'benchmark':<44} {'mode':<10} {'before ns':>12} {'after ns':>12} {'change':>8}")
+        for name, mode, before, after, ratio in rows:
+            print(f"  {name:<44} {mode:<10} {before:12.3f} {after:12.3f} {(ratio - 1) * 100:+7.1f}%")
+
+    table("Regressions", sorted(regressions, key=lambda r: -r[4]))
+    table("Improvements", sorted(improvements, key=lambda r: r[4]))
+    if args.all:
+        table("Unchanged", unchanged)
+
+    def names(title, keys):
+        if not keys:
+            return
+        shown = ", ".join(f"{n} ({m})" for n, m in keys[:8])
+        more = f" and {len(keys) - 8} more" if len(keys) > 8 else ""
+        print(f"\n{title}: {shown}{more}")
+
+    names("Missing from current", sorted(set(base) - set(cur)))
+    names("New in current", sorted(set(cur) - set(base)))
+
+    print(f"\n{len(regressions)} regressions, {len(improvements)} improvements, {len(unchanged)} unchanged")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bench.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+
+// cgmath_bench [--filter TEXT] [--json PATH] [--min-time SECONDS] [--repetitions N] [--list]
+// cgmath_bench --accuracy
+//
+// Every benchmark is calibrated until one run takes at least --min-time, then repeated and
+// the fastest run is reported, which is the most stable statistic on a noisy machine.
+
+namespace cgmath::bench {
+
+volatile uint32_t opaque_zero = 0;
+
+std::vector<benchmark>& registry() {
+  static std::vector<benchmark> benchmarks;
+  return benchmarks;
+}
+
+std::mt19937& rng() {
+  static std::mt19937 generator(20240601u);
+  return generator;
+}
+
+float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng()); }
+
+namespace {
+
+struct options {
+  std::string filter;
+  std::string json;
+  double min_time = 0.05;
+  size_t repetitions = 5;
+  bool list = false;
+  bool accuracy = false;
+};
+
+struct result {
+  const benchmark* bench;
+  size_t iterations;
+  double ns_per_item;
+};
+
+const char* simd_name() {
+#if defined(__AVX512F__)
+  return "avx512";
+#elif defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE4_1__)
+  return "sse4.1";
+#elif defined(__SSE__)
+  return "sse";
+#else
+  return "scalar";
+#endif
+}
+
+const char* compiler_name() {
+#if defined(__clang__)
+  return "clang " __clang_version__;
+#elif defined(__GNUC__)
+  return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+#define CG_MATH_BENCH_STR2(x) #x
+#define CG_MATH_BENCH_STR(x) CG_MATH_BENCH_STR2(x)
+  return "msvc " CG_MATH_BENCH_STR(_MSC_FULL_VER);
+#else
+  return "unknown";
+#endif
+}
+
+double seconds(size_t iterations, const benchmark& b) {
+  auto start = std::chrono::steady_clock::now();
+  b.run(iterations);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+result measure(const benchmark& b, const options& o) {
+  size_t iterations = 1;
+  double t = seconds(iterations, b);
+  while (t < o.min_time && iterations < (size_t(1) << 40)) {
+    // Aim a little past min_time, but at most grow 10x per step in case the first runs were noise
+    double scale = t > 0.0 ? o.min_time * 1.2 / t : 10.0;
+    iterations = static_cast<size_t>(iterations * (scale < 10.0 ? (scale > 1.5 ? scale : 1.5) : 10.0));
+    t = seconds(iterations, b);
+  }
+  double best = t;
+  for (size_t i = 1; i < o.repetitions; ++i) {
+    double r = seconds(iterations, b);
+    if (r < best) best = r;
+  }
+  return {&b, iterations, best * 1e9 / (double(iterations) * double(b.items))};
+}
+
+void write_json(std::FILE* f, const options& o, const std::vector<result>& results) {
+  char date[32];
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+  std::fprintf(f, "{\n  \"context\": {\n");
+  std::fprintf(f, "    \"date\": \"%s\",\n", date);
+  std::fprintf(f, "    \"compiler\": \"%s\",\n", compiler_name());
+#ifdef NDEBUG
+  std::fprintf(f, "    \"build\": \"release\",\n");
+#else
+  std::fprintf(f, "    \"build\": \"debug\",\n");
+#endif
+  std::fprintf(f, "    \"simd\": \"%s\",\n", simd_name());
+  std::fprintf(f, "    \"dispatch\": \"%s\",\n", isa_name(active_isa()));
+  std::fprintf(f, "    \"min_time\": %g,\n    \"repetitions\": %zu\n  },\n", o.min_time, o.repetitions);
+  std::fprintf(f, "  \"benchmarks\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result& r = results[i];
+    std::fprintf(f, "%s\n    {\"name\": \"%s\", \"mode\": \"%s\", \"items\": %zu, \"iterations\": %zu, "
+                    "\"ns_per_item\": %.6g, \"items_per_second\": %.6g}",
+                 i ? "," : "", r.bench->name.c_str(), r.bench->mode.c_str(), r.bench->items, r.iterations,
+                 r.ns_per_item, 1e9 / r.ns_per_item);
+  }
+  std::fprintf(f, "\n  ]\n}\n");
+}
+
+bool parse(int argc, char** argv, options& o) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--filter" && has_value) {
+      o.filter = argv[++i];
+    } else if (arg == "--json" && has_value) {
+      o.json = argv[++i];
+    } else if (arg == "--min-time" && has_value) {
+      o.min_time = std::atof(argv[++i]);
+    } else if (arg == "--repetitions" && has_value) {
+      o.repetitions = static_cast<size_t>(std::atoi(argv[++i]));
+      if (o.repetitions == 0) o.repetitions = 1;
+    } else if (arg == "--list") {
+      o.list = true;
+    } else if (arg == "--accuracy") {
+      o.accuracy = true;
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--filter TEXT] [--json PATH|-] [--min-time SECONDS] [--repetitions N] [--list]\n"
+                   "       %s --accuracy\n",
+                   argv[0], argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+} // namespace cgmath::bench
+
+int main(int argc, char** argv) {
+  using namespace cgmath::bench;
+
+  options o;
+  if (!parse(argc, argv, o)) return 2;
+
+  // The check_* comparisons of bench.h against reference results instead of timings; fails
+  // when one is exceeded. Every check runs even after a failure.
+  if (o.accuracy) {
+    bool ok = check_matrix3x4();
+    ok = check_vec_mat() && ok;
+    ok = check_constexpr_math() && ok;
+    ok = check_fast_math_accuracy() && ok;
+    ok = check_codec_accuracy() && ok;
+    ok = check_spatial() && ok;
+    ok = check_parallel() && ok;
+    ok = check_hierarchy() && ok;
+    ok = check_gpu_layout() && ok;
+    ok = check_quaternions() && ok;
+    ok = check_skinning() && ok;
+    ok = check_frustum() && ok;
+    ok = check_bvh() && ok;
+    ok = check_format() && ok;
+    ok = check_soa() && ok;
+    ok = check_transforms() && ok;
+    ok = check_precision() && ok;
+    ok = check_pack() && ok;
+    ok = check_batch_kernels() && ok;
+    ok = check_ray_packets() && ok;
+    ok = check_decomposition() && ok;
+    return ok ? 0 : 1;
+  }
+
+  register_types();
+  register_batch();
+  register_fast_math();
+  register_codec();
+  register_spatial();
+  register_parallel();
+  register_hierarchy();
+  register_gpu_layout();
+  register_decomposition();
+
+  // With --json - the table goes to stderr so stdout stays valid JSON
+  std::FILE* table = o.json == "-" ? stderr : stdout;
+  std::vector<result> results;
+  for (const benchmark& b : registry()) {
+    if (!o.filter.empty() && b.name.find(o.filter) == std::string::npos) continue;
+    if (o.list) {
+      std::printf("%s %s\n", b.name.c_str(), b.mode.c_str());
+      continue;
+    }
+    result r = measure(b, o);
+    results.push_back(r);
+    std::fprintf(table, "%-44s %-10s %12.3f ns %14.2f M/s\n", b.name.c_str(), b.mode.c_str(), r.ns_per_item,
+                 1e3 / r.ns_per_item);
+    std::fflush(table);
+  }
+
+  if (!o.json.empty() && !o.list) {
+    std::FILE* f = o.json == "-" ? stdout : std::fopen(o.json.c_str(), "w");
+    if (!f) {
+      std::fprintf(stderr, "cannot write %s\n", o.json.c_str());
+      return 1;
+    }
+    write_json(f, o, results);
+    if (f != stdout) std::fclose(f);
+  }
+  return 0;
+}
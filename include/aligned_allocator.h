@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+
+#include <cstddef>
+#include <new>
+
+namespace cgmath {
+
+// Allocator for std::vector storage that SIMD kernels can load with aligned instructions
+template <typename T, size_t Alignment>
+struct aligned_allocator
+{
+  static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+                "Alignment must be a power of two not smaller than alignof(T)");
+
+  using value_type = T;
+
+  template <typename U>
+  struct rebind { using other = aligned_allocator<U, Alignment>; };
+
+  constexpr aligned_allocator() noexcept = default;
+  template <typename U>
+  constexpr aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(T* p, size_t) noexcept {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  constexpr bool operator==(const aligned_allocator<U, Alignment>&) const noexcept { return true; }
+  template <typename U>
+  constexpr bool operator!=(const aligned_allocator<U, Alignment>&) const noexcept { return false; }
+};
+
+} // namespace cgmath
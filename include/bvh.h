@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "ray.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace cgmath {
+
+// 32-byte node. Interior nodes keep their children at first and first + 1, leaves
+// reference count triangles starting at first in bvh::triangles.
+struct alignas(32) bvh_node {
+  float3 min;
+  uint32_t first;
+  float3 max;
+  uint32_t count;
+
+  constexpr bool is_leaf() const noexcept { return count != 0; }
+};
+
+static_assert(sizeof(bvh_node) == 32, "bvh_node must be 32 bytes");
+
+// Triangle in the precomputed edge form used by the intersection test
+struct bvh_triangle {
+  float3 v0;
+  float3 e1;  // v1 - v0
+  float3 e2;  // v2 - v0
+};
+
+// Bounding volume hierarchy over a triangle mesh. Geometry is given as vertices plus
+// three indices per triangle, or as a plain soup of 3 * triangle_count vertices when
+// indices is null. The tree keeps its own copy of the triangles, so the source arrays
+// only need to live for the duration of build and refit.
+struct bvh {
+  std::vector<bvh_node> nodes;          // nodes[0] is the root
+  std::vector<bvh_triangle> triangles;  // leaf order
+  std::vector<uint32_t> primitives;     // leaf order -> source triangle index
+
+  // Binned SAH build on parallel_for. thread_count is parallel_options::thread_count: 0 uses
+  // every thread of the scheduler, 1 builds on the calling thread.
+  void build(const float3* vertices, const uint32_t* indices, size_t triangle_count, size_t thread_count = 0);
+
+  // Updates bounds after the vertices moved, keeping the topology. Quality degrades
+  // with large deformations, rebuild in that case.
+  void refit(const float3* vertices, const uint32_t* indices) noexcept;
+
+  bool empty() const noexcept { return triangles.empty(); }
+
+  // Closest hit within [r.t_min, r.t_max]; hit is updated only when a closer one is found
+  bool intersect(const ray& r, ray_hit& hit) const noexcept;
+
+  // Any hit within [r.t_min, r.t_max], for shadow and occlusion rays
+  bool occluded(const ray& r) const noexcept;
+};
+
+} // namespace cgmath
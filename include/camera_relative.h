@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "float4.h"
+#include "double3.h"
+#include "double4.h"
+#include "dmatrix4x4.h"
+#include "half.h"
+
+#include <cstddef>
+
+// Relative-to-camera downconversion: world data stays in double on the CPU and every frame
+// goes to the GPU as float (or half) offsets from the camera position. Subtracting in double
+// first keeps full float precision around the viewer however far it is from the world
+// origin; render with a view matrix whose eye is at zero.
+//
+// in and out must not overlap. Each call is one streaming pass, the cost is the memory
+// traffic (24 bytes in and 12 or 6 out per double3).
+
+namespace cgmath {
+
+// out[i] = in[i] - origin
+void relative_to_camera(const double3* in, const double3& origin, float3* out, size_t n) noexcept;
+
+// Far-field positions stored at half precision; only good to ~1/1000 of the distance
+void relative_to_camera(const double3* in, const double3& origin, half3* out, size_t n) noexcept;
+
+// xyz - origin, w is copied
+void relative_to_camera(const double4* in, const double3& origin, float4* out, size_t n) noexcept;
+
+// out[i] = in[i].relative_to(origin)
+void relative_to_camera(const dmatrix4x4* in, const double3& origin, matrix4x4* out, size_t n) noexcept;
+
+} // namespace cgmath
@@ -20,10 +20,41 @@
 #include "vector3.h"
 #include "vector4.h"
 
+#include "half.h"
+#include "double3.h"
+#include "double4.h"
+
 #include "matrix3x3.h"
 #include "matrix3x4.h"
 #include "matrix4x3.h"
 #include "matrix4x4.h"
+#include "dmatrix4x4.h"
+
+#include "vec.h"
+#include "mat.h"
+
+#include "quaternion.h"
+#include "dual_quaternion.h"
+#include "soa.h"
+#include "transform.h"
+#include "transform_hierarchy.h"
+#include "gpu_layout.h"
+#include "decomposition.h"
+#include "camera_relative.h"
+#include "vertex_codec.h"
+#include "morton.h"
+#include "spatial_hash.h"
+#include "skinning.h"
+#include "frustum.h"
+#include "ray.h"
+#include "bvh.h"
+#include "ray_packet.h"
+#include "text_writer.h"
+#include "pack.h"
+#include "cpu.h"
+#include "parallel.h"
+#include "fast_math.h"
+#include "constexpr_math.h"
 
 namespace cgmath {
 
@@ -54,30 +85,6 @@ constexpr float smoothstep(float edge0, float edge1, float x) noexcept {
 }
 constexpr float step(float edge, float x) noexcept { return x < edge ? 0.0f : 1.0f; }
 
-// Trigonometry
-inline float sin(float x) noexcept { return std::sin(x); }
-inline float cos(float x) noexcept { return std::cos(x); }
-inline float tan(float x) noexcept { return std::tan(x); }
-inline float asin(float x) noexcept { return std::asin(x); }
-inline float acos(float x) noexcept { return std::acos(x); }
-inline float atan(float x) noexcept { return std::atan(x); }
-inline float atan2(float y, float x) noexcept { return std::atan2(y, x); }
-
-// Power and logarithms
-inline float pow(float x, float y) noexcept { return std::pow(x, y); }
-inline float sqrt(float x) noexcept { return std::sqrt(x); }
-inline float rsqrt(float x) noexcept { return 1.0f / sqrt(x); }
-inline float log(float x) noexcept { return std::log(x); }
-inline float log2(float x) noexcept { return std::log2(x); }
-inline float log10(float x) noexcept { return std::log10(x); }
-
-// Rounding functions
-inline float floor(float x) noexcept { return std::floor(x); }
-inline float ceil(float x) noexcept { return std::ceil(x); }
-inline float round(float x) noexcept { return std::round(x); }
-inline float fract(float x) noexcept { return x - floor(x); }
-inline float trunc(float x) noexcept { return std::trunc(x); }
-
 // Constants of the Golden Ratio
 constexpr float PHI       = 1.618033988749895f;  // Golden ratio (φ)
 constexpr float INV_PHI   = 0.618033988749895f;  // 1 / φ
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+
+#include <limits>
+
+// Scalar functions that work in constant expressions, so tables and fixed camera or
+// projection matrices can be baked into the binary. At runtime cgmath::sqrt and friends
+// forward to libm exactly as before; during constant evaluation they switch to the
+// software versions in cgmath::compile_time.
+//
+// The software versions evaluate in double and round once to float, which matches the
+// double-precision libm result rounded to float; atan2 and pow are within 1 ULP of it.
+// sin, cos and tan reduce precisely for |x| < 2^20 only. atan2 does not tell +0 from -0
+// and pow of a negative base needs an integer exponent.
+
+namespace cgmath {
+
+namespace compile_time {
+
+namespace detail {
+
+constexpr double PI      = 3.14159265358979323846;
+constexpr double HALF_PI = 1.57079632679489661923;
+constexpr double LN2     = 0.69314718055994530942;
+constexpr double LN10    = 2.30258509299404568402;
+
+constexpr bool is_nan(double x) noexcept { return x != x; }
+constexpr bool is_inf(double x) noexcept { return x == std::numeric_limits<double>::infinity() || x == -std::numeric_limits<double>::infinity(); }
+
+// Out of range doubles must not reach the float conversion, it is not a constant expression
+constexpr float to_float(double x) noexcept {
+  if (x > std::numeric_limits<float>::max()) return std::numeric_limits<float>::infinity();
+  if (x < -std::numeric_limits<float>::max()) return -std::numeric_limits<float>::infinity();
+  return static_cast<float>(x);
+}
+
+constexpr double sqrt(double x) noexcept {
+  if (is_nan(x) || x < 0.0) return std::numeric_limits<double>::quiet_NaN();
+  if (x == 0.0 || is_inf(x)) return x;
+  // Scale into [1, 4) by powers of four, Newton from there
+  double scale = 1.0;
+  while (x >= 4.0) { x *= 0.25; scale *= 2.0; }
+  while (x < 1.0) { x *= 4.0; scale *= 0.5; }
+  double y = 0.5 * (x + 1.0);
+  for (int i = 0; i < 8; ++i) y = 0.5 * (y + x / y);
+  return y * scale;
+}
+
+// Nearest integer, ties to even like the default rounding mode
+constexpr double round_even(double x) noexcept {
+  if (!(x > -4503599627370496.0 && x < 4503599627370496.0)) return x;
+  double r = static_cast<double>(static_cast<int64_t>(x < 0.0 ? x - 0.5 : x + 0.5));
+  if (r - x == 0.5 || x - r == 0.5) r = static_cast<double>(static_cast<int64_t>(r / 2.0) * 2);
+  return r;
+}
+
+// x - k pi/2 with pi/2 split fdlibm-style into 33 + 33 + 53 bits; k*part is exact for k < 2^20.
+// Past 2^52 there is nothing left to reduce precisely and the quadrant is taken as 0.
+constexpr double reduce_half_pi(double x, int& quadrant) noexcept {
+  double n = round_even(x * (2.0 / PI));
+  quadrant = n > -4503599627370496.0 && n < 4503599627370496.0 ? static_cast<int>(static_cast<int64_t>(n) & 3) : 0;
+  return ((x - n * 1.57079632673412561417e+00) - n * 6.07710050630396597660e-11) - n * 2.02226624879595063154e-21;
+}
+
+// Taylor series on |r| <= pi/4, accurate to double rounding
+constexpr double sin_series(double r) noexcept {
+  double r2 = r * r, term = r, sum = r;
+  for (int i = 1; i < 14; ++i) {
+    term *= -r2 / ((2.0 * i) * (2.0 * i + 1.0));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double cos_series(double r) noexcept {
+  double r2 = r * r, term = 1.0, sum = 1.0;
+  for (int i = 1; i < 14; ++i) {
+    term *= -r2 / ((2.0 * i - 1.0) * (2.0 * i));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr void sincos(double x, double& s, double& c) noexcept {
+  if (is_nan(x) || is_inf(x)) {
+    s = c = std::numeric_limits<double>::quiet_NaN();
+    return;
+  }
+  int quadrant = 0;
+  double r = reduce_half_pi(x, quadrant);
+  double sr = sin_series(r), cr = cos_series(r);
+  switch (quadrant) {
+    case 0: s = sr; c = cr; break;
+    case 1: s = cr; c = -sr; break;
+    case 2: s = -sr; c = -cr; break;
+    default: s = -cr; c = sr; break;
+  }
+}
+
+constexpr double atan(double x) noexcept {
+  if (is_nan(x)) return x;
+  if (x < 0.0) return -atan(-x);
+  if (x > 1.0) return HALF_PI - atan(1.0 / x);
+  // Two half-angle steps bring x below tan(pi/16), where the series converges quickly
+  x = x / (1.0 + sqrt(1.0 + x * x));
+  x = x / (1.0 + sqrt(1.0 + x * x));
+  double x2 = x * x, power = x, sum = x;
+  for (int i = 1; i < 16; ++i) {
+    power *= -x2;
+    sum += power / (2.0 * i + 1.0);
+  }
+  return 4.0 * sum;
+}
+
+constexpr double atan2(double y, double x) noexcept {
+  if (is_nan(x) || is_nan(y)) return std::numeric_limits<double>::quiet_NaN();
+  if (x == 0.0) return y > 0.0 ? HALF_PI : y < 0.0 ? -HALF_PI : 0.0;
+  if (is_inf(x) || is_inf(y)) {
+    if (is_inf(y)) return (x > 0.0 && is_inf(x) ? 0.25 * PI : x < 0.0 && is_inf(x) ? 0.75 * PI : HALF_PI) * (y < 0.0 ? -1.0 : 1.0);
+    return x > 0.0 ? 0.0 : y < 0.0 ? -PI : PI;
+  }
+  double a = atan(y / x);
+  if (x > 0.0) return a;
+  return y < 0.0 ? a - PI : a + PI;
+}
+
+constexpr double exp(double x) noexcept {
+  if (is_nan(x)) return x;
+  if (x > 709.0) return std::numeric_limits<double>::infinity();
+  if (x < -745.0) return 0.0;
+  // x = k ln2 + r with |r| <= ln2 / 2
+  double k = round_even(x / LN2);
+  double r = (x - k * 6.93147180369123816490e-01) - k * 1.90821492927058770002e-10;
+  double term = 1.0, sum = 1.0;
+  for (int i = 1; i < 20; ++i) {
+    term *= r / i;
+    sum += term;
+  }
+  for (; k > 0.0; k -= 1.0) sum *= 2.0;
+  for (; k < 0.0; k += 1.0) sum *= 0.5;
+  return sum;
+}
+
+constexpr double log(double x) noexcept {
+  if (is_nan(x) || x < 0.0) return std::numeric_limits<double>::quiet_NaN();
+  if (x == 0.0) return -std::numeric_limits<double>::infinity();
+  if (is_inf(x)) return x;
+  // x = m 2^e with m in [sqrt(1/2), sqrt(2)), then log(m) = 2 atanh((m - 1) / (m + 1))
+  double e = 0.0;
+  while (x >= 1.41421356237309504880) { x *= 0.5; e += 1.0; }
+  while (x < 0.70710678118654752440) { x *= 2.0; e -= 1.0; }
+  double s = (x - 1.0) / (x + 1.0), s2 = s * s, power = s, sum = s;
+  for (int i = 1; i < 14; ++i) {
+    power *= s2;
+    sum += power / (2.0 * i + 1.0);
+  }
+  return e * LN2 + 2.0 * sum;
+}
+
+constexpr bool is_integer(double x) noexcept {
+  return x > -4503599627370496.0 && x < 4503599627370496.0 ? static_cast<double>(static_cast<int64_t>(x)) == x : !is_nan(x);
+}
+
+constexpr double pow(double x, double y) noexcept {
+  if (y == 0.0 || x == 1.0) return 1.0;
+  if (is_nan(x) || is_nan(y)) return std::numeric_limits<double>::quiet_NaN();
+  if (x == 0.0) return y > 0.0 ? 0.0 : std::numeric_limits<double>::infinity();
+  if (x < 0.0) {
+    if (!is_integer(y)) return std::numeric_limits<double>::quiet_NaN();
+    bool odd = y > -9007199254740992.0 && y < 9007199254740992.0 && static_cast<int64_t>(y) % 2 != 0;
+    return odd ? -pow(-x, y) : pow(-x, y);
+  }
+  return exp(y * log(x));
+}
+
+} // namespace detail
+
+constexpr float sqrt(float x) noexcept { return static_cast<float>(detail::sqrt(x)); }
+constexpr float sin(float x) noexcept { double s = 0.0, c = 0.0; detail::sincos(x, s, c); return static_cast<float>(s); }
+constexpr float cos(float x) noexcept { double s = 0.0, c = 0.0; detail::sincos(x, s, c); return static_cast<float>(c); }
+constexpr float tan(float x) noexcept { double s = 0.0, c = 0.0; detail::sincos(x, s, c); return detail::to_float(s / c); }
+constexpr float atan(float x) noexcept { return static_cast<float>(detail::atan(x)); }
+constexpr float atan2(float y, float x) noexcept { return static_cast<float>(detail::atan2(y, x)); }
+
+constexpr float asin(float x) noexcept {
+  if (x < -1.0f || x > 1.0f) return std::numeric_limits<float>::quiet_NaN();
+  double d = x;
+  return static_cast<float>(detail::atan2(d, detail::sqrt((1.0 - d) * (1.0 + d))));
+}
+
+constexpr float acos(float x) noexcept {
+  if (x < -1.0f || x > 1.0f) return std::numeric_limits<float>::quiet_NaN();
+  double d = x;
+  return static_cast<float>(detail::atan2(detail::sqrt((1.0 - d) * (1.0 + d)), d));
+}
+
+constexpr float exp(float x) noexcept { return detail::to_float(detail::exp(x)); }
+constexpr float log(float x) noexcept { return static_cast<float>(detail::log(x)); }
+constexpr float log2(float x) noexcept { return static_cast<float>(detail::log(x) / detail::LN2); }
+constexpr float log10(float x) noexcept { return static_cast<float>(detail::log(x) / detail::LN10); }
+constexpr float pow(float x, float y) noexcept { return detail::to_float(detail::pow(x, y)); }
+
+// Inputs of 2^23 and beyond are already integral; NaN and inf pass through the same way
+constexpr float trunc(float x) noexcept {
+  if (!(x > -8388608.0f && x < 8388608.0f)) return x;
+  float t = static_cast<float>(static_cast<int32_t>(x));
+  return t == 0.0f && x < 0.0f ? -0.0f : t;
+}
+
+constexpr float floor(float x) noexcept {
+  float t = trunc(x);
+  return t > x ? t - 1.0f : t;
+}
+
+constexpr float ceil(float x) noexcept {
+  float t = trunc(x);
+  return t < x ? t + 1.0f : t;
+}
+
+// Halfway cases away from zero like std::round
+constexpr float round(float x) noexcept {
+  float t = trunc(x);
+  if (x - t >= 0.5f) return t + 1.0f;
+  if (t - x >= 0.5f) return t - 1.0f;
+  return t;
+}
+
+// The non-NaN argument wins like std::fmin and std::fmax
+constexpr float fmin(float a, float b) noexcept { return b != b || a < b ? a : b; }
+constexpr float fmax(float a, float b) noexcept { return b != b || a > b ? a : b; }
+
+} // namespace compile_time
+
+// Trigonometry
+constexpr float sin(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::sin(x);
+  return compile_time::sin(x);
+}
+
+constexpr float cos(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::cos(x);
+  return compile_time::cos(x);
+}
+
+constexpr float tan(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::tan(x);
+  return compile_time::tan(x);
+}
+
+constexpr float asin(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::asin(x);
+  return compile_time::asin(x);
+}
+
+constexpr float acos(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::acos(x);
+  return compile_time::acos(x);
+}
+
+constexpr float atan(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::atan(x);
+  return compile_time::atan(x);
+}
+
+constexpr float atan2(float y, float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::atan2(y, x);
+  return compile_time::atan2(y, x);
+}
+
+// Power and logarithms
+constexpr float pow(float x, float y) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::pow(x, y);
+  return compile_time::pow(x, y);
+}
+
+constexpr float sqrt(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::sqrt(x);
+  return compile_time::sqrt(x);
+}
+
+constexpr float rsqrt(float x) noexcept { return 1.0f / sqrt(x); }
+
+constexpr float exp(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::exp(x);
+  return compile_time::exp(x);
+}
+
+constexpr float log(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::log(x);
+  return compile_time::log(x);
+}
+
+constexpr float log2(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::log2(x);
+  return compile_time::log2(x);
+}
+
+constexpr float log10(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::log10(x);
+  return compile_time::log10(x);
+}
+
+// Rounding functions
+constexpr float floor(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::floor(x);
+  return compile_time::floor(x);
+}
+
+constexpr float ceil(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::ceil(x);
+  return compile_time::ceil(x);
+}
+
+constexpr float round(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::round(x);
+  return compile_time::round(x);
+}
+
+constexpr float trunc(float x) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::trunc(x);
+  return compile_time::trunc(x);
+}
+
+constexpr float fract(float x) noexcept { return x - floor(x); }
+
+// NaN-ignoring min and max for clamping
+constexpr float fmin(float a, float b) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::fmin(a, b);
+  return compile_time::fmin(a, b);
+}
+
+constexpr float fmax(float a, float b) noexcept {
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::fmax(a, b);
+  return compile_time::fmax(a, b);
+}
+
+} // namespace cgmath
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+
+// Runtime CPU feature detection for the batch kernels (soa, transform, quaternion arrays,
+// frustum culling). The library carries one kernel table per instruction set it was built
+// for and picks the widest one the host supports on first use. Setting the environment
+// variable CG_MATH_ISA to scalar, sse2, sse4.1, avx2 or avx512 caps that choice, which is
+// handy for testing the narrower paths on a wide machine.
+
+namespace cgmath {
+
+enum class cpu_isa : uint8_t {
+  scalar,
+  sse2,
+  sse41,
+  avx2,   // with FMA and F16C
+  avx512  // AVX-512F
+};
+
+// Instruction sets usable on this host; AVX and AVX-512 also require the OS to save
+// the wider register state
+struct cpu_features {
+  bool sse2 = false;
+  bool sse3 = false;
+  bool ssse3 = false;
+  bool sse41 = false;
+  bool sse42 = false;
+  bool avx = false;
+  bool avx2 = false;
+  bool fma = false;
+  bool f16c = false;
+  bool avx512f = false;
+};
+
+// CPUID results, detected once
+const cpu_features& cpu_detect() noexcept;
+
+// Widest level the host can run
+cpu_isa host_isa() noexcept;
+
+// Level the batch kernels currently run at
+cpu_isa active_isa() noexcept;
+
+// Caps the kernel level, like CG_MATH_ISA. Levels the host or the build lack fall back to
+// the next narrower one; returns the level now active. Not meant to race with running kernels.
+cpu_isa set_isa(cpu_isa max) noexcept;
+
+// "scalar", "sse2", "sse4.1", "avx2" or "avx512"
+const char* isa_name(cpu_isa isa) noexcept;
+
+} // namespace cgmath
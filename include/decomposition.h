@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "matrix3x3.h"
+#include "soa.h"
+
+#include <cstddef>
+
+// Decompositions of 3x3 matrices for deformation, physics and animation code: symmetric
+// eigen-decomposition, SVD and polar decomposition. All three run a fixed number of Jacobi
+// sweeps without data-dependent branches, so the SoA overloads decompose a whole SIMD register
+// of matrices at a time (4, 8 or 16 with SSE, AVX2 or AVX-512 dispatch).
+//
+// Products of the factors reproduce the input to about 1e-6 of its largest entry. Singular and
+// rank-deficient matrices are fine, with arbitrary but orthonormal vectors for the null space.
+
+namespace cgmath {
+
+// m = vectors * diag(values) * vectors^T, eigenvectors in the columns of a rotation matrix,
+// values in decreasing order
+struct eigen3 {
+  float3 values;
+  matrix3x3 vectors;
+};
+
+// m = u * diag(sigma) * v^T with u and v rotations. |sigma| is decreasing and only sigma.z
+// can be negative, carrying the sign of det(m).
+struct svd3 {
+  matrix3x3 u;
+  float3 sigma;
+  matrix3x3 v;
+};
+
+// m = rotation * stretch with stretch symmetric. The rotation is always proper: for
+// det(m) < 0 stretch takes the reflection, as co-rotational solvers expect.
+struct polar3 {
+  matrix3x3 rotation;
+  matrix3x3 stretch;
+};
+
+// Only the symmetric part (m + m^T) / 2 is decomposed
+eigen3 eigen_symmetric(const matrix3x3& m) noexcept;
+svd3 svd(const matrix3x3& m) noexcept;
+polar3 polar(const matrix3x3& m) noexcept;
+
+// size matrices as nine streams, m[r * 3 + c] holding element (r, c)
+struct matrix3x3_soa_view {
+  float* m[9];
+  size_t size;
+};
+
+struct const_matrix3x3_soa_view {
+  const float* m[9];
+  size_t size;
+};
+
+// Batch forms over m.size matrices; outputs need as many elements
+void eigen_symmetric(const_matrix3x3_soa_view m, float3_soa_view values, matrix3x3_soa_view vectors) noexcept;
+void svd(const_matrix3x3_soa_view m, matrix3x3_soa_view u, float3_soa_view sigma, matrix3x3_soa_view v) noexcept;
+void polar(const_matrix3x3_soa_view m, matrix3x3_soa_view rotation, matrix3x3_soa_view stretch) noexcept;
+
+} // namespace cgmath
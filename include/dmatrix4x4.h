@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "format.h"
+#include "double3.h"
+#include "double4.h"
+#include "matrix4x4.h"
+
+namespace cgmath {
+
+// Double precision counterpart of matrix4x4 for world transforms of large scenes: row-major,
+// vectors are columns and the translation lives in m[0..2][3]. It is kept on the CPU; what
+// goes to float is the transform relative to the camera, see relative_to().
+struct dmatrix4x4 {
+  double m[4][4];
+
+  constexpr dmatrix4x4() noexcept : m{} {}
+
+  constexpr dmatrix4x4(double m00, double m01, double m02, double m03,
+                       double m10, double m11, double m12, double m13,
+                       double m20, double m21, double m22, double m23,
+                       double m30, double m31, double m32, double m33) noexcept
+  : m{{m00, m01, m02, m03}, {m10, m11, m12, m13}, {m20, m21, m22, m23}, {m30, m31, m32, m33}} {}
+
+  constexpr explicit dmatrix4x4(const matrix4x4& f) noexcept
+  : m{{f._m._11, f._m._12, f._m._13, f._m._14},
+      {f._m._21, f._m._22, f._m._23, f._m._24},
+      {f._m._31, f._m._32, f._m._33, f._m._34},
+      {f._m._41, f._m._42, f._m._43, f._m._44}} {}
+
+  static constexpr dmatrix4x4 identity() noexcept {
+    return dmatrix4x4(
+      1.0, 0.0, 0.0, 0.0,
+      0.0, 1.0, 0.0, 0.0,
+      0.0, 0.0, 1.0, 0.0,
+      0.0, 0.0, 0.0, 1.0
+    );
+  }
+
+  static constexpr dmatrix4x4 translation(const double3& t) noexcept {
+    return dmatrix4x4(
+      1.0, 0.0, 0.0, t.x,
+      0.0, 1.0, 0.0, t.y,
+      0.0, 0.0, 1.0, t.z,
+      0.0, 0.0, 0.0, 1.0
+    );
+  }
+
+  // A float rotation/scale (the translation of r is ignored) placed at a double position
+  static constexpr dmatrix4x4 from_rotation_translation(const matrix4x4& r, const double3& t) noexcept {
+    dmatrix4x4 d(r);
+    d.m[0][3] = t.x;
+    d.m[1][3] = t.y;
+    d.m[2][3] = t.z;
+    d.m[3][0] = d.m[3][1] = d.m[3][2] = 0.0;
+    d.m[3][3] = 1.0;
+    return d;
+  }
+
+  double operator()(size_t row, size_t col) const noexcept { return m[row][col]; }
+  double& operator()(size_t row, size_t col) noexcept { return m[row][col]; }
+
+  constexpr double3 get_translation() const noexcept { return {m[0][3], m[1][3], m[2][3]}; }
+
+  constexpr dmatrix4x4 operator*(const dmatrix4x4& other) const noexcept {
+    dmatrix4x4 r;
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        r.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j] + m[i][3] * other.m[3][j];
+      }
+    }
+    return r;
+  }
+
+  constexpr double4 operator*(const double4& v) const noexcept {
+    return {
+      m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3] * v.w,
+      m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + m[1][3] * v.w,
+      m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z + m[2][3] * v.w,
+      m[3][0] * v.x + m[3][1] * v.y + m[3][2] * v.z + m[3][3] * v.w
+    };
+  }
+
+  // Affine point transform (w = 1), the fourth row is ignored
+  constexpr double3 transform_point(const double3& p) const noexcept {
+    return {
+      m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+      m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+      m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]
+    };
+  }
+
+  // Direction transform (w = 0), translation is ignored
+  constexpr double3 transform_direction(const double3& d) const noexcept {
+    return {
+      m[0][0] * d.x + m[0][1] * d.y + m[0][2] * d.z,
+      m[1][0] * d.x + m[1][1] * d.y + m[1][2] * d.z,
+      m[2][0] * d.x + m[2][1] * d.y + m[2][2] * d.z
+    };
+  }
+
+  constexpr dmatrix4x4 transpose() const noexcept {
+    dmatrix4x4 r;
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) r.m[i][j] = m[j][i];
+    }
+    return r;
+  }
+
+  // Rounds every element, only safe when the translation is small
+  constexpr matrix4x4 to_matrix4x4() const noexcept {
+    return matrix4x4(
+      static_cast<float>(m[0][0]), static_cast<float>(m[0][1]), static_cast<float>(m[0][2]), static_cast<float>(m[0][3]),
+      static_cast<float>(m[1][0]), static_cast<float>(m[1][1]), static_cast<float>(m[1][2]), static_cast<float>(m[1][3]),
+      static_cast<float>(m[2][0]), static_cast<float>(m[2][1]), static_cast<float>(m[2][2]), static_cast<float>(m[2][3]),
+      static_cast<float>(m[3][0]), static_cast<float>(m[3][1]), static_cast<float>(m[3][2]), static_cast<float>(m[3][3])
+    );
+  }
+
+  // translation(-origin) * this in float: the same transform for a world whose origin moved
+  // to `origin`. The large parts cancel in double before rounding, so objects near the
+  // camera keep full float precision. Pair it with a view matrix whose eye is at zero.
+  constexpr matrix4x4 relative_to(const double3& origin) const noexcept {
+    const double o[3] = {origin.x, origin.y, origin.z};
+    float r[16] = {};
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 4; ++j) r[i * 4 + j] = static_cast<float>(m[i][j] - o[i] * m[3][j]);
+    }
+    for (int j = 0; j < 4; ++j) r[12 + j] = static_cast<float>(m[3][j]);
+    return matrix4x4(r);
+  }
+
+  // One "| a b c d |" line per row with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    return format_rows(first, last, m[0], 4, 4);
+  }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
+
+  constexpr bool operator==(const dmatrix4x4& other) const noexcept {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        if (m[i][j] != other.m[i][j]) return false;
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace cgmath
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
+#include "float3.h"
+
+namespace cgmath {
+
+// Double precision position for large worlds. Keep world coordinates in double3 and move
+// them to float only relative to a nearby origin (usually the camera), see camera_relative.h.
+struct double3
+{
+  double x, y, z;
+
+  constexpr double3() noexcept : x(0.0), y(0.0), z(0.0) {}
+  constexpr double3(double _x, double _y, double _z) noexcept : x(_x), y(_y), z(_z) {}
+  constexpr explicit double3(const float3& v) noexcept : x(v.x), y(v.y), z(v.z) {}
+
+#if (__cplusplus >= 202002L)
+  constexpr bool operator==(const double3&) const noexcept = default;
+#else
+  constexpr bool operator==(const double3& other) const noexcept {
+    return x == other.x && y == other.y && z == other.z;
+  }
+#endif
+
+  constexpr double3 operator+(const double3& v) const noexcept { return {x + v.x, y + v.y, z + v.z}; }
+  constexpr double3 operator-(const double3& v) const noexcept { return {x - v.x, y - v.y, z - v.z}; }
+  constexpr double3 operator-() const noexcept { return {-x, -y, -z}; }
+  constexpr double3 operator*(double scalar) const noexcept { return {x * scalar, y * scalar, z * scalar}; }
+  constexpr double3 operator/(double scalar) const noexcept { return {x / scalar, y / scalar, z / scalar}; }
+
+  constexpr double3& operator+=(const double3& v) noexcept { x += v.x; y += v.y; z += v.z; return *this; }
+  constexpr double3& operator-=(const double3& v) noexcept { x -= v.x; y -= v.y; z -= v.z; return *this; }
+  constexpr double3& operator*=(double scalar) noexcept { x *= scalar; y *= scalar; z *= scalar; return *this; }
+  constexpr double3& operator/=(double scalar) noexcept { x /= scalar; y /= scalar; z /= scalar; return *this; }
+
+  constexpr double dot(const double3& v) const noexcept { return x * v.x + y * v.y + z * v.z; }
+
+  constexpr double3 cross(const double3& v) const noexcept {
+    return {
+      y * v.z - z * v.y,
+      z * v.x - x * v.z,
+      x * v.y - y * v.x
+    };
+  }
+
+  constexpr double length() const noexcept {
+    double l = dot(*this);
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::sqrt(l);
+    return compile_time::detail::sqrt(l);
+  }
+
+  constexpr double3 normalized() const noexcept {
+    double len = length();
+    return len > 0 ? double3{x / len, y / len, z / len} : double3{};
+  }
+
+  // Rounds each component; subtract a nearby origin first to keep the precision
+  constexpr float3 to_float3() const noexcept {
+    return {static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)};
+  }
+
+  // "double3(x, y, z)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const double v[] = {x, y, z};
+    return format_tuple(first, last, "double3", v, 3);
+  }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
+};
+
+static_assert(sizeof(double3) == sizeof(double) * 3, "double3 must be 24 bytes");
+
+} // namespace cgmath
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
+#include "float4.h"
+#include "double3.h"
+
+namespace cgmath {
+
+struct double4
+{
+  double x, y, z, w;
+
+  constexpr double4() noexcept : x(0.0), y(0.0), z(0.0), w(0.0) {}
+  constexpr double4(double _x, double _y, double _z, double _w) noexcept : x(_x), y(_y), z(_z), w(_w) {}
+  constexpr double4(const double3& v, double _w) noexcept : x(v.x), y(v.y), z(v.z), w(_w) {}
+  constexpr explicit double4(const float4& v) noexcept : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+#if (__cplusplus >= 202002L)
+  constexpr bool operator==(const double4&) const noexcept = default;
+#else
+  constexpr bool operator==(const double4& other) const noexcept {
+    return x == other.x && y == other.y && z == other.z && w == other.w;
+  }
+#endif
+
+  constexpr double4 operator+(const double4& v) const noexcept { return {x + v.x, y + v.y, z + v.z, w + v.w}; }
+  constexpr double4 operator-(const double4& v) const noexcept { return {x - v.x, y - v.y, z - v.z, w - v.w}; }
+  constexpr double4 operator*(double scalar) const noexcept { return {x * scalar, y * scalar, z * scalar, w * scalar}; }
+  constexpr double4 operator/(double scalar) const noexcept { return {x / scalar, y / scalar, z / scalar, w / scalar}; }
+
+  constexpr double4& operator+=(const double4& v) noexcept { x += v.x; y += v.y; z += v.z; w += v.w; return *this; }
+  constexpr double4& operator-=(const double4& v) noexcept { x -= v.x; y -= v.y; z -= v.z; w -= v.w; return *this; }
+  constexpr double4& operator*=(double scalar) noexcept { x *= scalar; y *= scalar; z *= scalar; w *= scalar; return *this; }
+  constexpr double4& operator/=(double scalar) noexcept { x /= scalar; y /= scalar; z /= scalar; w /= scalar; return *this; }
+
+  constexpr double dot(const double4& v) const noexcept { return x * v.x + y * v.y + z * v.z + w * v.w; }
+
+  constexpr double length() const noexcept {
+    double l = dot(*this);
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return std::sqrt(l);
+    return compile_time::detail::sqrt(l);
+  }
+
+  constexpr double3 xyz() const noexcept { return {x, y, z}; }
+
+  constexpr float4 to_float4() const noexcept {
+    return {static_cast<float>(x), static_cast<float>(y), static_cast<float>(z), static_cast<float>(w)};
+  }
+
+  // "double4(x, y, z, w)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const double v[] = {x, y, z, w};
+    return format_tuple(first, last, "double4", v, 4);
+  }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
+};
+
+static_assert(sizeof(double4) == sizeof(double) * 4, "double4 must be 32 bytes");
+
+} // namespace cgmath
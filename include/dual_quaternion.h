@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "matrix3x3.h"
+#include "matrix3x4.h"
+#include "quaternion.h"
+
+namespace cgmath {
+
+// Rigid transform as real (rotation) and dual (0.5 * translation * rotation) quaternions
+struct alignas(16) dual_quaternion
+{
+  quaternion real;
+  quaternion dual;
+
+  constexpr dual_quaternion() noexcept : real(), dual(0.0f, 0.0f, 0.0f, 0.0f) {}
+  constexpr dual_quaternion(const quaternion& _real, const quaternion& _dual) noexcept : real(_real), dual(_dual) {}
+
+  static constexpr dual_quaternion from_rotation_translation(const quaternion& r, const float3& t) noexcept {
+    return {r, quaternion(t.x, t.y, t.z, 0.0f) * r * 0.5f};
+  }
+
+  // Rotation and translation of a rigid matrix3x4, scale and shear are not representable
+  static constexpr dual_quaternion from_matrix(const matrix3x4& m) noexcept {
+    matrix3x3 r(m._m._11, m._m._12, m._m._13,
+                m._m._21, m._m._22, m._m._23,
+                m._m._31, m._m._32, m._m._33);
+    return from_rotation_translation(quaternion::from_matrix(r).normalized(), float3(m._m._14, m._m._24, m._m._34));
+  }
+
+  constexpr dual_quaternion operator+(const dual_quaternion& q) const noexcept { return {real + q.real, dual + q.dual}; }
+  constexpr dual_quaternion operator*(float scalar) const noexcept { return {real * scalar, dual * scalar}; }
+
+  constexpr dual_quaternion normalized() const noexcept {
+    float len = real.length();
+    return len > 0.0f ? *this * (1.0f / len) : dual_quaternion{};
+  }
+
+  // Valid for normalized dual quaternions
+  constexpr float3 translation() const noexcept {
+    quaternion t = dual * real.conjugate();
+    return {2.0f * t.v.vec.x, 2.0f * t.v.vec.y, 2.0f * t.v.vec.z};
+  }
+
+  constexpr float3 transform_point(const float3& p) const noexcept { return real.rotate(p) + translation(); }
+  constexpr float3 transform_direction(const float3& d) const noexcept { return real.rotate(d); }
+
+  constexpr matrix3x4 to_matrix3x4() const noexcept { return real.to_matrix3x4(translation()); }
+};
+
+static_assert(sizeof(dual_quaternion) == 32, "dual_quaternion must be 32 bytes");
+
+} // namespace cgmath
@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "simd.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Approximate elementary functions for code that trades a few ULP for speed and
+// vectorization: particles, audio, procedural noise. cgmath::sin and friends keep
+// forwarding to libm.
+//
+// Each function comes as a float, an __m128 (SSE2) and an __m256 (AVX2) overload built from
+// the same code, so a lane computes the same result at any width up to FMA contraction.
+// Maximum errors against the exact result, checked by `cgmath_bench --accuracy`:
+//
+//   rsqrt      4 ULP      positive normal x; 0 gives inf, inf and subnormals are not handled
+//   sin, cos   2 ULP      |x| <= pi/2
+//              1.5e-7     absolute for |x| <= 8192, relative error grows near the zeros
+//   atan2      4 ULP      NaN in gives NaN; both arguments infinite is not handled
+//   exp2       2 ULP    subnormal results are rounded twice; overflow gives inf
+//   exp        2 ULP    as exp2
+//   log2       2 ULP    x < 0 and NaN give NaN, 0 gives -inf
+//   log        2 ULP    as log2
+//
+// The vector forms expect the default MXCSR rounding mode. The float forms are branchless and
+// mostly there for loop tails; on their own they rarely beat libm except for sin, cos and atan2.
+
+namespace cgmath::fast {
+
+namespace detail {
+
+// The handful of operations the kernels below need, per register width. Keyed by the lane
+// count since GCC drops the vector attributes of __m128 in template arguments.
+template <size_t Width> struct ops_for;
+template <typename V> using ops = ops_for<sizeof(V) / sizeof(float)>;
+
+template <>
+struct ops_for<1> {
+  using mask = bool;
+  using ints = int32_t;
+
+  static float set1(float v) noexcept { return v; }
+  static float add(float a, float b) noexcept { return a + b; }
+  static float sub(float a, float b) noexcept { return a - b; }
+  static float mul(float a, float b) noexcept { return a * b; }
+  static float div(float a, float b) noexcept { return a / b; }
+  static float madd(float a, float b, float c) noexcept {
+#ifdef __FMA__
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+  }
+  static float min(float a, float b) noexcept { return a < b ? a : b; }
+  static float max(float a, float b) noexcept { return a > b ? a : b; }
+
+  static bool lt(float a, float b) noexcept { return a < b; }
+  static bool gt(float a, float b) noexcept { return a > b; }
+  static bool eq(float a, float b) noexcept { return a == b; }
+  static float select(bool m, float a, float b) noexcept { return m ? a : b; }
+
+  static float rsqrt_estimate(float x) noexcept {
+#ifdef __SSE__
+    return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+    return 1.0f / std::sqrt(x);
+#endif
+  }
+
+  // Round to nearest, INT32_MIN when out of range like cvtps2dq
+  static int32_t to_int(float v) noexcept {
+#ifdef __SSE__
+    return _mm_cvtss_si32(_mm_set_ss(v));
+#else
+    return v > -2147483648.0f && v < 2147483648.0f ? static_cast<int32_t>(std::nearbyint(v)) : INT32_MIN;
+#endif
+  }
+  static float to_float(int32_t v) noexcept { return static_cast<float>(v); }
+  static int32_t as_int(float v) noexcept {
+    int32_t i;
+    std::memcpy(&i, &v, sizeof(i));
+    return i;
+  }
+  static float as_float(int32_t v) noexcept {
+    float f;
+    std::memcpy(&f, &v, sizeof(f));
+    return f;
+  }
+
+  static int32_t iset1(int32_t v) noexcept { return v; }
+  static int32_t iadd(int32_t a, int32_t b) noexcept { return static_cast<int32_t>(uint32_t(a) + uint32_t(b)); }
+  static int32_t isub(int32_t a, int32_t b) noexcept { return static_cast<int32_t>(uint32_t(a) - uint32_t(b)); }
+  static int32_t iand(int32_t a, int32_t b) noexcept { return a & b; }
+  static int32_t ior(int32_t a, int32_t b) noexcept { return a | b; }
+  static int32_t ixor(int32_t a, int32_t b) noexcept { return a ^ b; }
+  static bool ieq(int32_t a, int32_t b) noexcept { return a == b; }
+  template <int N> static int32_t shl(int32_t a) noexcept { return static_cast<int32_t>(uint32_t(a) << N); }
+  template <int N> static int32_t sra(int32_t a) noexcept { return a >> N; }
+};
+
+#ifdef __SSE2__
+
+template <>
+struct ops_for<4> {
+  using mask = __m128;
+  using ints = __m128i;
+
+  static __m128 set1(float v) noexcept { return _mm_set1_ps(v); }
+  static __m128 add(__m128 a, __m128 b) noexcept { return _mm_add_ps(a, b); }
+  static __m128 sub(__m128 a, __m128 b) noexcept { return _mm_sub_ps(a, b); }
+  static __m128 mul(__m128 a, __m128 b) noexcept { return _mm_mul_ps(a, b); }
+  static __m128 div(__m128 a, __m128 b) noexcept { return _mm_div_ps(a, b); }
+  static __m128 madd(__m128 a, __m128 b, __m128 c) noexcept { return simd::madd(a, b, c); }
+  static __m128 min(__m128 a, __m128 b) noexcept { return _mm_min_ps(a, b); }
+  static __m128 max(__m128 a, __m128 b) noexcept { return _mm_max_ps(a, b); }
+
+  static __m128 lt(__m128 a, __m128 b) noexcept { return _mm_cmplt_ps(a, b); }
+  static __m128 gt(__m128 a, __m128 b) noexcept { return _mm_cmpgt_ps(a, b); }
+  static __m128 eq(__m128 a, __m128 b) noexcept { return _mm_cmpeq_ps(a, b); }
+  static __m128 select(__m128 m, __m128 a, __m128 b) noexcept {
+#ifdef __SSE4_1__
+    return _mm_blendv_ps(b, a, m);
+#else
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+#endif
+  }
+
+  static __m128 rsqrt_estimate(__m128 x) noexcept { return _mm_rsqrt_ps(x); }
+
+  static __m128i to_int(__m128 v) noexcept { return _mm_cvtps_epi32(v); }
+  static __m128 to_float(__m128i v) noexcept { return _mm_cvtepi32_ps(v); }
+  static __m128i as_int(__m128 v) noexcept { return _mm_castps_si128(v); }
+  static __m128 as_float(__m128i v) noexcept { return _mm_castsi128_ps(v); }
+
+  static __m128i iset1(int32_t v) noexcept { return _mm_set1_epi32(v); }
+  static __m128i iadd(__m128i a, __m128i b) noexcept { return _mm_add_epi32(a, b); }
+  static __m128i isub(__m128i a, __m128i b) noexcept { return _mm_sub_epi32(a, b); }
+  static __m128i iand(__m128i a, __m128i b) noexcept { return _mm_and_si128(a, b); }
+  static __m128i ior(__m128i a, __m128i b) noexcept { return _mm_or_si128(a, b); }
+  static __m128i ixor(__m128i a, __m128i b) noexcept { return _mm_xor_si128(a, b); }
+  static __m128 ieq(__m128i a, __m128i b) noexcept { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+  template <int N> static __m128i shl(__m128i a) noexcept { return _mm_slli_epi32(a, N); }
+  template <int N> static __m128i sra(__m128i a) noexcept { return _mm_srai_epi32(a, N); }
+};
+
+#endif
+
+#ifdef __AVX2__
+
+template <>
+struct ops_for<8> {
+  using mask = __m256;
+  using ints = __m256i;
+
+  static __m256 set1(float v) noexcept { return _mm256_set1_ps(v); }
+  static __m256 add(__m256 a, __m256 b) noexcept { return _mm256_add_ps(a, b); }
+  static __m256 sub(__m256 a, __m256 b) noexcept { return _mm256_sub_ps(a, b); }
+  static __m256 mul(__m256 a, __m256 b) noexcept { return _mm256_mul_ps(a, b); }
+  static __m256 div(__m256 a, __m256 b) noexcept { return _mm256_div_ps(a, b); }
+  static __m256 madd(__m256 a, __m256 b, __m256 c) noexcept {
+#ifdef __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+  }
+  static __m256 min(__m256 a, __m256 b) noexcept { return _mm256_min_ps(a, b); }
+  static __m256 max(__m256 a, __m256 b) noexcept { return _mm256_max_ps(a, b); }
+
+  static __m256 lt(__m256 a, __m256 b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static __m256 gt(__m256 a, __m256 b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+  static __m256 eq(__m256 a, __m256 b) noexcept { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+  static __m256 select(__m256 m, __m256 a, __m256 b) noexcept { return _mm256_blendv_ps(b, a, m); }
+
+  static __m256 rsqrt_estimate(__m256 x) noexcept { return _mm256_rsqrt_ps(x); }
+
+  static __m256i to_int(__m256 v) noexcept { return _mm256_cvtps_epi32(v); }
+  static __m256 to_float(__m256i v) noexcept { return _mm256_cvtepi32_ps(v); }
+  static __m256i as_int(__m256 v) noexcept { return _mm256_castps_si256(v); }
+  static __m256 as_float(__m256i v) noexcept { return _mm256_castsi256_ps(v); }
+
+  static __m256i iset1(int32_t v) noexcept { return _mm256_set1_epi32(v); }
+  static __m256i iadd(__m256i a, __m256i b) noexcept { return _mm256_add_epi32(a, b); }
+  static __m256i isub(__m256i a, __m256i b) noexcept { return _mm256_sub_epi32(a, b); }
+  static __m256i iand(__m256i a, __m256i b) noexcept { return _mm256_and_si256(a, b); }
+  static __m256i ior(__m256i a, __m256i b) noexcept { return _mm256_or_si256(a, b); }
+  static __m256i ixor(__m256i a, __m256i b) noexcept { return _mm256_xor_si256(a, b); }
+  static __m256 ieq(__m256i a, __m256i b) noexcept { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+  template <int N> static __m256i shl(__m256i a) noexcept { return _mm256_slli_epi32(a, N); }
+  template <int N> static __m256i sra(__m256i a) noexcept { return _mm256_srai_epi32(a, N); }
+};
+
+#endif
+
+// One Newton-Raphson step on the ~12-bit hardware estimate
+template <typename V>
+inline V rsqrt(V x) noexcept {
+  using O = ops<V>;
+  V r = O::rsqrt_estimate(x);
+  V refined = O::mul(O::mul(O::set1(0.5f), r), O::madd(O::mul(O::mul(O::set1(-1.0f), x), r), r, O::set1(3.0f)));
+  return O::select(O::eq(x, O::set1(0.0f)), r, refined);
+}
+
+// Cody-Waite reduction by pi/2 into [-pi/4, pi/4] and the Cephes minimax polynomials
+template <typename V>
+inline void sincos(V x, V& s, V& c) noexcept {
+  using O = ops<V>;
+  using I = typename O::ints;
+  I q = O::to_int(O::mul(x, O::set1(0.636619772367581343f)));
+  V j = O::to_float(q);
+  V r = O::madd(j, O::set1(-1.5703125f), x);
+  r = O::madd(j, O::set1(-4.837512969970703125e-4f), r);
+  r = O::madd(j, O::set1(-7.54978995489188216e-8f), r);
+  V z = O::mul(r, r);
+
+  V ps = O::madd(O::madd(O::set1(-1.9515295891e-4f), z, O::set1(8.3321608736e-3f)), z, O::set1(-1.6666654611e-1f));
+  ps = O::madd(O::mul(ps, z), r, r);
+  V pc = O::madd(O::madd(O::set1(2.443315711809948e-5f), z, O::set1(-1.388731625493765e-3f)), z,
+                 O::set1(4.166664568298827e-2f));
+  pc = O::madd(O::mul(pc, z), z, O::madd(z, O::set1(-0.5f), O::set1(1.0f)));
+
+  // Quadrant q: sin is (s, c, -s, -c)[q & 3] and cos is (c, -s, -c, s)[q & 3]
+  auto swap = O::ieq(O::iand(q, O::iset1(1)), O::iset1(1));
+  V vs = O::select(swap, pc, ps);
+  V vc = O::select(swap, ps, pc);
+  I sin_sign = O::template shl<30>(O::iand(q, O::iset1(2)));
+  I cos_sign = O::template shl<30>(O::iand(O::iadd(q, O::iset1(1)), O::iset1(2)));
+  s = O::as_float(O::ixor(O::as_int(vs), sin_sign));
+  c = O::as_float(O::ixor(O::as_int(vc), cos_sign));
+}
+
+template <typename V>
+inline V atan2(V y, V x) noexcept {
+  using O = ops<V>;
+  using I = typename O::ints;
+  const I sign_bit = O::iset1(INT32_MIN);
+  V ax = O::as_float(O::iand(O::as_int(x), O::iset1(INT32_MAX)));
+  V ay = O::as_float(O::iand(O::as_int(y), O::iset1(INT32_MAX)));
+
+  // atan(t) for t = min / max in [0, 1], past tan(pi/8) through atan(t) = pi/4 + atan((t - 1) / (t + 1))
+  V lo = O::min(ax, ay), hi = O::max(ax, ay);
+  V t = O::select(O::gt(hi, O::set1(0.0f)), O::div(lo, hi), O::set1(0.0f));
+  auto far = O::gt(t, O::set1(0.414213562373095f));
+  V z = O::select(far, O::div(O::sub(t, O::set1(1.0f)), O::add(t, O::set1(1.0f))), t);
+  V zz = O::mul(z, z);
+  V p = O::madd(O::madd(O::madd(O::set1(8.05374449538e-2f), zz, O::set1(-1.38776856032e-1f)), zz,
+                        O::set1(1.99777106478e-1f)), zz, O::set1(-3.33329491539e-1f));
+  V a = O::add(O::select(far, O::set1(0.785398163397448f), O::set1(0.0f)), O::madd(O::mul(p, zz), z, z));
+
+  a = O::select(O::gt(ay, ax), O::sub(O::set1(1.57079632679490f), a), a);
+  a = O::select(O::ieq(O::iand(O::as_int(x), sign_bit), sign_bit), O::sub(O::set1(3.14159265358979f), a), a);
+  a = O::as_float(O::ior(O::as_int(a), O::iand(O::as_int(y), sign_bit)));
+  return O::select(O::eq(O::add(x, y), O::add(x, y)), a, O::add(x, y));
+}
+
+// 2^f * 2^n for f in [-0.5, 0.5]. The scale is split in two factors so that n from -252 to
+// 254 neither wraps the exponent field nor skips gradual underflow.
+template <typename V>
+inline V exp2_scaled(V f, typename ops<V>::ints n) noexcept {
+  using O = ops<V>;
+  using I = typename O::ints;
+  V p = O::madd(O::madd(O::madd(O::madd(O::madd(O::set1(1.535336188319500e-4f), f, O::set1(1.339887440266574e-3f)), f,
+                                        O::set1(9.618437357674640e-3f)), f, O::set1(5.550332471162809e-2f)), f,
+                        O::set1(2.402264791363012e-1f)), f, O::set1(6.931472028550421e-1f));
+  p = O::madd(p, f, O::set1(1.0f));
+  I n1 = O::template sra<1>(n);
+  I n2 = O::isub(n, n1);
+  V s1 = O::as_float(O::template shl<23>(O::iadd(n1, O::iset1(127))));
+  V s2 = O::as_float(O::template shl<23>(O::iadd(n2, O::iset1(127))));
+  return O::mul(O::mul(p, s1), s2);
+}
+
+template <typename V>
+inline V exp2(V x) noexcept {
+  using O = ops<V>;
+  V c = O::min(O::max(x, O::set1(-152.0f)), O::set1(130.0f));
+  typename O::ints n = O::to_int(c);
+  V r = exp2_scaled(O::sub(c, O::to_float(n)), n);
+  return O::select(O::eq(x, x), r, x);
+}
+
+template <typename V>
+inline V exp(V x) noexcept {
+  using O = ops<V>;
+  V c = O::min(O::max(x, O::set1(-105.0f)), O::set1(90.0f));
+  typename O::ints n = O::to_int(O::mul(c, O::set1(1.44269504088896341f)));
+  V j = O::to_float(n);
+  V r = O::madd(j, O::set1(-0.693359375f), c);
+  r = O::madd(j, O::set1(2.12194440e-4f), r);
+  V e = exp2_scaled(O::mul(r, O::set1(1.44269504088896341f)), n);
+  return O::select(O::eq(x, x), e, x);
+}
+
+// x = 2^e * m with m in [sqrt(1/2), sqrt(2)), returns ln(m) and the exponent.
+// Subnormal x is scaled up first.
+template <typename V>
+inline V log_reduce(V x, V& e) noexcept {
+  using O = ops<V>;
+  using I = typename O::ints;
+  auto tiny = O::lt(x, O::set1(1.17549435e-38f));
+  V xs = O::select(tiny, O::mul(x, O::set1(8388608.0f)), x);
+  const I sqrt_half = O::iset1(0x3f3504f3);
+  I bits = O::isub(O::as_int(xs), sqrt_half);
+  e = O::add(O::to_float(O::template sra<23>(bits)), O::select(tiny, O::set1(-23.0f), O::set1(0.0f)));
+  V f = O::sub(O::as_float(O::iadd(O::iand(bits, O::iset1(0x007fffff)), sqrt_half)), O::set1(1.0f));
+
+  V z = O::mul(f, f);
+  V p = O::set1(7.0376836292e-2f);
+  p = O::madd(p, f, O::set1(-1.1514610310e-1f));
+  p = O::madd(p, f, O::set1(1.1676998740e-1f));
+  p = O::madd(p, f, O::set1(-1.2420140846e-1f));
+  p = O::madd(p, f, O::set1(1.4249322787e-1f));
+  p = O::madd(p, f, O::set1(-1.6668057665e-1f));
+  p = O::madd(p, f, O::set1(2.0000714765e-1f));
+  p = O::madd(p, f, O::set1(-2.4999993993e-1f));
+  p = O::madd(p, f, O::set1(3.3333331174e-1f));
+  V y = O::madd(z, O::set1(-0.5f), O::mul(O::mul(p, z), f));
+  return O::add(f, y);
+}
+
+// -inf at zero, NaN below zero and for NaN, inf at inf
+template <typename V>
+inline V log_special(V x, V r) noexcept {
+  using O = ops<V>;
+  const V inf = O::set1(INFINITY);
+  r = O::select(O::eq(x, inf), inf, r);
+  r = O::select(O::eq(x, O::set1(0.0f)), O::sub(O::set1(0.0f), inf), r);
+  return O::select(O::lt(x, O::set1(0.0f)), O::set1(NAN), O::select(O::eq(x, x), r, x));
+}
+
+template <typename V>
+inline V log2(V x) noexcept {
+  using O = ops<V>;
+  V e;
+  V ln = log_reduce(x, e);
+  return log_special(x, O::madd(ln, O::set1(1.44269504088896341f), e));
+}
+
+template <typename V>
+inline V log(V x) noexcept {
+  using O = ops<V>;
+  V e;
+  V ln = log_reduce(x, e);
+  return log_special(x, O::madd(e, O::set1(0.693359375f), O::madd(e, O::set1(-2.12194440e-4f), ln)));
+}
+
+} // namespace detail
+
+inline float rsqrt(float x) noexcept { return detail::rsqrt(x); }
+inline float sin(float x) noexcept { float s, c; detail::sincos(x, s, c); return s; }
+inline float cos(float x) noexcept { float s, c; detail::sincos(x, s, c); return c; }
+inline void sincos(float x, float& s, float& c) noexcept { detail::sincos(x, s, c); }
+inline float atan2(float y, float x) noexcept { return detail::atan2(y, x); }
+inline float exp2(float x) noexcept { return detail::exp2(x); }
+inline float exp(float x) noexcept { return detail::exp(x); }
+inline float log2(float x) noexcept { return detail::log2(x); }
+inline float log(float x) noexcept { return detail::log(x); }
+
+#ifdef __SSE2__
+inline __m128 rsqrt(__m128 x) noexcept { return detail::rsqrt(x); }
+inline __m128 sin(__m128 x) noexcept { __m128 s, c; detail::sincos(x, s, c); return s; }
+inline __m128 cos(__m128 x) noexcept { __m128 s, c; detail::sincos(x, s, c); return c; }
+inline void sincos(__m128 x, __m128& s, __m128& c) noexcept { detail::sincos(x, s, c); }
+inline __m128 atan2(__m128 y, __m128 x) noexcept { return detail::atan2(y, x); }
+inline __m128 exp2(__m128 x) noexcept { return detail::exp2(x); }
+inline __m128 exp(__m128 x) noexcept { return detail::exp(x); }
+inline __m128 log2(__m128 x) noexcept { return detail::log2(x); }
+inline __m128 log(__m128 x) noexcept { return detail::log(x); }
+#endif
+
+#ifdef __AVX2__
+inline __m256 rsqrt(__m256 x) noexcept { return detail::rsqrt(x); }
+inline __m256 sin(__m256 x) noexcept { __m256 s, c; detail::sincos(x, s, c); return s; }
+inline __m256 cos(__m256 x) noexcept { __m256 s, c; detail::sincos(x, s, c); return c; }
+inline void sincos(__m256 x, __m256& s, __m256& c) noexcept { detail::sincos(x, s, c); }
+inline __m256 atan2(__m256 y, __m256 x) noexcept { return detail::atan2(y, x); }
+inline __m256 exp2(__m256 x) noexcept { return detail::exp2(x); }
+inline __m256 exp(__m256 x) noexcept { return detail::exp(x); }
+inline __m256 log2(__m256 x) noexcept { return detail::log2(x); }
+inline __m256 log(__m256 x) noexcept { return detail::log(x); }
+#endif
+
+} // namespace cgmath::fast
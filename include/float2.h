@@ -5,6 +5,8 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
 
 namespace cgmath {
 
@@ -39,18 +41,20 @@ struct float2
   constexpr float2& operator*=(float scalar) noexcept { x *= scalar; y *= scalar; return *this; }
   constexpr float2& operator/=(float scalar) noexcept { x /= scalar; y /= scalar; return *this; }
 
-  constexpr float length() const noexcept { return std::sqrt(x * x + y * y); }
+  constexpr float length() const noexcept { return sqrt(x * x + y * y); }
 
   constexpr float2 normalized() const noexcept {
     float len = length();
     return len > 0 ? float2{x / len, y / len} : float2{0.0f, 0.0f};
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[32]; // Буфер на 32 символа (должно хватить для float)
-    std::snprintf(buffer, sizeof(buffer), "float2(%.6f, %.6f)", x, y);
-    return buffer;
+  // "float2(x, y)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {x, y};
+    return format_tuple(first, last, "float2", v, 2);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 static_assert(sizeof(float2) == sizeof(float) * 2, "float2 must be 8 bytes");
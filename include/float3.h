@@ -5,6 +5,8 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
 
 namespace cgmath {
 
@@ -39,7 +41,7 @@ struct float3
   constexpr float3& operator*=(float scalar) noexcept { x *= scalar; y *= scalar; z *= scalar; return *this; }
   constexpr float3& operator/=(float scalar) noexcept { x /= scalar; y /= scalar; z /= scalar; return *this; }
 
-  constexpr float length() const noexcept { return std::sqrt(x * x + y * y + z * z); }
+  constexpr float length() const noexcept { return sqrt(x * x + y * y + z * z); }
 
   constexpr float3 normalized() const noexcept {
     float len = length();
@@ -58,11 +60,13 @@ struct float3
     };
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[32]; // Буфер на 32 символа (должно хватить для float)
-    std::snprintf(buffer, sizeof(buffer), "float3(%.6f, %.6f, %.6f)", x, y, z);
-    return buffer;
+  // "float3(x, y, z)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {x, y, z};
+    return format_tuple(first, last, "float3", v, 3);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 static_assert(sizeof(float3) == sizeof(float) * 3, "float3 must be 12 bytes");
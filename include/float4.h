@@ -5,6 +5,8 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
 
 namespace cgmath {
 
@@ -39,7 +41,7 @@ struct float4
   constexpr float4& operator*=(float scalar) noexcept { x *= scalar; y *= scalar; z *= scalar; w *= scalar; return *this; }
   constexpr float4& operator/=(float scalar) noexcept { x /= scalar; y /= scalar; z /= scalar; w /= scalar; return *this; }
 
-  constexpr float length() const noexcept { return std::sqrt(x * x + y * y + z * z + w * w); }
+  constexpr float length() const noexcept { return sqrt(x * x + y * y + z * z + w * w); }
 
   constexpr float4 normalized() const noexcept {
     float len = length();
@@ -50,12 +52,14 @@ struct float4
     return x * v.x + y * v.y + z * v.z + w * v.w;
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[32]; // Буфер на 32 символа (должно хватить для float)
-    std::snprintf(buffer, sizeof(buffer), "float4(%.6f, %.6f, %.6f, %.6f)", x, y, z, w);
-    return buffer;
+  // "float4(x, y, z, w)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {x, y, z, w};
+    return format_tuple(first, last, "float4", v, 4);
   }
 
+  const char* to_string() const noexcept { return format_to_string(*this); }
+
 };
 
 static_assert(sizeof(float4) == sizeof(float) * 4, "float4 must be 16 bytes");
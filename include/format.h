@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+
+#include <charconv>
+#include <cstddef>
+
+// Text formatting shared by the to_chars/to_string members of every type. Output goes
+// into a caller-supplied [first, last) range with std::to_chars semantics: on success ptr
+// is one past the last written char, otherwise ec is value_too_large and ptr is last.
+// Floats use the shortest representation that parses back to the same value.
+
+namespace cgmath {
+
+// Upper bounds of a single formatted value, e.g. "-1.17549435e-38", "-2.2250738585072014e-308"
+// and "-2147483648"
+constexpr size_t FORMAT_FLOAT_CHARS = 15;
+constexpr size_t FORMAT_DOUBLE_CHARS = 24;
+constexpr size_t FORMAT_INT_CHARS = 11;
+
+// to_string() keeps its thread_local buffers this large, enough for any type here
+// (dmatrix4x4 being the longest)
+constexpr size_t TO_STRING_BUFFER_SIZE = 448;
+
+// "name(a, b, c)"
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const float* v, size_t n) noexcept;
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const double* v, size_t n) noexcept;
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const int32_t* v, size_t n) noexcept;
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const uint32_t* v, size_t n) noexcept;
+
+// Row-major matrix as "| a b c |" lines separated by '\n'
+std::to_chars_result format_rows(char* first, char* last, const float* m, size_t rows, size_t cols) noexcept;
+std::to_chars_result format_rows(char* first, char* last, const double* m, size_t rows, size_t cols) noexcept;
+
+// Null-terminated text in a per-thread buffer, valid until the next to_string call for the
+// same type on the same thread
+template <typename T>
+const char* format_to_string(const T& value) noexcept {
+  thread_local char buffer[TO_STRING_BUFFER_SIZE];
+  *value.to_chars(buffer, buffer + sizeof(buffer) - 1).ptr = '\0';
+  return buffer;
+}
+
+} // namespace cgmath
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "float4.h"
+#include "matrix4x4.h"
+#include "soa.h"
+
+#include <cstddef>
+
+namespace cgmath {
+
+enum class cull_result : uint8_t {
+  outside,
+  intersect,
+  inside
+};
+
+// Six planes facing into the volume, xyz is the unit normal and w the offset so that
+// dot(normal, p) + w is the signed distance of p. Order: left, right, bottom, top, near, far.
+struct frustum {
+  float4 planes[6];
+
+  static constexpr size_t plane_count = 6;
+
+  // Gribb-Hartmann extraction from a view-projection matrix (clip = m * world).
+  // With a world matrix folded in, the planes come out in that object's local space.
+  static constexpr frustum from_matrix(const matrix4x4& m, clip_depth depth = clip_depth::zero_to_one) noexcept {
+    // Through the named fields, m.m is not the active member of a constexpr-built matrix
+    const float r[4][4] = {
+      {m._m._11, m._m._12, m._m._13, m._m._14},
+      {m._m._21, m._m._22, m._m._23, m._m._24},
+      {m._m._31, m._m._32, m._m._33, m._m._34},
+      {m._m._41, m._m._42, m._m._43, m._m._44}
+    };
+    auto combine = [&](int row, float sign) {
+      return float4(r[3][0] + sign * r[row][0], r[3][1] + sign * r[row][1],
+                    r[3][2] + sign * r[row][2], r[3][3] + sign * r[row][3]);
+    };
+
+    frustum f;
+    f.planes[0] = combine(0, 1.0f);
+    f.planes[1] = combine(0, -1.0f);
+    f.planes[2] = combine(1, 1.0f);
+    f.planes[3] = combine(1, -1.0f);
+    f.planes[4] = depth == clip_depth::zero_to_one ? float4(r[2][0], r[2][1], r[2][2], r[2][3]) : combine(2, 1.0f);
+    f.planes[5] = combine(2, -1.0f);
+    for (float4& p : f.planes) {
+      float len = sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+      if (len > 0.0f) p = p / len;
+    }
+    return f;
+  }
+
+  constexpr float distance(size_t plane, const float3& p) const noexcept {
+    const float4& n = planes[plane];
+    return n.x * p.x + n.y * p.y + n.z * p.z + n.w;
+  }
+
+  constexpr cull_result test_sphere(const float3& center, float radius) const noexcept {
+    cull_result result = cull_result::inside;
+    for (size_t i = 0; i < plane_count; ++i) {
+      float d = distance(i, center);
+      if (d < -radius) return cull_result::outside;
+      if (d < radius) result = cull_result::intersect;
+    }
+    return result;
+  }
+
+  // Box given by center and half extents, projected onto each plane normal
+  constexpr cull_result test_aabb(const float3& center, const float3& extent) const noexcept {
+    cull_result result = cull_result::inside;
+    for (size_t i = 0; i < plane_count; ++i) {
+      const float4& n = planes[i];
+      float d = distance(i, center);
+      float r = (n.x < 0 ? -n.x : n.x) * extent.x + (n.y < 0 ? -n.y : n.y) * extent.y + (n.z < 0 ? -n.z : n.z) * extent.z;
+      if (d < -r) return cull_result::outside;
+      if (d < r) result = cull_result::intersect;
+    }
+    return result;
+  }
+};
+
+// Batch culling over SoA bounds. Spheres are (x, y, z, radius); boxes are center and half
+// extent streams of the same size. Objects that intersect a frustum count as visible.
+
+// Number of 64-bit words in a visibility bitmask for n objects
+constexpr size_t cull_mask_words(size_t n) noexcept { return (n + 63) / 64; }
+
+// Full classification per object
+void classify_spheres(const frustum& f, const_float4_soa_view spheres, cull_result* out) noexcept;
+void classify_aabbs(const frustum& f, const_float3_soa_view centers, const_float3_soa_view extents,
+                    cull_result* out) noexcept;
+
+// Writes the ascending indices of visible objects and returns their count
+size_t cull_spheres(const frustum& f, const_float4_soa_view spheres, uint32_t* visible) noexcept;
+size_t cull_aabbs(const frustum& f, const_float3_soa_view centers, const_float3_soa_view extents,
+                  uint32_t* visible) noexcept;
+
+// Several views in one pass over the bounds, e.g. shadow cascades. Bit i of masks[v]
+// is set when object i is visible in views[v]; each mask holds cull_mask_words(n) words.
+void cull_spheres(const frustum* views, size_t view_count, const_float4_soa_view spheres,
+                  uint64_t* const* masks) noexcept;
+void cull_aabbs(const frustum* views, size_t view_count, const_float3_soa_view centers,
+                const_float3_soa_view extents, uint64_t* const* masks) noexcept;
+
+} // namespace cgmath
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float2.h"
+#include "float3.h"
+#include "matrix3x3.h"
+#include "matrix3x4.h"
+#include "matrix4x4.h"
+#include "transform.h"
+
+#include <cstddef>
+
+// Arrays of cgmath types written straight into a staging buffer in the layout a shader reads
+// from a uniform (std140) or storage (std430) buffer:
+//
+//   float2      std140: 16 bytes, xy and padding     std430: 8 bytes
+//   float3      16 bytes, xyz and a zero
+//   matrix3x3   three vec3 columns (or rows) of 16 bytes, 48 bytes
+//   matrix3x4   column-major: four vec3 columns, 64 bytes, GLSL mat4x3 / HLSL float3x4
+//               row-major: three vec4 rows, 48 bytes, the compact form for affine transforms
+//   matrix4x4   64 bytes
+//
+// std140 and std430 only differ for arrays of scalars and two-component vectors here. cgmath
+// matrices are row-major; column_major transposes them on the way, which is what GLSL and
+// HLSL assume without a row_major qualifier. Padding is written as zeros.
+
+namespace cgmath {
+
+enum class gpu_layout { std140, std430 };
+
+enum class matrix_order { column_major, row_major };
+
+struct gpu_layout_options {
+  gpu_layout layout = gpu_layout::std430;
+  matrix_order order = matrix_order::column_major;
+  store_mode mode = store_mode::normal;  // non_temporal needs out aligned to 16 bytes,
+                                         // otherwise normal stores are used
+  size_t thread_count = 1;               // > 1 or 0 (every thread) splits the array with
+                                         // parallel_for, see parallel.h
+};
+
+// Bytes between consecutive array elements in the buffer
+template <typename T>
+constexpr size_t gpu_stride(const gpu_layout_options& o) noexcept;
+
+template <>
+constexpr size_t gpu_stride<float2>(const gpu_layout_options& o) noexcept {
+  return o.layout == gpu_layout::std140 ? 16 : 8;
+}
+
+template <>
+constexpr size_t gpu_stride<float3>(const gpu_layout_options&) noexcept { return 16; }
+
+template <>
+constexpr size_t gpu_stride<matrix3x3>(const gpu_layout_options&) noexcept { return 48; }
+
+template <>
+constexpr size_t gpu_stride<matrix3x4>(const gpu_layout_options& o) noexcept {
+  return o.order == matrix_order::column_major ? 64 : 48;
+}
+
+template <>
+constexpr size_t gpu_stride<matrix4x4>(const gpu_layout_options&) noexcept { return 64; }
+
+// Writes n elements to out, which must be 4-byte aligned and hold n * gpu_stride<T>(o) bytes.
+// Returns the bytes written.
+size_t to_gpu_layout(const float2* in, void* out, size_t n, const gpu_layout_options& o = {}) noexcept;
+size_t to_gpu_layout(const float3* in, void* out, size_t n, const gpu_layout_options& o = {}) noexcept;
+size_t to_gpu_layout(const matrix3x3* in, void* out, size_t n, const gpu_layout_options& o = {}) noexcept;
+size_t to_gpu_layout(const matrix3x4* in, void* out, size_t n, const gpu_layout_options& o = {}) noexcept;
+size_t to_gpu_layout(const matrix4x4* in, void* out, size_t n, const gpu_layout_options& o = {}) noexcept;
+
+} // namespace cgmath
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "format.h"
+#include "float2.h"
+#include "float3.h"
+#include "float4.h"
+
+#include <cstddef>
+#include <cstring>
+
+// IEEE 754 binary16 storage for bandwidth-bound streams (normals, colors, far-field
+// positions). The types only hold bits; convert to float2/3/4 to compute.
+//
+// Conversions round to nearest even, keep subnormals, turn values of 65520 and above into
+// infinity and NaN into a quiet NaN carrying the top payload bits, which is what F16C does.
+// The bulk functions below pick F16C (AVX2 and AVX-512 kernel levels) or an SSE2 integer
+// version at runtime and produce the same bits as the scalar ones.
+
+namespace cgmath {
+
+namespace detail {
+
+inline uint16_t float_to_half_bits(float v) noexcept {
+  uint32_t f;
+  std::memcpy(&f, &v, sizeof(f));
+  const uint16_t sign = static_cast<uint16_t>((f >> 16) & 0x8000);
+  f &= 0x7fffffff;
+
+  if (f >= 0x7f800000) return sign | (f > 0x7f800000 ? 0x7e00 | ((f >> 13) & 0x3ff) : 0x7c00);
+  if (f >= 0x477ff000) return sign | 0x7c00;
+
+  if (f < 0x38800000) {
+    // Below the smallest normal half: adding 0.5 lines the mantissa up with the half
+    // subnormal grid and the float addition rounds it to nearest even
+    float s;
+    std::memcpy(&s, &f, sizeof(s));
+    s += 0.5f;
+    std::memcpy(&f, &s, sizeof(f));
+    return sign | static_cast<uint16_t>(f - 0x3f000000);
+  }
+
+  // Rebias the exponent and round the 13 dropped bits to nearest even
+  f += 0xc8000fff + ((f >> 13) & 1);
+  return sign | static_cast<uint16_t>(f >> 13);
+}
+
+inline float half_bits_to_float(uint16_t h) noexcept {
+  const uint32_t sign = uint32_t(h & 0x8000) << 16;
+  const uint32_t exponent = (h >> 10) & 0x1f;
+  const uint32_t mantissa = h & 0x3ff;
+
+  uint32_t f;
+  if (exponent == 0x1f) {
+    f = sign | 0x7f800000 | (mantissa << 13) | (mantissa ? 0x00400000 : 0);
+  } else if (exponent == 0) {
+    // Zero or subnormal, exact in float
+    const float s = static_cast<float>(mantissa) * 5.9604644775390625e-8f;  // 2^-24
+    std::memcpy(&f, &s, sizeof(f));
+    f |= sign;
+  } else {
+    f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  float v;
+  std::memcpy(&v, &f, sizeof(v));
+  return v;
+}
+
+} // namespace detail
+
+struct half {
+  uint16_t bits;
+
+  constexpr half() noexcept : bits(0) {}
+  explicit half(float v) noexcept : bits(detail::float_to_half_bits(v)) {}
+
+  static constexpr half from_bits(uint16_t b) noexcept {
+    half h;
+    h.bits = b;
+    return h;
+  }
+
+  float to_float() const noexcept { return detail::half_bits_to_float(bits); }
+
+  // Bitwise, so +0 and -0 differ and a NaN equals itself
+  constexpr bool operator==(const half& other) const noexcept { return bits == other.bits; }
+  constexpr bool operator!=(const half& other) const noexcept { return bits != other.bits; }
+};
+
+struct half2 {
+  half x, y;
+
+  constexpr half2() noexcept : x(), y() {}
+  constexpr half2(half _x, half _y) noexcept : x(_x), y(_y) {}
+  explicit half2(const float2& v) noexcept : x(v.x), y(v.y) {}
+
+  float2 to_float2() const noexcept { return {x.to_float(), y.to_float()}; }
+
+  constexpr bool operator==(const half2& other) const noexcept { return x == other.x && y == other.y; }
+
+  // "half2(x, y)" of the float values, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {x.to_float(), y.to_float()};
+    return format_tuple(first, last, "half2", v, 2);
+  }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
+};
+
+struct half3 {
+  half x, y, z;
+
+  constexpr half3() noexcept : x(), y(), z() {}
+  constexpr half3(half _x, half _y, half _z) noexcept : x(_x), y(_y), z(_z) {}
+  explicit half3(const float3& v) noexcept : x(v.x), y(v.y), z(v.z) {}
+
+  float3 to_float3() const noexcept { return {x.to_float(), y.to_float(), z.to_float()}; }
+
+  constexpr bool operator==(const half3& other) const noexcept {
+    return x == other.x && y == other.y && z == other.z;
+  }
+
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {x.to_float(), y.to_float(), z.to_float()};
+    return format_tuple(first, last, "half3", v, 3);
+  }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
+};
+
+struct half4 {
+  half x, y, z, w;
+
+  constexpr half4() noexcept : x(), y(), z(), w() {}
+  constexpr half4(half _x, half _y, half _z, half _w) noexcept : x(_x), y(_y), z(_z), w(_w) {}
+  explicit half4(const float4& v) noexcept : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+  float4 to_float4() const noexcept { return {x.to_float(), y.to_float(), z.to_float(), w.to_float()}; }
+
+  constexpr bool operator==(const half4& other) const noexcept {
+    return x == other.x && y == other.y && z == other.z && w == other.w;
+  }
+
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {x.to_float(), y.to_float(), z.to_float(), w.to_float()};
+    return format_tuple(first, last, "half4", v, 4);
+  }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
+};
+
+static_assert(sizeof(half3) == 6 && sizeof(half4) == 8, "half vectors must be tightly packed");
+
+// Bulk conversions of n elements; in and out must not overlap
+void to_half(const float* in, half* out, size_t n) noexcept;
+void to_half(const float2* in, half2* out, size_t n) noexcept;
+void to_half(const float3* in, half3* out, size_t n) noexcept;
+void to_half(const float4* in, half4* out, size_t n) noexcept;
+
+void to_float(const half* in, float* out, size_t n) noexcept;
+void to_float(const half2* in, float2* out, size_t n) noexcept;
+void to_float(const half3* in, float3* out, size_t n) noexcept;
+void to_float(const half4* in, float4* out, size_t n) noexcept;
+
+} // namespace cgmath
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
 
 namespace cgmath {
 
@@ -24,11 +25,13 @@ struct int2 {
   constexpr int2& operator*=(int32_t scalar) noexcept { x *= scalar; y *= scalar; return *this; }
   constexpr int2& operator%=(int32_t scalar) noexcept { x %= scalar; y %= scalar; return *this; }
 
-  const char* to_string() const noexcept {
-    static char buffer[32];
-    std::snprintf(buffer, sizeof(buffer), "int2(%d, %d)", x, y);
-    return buffer;
+  // "int2(x, y)", see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const int32_t v[] = {x, y};
+    return format_tuple(first, last, "int2", v, 2);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 } // namespace cgmath
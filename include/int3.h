@@ -5,6 +5,10 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+
+#include <cstddef>
+#include <functional>
 
 namespace cgmath {
 
@@ -14,6 +18,15 @@ struct int3 {
   constexpr int3() noexcept : x(0), y(0), z(0) {}
   constexpr int3(int32_t _x, int32_t _y, int32_t _z) noexcept : x(_x), y(_y), z(_z) {}
 
+#if (__cplusplus >= 202002L)
+  constexpr bool operator==(const int3&) const noexcept = default;
+  constexpr auto operator<=>(const int3&) const noexcept = default;
+#else
+  constexpr bool operator==(const int3& other) const noexcept {
+    return x == other.x && y == other.y && z == other.z;
+  }
+#endif
+
   constexpr int3 operator+(const int3& v) const noexcept { return {x + v.x, y + v.y, z + v.z}; }
   constexpr int3 operator-(const int3& v) const noexcept { return {x - v.x, y - v.y, z - v.z}; }
   constexpr int3 operator*(int32_t scalar) const noexcept { return {x * scalar, y * scalar, z * scalar}; }
@@ -24,12 +37,33 @@ struct int3 {
   constexpr int3& operator*=(int32_t scalar) noexcept { x *= scalar; y *= scalar; z *= scalar; return *this; }
   constexpr int3& operator%=(int32_t scalar) noexcept { x %= scalar; y %= scalar; z %= scalar; return *this; }
 
-  const char* to_string() const noexcept {
-    static char buffer[48];
-    std::snprintf(buffer, sizeof(buffer), "int3(%d, %d, %d)", x, y, z);
-    return buffer;
+  // "int3(x, y, z)", see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const int32_t v[] = {x, y, z};
+    return format_tuple(first, last, "int3", v, 3);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
+// 32-bit hash of a cell coordinate for hash tables and grids. Every input bit reaches every
+// output bit, so neighbouring cells land in unrelated buckets of a power-of-two table.
+constexpr uint32_t hash(const int3& v) noexcept {
+  uint64_t h = uint64_t(uint32_t(v.x)) * 0x9e3779b97f4a7c15ull ^ uint64_t(uint32_t(v.y)) * 0xc2b2ae3d27d4eb4full ^
+               uint64_t(uint32_t(v.z)) * 0x165667b19e3779f9ull;
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ull;
+  return static_cast<uint32_t>(h >> 32);
+}
+
 } // namespace cgmath
 
+namespace std {
+
+template <>
+struct hash<cgmath::int3> {
+  size_t operator()(const cgmath::int3& v) const noexcept { return cgmath::hash(v); }
+};
+
+} // namespace std
+
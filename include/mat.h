@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "vec.h"
+#include "matrix3x3.h"
+#include "matrix3x4.h"
+#include "matrix4x3.h"
+#include "matrix4x4.h"
+
+#include <cstddef>
+#include <utility>
+
+// R x C matrix of T in row-major order, with the column-vector convention of matrix4x4:
+// mat<T, R, C> * vec<T, C> gives vec<T, R>. Element-wise operators come from vec.h; the
+// products below are generated per shape pair with every sum unrolled at compile time.
+
+namespace cgmath {
+
+template <typename T, size_t R, size_t C>
+struct mat : detail::expr<mat<T, R, C>, T, R, C> {
+  static_assert(R >= 1 && C >= 2, "mat needs at least two columns, columns are vec");
+
+  T e[R * C];
+
+  constexpr mat() noexcept : e{} {}
+
+  template <typename... A, typename = std::enable_if_t<sizeof...(A) == R * C && (std::is_convertible_v<A, T> && ...)>>
+  constexpr mat(A... a) noexcept : e{static_cast<T>(a)...} {}
+
+  template <typename E>
+  constexpr mat(const detail::expr<E, T, R, C>& x) noexcept : e{} {
+    for (size_t i = 0; i < R * C; ++i) e[i] = x.self().at(i);
+  }
+
+  template <typename X, typename Traits = layout_traits<X>,
+            typename = std::enable_if_t<Traits::defined && std::is_same_v<typename Traits::value_type, T> &&
+                                        Traits::rows == R && Traits::cols == C>>
+  constexpr mat(const X& x) noexcept : e{} {
+    Traits::read(x, e);
+  }
+
+  static constexpr mat identity() noexcept {
+    static_assert(R == C, "identity needs a square matrix");
+    mat m;
+    for (size_t i = 0; i < R; ++i) m.e[i * C + i] = T(1);
+    return m;
+  }
+
+  constexpr T at(size_t i) const noexcept { return e[i]; }
+  constexpr T operator()(size_t row, size_t col) const noexcept { return e[row * C + col]; }
+  constexpr T& operator()(size_t row, size_t col) noexcept { return e[row * C + col]; }
+
+  constexpr vec<T, C> row(size_t r) const noexcept {
+    vec<T, C> v;
+    for (size_t c = 0; c < C; ++c) v.v[c] = e[r * C + c];
+    return v;
+  }
+
+  constexpr vec<T, R> col(size_t c) const noexcept {
+    vec<T, R> v;
+    for (size_t r = 0; r < R; ++r) v.v[r] = e[r * C + c];
+    return v;
+  }
+
+  // x is evaluated into a temporary first: m = transpose(m) reads element (c, r) after
+  // element (r, c) would already have been written
+  template <typename E>
+  constexpr mat& operator=(const detail::expr<E, T, R, C>& x) noexcept {
+    const mat r(x);
+    for (size_t i = 0; i < R * C; ++i) e[i] = r.e[i];
+    return *this;
+  }
+
+  template <typename E>
+  constexpr mat& operator+=(const detail::expr<E, T, R, C>& x) noexcept {
+    const mat r(x);
+    for (size_t i = 0; i < R * C; ++i) e[i] += r.e[i];
+    return *this;
+  }
+
+  template <typename E>
+  constexpr mat& operator-=(const detail::expr<E, T, R, C>& x) noexcept {
+    const mat r(x);
+    for (size_t i = 0; i < R * C; ++i) e[i] -= r.e[i];
+    return *this;
+  }
+
+  constexpr mat& operator*=(T s) noexcept {
+    for (size_t i = 0; i < R * C; ++i) e[i] *= s;
+    return *this;
+  }
+};
+
+namespace detail {
+
+template <typename E, typename T, size_t R, size_t C>
+struct transpose_expr : expr<transpose_expr<E, T, R, C>, T, R, C> {
+  operand_t<E> x;
+
+  constexpr explicit transpose_expr(const E& _x) noexcept : x(_x) {}
+  constexpr T at(size_t i) const noexcept { return x.at((i % C) * R + i / C); }
+};
+
+// Result of a product: a vec for a single column
+template <typename T, size_t R, size_t C>
+using product_t = std::conditional_t<C == 1, vec<T, R>, mat<T, R, C>>;
+
+// Products read every operand element several times, so expressions are evaluated first
+template <typename E, typename T, size_t R, size_t C>
+constexpr std::conditional_t<is_leaf<E>::value, const E&, product_t<T, R, C>> evaluate(const expr<E, T, R, C>& x) noexcept {
+  return x.self();
+}
+
+template <size_t K, size_t C, typename T, typename A, typename B, size_t... k>
+constexpr T product_element(const A& a, const B& b, size_t i, std::index_sequence<k...>) noexcept {
+  const size_t row = i / C, col = i % C;
+  return (... + (a.at(row * K + k) * b.at(k * C + col)));
+}
+
+template <typename T, size_t R, size_t K, size_t C, typename A, typename B, size_t... i>
+constexpr product_t<T, R, C> product(const A& a, const B& b, std::index_sequence<i...>) noexcept {
+  return product_t<T, R, C>(product_element<K, C, T>(a, b, i, std::make_index_sequence<K>{})...);
+}
+
+} // namespace detail
+
+// Matrix product for every pair of shapes that agree on K, e.g. 3x4 * 4x4 -> 3x4 and
+// 4x4 * vec4 -> vec4. Not defined for two vecs, which multiply component-wise.
+template <typename A, typename B, typename T, size_t R, size_t K, size_t C>
+constexpr detail::product_t<T, R, C> operator*(const detail::expr<A, T, R, K>& a, const detail::expr<B, T, K, C>& b) noexcept {
+  const auto& l = detail::evaluate(a);
+  const auto& r = detail::evaluate(b);
+  return detail::product<T, R, K, C>(l, r, std::make_index_sequence<R * C>{});
+}
+
+template <typename E, typename T, size_t R, size_t C>
+constexpr auto transpose(const detail::expr<E, T, R, C>& x) noexcept {
+  return detail::transpose_expr<E, T, C, R>(x.self());
+}
+
+// Hand-written matrices, through the named fields so conversions work in constant expressions
+
+template <>
+struct layout_traits<matrix3x3> {
+  static constexpr bool defined = true;
+  using value_type = float;
+  static constexpr size_t rows = 3;
+  static constexpr size_t cols = 3;
+
+  static constexpr void read(const matrix3x3& x, float* out) noexcept {
+    const auto& m = x._m;
+    const float e[] = {m._11, m._12, m._13, m._21, m._22, m._23, m._31, m._32, m._33};
+    for (size_t i = 0; i < 9; ++i) out[i] = e[i];
+  }
+
+  static constexpr matrix3x3 make(const float* a) noexcept { return matrix3x3(a); }
+};
+
+template <>
+struct layout_traits<matrix3x4> {
+  static constexpr bool defined = true;
+  using value_type = float;
+  static constexpr size_t rows = 3;
+  static constexpr size_t cols = 4;
+
+  static constexpr void read(const matrix3x4& x, float* out) noexcept {
+    const auto& m = x._m;
+    const float e[] = {m._11, m._12, m._13, m._14, m._21, m._22, m._23, m._24, m._31, m._32, m._33, m._34};
+    for (size_t i = 0; i < 12; ++i) out[i] = e[i];
+  }
+
+  static constexpr matrix3x4 make(const float* a) noexcept { return matrix3x4(a); }
+};
+
+template <>
+struct layout_traits<matrix4x3> {
+  static constexpr bool defined = true;
+  using value_type = float;
+  static constexpr size_t rows = 4;
+  static constexpr size_t cols = 3;
+
+  static constexpr void read(const matrix4x3& x, float* out) noexcept {
+    const auto& m = x._m;
+    const float e[] = {m._11, m._12, m._13, m._21, m._22, m._23, m._31, m._32, m._33, m._41, m._42, m._43};
+    for (size_t i = 0; i < 12; ++i) out[i] = e[i];
+  }
+
+  static constexpr matrix4x3 make(const float* a) noexcept { return matrix4x3(a); }
+};
+
+template <>
+struct layout_traits<matrix4x4> {
+  static constexpr bool defined = true;
+  using value_type = float;
+  static constexpr size_t rows = 4;
+  static constexpr size_t cols = 4;
+
+  static constexpr void read(const matrix4x4& x, float* out) noexcept {
+    const auto& m = x._m;
+    const float e[] = {m._11, m._12, m._13, m._14, m._21, m._22, m._23, m._24,
+                       m._31, m._32, m._33, m._34, m._41, m._42, m._43, m._44};
+    for (size_t i = 0; i < 16; ++i) out[i] = e[i];
+  }
+
+  static constexpr matrix4x4 make(const float* a) noexcept { return matrix4x4(a); }
+};
+
+} // namespace cgmath
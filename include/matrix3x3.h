@@ -5,6 +5,7 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
 
 namespace cgmath {
 
@@ -18,7 +19,7 @@ struct alignas(8) matrix3x3 {
     float m[3][3];
   };
 
-  matrix3x3() noexcept 
+  constexpr matrix3x3() noexcept
   : _m{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f} {}
 
   constexpr matrix3x3(float m00, float m01, float m02,
@@ -26,11 +27,10 @@ struct alignas(8) matrix3x3 {
                       float m20, float m21, float m22) noexcept
   : _m{m00, m01, m02, m10, m11, m12, m20, m21, m22} {}
 
-  explicit matrix3x3(const float* arr) noexcept {
-    _m._11 = arr[0]; _m._12 = arr[1]; _m._13 = arr[2];
-    _m._21 = arr[3]; _m._22 = arr[4]; _m._23 = arr[5];
-    _m._31 = arr[6]; _m._32 = arr[7]; _m._33 = arr[8];
-  }
+  constexpr explicit matrix3x3(const float* arr) noexcept
+  : _m{arr[0], arr[1], arr[2],
+       arr[3], arr[4], arr[5],
+       arr[6], arr[7], arr[8]} {}
 
   float operator()(size_t row, size_t col) const noexcept {
     return m[row][col];
@@ -115,14 +115,13 @@ struct alignas(8) matrix3x3 {
     printf("| %.2f %.2f %.2f |\n", _m._31, _m._32, _m._33);
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[128];
-    std::snprintf(buffer, sizeof(buffer),
-                  "| %.2f %.2f %.2f |\n| %.2f %.2f %.2f |\n| %.2f %.2f %.2f |",
-                  _m._11, _m._12, _m._13, _m._21, _m._22, _m._23, _m._31, _m._32, _m._33);
-    return buffer;
+  // One "| a b c |" line per row with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    return format_rows(first, last, m[0], 3, 3);
   }
 
+  const char* to_string() const noexcept { return format_to_string(*this); }
+
 #if (__cplusplus >= 202002L)
   constexpr bool operator==(const matrix3x3& other) const noexcept = default;
   constexpr auto operator<=>(const matrix3x3& other) const noexcept = default;
@@ -5,9 +5,16 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "simd.h"
+#include "float3.h"
+#include "matrix4x3.h"
+#include "matrix4x4.h"
 
 namespace cgmath {
 
+// Affine transform: the first three rows of a 4x4 matrix whose fourth row is (0, 0, 0, 1),
+// 48 bytes instead of 64. Products, inverses and transforms treat it that way.
 struct alignas(8) matrix3x4 {
   union {
     struct {
@@ -18,7 +25,7 @@ struct alignas(8) matrix3x4 {
     float m[3][4];
   };
 
-  matrix3x4() noexcept 
+  constexpr matrix3x4() noexcept
   : _m{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f} {}
 
   constexpr matrix3x4(float m00, float m01, float m02, float m03,
@@ -26,10 +33,23 @@ struct alignas(8) matrix3x4 {
                       float m20, float m21, float m22, float m23) noexcept
   : _m{m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23} {}
 
-  explicit matrix3x4(const float* arr) noexcept {
-    _m._11 = arr[0]; _m._12 = arr[1]; _m._13 = arr[2]; _m._14 = arr[3];
-    _m._21 = arr[4]; _m._22 = arr[5]; _m._23 = arr[6]; _m._24 = arr[7];
-    _m._31 = arr[8]; _m._32 = arr[9]; _m._33 = arr[10]; _m._34 = arr[11];
+  constexpr explicit matrix3x4(const float* arr) noexcept
+  : _m{arr[0], arr[1], arr[2], arr[3],
+       arr[4], arr[5], arr[6], arr[7],
+       arr[8], arr[9], arr[10], arr[11]} {}
+
+  // The first three rows, see matrix4x4::is_affine()
+  constexpr explicit matrix3x4(const matrix4x4& a) noexcept
+  : _m{a._m._11, a._m._12, a._m._13, a._m._14,
+       a._m._21, a._m._22, a._m._23, a._m._24,
+       a._m._31, a._m._32, a._m._33, a._m._34} {}
+
+  static constexpr matrix3x4 identity() noexcept {
+    return matrix3x4(
+      1.0f, 0.0f, 0.0f, 0.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f
+    );
   }
 
   float operator()(size_t row, size_t col) const noexcept {
@@ -64,8 +84,9 @@ struct alignas(8) matrix3x4 {
     );
   }
 
-  constexpr matrix3x4 transpose() const noexcept {
-    return matrix3x4(
+  // The same transform for row vectors (v * m), as a 4x3 matrix
+  constexpr matrix4x3 transpose() const noexcept {
+    return matrix4x3(
       _m._11, _m._21, _m._31,
       _m._12, _m._22, _m._32,
       _m._13, _m._23, _m._33,
@@ -73,20 +94,153 @@ struct alignas(8) matrix3x4 {
     );
   }
 
+  // With the fourth row (0, 0, 0, 1)
+  constexpr matrix4x4 to_matrix4x4() const noexcept {
+    return matrix4x4(
+      _m._11, _m._12, _m._13, _m._14,
+      _m._21, _m._22, _m._23, _m._24,
+      _m._31, _m._32, _m._33, _m._34,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  // Affine composition: (a * b).transform_point(p) == a.transform_point(b.transform_point(p))
+  constexpr matrix3x4 operator*(const matrix3x4& other) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      matrix3x4 result;
+      simd::mat34_mul(&m[0][0], &other.m[0][0], &result.m[0][0]);
+      return result;
+    }
+#endif
+    return matrix3x4(
+      _m._11 * other._m._11 + _m._12 * other._m._21 + _m._13 * other._m._31,
+      _m._11 * other._m._12 + _m._12 * other._m._22 + _m._13 * other._m._32,
+      _m._11 * other._m._13 + _m._12 * other._m._23 + _m._13 * other._m._33,
+      _m._11 * other._m._14 + _m._12 * other._m._24 + _m._13 * other._m._34 + _m._14,
+      _m._21 * other._m._11 + _m._22 * other._m._21 + _m._23 * other._m._31,
+      _m._21 * other._m._12 + _m._22 * other._m._22 + _m._23 * other._m._32,
+      _m._21 * other._m._13 + _m._22 * other._m._23 + _m._23 * other._m._33,
+      _m._21 * other._m._14 + _m._22 * other._m._24 + _m._23 * other._m._34 + _m._24,
+      _m._31 * other._m._11 + _m._32 * other._m._21 + _m._33 * other._m._31,
+      _m._31 * other._m._12 + _m._32 * other._m._22 + _m._33 * other._m._32,
+      _m._31 * other._m._13 + _m._32 * other._m._23 + _m._33 * other._m._33,
+      _m._31 * other._m._14 + _m._32 * other._m._24 + _m._33 * other._m._34 + _m._34
+    );
+  }
+
+  constexpr float3 transform_point(const float3& p) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      alignas(16) float r[4] = {};
+      _mm_store_ps(r, simd::mat34_transform(m[0], _mm_setr_ps(p.x, p.y, p.z, 1.0f)));
+      return {r[0], r[1], r[2]};
+    }
+#endif
+    return {
+      _m._11 * p.x + _m._12 * p.y + _m._13 * p.z + _m._14,
+      _m._21 * p.x + _m._22 * p.y + _m._23 * p.z + _m._24,
+      _m._31 * p.x + _m._32 * p.y + _m._33 * p.z + _m._34
+    };
+  }
+
+  // Translation is ignored
+  constexpr float3 transform_direction(const float3& d) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      alignas(16) float r[4] = {};
+      _mm_store_ps(r, simd::mat34_transform(m[0], _mm_setr_ps(d.x, d.y, d.z, 0.0f)));
+      return {r[0], r[1], r[2]};
+    }
+#endif
+    return {
+      _m._11 * d.x + _m._12 * d.y + _m._13 * d.z,
+      _m._21 * d.x + _m._22 * d.y + _m._23 * d.z,
+      _m._31 * d.x + _m._32 * d.y + _m._33 * d.z
+    };
+  }
+
+  constexpr float3 translation() const noexcept { return {_m._14, _m._24, _m._34}; }
+
+  // Of the 3x3 part
+  constexpr float determinant() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      // row0 . (row1 x row2), the translations in lane 3 take no part
+      const __m128 r1 = _mm_loadu_ps(m[1]), r2 = _mm_loadu_ps(m[2]);
+      return _mm_cvtss_f32(simd::dot3(_mm_loadu_ps(m[0]), simd::cross3(r1, r2)));
+    }
+#endif
+    return _m._11 * (_m._22 * _m._33 - _m._23 * _m._32) +
+           _m._12 * (_m._23 * _m._31 - _m._21 * _m._33) +
+           _m._13 * (_m._21 * _m._32 - _m._22 * _m._31);
+  }
+
+  // General affine inverse, scale and shear included; returns a zero matrix when singular
+  constexpr matrix3x4 inverse() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      matrix3x4 result;
+      simd::mat4_inverse_affine(&m[0][0], &result.m[0][0]);
+      return result;
+    }
+#endif
+    float c00 = _m._22 * _m._33 - _m._23 * _m._32;
+    float c01 = _m._23 * _m._31 - _m._21 * _m._33;
+    float c02 = _m._21 * _m._32 - _m._22 * _m._31;
+
+    float det = _m._11 * c00 + _m._12 * c01 + _m._13 * c02;
+    if (det == 0.0f) return matrix3x4{};
+
+    float invDet = 1.0f / det;
+
+    float i11 = c00 * invDet;
+    float i12 = (_m._13 * _m._32 - _m._12 * _m._33) * invDet;
+    float i13 = (_m._12 * _m._23 - _m._13 * _m._22) * invDet;
+    float i21 = c01 * invDet;
+    float i22 = (_m._11 * _m._33 - _m._13 * _m._31) * invDet;
+    float i23 = (_m._13 * _m._21 - _m._11 * _m._23) * invDet;
+    float i31 = c02 * invDet;
+    float i32 = (_m._12 * _m._31 - _m._11 * _m._32) * invDet;
+    float i33 = (_m._11 * _m._22 - _m._12 * _m._21) * invDet;
+
+    return matrix3x4(
+      i11, i12, i13, -(i11 * _m._14 + i12 * _m._24 + i13 * _m._34),
+      i21, i22, i23, -(i21 * _m._14 + i22 * _m._24 + i23 * _m._34),
+      i31, i32, i33, -(i31 * _m._14 + i32 * _m._24 + i33 * _m._34)
+    );
+  }
+
+  // Rotation and translation only: the transposed rotation and the translation rotated back.
+  // Cheaper than inverse() and exact for orthonormal rotations; wrong with scale or shear.
+  constexpr matrix3x4 inverse_rigid() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      matrix3x4 result;
+      simd::mat34_inverse_rigid(&m[0][0], &result.m[0][0]);
+      return result;
+    }
+#endif
+    return matrix3x4(
+      _m._11, _m._21, _m._31, -(_m._11 * _m._14 + _m._21 * _m._24 + _m._31 * _m._34),
+      _m._12, _m._22, _m._32, -(_m._12 * _m._14 + _m._22 * _m._24 + _m._32 * _m._34),
+      _m._13, _m._23, _m._33, -(_m._13 * _m._14 + _m._23 * _m._24 + _m._33 * _m._34)
+    );
+  }
+
   void print() const noexcept {
     printf("| %.2f %.2f %.2f %.2f |\n", _m._11, _m._12, _m._13, _m._14);
     printf("| %.2f %.2f %.2f %.2f |\n", _m._21, _m._22, _m._23, _m._24);
     printf("| %.2f %.2f %.2f %.2f |\n", _m._31, _m._32, _m._33, _m._34);
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[160];
-    std::snprintf(buffer, sizeof(buffer),
-                  "| %.2f %.2f %.2f %.2f |\n| %.2f %.2f %.2f %.2f |\n| %.2f %.2f %.2f %.2f |",
-                  _m._11, _m._12, _m._13, _m._14, _m._21, _m._22, _m._23, _m._24, _m._31, _m._32, _m._33, _m._34);
-    return buffer;
+  // One "| a b c |" line per row with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    return format_rows(first, last, m[0], 3, 4);
   }
 
+  const char* to_string() const noexcept { return format_to_string(*this); }
+
 #if (__cplusplus >= 202002L)
   constexpr bool operator==(const matrix3x4& other) const noexcept = default;
   constexpr auto operator<=>(const matrix3x4& other) const noexcept = default;
@@ -99,5 +253,13 @@ struct alignas(8) matrix3x4 {
 #endif
 };
 
+constexpr matrix3x4 matrix4x3::transpose() const noexcept {
+  return matrix3x4(
+    _m._11, _m._21, _m._31, _m._41,
+    _m._12, _m._22, _m._32, _m._42,
+    _m._13, _m._23, _m._33, _m._43
+  );
+}
+
 } // namespace cgmath
 
@@ -5,9 +5,14 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
 
 namespace cgmath {
 
+struct matrix3x4;
+
+// Affine transform for row vectors (v * m): the 3x3 part in the first three rows and the
+// translation in the fourth. transpose() gives the matrix3x4 of the same transform.
 struct alignas(8) matrix4x3 {
   union {
     struct {
@@ -19,7 +24,7 @@ struct alignas(8) matrix4x3 {
     float m[4][3];
   };
 
-  matrix4x3() noexcept 
+  constexpr matrix4x3() noexcept
   : _m{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f} {}
 
   constexpr matrix4x3(float m00, float m01, float m02,
@@ -28,12 +33,11 @@ struct alignas(8) matrix4x3 {
                       float m30, float m31, float m32) noexcept
   : _m{m00, m01, m02, m10, m11, m12, m20, m21, m22, m30, m31, m32} {}
 
-  explicit matrix4x3(const float* arr) noexcept {
-    _m._11 = arr[0]; _m._12 = arr[1]; _m._13 = arr[2];
-    _m._21 = arr[3]; _m._22 = arr[4]; _m._23 = arr[5];
-    _m._31 = arr[6]; _m._32 = arr[7]; _m._33 = arr[8];
-    _m._41 = arr[9]; _m._42 = arr[10]; _m._43 = arr[11];
-  }
+  constexpr explicit matrix4x3(const float* arr) noexcept
+  : _m{arr[0], arr[1], arr[2],
+       arr[3], arr[4], arr[5],
+       arr[6], arr[7], arr[8],
+       arr[9], arr[10], arr[11]} {}
 
   float operator()(size_t row, size_t col) const noexcept {
     return m[row][col];
@@ -70,13 +74,8 @@ struct alignas(8) matrix4x3 {
     );
   }
 
-  constexpr matrix4x3 transpose() const noexcept {
-    return matrix4x3(
-      _m._11, _m._21, _m._31, _m._41,
-      _m._12, _m._22, _m._32, _m._42,
-      _m._13, _m._23, _m._33, _m._43
-    );
-  }
+  // Defined in matrix3x4.h
+  constexpr matrix3x4 transpose() const noexcept;
 
   void print() const noexcept {
     printf("| %.2f %.2f %.2f |\n", _m._11, _m._12, _m._13);
@@ -85,15 +84,13 @@ struct alignas(8) matrix4x3 {
     printf("| %.2f %.2f %.2f |\n", _m._41, _m._42, _m._43);
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[160];
-    std::snprintf(buffer, sizeof(buffer),
-                  "| %.2f %.2f %.2f |\n| %.2f %.2f %.2f |\n| %.2f %.2f %.2f |\n| %.2f %.2f %.2f |",
-                  _m._11, _m._12, _m._13, _m._21, _m._22, _m._23, _m._31, _m._32, _m._33,
-                  _m._41, _m._42, _m._43);
-    return buffer;
+  // One "| a b c |" line per row with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    return format_rows(first, last, m[0], 4, 3);
   }
 
+  const char* to_string() const noexcept { return format_to_string(*this); }
+
 #if (__cplusplus >= 202002L)
   constexpr bool operator==(const matrix4x3& other) const noexcept = default;
   constexpr auto operator<=>(const matrix4x3& other) const noexcept = default;
@@ -109,3 +106,5 @@ struct alignas(8) matrix4x3 {
 
 } // namespace cgmath
 
+#include "matrix3x4.h"
+
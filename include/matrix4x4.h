@@ -5,9 +5,21 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "simd.h"
+#include "constexpr_math.h"
+#include "float3.h"
+#include "vector4.h"
 
 namespace cgmath {
 
+// Depth range of clip space z after the perspective divide
+enum class clip_depth {
+  zero_to_one,     // Direct3D, Vulkan, Metal
+  minus_one_to_one // OpenGL
+};
+
+// Row-major storage; vectors are columns (v' = M * v) and the translation lives in _14, _24, _34
 struct alignas(8) matrix4x4 {
   union {
     struct {
@@ -19,7 +31,7 @@ struct alignas(8) matrix4x4 {
     float m[4][4];
   };
 
-  matrix4x4() noexcept 
+  constexpr matrix4x4() noexcept
   : _m{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f} {}
 
   constexpr matrix4x4(float m00, float m01, float m02, float m03,
@@ -28,11 +40,108 @@ struct alignas(8) matrix4x4 {
                       float m30, float m31, float m32, float m33) noexcept
   : _m{m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23, m30, m31, m32, m33} {}
 
-  explicit matrix4x4(const float* arr) noexcept {
-    _m._11 = arr[0]; _m._12 = arr[1]; _m._13 = arr[2]; _m._14 = arr[3];
-    _m._21 = arr[4]; _m._22 = arr[5]; _m._23 = arr[6]; _m._24 = arr[7];
-    _m._31 = arr[8]; _m._32 = arr[9]; _m._33 = arr[10]; _m._34 = arr[11];
-    _m._41 = arr[12]; _m._42 = arr[13]; _m._43 = arr[14]; _m._44 = arr[15];
+  constexpr explicit matrix4x4(const float* arr) noexcept
+  : _m{arr[0], arr[1], arr[2], arr[3],
+       arr[4], arr[5], arr[6], arr[7],
+       arr[8], arr[9], arr[10], arr[11],
+       arr[12], arr[13], arr[14], arr[15]} {}
+
+  static constexpr matrix4x4 identity() noexcept {
+    return matrix4x4(
+      1.0f, 0.0f, 0.0f, 0.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  // The builders below are constexpr so fixed cameras and projections can be baked in.
+  // Right-handed: rotations by a positive angle are counterclockwise looking down the axis.
+
+  static constexpr matrix4x4 rotation_x(float angle) noexcept {
+    float s = sin(angle), c = cos(angle);
+    return matrix4x4(
+      1.0f, 0.0f, 0.0f, 0.0f,
+      0.0f, c, -s, 0.0f,
+      0.0f, s, c, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  static constexpr matrix4x4 rotation_y(float angle) noexcept {
+    float s = sin(angle), c = cos(angle);
+    return matrix4x4(
+      c, 0.0f, s, 0.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      -s, 0.0f, c, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  static constexpr matrix4x4 rotation_z(float angle) noexcept {
+    float s = sin(angle), c = cos(angle);
+    return matrix4x4(
+      c, -s, 0.0f, 0.0f,
+      s, c, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  // axis must be unit length, angle in radians (Rodrigues' formula)
+  static constexpr matrix4x4 rotation(const float3& axis, float angle) noexcept {
+    float s = sin(angle), c = cos(angle), t = 1.0f - c;
+    float x = axis.x, y = axis.y, z = axis.z;
+    return matrix4x4(
+      t * x * x + c, t * x * y - s * z, t * x * z + s * y, 0.0f,
+      t * x * y + s * z, t * y * y + c, t * y * z - s * x, 0.0f,
+      t * x * z - s * y, t * y * z + s * x, t * z * z + c, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  // World to view transform of a camera at eye looking at target; the camera looks down -z
+  // with +y up. up must not be parallel to target - eye.
+  static constexpr matrix4x4 look_at(const float3& eye, const float3& target, const float3& up) noexcept {
+    float3 f = (target - eye).normalized();
+    float3 s = f.cross(up).normalized();
+    float3 u = s.cross(f);
+    return matrix4x4(
+      s.x, s.y, s.z, -s.dot(eye),
+      u.x, u.y, u.z, -u.dot(eye),
+      -f.x, -f.y, -f.z, f.dot(eye),
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  // View to clip for a camera looking down -z, fov_y in radians. z_near maps to the low end of
+  // the depth range and z_far to 1, matching frustum::from_matrix with the same clip_depth.
+  static constexpr matrix4x4 perspective(float fov_y, float aspect, float z_near, float z_far,
+                                         clip_depth depth = clip_depth::zero_to_one) noexcept {
+    float f = 1.0f / tan(fov_y * 0.5f);
+    float range = 1.0f / (z_near - z_far);
+    bool zero_to_one = depth == clip_depth::zero_to_one;
+    return matrix4x4(
+      f / aspect, 0.0f, 0.0f, 0.0f,
+      0.0f, f, 0.0f, 0.0f,
+      0.0f, 0.0f, (zero_to_one ? z_far : z_far + z_near) * range, (zero_to_one ? 1.0f : 2.0f) * z_near * z_far * range,
+      0.0f, 0.0f, -1.0f, 0.0f
+    );
+  }
+
+  // View to clip for the box [left, right] x [bottom, top] x [-z_near, -z_far]
+  static constexpr matrix4x4 orthographic(float left, float right, float bottom, float top, float z_near, float z_far,
+                                          clip_depth depth = clip_depth::zero_to_one) noexcept {
+    float w = 1.0f / (right - left);
+    float h = 1.0f / (top - bottom);
+    float range = 1.0f / (z_near - z_far);
+    bool zero_to_one = depth == clip_depth::zero_to_one;
+    return matrix4x4(
+      2.0f * w, 0.0f, 0.0f, -(right + left) * w,
+      0.0f, 2.0f * h, 0.0f, -(top + bottom) * h,
+      0.0f, 0.0f, (zero_to_one ? 1.0f : 2.0f) * range, (zero_to_one ? z_near : z_far + z_near) * range,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
   }
 
   float operator()(size_t row, size_t col) const noexcept {
@@ -79,6 +188,191 @@ struct alignas(8) matrix4x4 {
     );
   }
 
+  constexpr matrix4x4 operator*(const matrix4x4& other) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      matrix4x4 result;
+      simd::mat4_mul(&m[0][0], &other.m[0][0], &result.m[0][0]);
+      return result;
+    }
+#endif
+    return matrix4x4(
+      _m._11 * other._m._11 + _m._12 * other._m._21 + _m._13 * other._m._31 + _m._14 * other._m._41,
+      _m._11 * other._m._12 + _m._12 * other._m._22 + _m._13 * other._m._32 + _m._14 * other._m._42,
+      _m._11 * other._m._13 + _m._12 * other._m._23 + _m._13 * other._m._33 + _m._14 * other._m._43,
+      _m._11 * other._m._14 + _m._12 * other._m._24 + _m._13 * other._m._34 + _m._14 * other._m._44,
+      _m._21 * other._m._11 + _m._22 * other._m._21 + _m._23 * other._m._31 + _m._24 * other._m._41,
+      _m._21 * other._m._12 + _m._22 * other._m._22 + _m._23 * other._m._32 + _m._24 * other._m._42,
+      _m._21 * other._m._13 + _m._22 * other._m._23 + _m._23 * other._m._33 + _m._24 * other._m._43,
+      _m._21 * other._m._14 + _m._22 * other._m._24 + _m._23 * other._m._34 + _m._24 * other._m._44,
+      _m._31 * other._m._11 + _m._32 * other._m._21 + _m._33 * other._m._31 + _m._34 * other._m._41,
+      _m._31 * other._m._12 + _m._32 * other._m._22 + _m._33 * other._m._32 + _m._34 * other._m._42,
+      _m._31 * other._m._13 + _m._32 * other._m._23 + _m._33 * other._m._33 + _m._34 * other._m._43,
+      _m._31 * other._m._14 + _m._32 * other._m._24 + _m._33 * other._m._34 + _m._34 * other._m._44,
+      _m._41 * other._m._11 + _m._42 * other._m._21 + _m._43 * other._m._31 + _m._44 * other._m._41,
+      _m._41 * other._m._12 + _m._42 * other._m._22 + _m._43 * other._m._32 + _m._44 * other._m._42,
+      _m._41 * other._m._13 + _m._42 * other._m._23 + _m._43 * other._m._33 + _m._44 * other._m._43,
+      _m._41 * other._m._14 + _m._42 * other._m._24 + _m._43 * other._m._34 + _m._44 * other._m._44
+    );
+  }
+
+  constexpr vector4 operator*(const vector4& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      return vector4(simd::mat4_transform(_mm_loadu_ps(m[0]), _mm_loadu_ps(m[1]),
+                                          _mm_loadu_ps(m[2]), _mm_loadu_ps(m[3]), v.to_m128()));
+    }
+#endif
+    return vector4(
+      _m._11 * v.vec.x + _m._12 * v.vec.y + _m._13 * v.vec.z + _m._14 * v.vec.w,
+      _m._21 * v.vec.x + _m._22 * v.vec.y + _m._23 * v.vec.z + _m._24 * v.vec.w,
+      _m._31 * v.vec.x + _m._32 * v.vec.y + _m._33 * v.vec.z + _m._34 * v.vec.w,
+      _m._41 * v.vec.x + _m._42 * v.vec.y + _m._43 * v.vec.z + _m._44 * v.vec.w
+    );
+  }
+
+  // Affine point transform (w = 1), the fourth row is ignored
+  constexpr float3 transform_point(const float3& p) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      alignas(16) float r[4] = {};
+      _mm_store_ps(r, simd::mat34_transform(m[0], _mm_setr_ps(p.x, p.y, p.z, 1.0f)));
+      return {r[0], r[1], r[2]};
+    }
+#endif
+    return {
+      _m._11 * p.x + _m._12 * p.y + _m._13 * p.z + _m._14,
+      _m._21 * p.x + _m._22 * p.y + _m._23 * p.z + _m._24,
+      _m._31 * p.x + _m._32 * p.y + _m._33 * p.z + _m._34
+    };
+  }
+
+  // Direction transform (w = 0), translation is ignored
+  constexpr float3 transform_direction(const float3& d) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      alignas(16) float r[4] = {};
+      _mm_store_ps(r, simd::mat34_transform(m[0], _mm_setr_ps(d.x, d.y, d.z, 0.0f)));
+      return {r[0], r[1], r[2]};
+    }
+#endif
+    return {
+      _m._11 * d.x + _m._12 * d.y + _m._13 * d.z,
+      _m._21 * d.x + _m._22 * d.y + _m._23 * d.z,
+      _m._31 * d.x + _m._32 * d.y + _m._33 * d.z
+    };
+  }
+
+  constexpr bool is_affine() const noexcept {
+    return _m._41 == 0.0f && _m._42 == 0.0f && _m._43 == 0.0f && _m._44 == 1.0f;
+  }
+
+  constexpr float determinant() const noexcept {
+    float s0 = _m._11 * _m._22 - _m._21 * _m._12;
+    float s1 = _m._11 * _m._23 - _m._21 * _m._13;
+    float s2 = _m._11 * _m._24 - _m._21 * _m._14;
+    float s3 = _m._12 * _m._23 - _m._22 * _m._13;
+    float s4 = _m._12 * _m._24 - _m._22 * _m._14;
+    float s5 = _m._13 * _m._24 - _m._23 * _m._14;
+
+    float c5 = _m._33 * _m._44 - _m._43 * _m._34;
+    float c4 = _m._32 * _m._44 - _m._42 * _m._34;
+    float c3 = _m._32 * _m._43 - _m._42 * _m._33;
+    float c2 = _m._31 * _m._44 - _m._41 * _m._34;
+    float c1 = _m._31 * _m._43 - _m._41 * _m._33;
+    float c0 = _m._31 * _m._42 - _m._41 * _m._32;
+
+    return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  }
+
+  constexpr bool is_invertible() const noexcept {
+    return determinant() != 0.0f;
+  }
+
+  // General cofactor inverse, returns a zero matrix when singular
+  constexpr matrix4x4 inverse() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      matrix4x4 result;
+      simd::mat4_inverse(&m[0][0], &result.m[0][0]);
+      return result;
+    }
+#endif
+    float s0 = _m._11 * _m._22 - _m._21 * _m._12;
+    float s1 = _m._11 * _m._23 - _m._21 * _m._13;
+    float s2 = _m._11 * _m._24 - _m._21 * _m._14;
+    float s3 = _m._12 * _m._23 - _m._22 * _m._13;
+    float s4 = _m._12 * _m._24 - _m._22 * _m._14;
+    float s5 = _m._13 * _m._24 - _m._23 * _m._14;
+
+    float c5 = _m._33 * _m._44 - _m._43 * _m._34;
+    float c4 = _m._32 * _m._44 - _m._42 * _m._34;
+    float c3 = _m._32 * _m._43 - _m._42 * _m._33;
+    float c2 = _m._31 * _m._44 - _m._41 * _m._34;
+    float c1 = _m._31 * _m._43 - _m._41 * _m._33;
+    float c0 = _m._31 * _m._42 - _m._41 * _m._32;
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f) return matrix4x4{};
+
+    float invDet = 1.0f / det;
+
+    return matrix4x4(
+      ( _m._22 * c5 - _m._23 * c4 + _m._24 * c3) * invDet,
+      (-_m._12 * c5 + _m._13 * c4 - _m._14 * c3) * invDet,
+      ( _m._42 * s5 - _m._43 * s4 + _m._44 * s3) * invDet,
+      (-_m._32 * s5 + _m._33 * s4 - _m._34 * s3) * invDet,
+      (-_m._21 * c5 + _m._23 * c2 - _m._24 * c1) * invDet,
+      ( _m._11 * c5 - _m._13 * c2 + _m._14 * c1) * invDet,
+      (-_m._41 * s5 + _m._43 * s2 - _m._44 * s1) * invDet,
+      ( _m._31 * s5 - _m._33 * s2 + _m._34 * s1) * invDet,
+      ( _m._21 * c4 - _m._22 * c2 + _m._24 * c0) * invDet,
+      (-_m._11 * c4 + _m._12 * c2 - _m._14 * c0) * invDet,
+      ( _m._41 * s4 - _m._42 * s2 + _m._44 * s0) * invDet,
+      (-_m._31 * s4 + _m._32 * s2 - _m._34 * s0) * invDet,
+      (-_m._21 * c3 + _m._22 * c1 - _m._23 * c0) * invDet,
+      ( _m._11 * c3 - _m._12 * c1 + _m._13 * c0) * invDet,
+      (-_m._41 * s3 + _m._42 * s1 - _m._43 * s0) * invDet,
+      ( _m._31 * s3 - _m._32 * s1 + _m._33 * s0) * invDet
+    );
+  }
+
+  // Fast path for matrices with a (0, 0, 0, 1) fourth row, see is_affine()
+  constexpr matrix4x4 inverse_affine() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      matrix4x4 result;
+      if (_mm_cvtss_f32(simd::mat4_inverse_affine(&m[0][0], &result.m[0][0])) != 0.0f) result._m._44 = 1.0f;
+      return result;
+    }
+#endif
+    float c00 = _m._22 * _m._33 - _m._23 * _m._32;
+    float c01 = _m._23 * _m._31 - _m._21 * _m._33;
+    float c02 = _m._21 * _m._32 - _m._22 * _m._31;
+
+    float det = _m._11 * c00 + _m._12 * c01 + _m._13 * c02;
+    if (det == 0.0f) return matrix4x4{};
+
+    float invDet = 1.0f / det;
+
+    float i11 = c00 * invDet;
+    float i12 = (_m._13 * _m._32 - _m._12 * _m._33) * invDet;
+    float i13 = (_m._12 * _m._23 - _m._13 * _m._22) * invDet;
+    float i21 = c01 * invDet;
+    float i22 = (_m._11 * _m._33 - _m._13 * _m._31) * invDet;
+    float i23 = (_m._13 * _m._21 - _m._11 * _m._23) * invDet;
+    float i31 = c02 * invDet;
+    float i32 = (_m._12 * _m._31 - _m._11 * _m._32) * invDet;
+    float i33 = (_m._11 * _m._22 - _m._12 * _m._21) * invDet;
+
+    return matrix4x4(
+      i11, i12, i13, -(i11 * _m._14 + i12 * _m._24 + i13 * _m._34),
+      i21, i22, i23, -(i21 * _m._14 + i22 * _m._24 + i23 * _m._34),
+      i31, i32, i33, -(i31 * _m._14 + i32 * _m._24 + i33 * _m._34),
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
   void print() const noexcept {
     printf("| %.2f %.2f %.2f %.2f |\n", _m._11, _m._12, _m._13, _m._14);
     printf("| %.2f %.2f %.2f %.2f |\n", _m._21, _m._22, _m._23, _m._24);
@@ -86,15 +380,13 @@ struct alignas(8) matrix4x4 {
     printf("| %.2f %.2f %.2f %.2f |\n", _m._41, _m._42, _m._43, _m._44);
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[256];
-    std::snprintf(buffer, sizeof(buffer),
-                  "| %.2f %.2f %.2f %.2f |\n| %.2f %.2f %.2f %.2f |\n| %.2f %.2f %.2f %.2f |\n| %.2f %.2f %.2f %.2f |",
-                  _m._11, _m._12, _m._13, _m._14, _m._21, _m._22, _m._23, _m._24,
-                  _m._31, _m._32, _m._33, _m._34, _m._41, _m._42, _m._43, _m._44);
-    return buffer;
+  // One "| a b c |" line per row with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    return format_rows(first, last, m[0], 4, 4);
   }
 
+  const char* to_string() const noexcept { return format_to_string(*this); }
+
 #if (__cplusplus >= 202002L)
   constexpr bool operator==(const matrix4x4& other) const noexcept = default;
   constexpr auto operator<=>(const matrix4x4& other) const noexcept = default;
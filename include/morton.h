@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "int2.h"
+#include "int3.h"
+#include "uint2.h"
+#include "uint3.h"
+
+#include <cstddef>
+
+// Space-filling curve keys for sorting points and voxels spatially. Morton (Z-order) keys
+// interleave the coordinate bits, x in the lowest bit: 32 bits per axis in 2D and 21 bits per
+// axis in 3D, both giving 64-bit keys. Hilbert keys use the same 21 bits per axis; neighbours
+// along the curve are always neighbouring cells, so runs of keys stay more compact than
+// Morton ones at the cost of a slower encode.
+//
+// Built with BMI2 (-mbmi2, -march=haswell and later) the scalar functions use pdep/pext,
+// otherwise shifts and masks. The batch functions quantize float3 arrays into keys with the
+// runtime-dispatched kernels (cpu.h).
+
+namespace cgmath {
+
+constexpr uint32_t MORTON3_BITS = 21;
+
+namespace detail {
+
+// x's bits moved to every second bit
+constexpr uint64_t spread_by_1(uint32_t v) noexcept {
+  uint64_t x = v;
+  x = (x | (x << 16)) & 0x0000ffff0000ffffull;
+  x = (x | (x << 8)) & 0x00ff00ff00ff00ffull;
+  x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0full;
+  x = (x | (x << 2)) & 0x3333333333333333ull;
+  x = (x | (x << 1)) & 0x5555555555555555ull;
+  return x;
+}
+
+constexpr uint32_t compact_by_1(uint64_t x) noexcept {
+  x &= 0x5555555555555555ull;
+  x = (x | (x >> 1)) & 0x3333333333333333ull;
+  x = (x | (x >> 2)) & 0x0f0f0f0f0f0f0f0full;
+  x = (x | (x >> 4)) & 0x00ff00ff00ff00ffull;
+  x = (x | (x >> 8)) & 0x0000ffff0000ffffull;
+  x = (x | (x >> 16)) & 0x00000000ffffffffull;
+  return static_cast<uint32_t>(x);
+}
+
+// The low 21 bits moved to every third bit
+constexpr uint64_t spread_by_2(uint32_t v) noexcept {
+  uint64_t x = v & 0x1fffff;
+  x = (x | (x << 32)) & 0x001f00000000ffffull;
+  x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+  x = (x | (x << 8)) & 0x100f00f00f00f00full;
+  x = (x | (x << 4)) & 0x10c30c30c30c30c3ull;
+  x = (x | (x << 2)) & 0x1249249249249249ull;
+  return x;
+}
+
+constexpr uint32_t compact_by_2(uint64_t x) noexcept {
+  x &= 0x1249249249249249ull;
+  x = (x | (x >> 2)) & 0x10c30c30c30c30c3ull;
+  x = (x | (x >> 4)) & 0x100f00f00f00f00full;
+  x = (x | (x >> 8)) & 0x001f0000ff0000ffull;
+  x = (x | (x >> 16)) & 0x001f00000000ffffull;
+  x = (x | (x >> 32)) & 0x00000000001fffffull;
+  return static_cast<uint32_t>(x);
+}
+
+} // namespace detail
+
+constexpr uint64_t morton_encode(const uint2& p) noexcept {
+#ifdef __BMI2__
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+    return _pdep_u64(p.x, 0x5555555555555555ull) | _pdep_u64(p.y, 0xaaaaaaaaaaaaaaaaull);
+  }
+#endif
+  return detail::spread_by_1(p.x) | (detail::spread_by_1(p.y) << 1);
+}
+
+constexpr uint2 morton_decode2(uint64_t key) noexcept {
+#ifdef __BMI2__
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+    return {static_cast<uint32_t>(_pext_u64(key, 0x5555555555555555ull)),
+            static_cast<uint32_t>(_pext_u64(key, 0xaaaaaaaaaaaaaaaaull))};
+  }
+#endif
+  return {detail::compact_by_1(key), detail::compact_by_1(key >> 1)};
+}
+
+// Only the low 21 bits of each coordinate are used
+constexpr uint64_t morton_encode(const uint3& p) noexcept {
+#ifdef __BMI2__
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+    return _pdep_u64(p.x, 0x1249249249249249ull) | _pdep_u64(p.y, 0x2492492492492492ull) |
+           _pdep_u64(p.z, 0x4924924924924924ull);
+  }
+#endif
+  return detail::spread_by_2(p.x) | (detail::spread_by_2(p.y) << 1) | (detail::spread_by_2(p.z) << 2);
+}
+
+constexpr uint3 morton_decode3(uint64_t key) noexcept {
+#ifdef __BMI2__
+  if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+    return {static_cast<uint32_t>(_pext_u64(key, 0x1249249249249249ull)),
+            static_cast<uint32_t>(_pext_u64(key, 0x2492492492492492ull)),
+            static_cast<uint32_t>(_pext_u64(key, 0x4924924924924924ull))};
+  }
+#endif
+  return {detail::compact_by_2(key), detail::compact_by_2(key >> 1), detail::compact_by_2(key >> 2)};
+}
+
+// Signed coordinates are offset by half the range, so [-2^31, 2^31) in 2D and [-2^20, 2^20)
+// in 3D map to increasing keys with the origin in the middle
+constexpr uint64_t morton_encode(const int2& p) noexcept {
+  return morton_encode(uint2(static_cast<uint32_t>(p.x) ^ 0x80000000u, static_cast<uint32_t>(p.y) ^ 0x80000000u));
+}
+
+constexpr int2 morton_decode2_signed(uint64_t key) noexcept {
+  const uint2 u = morton_decode2(key);
+  return {static_cast<int32_t>(u.x ^ 0x80000000u), static_cast<int32_t>(u.y ^ 0x80000000u)};
+}
+
+constexpr uint64_t morton_encode(const int3& p) noexcept {
+  constexpr uint32_t half = 1u << (MORTON3_BITS - 1);
+  return morton_encode(uint3(static_cast<uint32_t>(p.x) + half, static_cast<uint32_t>(p.y) + half,
+                             static_cast<uint32_t>(p.z) + half));
+}
+
+constexpr int3 morton_decode3_signed(uint64_t key) noexcept {
+  constexpr int32_t half = 1 << (MORTON3_BITS - 1);
+  const uint3 u = morton_decode3(key);
+  return {static_cast<int32_t>(u.x) - half, static_cast<int32_t>(u.y) - half, static_cast<int32_t>(u.z) - half};
+}
+
+// 3D Hilbert key over 21 bits per axis, after Skilling, "Programming the Hilbert curve"
+// (AIP Conf. Proc. 707, 2004): the coordinates are turned into the transposed index in
+// place, whose bits then interleave into the key with the first axis most significant.
+constexpr uint64_t hilbert_encode(const uint3& p) noexcept {
+  constexpr uint32_t mask = (1u << MORTON3_BITS) - 1;
+  uint32_t x[3] = {p.x & mask, p.y & mask, p.z & mask};
+
+  // Inverse undo: invert or exchange the low bits, top bit first
+  for (uint32_t q = 1u << (MORTON3_BITS - 1); q > 1; q >>= 1) {
+    const uint32_t low = q - 1;
+    for (int i = 0; i < 3; ++i) {
+      if (x[i] & q) {
+        x[0] ^= low;
+      } else {
+        const uint32_t t = (x[0] ^ x[i]) & low;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+
+  // Gray encode
+  x[1] ^= x[0];
+  x[2] ^= x[1];
+  uint32_t t = 0;
+  for (uint32_t q = 1u << (MORTON3_BITS - 1); q > 1; q >>= 1) {
+    if (x[2] & q) t ^= q - 1;
+  }
+  for (uint32_t& v : x) v ^= t;
+
+  return morton_encode(uint3(x[2], x[1], x[0]));
+}
+
+constexpr uint3 hilbert_decode3(uint64_t key) noexcept {
+  const uint3 m = morton_decode3(key);
+  uint32_t x[3] = {m.z, m.y, m.x};
+
+  // Gray decode
+  uint32_t t = x[2] >> 1;
+  x[2] ^= x[1];
+  x[1] ^= x[0];
+  x[0] ^= t;
+
+  // Undo the excess work, low bits first
+  for (uint32_t q = 2; q != (1u << MORTON3_BITS); q <<= 1) {
+    const uint32_t low = q - 1;
+    for (int i = 2; i >= 0; --i) {
+      if (x[i] & q) {
+        x[0] ^= low;
+      } else {
+        t = (x[0] ^ x[i]) & low;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+  return {x[0], x[1], x[2]};
+}
+
+enum class space_curve { morton, hilbert };
+
+// Keys of points quantized into 2^21 cells per axis of [min, max]; points outside the box
+// are clamped to it. Cell c covers [min + c * extent / 2^21, min + (c + 1) * extent / 2^21).
+void morton_keys(const float3* points, size_t n, const float3& min, const float3& max, uint64_t* keys) noexcept;
+void hilbert_keys(const float3* points, size_t n, const float3& min, const float3& max, uint64_t* keys) noexcept;
+
+// Stable radix sort of keys in ascending order, values moved along with them: one pass on the
+// most significant byte that varies, then the lower bytes within each of its 256 buckets while
+// they are in cache. Bytes equal in every key are skipped. thread_count 0 uses every thread of
+// the default scheduler (parallel.h); needs 12 bytes of scratch per element.
+void radix_sort(uint64_t* keys, uint32_t* values, size_t n, size_t thread_count = 0);
+
+// Permutation visiting points along the curve through their bounding box: order[i] is the
+// index of the i-th point. Reordering a point cloud for locality is then a single gather.
+void spatial_order(const float3* points, size_t n, uint32_t* order, space_curve curve = space_curve::morton,
+                   size_t thread_count = 0);
+
+} // namespace cgmath
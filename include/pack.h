@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float2.h"
+#include "float3.h"
+#include "float4.h"
+#include "int2.h"
+#include "int3.h"
+#include "int4.h"
+#include "uint2.h"
+#include "uint3.h"
+#include "uint4.h"
+#include "vector2.h"
+#include "vector3.h"
+#include "vector4.h"
+#include "quaternion.h"
+#include "dual_quaternion.h"
+#include "matrix3x3.h"
+#include "matrix3x4.h"
+#include "matrix4x3.h"
+#include "matrix4x4.h"
+
+#include <cstddef>
+#include <vector>
+
+// Binary container of named typed arrays, meant to be memory mapped and read in place.
+//
+// Layout: pack_header, the array data blocks each aligned to PACK_DATA_ALIGNMENT, then the
+// directory of pack_entry records at header.directory_offset. All fields are little endian
+// as written by the producing machine; readers reject files with a different byte order.
+
+namespace cgmath {
+
+constexpr uint32_t PACK_VERSION = 1;
+constexpr size_t PACK_DATA_ALIGNMENT = 64;
+constexpr size_t PACK_NAME_SIZE = 32;
+
+// pack_entry::flags
+constexpr uint32_t PACK_ENTRY_CHECKSUM = 1;  // checksum holds pack_checksum of the data
+
+// Element type tags, the values are part of the file format
+enum class pack_type : uint32_t {
+  u8 = 1, u16, u32, i32, f32,
+  float2 = 16, float3, float4,
+  int2, int3, int4,
+  uint2, uint3, uint4,
+  vector2 = 32, vector3, vector4,
+  quaternion, dual_quaternion,
+  matrix3x3 = 48, matrix3x4, matrix4x3, matrix4x4
+};
+
+template <typename T> struct pack_type_of;
+template <> struct pack_type_of<uint8_t> { static constexpr pack_type value = pack_type::u8; };
+template <> struct pack_type_of<uint16_t> { static constexpr pack_type value = pack_type::u16; };
+template <> struct pack_type_of<uint32_t> { static constexpr pack_type value = pack_type::u32; };
+template <> struct pack_type_of<int32_t> { static constexpr pack_type value = pack_type::i32; };
+template <> struct pack_type_of<float> { static constexpr pack_type value = pack_type::f32; };
+template <> struct pack_type_of<float2> { static constexpr pack_type value = pack_type::float2; };
+template <> struct pack_type_of<float3> { static constexpr pack_type value = pack_type::float3; };
+template <> struct pack_type_of<float4> { static constexpr pack_type value = pack_type::float4; };
+template <> struct pack_type_of<int2> { static constexpr pack_type value = pack_type::int2; };
+template <> struct pack_type_of<int3> { static constexpr pack_type value = pack_type::int3; };
+template <> struct pack_type_of<int4> { static constexpr pack_type value = pack_type::int4; };
+template <> struct pack_type_of<uint2> { static constexpr pack_type value = pack_type::uint2; };
+template <> struct pack_type_of<uint3> { static constexpr pack_type value = pack_type::uint3; };
+template <> struct pack_type_of<uint4> { static constexpr pack_type value = pack_type::uint4; };
+template <> struct pack_type_of<vector2> { static constexpr pack_type value = pack_type::vector2; };
+template <> struct pack_type_of<vector3> { static constexpr pack_type value = pack_type::vector3; };
+template <> struct pack_type_of<vector4> { static constexpr pack_type value = pack_type::vector4; };
+template <> struct pack_type_of<quaternion> { static constexpr pack_type value = pack_type::quaternion; };
+template <> struct pack_type_of<dual_quaternion> { static constexpr pack_type value = pack_type::dual_quaternion; };
+template <> struct pack_type_of<matrix3x3> { static constexpr pack_type value = pack_type::matrix3x3; };
+template <> struct pack_type_of<matrix3x4> { static constexpr pack_type value = pack_type::matrix3x4; };
+template <> struct pack_type_of<matrix4x3> { static constexpr pack_type value = pack_type::matrix4x3; };
+template <> struct pack_type_of<matrix4x4> { static constexpr pack_type value = pack_type::matrix4x4; };
+
+struct pack_header {
+  char magic[8];              // "CGMPACK" and a zero
+  uint32_t version;           // PACK_VERSION
+  uint32_t byte_order;        // 0x01020304 in the producer's byte order
+  uint32_t array_count;
+  uint32_t flags;             // reserved, zero
+  uint64_t directory_offset;
+  uint64_t file_size;
+  uint8_t reserved[24];
+};
+
+struct pack_entry {
+  char name[PACK_NAME_SIZE];  // zero padded, at least one trailing zero
+  uint32_t type;              // pack_type
+  uint32_t stride;            // bytes per element, sizeof(T) of the producer
+  uint32_t alignment;         // alignof(T) of the producer
+  uint32_t flags;
+  uint64_t count;
+  uint64_t offset;            // from the start of the file
+  uint64_t size;              // count * stride bytes
+  uint64_t checksum;
+};
+
+static_assert(sizeof(pack_header) == 64, "pack_header must be 64 bytes");
+static_assert(sizeof(pack_entry) == 80, "pack_entry must be 80 bytes");
+
+// Read-only view into a mapped pack
+template <typename T>
+struct pack_view {
+  const T* data = nullptr;
+  size_t size = 0;
+
+  bool empty() const noexcept { return size == 0; }
+  const T* begin() const noexcept { return data; }
+  const T* end() const noexcept { return data + size; }
+  const T& operator[](size_t i) const noexcept { return data[i]; }
+};
+
+// 64-bit hash used for the entry checksums, several GB/s per core. Detects corruption, not tampering.
+uint64_t pack_checksum(const void* data, size_t size) noexcept;
+
+// Collects arrays by reference and writes them out in one go; the arrays must stay
+// alive until save returns.
+struct pack_writer {
+  // Fails on a name that is empty, too long or already used, or on an alignment that is not a
+  // power of two
+  template <typename T>
+  bool add(const char* name, const T* data, size_t count) {
+    return add_raw(name, static_cast<uint32_t>(pack_type_of<T>::value), sizeof(T), alignof(T), data, count);
+  }
+
+  bool add_raw(const char* name, uint32_t type, uint32_t stride, uint32_t alignment, const void* data, size_t count);
+
+  bool save(const char* path, bool checksum = true) const;
+
+private:
+  struct pending {
+    pack_entry entry;
+    const void* data;
+  };
+  std::vector<pending> arrays;
+};
+
+// Memory-mapped pack. Views stay valid until close or destruction.
+struct pack_file {
+  pack_file() noexcept = default;
+  pack_file(const pack_file&) = delete;
+  pack_file& operator=(const pack_file&) = delete;
+  pack_file(pack_file&& other) noexcept;
+  pack_file& operator=(pack_file&& other) noexcept;
+  ~pack_file();
+
+  // Maps the file and validates the header and directory bounds; data is not touched
+  bool open(const char* path) noexcept;
+  void close() noexcept;
+  bool is_open() const noexcept { return base != nullptr; }
+
+  const pack_header& header() const noexcept { return *reinterpret_cast<const pack_header*>(base); }
+  size_t array_count() const noexcept { return is_open() ? header().array_count : 0; }
+  const pack_entry& entry(size_t i) const noexcept { return directory()[i]; }
+  const pack_entry* find(const char* name) const noexcept;
+
+  // Zero-copy view, empty when the array is missing or its type, stride or alignment
+  // do not match T on this machine
+  template <typename T>
+  pack_view<T> get(const char* name) const noexcept {
+    const pack_entry* e = find(name);
+    if (!e || e->type != static_cast<uint32_t>(pack_type_of<T>::value) || e->stride != sizeof(T)) return {};
+    const void* p = base + e->offset;
+    if (reinterpret_cast<uintptr_t>(p) % alignof(T) != 0) return {};
+    return {static_cast<const T*>(p), static_cast<size_t>(e->count)};
+  }
+
+  // Recomputes the checksum of one array, which reads all of it. Entries written without
+  // checksums always pass.
+  bool verify(const pack_entry& e) const noexcept;
+
+private:
+  const pack_entry* directory() const noexcept {
+    return reinterpret_cast<const pack_entry*>(base + header().directory_offset);
+  }
+
+  const unsigned char* base = nullptr;
+  size_t mapped_size = 0;
+#ifdef _WIN32
+  void* file_handle = nullptr;
+  void* mapping_handle = nullptr;
+#endif
+};
+
+} // namespace cgmath
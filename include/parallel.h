@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Parallel loops over index ranges for the batch functions, which all work on sub-ranges:
+//
+//   parallel_for(0, n, [&](size_t begin, size_t end) {
+//     transform_points(m, in + begin, out + begin, end - begin);
+//   });
+//
+// The range is cut into chunks and every thread starts on an equal share of them. A thread
+// that runs out steals the upper half of the chunks another one has left, so uneven work
+// still finishes together. Loops started from inside a loop body run on the calling thread.
+
+namespace cgmath {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Runs the workers of parallel loops. The built-in one is a pool of hardware_concurrency() - 1
+// threads, started on first use, plus the calling thread; an engine with a job system of its
+// own implements this instead and passes it in parallel_options or to set_default_scheduler.
+struct scheduler {
+  virtual ~scheduler() = default;
+
+  // Threads run can keep busy at once, counting the calling one
+  virtual size_t concurrency() const noexcept = 0;
+
+  // Calls work(context, i) for every i in [0, count) and returns once all of them have
+  // returned. The calls may run on any threads in any order, the calling thread included;
+  // each one steals from the others, so running them one after another is also correct.
+  virtual void run(size_t count, void (*work)(void* context, size_t i), void* context) = 0;
+};
+
+// The scheduler loops use when parallel_options::executor is null
+scheduler& default_scheduler() noexcept;
+
+// Replaces the default scheduler, null restores the built-in pool. Not meant to race with
+// running loops.
+void set_default_scheduler(scheduler* s) noexcept;
+
+enum class partition {
+  dynamic,       // chunk size from the range and the thread count
+  deterministic  // chunk size from the grain only, the same on any machine and thread count
+};
+
+struct parallel_options {
+  size_t thread_count = 0;    // 0 uses every thread of the scheduler
+  size_t grain = 0;           // fewest indices per chunk, 0 for 16 KB worth of elements
+  size_t element_size = 4;    // bytes per index in the arrays written; chunks start on
+                              // multiples of CACHE_LINE_SIZE bytes from begin. 0 for loops
+                              // over tasks rather than elements: no rounding, grain 0 is 1
+  partition mode = partition::dynamic;
+  scheduler* executor = nullptr;
+};
+
+namespace detail {
+
+struct chunking {
+  size_t begin, end;
+  size_t size;   // indices per chunk, the last one may be shorter
+  size_t count;  // chunks
+};
+
+chunking make_chunks(size_t begin, size_t end, const parallel_options& options) noexcept;
+
+// Calls body(context, chunk, chunk_begin, chunk_end) once for every chunk
+void run_chunks(const chunking& c, const parallel_options& options,
+                void (*body)(void* context, size_t chunk, size_t begin, size_t end), void* context);
+
+} // namespace detail
+
+// Calls f(chunk_begin, chunk_end) over disjoint chunks covering [begin, end), concurrently.
+// f must not throw.
+template <typename F>
+void parallel_for(size_t begin, size_t end, F&& f, const parallel_options& options = {}) {
+  using body_type = std::remove_reference_t<F>;
+  const detail::chunking c = detail::make_chunks(begin, end, options);
+  detail::run_chunks(c, options, [](void* context, size_t, size_t b, size_t e) { (*static_cast<body_type*>(context))(b, e); },
+                     const_cast<void*>(static_cast<const void*>(&f)));
+}
+
+// combine(identity, map(b0, e0), map(b1, e1), ...) over the chunks in order; map returns the
+// partial result of one chunk. With partition::deterministic the result is the same for every
+// thread count and scheduler, floating-point sums included. map must not throw.
+template <typename T, typename Map, typename Combine>
+T parallel_reduce(size_t begin, size_t end, T identity, Map&& map, Combine&& combine,
+                  const parallel_options& options = {}) {
+  const detail::chunking c = detail::make_chunks(begin, end, options);
+  std::vector<T> partials(c.count, identity);
+  struct context_type {
+    std::remove_reference_t<Map>* map;
+    T* partials;
+  } context{&map, partials.data()};
+  detail::run_chunks(
+      c, options,
+      [](void* p, size_t chunk, size_t b, size_t e) {
+        auto* ctx = static_cast<context_type*>(p);
+        ctx->partials[chunk] = (*ctx->map)(b, e);
+      },
+      &context);
+  T result = identity;
+  for (const T& v : partials) result = combine(result, v);
+  return result;
+}
+
+} // namespace cgmath
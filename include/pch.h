@@ -12,3 +12,22 @@
 #ifdef __SSE__
   #include <xmmintrin.h>
 #endif
+
+#ifdef __SSE2__
+  #include <emmintrin.h>
+#endif
+
+#ifdef __SSE4_1__
+  #include <smmintrin.h>
+#endif
+
+#if defined(__AVX__) || defined(__FMA__) || defined(__BMI2__)
+  #include <immintrin.h>
+#endif
+
+// Selects the constexpr (scalar) path during constant evaluation and the SIMD path at runtime
+#if (__cplusplus >= 202002L)
+  #define CG_MATH_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#else
+  #define CG_MATH_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "format.h"
+#include "simd.h"
+#include "constexpr_math.h"
+#include "float3.h"
+#include "vector3.h"
+#include "vector4.h"
+#include "matrix3x3.h"
+#include "matrix3x4.h"
+#include "matrix4x4.h"
+
+#include <cstddef>
+
+namespace cgmath {
+
+// Rotation quaternion stored as vector4 (x, y, z, w) with w as the scalar part.
+// Rotations follow the column-vector convention of matrix4x4: q * p * conj(q).
+struct alignas(16) quaternion
+{
+  vector4 v;
+
+  // Identity rotation
+  constexpr quaternion() noexcept : v(0.0f, 0.0f, 0.0f, 1.0f) {}
+  constexpr quaternion(float _x, float _y, float _z, float _w) noexcept : v(_x, _y, _z, _w) {}
+  constexpr explicit quaternion(const vector4& _v) noexcept : v(_v) {}
+
+#ifdef __SSE__
+  quaternion(__m128 q) noexcept : v(q) {}
+  __m128 to_m128() const noexcept { return v.to_m128(); }
+#endif
+
+  static constexpr quaternion identity() noexcept { return {}; }
+
+  // axis must be unit length, angle in radians
+  static constexpr quaternion from_axis_angle(const float3& axis, float angle) noexcept {
+    float s = sin(angle * 0.5f);
+    return {axis.x * s, axis.y * s, axis.z * s, cos(angle * 0.5f)};
+  }
+
+  // Rotation part of a rotation matrix (Shepperd's method)
+  static constexpr quaternion from_matrix(const matrix3x3& m) noexcept {
+    float trace = m._m._11 + m._m._22 + m._m._33;
+    if (trace > 0.0f) {
+      float s = sqrt(trace + 1.0f) * 2.0f;
+      return {(m._m._32 - m._m._23) / s, (m._m._13 - m._m._31) / s, (m._m._21 - m._m._12) / s, 0.25f * s};
+    }
+    if (m._m._11 > m._m._22 && m._m._11 > m._m._33) {
+      float s = sqrt(1.0f + m._m._11 - m._m._22 - m._m._33) * 2.0f;
+      return {0.25f * s, (m._m._12 + m._m._21) / s, (m._m._13 + m._m._31) / s, (m._m._32 - m._m._23) / s};
+    }
+    if (m._m._22 > m._m._33) {
+      float s = sqrt(1.0f + m._m._22 - m._m._11 - m._m._33) * 2.0f;
+      return {(m._m._12 + m._m._21) / s, 0.25f * s, (m._m._23 + m._m._32) / s, (m._m._13 - m._m._31) / s};
+    }
+    float s = sqrt(1.0f + m._m._33 - m._m._11 - m._m._22) * 2.0f;
+    return {(m._m._13 + m._m._31) / s, (m._m._23 + m._m._32) / s, 0.25f * s, (m._m._21 - m._m._12) / s};
+  }
+
+  constexpr float3 xyz() const noexcept { return {v.vec.x, v.vec.y, v.vec.z}; }
+  constexpr float w() const noexcept { return v.vec.w; }
+
+  constexpr quaternion operator+(const quaternion& q) const noexcept { return quaternion(v + q.v); }
+  constexpr quaternion operator-(const quaternion& q) const noexcept { return quaternion(v - q.v); }
+  constexpr quaternion operator*(float scalar) const noexcept { return quaternion(v * scalar); }
+  constexpr quaternion operator-() const noexcept { return quaternion(v * -1.0f); }
+
+  // Hamilton product, (a * b) rotates by b first and then by a
+  constexpr quaternion operator*(const quaternion& q) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      __m128 a = to_m128(), b = q.to_m128();
+      __m128 r = _mm_mul_ps(simd::swizzle<3, 3, 3, 3>(a), b);
+      r = simd::madd(simd::swizzle<0, 0, 0, 0>(a), _mm_mul_ps(simd::swizzle<3, 2, 1, 0>(b), _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f)), r);
+      r = simd::madd(simd::swizzle<1, 1, 1, 1>(a), _mm_mul_ps(simd::swizzle<2, 3, 0, 1>(b), _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f)), r);
+      r = simd::madd(simd::swizzle<2, 2, 2, 2>(a), _mm_mul_ps(simd::swizzle<1, 0, 3, 2>(b), _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f)), r);
+      return quaternion(r);
+    }
+#endif
+    const auto& a = v.vec;
+    const auto& b = q.v.vec;
+    return {
+      a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+      a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+      a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+      a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    };
+  }
+
+  constexpr quaternion& operator*=(const quaternion& q) noexcept { return *this = *this * q; }
+
+  constexpr float dot(const quaternion& q) const noexcept { return v.dot(q.v); }
+  constexpr float length() const noexcept { return v.length(); }
+  constexpr quaternion normalized() const noexcept { return quaternion(v.normalized()); }
+  constexpr quaternion conjugate() const noexcept { return {-v.vec.x, -v.vec.y, -v.vec.z, v.vec.w}; }
+
+  constexpr quaternion inverse() const noexcept {
+    float len2 = dot(*this);
+    return len2 > 0.0f ? conjugate() * (1.0f / len2) : quaternion(0.0f, 0.0f, 0.0f, 0.0f);
+  }
+
+  // v' = v + w t + xyz x t with t = 2 (xyz x v), valid for unit quaternions
+  constexpr float3 rotate(const float3& p) const noexcept {
+    float3 u = xyz();
+    float3 t = u.cross(p) * 2.0f;
+    return p + t * v.vec.w + u.cross(t);
+  }
+
+  vector3 rotate(const vector3& p) const noexcept {
+#ifdef __SSE__
+    __m128 q = to_m128();
+    __m128 vp = p.to_m128();
+    __m128 t = simd::cross3(q, vp);
+    t = _mm_add_ps(t, t);
+    return vector3(_mm_add_ps(simd::madd(simd::swizzle<3, 3, 3, 3>(q), t, vp), simd::cross3(q, t)));
+#else
+    float3 r = rotate(float3(p.vec.x, p.vec.y, p.vec.z));
+    return {r.x, r.y, r.z};
+#endif
+  }
+
+  // Logarithm of a unit quaternion: (axis * half_angle, 0)
+  quaternion log() const noexcept {
+    float3 u = xyz();
+    float s = u.length();
+    float len = length();
+    float angle = std::atan2(s, v.vec.w);
+    float k = s > 0.0f ? angle / s : 1.0f;
+    return {u.x * k, u.y * k, u.z * k, std::log(len)};
+  }
+
+  quaternion exp() const noexcept {
+    float3 u = xyz();
+    float angle = u.length();
+    float e = std::exp(v.vec.w);
+    float k = angle > 0.0f ? e * std::sin(angle) / angle : e;
+    return {u.x * k, u.y * k, u.z * k, e * std::cos(angle)};
+  }
+
+  constexpr matrix3x3 to_matrix3x3() const noexcept {
+    const auto& q = v.vec;
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return matrix3x3(
+      1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy),
+      2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx),
+      2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy)
+    );
+  }
+
+  constexpr matrix3x4 to_matrix3x4(const float3& translation = {}) const noexcept {
+    matrix3x3 r = to_matrix3x3();
+    return matrix3x4(
+      r._m._11, r._m._12, r._m._13, translation.x,
+      r._m._21, r._m._22, r._m._23, translation.y,
+      r._m._31, r._m._32, r._m._33, translation.z
+    );
+  }
+
+  constexpr matrix4x4 to_matrix4x4(const float3& translation = {}) const noexcept {
+    matrix3x3 r = to_matrix3x3();
+    return matrix4x4(
+      r._m._11, r._m._12, r._m._13, translation.x,
+      r._m._21, r._m._22, r._m._23, translation.y,
+      r._m._31, r._m._32, r._m._33, translation.z,
+      0.0f, 0.0f, 0.0f, 1.0f
+    );
+  }
+
+  // "quaternion(x, y, z, w)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float values[] = {v.vec.x, v.vec.y, v.vec.z, v.vec.w};
+    return format_tuple(first, last, "quaternion", values, 4);
+  }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
+
+  constexpr bool operator==(const quaternion& other) const noexcept {
+    return v.vec.x == other.v.vec.x && v.vec.y == other.v.vec.y && v.vec.z == other.v.vec.z && v.vec.w == other.v.vec.w;
+  }
+};
+
+static_assert(sizeof(quaternion) == 16, "quaternion must be 16 bytes");
+
+// Normalized linear interpolation along the shortest arc
+constexpr quaternion nlerp(const quaternion& a, const quaternion& b, float t) noexcept {
+  quaternion end = a.dot(b) < 0.0f ? -b : b;
+  return (a + (end - a) * t).normalized();
+}
+
+// Spherical linear interpolation along the shortest arc, falls back to nlerp for nearly equal inputs
+inline quaternion slerp(const quaternion& a, const quaternion& b, float t) noexcept {
+  float cos_theta = a.dot(b);
+  quaternion end = cos_theta < 0.0f ? -b : b;
+  cos_theta = std::fabs(cos_theta);
+  if (cos_theta > 0.9995f) return nlerp(a, end, t);
+
+  float theta = std::acos(cos_theta);
+  float inv_sin = 1.0f / std::sin(theta);
+  float s0 = std::sin((1.0f - t) * theta) * inv_sin;
+  float s1 = std::sin(t * theta) * inv_sin;
+#ifdef __SSE__
+  return quaternion(simd::madd(a.to_m128(), _mm_set1_ps(s0), _mm_mul_ps(end.to_m128(), _mm_set1_ps(s1))));
+#else
+  return a * s0 + end * s1;
+#endif
+}
+
+// Batch helpers over arrays of n elements; translations may be null for pure rotations
+void to_matrix3x4(const quaternion* rotations, const float3* translations, matrix3x4* out, size_t n) noexcept;
+void to_matrix4x4(const quaternion* rotations, const float3* translations, matrix4x4* out, size_t n) noexcept;
+void nlerp(const quaternion* a, const quaternion* b, float t, quaternion* out, size_t n) noexcept;
+
+} // namespace cgmath
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+
+#include <limits>
+
+namespace cgmath {
+
+// Half-open segment origin + t * direction for t in [t_min, t_max]. direction does not
+// need to be normalized, hit distances are then in units of its length.
+struct ray {
+  float3 origin;
+  float3 direction;
+  float t_min = 0.0f;
+  float t_max = std::numeric_limits<float>::infinity();
+
+  constexpr float3 at(float t) const noexcept { return origin + direction * t; }
+};
+
+// Closest intersection found so far. u and v are the barycentric weights of the second
+// and third triangle vertices.
+struct ray_hit {
+  static constexpr uint32_t none = ~0u;
+
+  float t = std::numeric_limits<float>::infinity();
+  float u = 0.0f;
+  float v = 0.0f;
+  uint32_t primitive = none;
+
+  constexpr explicit operator bool() const noexcept { return primitive != none; }
+};
+
+} // namespace cgmath
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "ray.h"
+#include "bvh.h"
+
+#include <cstddef>
+#include <limits>
+
+namespace cgmath {
+
+// N rays in SoA layout for the packet kernels. Lanes are inactive when t_min > t_max,
+// which is how a default constructed packet and partially filled tails start out.
+// Lane masks in the functions below have bit k set for lane k.
+//
+// The functions below run at the kernel level of set_isa, 4, 8 or 16 lanes per step whatever
+// the packet size. Packets pay off with wide registers and coherent rays; on SSE alone a
+// packet of 8 or 16 is usually slower than as many single rays through bvh::intersect.
+template <size_t N>
+struct alignas(64) ray_packet {
+  static constexpr size_t size = N;
+
+  float ox[N], oy[N], oz[N];
+  float dx[N], dy[N], dz[N];
+  float inv_dx[N], inv_dy[N], inv_dz[N];  // 1 / direction, kept in sync by set
+  float t_min[N], t_max[N];
+
+  ray_packet() noexcept {
+    for (size_t i = 0; i < N; ++i) set_inactive(i);
+  }
+
+  // Up to N rays; lanes past count stay inactive
+  static ray_packet from_rays(const ray* rays, size_t count) noexcept {
+    ray_packet p;
+    for (size_t i = 0; i < count && i < N; ++i) p.set(i, rays[i]);
+    return p;
+  }
+
+  static ray_packet from_arrays(const float3* origins, const float3* directions, size_t count,
+                                float t_max = std::numeric_limits<float>::infinity()) noexcept {
+    ray_packet p;
+    for (size_t i = 0; i < count && i < N; ++i) p.set(i, ray{origins[i], directions[i], 0.0f, t_max});
+    return p;
+  }
+
+  void set(size_t lane, const ray& r) noexcept {
+    ox[lane] = r.origin.x;
+    oy[lane] = r.origin.y;
+    oz[lane] = r.origin.z;
+    dx[lane] = r.direction.x;
+    dy[lane] = r.direction.y;
+    dz[lane] = r.direction.z;
+    inv_dx[lane] = 1.0f / r.direction.x;
+    inv_dy[lane] = 1.0f / r.direction.y;
+    inv_dz[lane] = 1.0f / r.direction.z;
+    t_min[lane] = r.t_min;
+    t_max[lane] = r.t_max;
+  }
+
+  void set_inactive(size_t lane) noexcept {
+    ox[lane] = oy[lane] = oz[lane] = 0.0f;
+    dx[lane] = dy[lane] = dz[lane] = 1.0f;
+    inv_dx[lane] = inv_dy[lane] = inv_dz[lane] = 1.0f;
+    t_min[lane] = std::numeric_limits<float>::infinity();
+    t_max[lane] = -std::numeric_limits<float>::infinity();
+  }
+
+  ray get(size_t lane) const noexcept {
+    return {float3(ox[lane], oy[lane], oz[lane]), float3(dx[lane], dy[lane], dz[lane]), t_min[lane], t_max[lane]};
+  }
+
+  uint32_t active_mask() const noexcept {
+    uint32_t m = 0;
+    for (size_t i = 0; i < N; ++i) m |= uint32_t(t_min[i] <= t_max[i]) << i;
+    return m;
+  }
+};
+
+template <size_t N>
+struct alignas(64) packet_hit {
+  float t[N];
+  float u[N];
+  float v[N];
+  uint32_t primitive[N];
+
+  packet_hit() noexcept {
+    for (size_t i = 0; i < N; ++i) {
+      t[i] = std::numeric_limits<float>::infinity();
+      u[i] = v[i] = 0.0f;
+      primitive[i] = ray_hit::none;
+    }
+  }
+
+  ray_hit get(size_t lane) const noexcept { return {t[lane], u[lane], v[lane], primitive[lane]}; }
+};
+
+using ray8 = ray_packet<8>;
+using ray16 = ray_packet<16>;
+using hit8 = packet_hit<8>;
+using hit16 = packet_hit<16>;
+
+// Packet against one triangle in edge form. Lanes that hit within [t_min, t_max] record
+// the hit and shrink t_max to it, so later calls only accept closer hits. Returns those lanes.
+uint32_t intersect_triangle(ray8& r, const bvh_triangle& tri, uint32_t primitive, hit8& hit) noexcept;
+uint32_t intersect_triangle(ray16& r, const bvh_triangle& tri, uint32_t primitive, hit16& hit) noexcept;
+
+// Slab test, returns the lanes whose [t_min, t_max] overlaps the box. t_enter receives
+// the entry distance of every lane when given.
+uint32_t intersect_aabb(const ray8& r, const float3& min, const float3& max, float* t_enter = nullptr) noexcept;
+uint32_t intersect_aabb(const ray16& r, const float3& min, const float3& max, float* t_enter = nullptr) noexcept;
+
+// Packet traversal of a BVH, visiting a node once for all lanes that overlap it.
+// intersect returns the lanes that found a hit, occluded the lanes with any hit.
+uint32_t intersect(const bvh& tree, ray8& r, hit8& hit) noexcept;
+uint32_t intersect(const bvh& tree, ray16& r, hit16& hit) noexcept;
+uint32_t occluded(const bvh& tree, const ray8& r) noexcept;
+uint32_t occluded(const bvh& tree, const ray16& r) noexcept;
+
+// Orders incoherent rays (secondary bounces, random visibility queries) by direction octant,
+// then by the Morton code of the origin, so that consecutive packets share traversal paths.
+// order receives a permutation of [0, n).
+void sort_rays(const ray* rays, size_t n, uint32_t* order);
+
+} // namespace cgmath
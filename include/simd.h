@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+
+#ifdef __SSE__
+
+namespace cgmath::simd {
+
+inline __m128 madd(__m128 a, __m128 b, __m128 c) noexcept {
+#ifdef __FMA__
+  return _mm_fmadd_ps(a, b, c);
+#else
+  return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+inline __m128 msub(__m128 a, __m128 b, __m128 c) noexcept {
+#ifdef __FMA__
+  return _mm_fmsub_ps(a, b, c);
+#else
+  return _mm_sub_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+inline __m128 nmadd(__m128 a, __m128 b, __m128 c) noexcept {
+#ifdef __FMA__
+  return _mm_fnmadd_ps(a, b, c);
+#else
+  return _mm_sub_ps(c, _mm_mul_ps(a, b));
+#endif
+}
+
+template <int x, int y, int z, int w>
+inline __m128 swizzle(__m128 v) noexcept {
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x));
+}
+
+// (a[x], a[y], b[z], b[w])
+template <int x, int y, int z, int w>
+inline __m128 shuffle(__m128 a, __m128 b) noexcept {
+  return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x));
+}
+
+inline float hsum(__m128 v) noexcept {
+  __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+// Dot products, result broadcast to all lanes
+inline __m128 dot3(__m128 a, __m128 b) noexcept {
+#ifdef __SSE4_1__
+  return _mm_dp_ps(a, b, 0x7F);
+#else
+  __m128 m = _mm_mul_ps(a, b);
+  __m128 s = _mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+  s = _mm_add_ss(s, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2)));
+  return _mm_shuffle_ps(s, s, _MM_SHUFFLE(0, 0, 0, 0));
+#endif
+}
+
+inline __m128 dot4(__m128 a, __m128 b) noexcept {
+#ifdef __SSE4_1__
+  return _mm_dp_ps(a, b, 0xFF);
+#else
+  __m128 m = _mm_mul_ps(a, b);
+  __m128 s = _mm_add_ps(m, _mm_movehl_ps(m, m));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_shuffle_ps(s, s, _MM_SHUFFLE(0, 0, 0, 0));
+#endif
+}
+
+// (a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x, 0)
+inline __m128 cross3(__m128 a, __m128 b) noexcept {
+  __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 c = msub(a, b_yzx, _mm_mul_ps(a_yzx, b));
+  return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// _mm_rsqrt_ps (~12 bits) refined by one Newton-Raphson step (~22 bits)
+inline __m128 rsqrt_nr(__m128 x) noexcept {
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 three = _mm_set1_ps(3.0f);
+  __m128 r = _mm_rsqrt_ps(x);
+  __m128 xrr = _mm_mul_ps(_mm_mul_ps(x, r), r);
+  return _mm_mul_ps(_mm_mul_ps(half, r), _mm_sub_ps(three, xrr));
+}
+
+// v / sqrt(len2), or zero where len2 is not positive
+inline __m128 normalize(__m128 v, __m128 len2) noexcept {
+  __m128 mask = _mm_cmpgt_ps(len2, _mm_setzero_ps());
+  return _mm_and_ps(_mm_div_ps(v, _mm_sqrt_ps(len2)), mask);
+}
+
+inline __m128 normalize_fast(__m128 v, __m128 len2) noexcept {
+  __m128 mask = _mm_cmpgt_ps(len2, _mm_setzero_ps());
+  return _mm_and_ps(_mm_mul_ps(v, rsqrt_nr(len2)), mask);
+}
+
+inline __m128 clamp(__m128 v, __m128 lo, __m128 hi) noexcept {
+  return _mm_max_ps(lo, _mm_min_ps(v, hi));
+}
+
+// 4x4 row-major kernels operating on float[16]
+
+// out = a * b, out may alias a or b
+inline void mat4_mul(const float* a, const float* b, float* out) noexcept {
+  __m128 b0 = _mm_loadu_ps(b + 0);
+  __m128 b1 = _mm_loadu_ps(b + 4);
+  __m128 b2 = _mm_loadu_ps(b + 8);
+  __m128 b3 = _mm_loadu_ps(b + 12);
+  __m128 r[4];
+  for (int i = 0; i < 4; ++i) {
+    const float* row = a + i * 4;
+    __m128 acc = _mm_mul_ps(_mm_set1_ps(row[0]), b0);
+    acc = madd(_mm_set1_ps(row[1]), b1, acc);
+    acc = madd(_mm_set1_ps(row[2]), b2, acc);
+    r[i] = madd(_mm_set1_ps(row[3]), b3, acc);
+  }
+  for (int i = 0; i < 4; ++i) _mm_storeu_ps(out + i * 4, r[i]);
+}
+
+// (dot(r0, v), dot(r1, v), dot(r2, v), dot(r3, v))
+inline __m128 mat4_transform(__m128 r0, __m128 r1, __m128 r2, __m128 r3, __m128 v) noexcept {
+  __m128 m0 = _mm_mul_ps(r0, v);
+  __m128 m1 = _mm_mul_ps(r1, v);
+  __m128 m2 = _mm_mul_ps(r2, v);
+  __m128 m3 = _mm_mul_ps(r3, v);
+  __m128 s0 = _mm_add_ps(_mm_unpacklo_ps(m0, m1), _mm_unpackhi_ps(m0, m1));
+  __m128 s1 = _mm_add_ps(_mm_unpacklo_ps(m2, m3), _mm_unpackhi_ps(m2, m3));
+  return _mm_add_ps(_mm_movelh_ps(s0, s1), _mm_movehl_ps(s1, s0));
+}
+
+// 2x2 row-major blocks packed as (m00, m01, m10, m11)
+inline __m128 mat2_mul(__m128 a, __m128 b) noexcept {
+  return madd(a, swizzle<0, 3, 0, 3>(b), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+}
+
+// adj(a) * b
+inline __m128 mat2_adj_mul(__m128 a, __m128 b) noexcept {
+  return msub(swizzle<3, 3, 0, 0>(a), b, _mm_mul_ps(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+}
+
+// a * adj(b)
+inline __m128 mat2_mul_adj(__m128 a, __m128 b) noexcept {
+  return msub(a, swizzle<3, 0, 3, 0>(b), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+}
+
+// Block-wise (2x2) cofactor inverse. Returns the determinant broadcast to all lanes;
+// out is left untouched when it is zero.
+inline __m128 mat4_inverse(const float* in, float* out) noexcept {
+  __m128 r0 = _mm_loadu_ps(in + 0);
+  __m128 r1 = _mm_loadu_ps(in + 4);
+  __m128 r2 = _mm_loadu_ps(in + 8);
+  __m128 r3 = _mm_loadu_ps(in + 12);
+
+  __m128 A = _mm_movelh_ps(r0, r1);
+  __m128 B = _mm_movehl_ps(r1, r0);
+  __m128 C = _mm_movelh_ps(r2, r3);
+  __m128 D = _mm_movehl_ps(r3, r2);
+
+  // (|A|, |B|, |C|, |D|)
+  __m128 det_sub = msub(shuffle<0, 2, 0, 2>(r0, r2), shuffle<1, 3, 1, 3>(r1, r3),
+                        _mm_mul_ps(shuffle<1, 3, 1, 3>(r0, r2), shuffle<0, 2, 0, 2>(r1, r3)));
+  __m128 det_A = swizzle<0, 0, 0, 0>(det_sub);
+  __m128 det_B = swizzle<1, 1, 1, 1>(det_sub);
+  __m128 det_C = swizzle<2, 2, 2, 2>(det_sub);
+  __m128 det_D = swizzle<3, 3, 3, 3>(det_sub);
+
+  __m128 D_C = mat2_adj_mul(D, C);
+  __m128 A_B = mat2_adj_mul(A, B);
+
+  // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+  __m128 det = madd(det_A, det_D, _mm_mul_ps(det_B, det_C));
+  det = _mm_sub_ps(det, _mm_set1_ps(hsum(_mm_mul_ps(A_B, swizzle<0, 2, 1, 3>(D_C)))));
+  if (_mm_cvtss_f32(det) == 0.0f) return det;
+
+  __m128 X = msub(det_D, A, mat2_mul(B, D_C));
+  __m128 W = msub(det_A, D, mat2_mul(C, A_B));
+  __m128 Y = msub(det_B, C, mat2_mul_adj(D, A_B));
+  __m128 Z = msub(det_C, B, mat2_mul_adj(A, D_C));
+
+  __m128 rcp = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+  X = _mm_mul_ps(X, rcp);
+  Y = _mm_mul_ps(Y, rcp);
+  Z = _mm_mul_ps(Z, rcp);
+  W = _mm_mul_ps(W, rcp);
+
+  // adjugate of each block folded into the final shuffle
+  _mm_storeu_ps(out + 0, shuffle<3, 1, 3, 1>(X, Y));
+  _mm_storeu_ps(out + 4, shuffle<2, 0, 2, 0>(X, Y));
+  _mm_storeu_ps(out + 8, shuffle<3, 1, 3, 1>(Z, W));
+  _mm_storeu_ps(out + 12, shuffle<2, 0, 2, 0>(Z, W));
+  return det;
+}
+
+// Inverse of [A t; 0 0 0 1] as [inv(A) -inv(A)t; 0 0 0 1]. Same contract as mat4_inverse.
+// Only the first three rows of in and out are accessed.
+inline __m128 mat4_inverse_affine(const float* in, float* out) noexcept {
+  __m128 r0 = _mm_loadu_ps(in + 0);
+  __m128 r1 = _mm_loadu_ps(in + 4);
+  __m128 r2 = _mm_loadu_ps(in + 8);
+  __m128 t = _mm_setr_ps(in[3], in[7], in[11], 0.0f);
+
+  // Columns of adj(A), lane 3 only ever reaches the discarded fourth row
+  __m128 c0 = cross3(r1, r2);
+  __m128 c1 = cross3(r2, r0);
+  __m128 c2 = cross3(r0, r1);
+  __m128 det = dot3(r0, c0);
+  if (_mm_cvtss_f32(det) == 0.0f) return det;
+
+  __m128 rcp = _mm_div_ps(_mm_set1_ps(1.0f), det);
+  c0 = _mm_mul_ps(c0, rcp);
+  c1 = _mm_mul_ps(c1, rcp);
+  c2 = _mm_mul_ps(c2, rcp);
+
+  __m128 nt = _mm_mul_ps(c0, swizzle<0, 0, 0, 0>(t));
+  nt = madd(c1, swizzle<1, 1, 1, 1>(t), nt);
+  nt = madd(c2, swizzle<2, 2, 2, 2>(t), nt);
+  nt = _mm_sub_ps(_mm_setzero_ps(), nt);
+
+  _MM_TRANSPOSE4_PS(c0, c1, c2, nt);
+  _mm_storeu_ps(out + 0, c0);
+  _mm_storeu_ps(out + 4, c1);
+  _mm_storeu_ps(out + 8, c2);
+  return det;
+}
+
+// 3x4 affine kernels on float[12], the rows of a 4x4 matrix whose implicit fourth row is
+// (0, 0, 0, 1)
+
+// out = a * b, out may alias a or b
+inline void mat34_mul(const float* a, const float* b, float* out) noexcept {
+  __m128 b0 = _mm_loadu_ps(b + 0);
+  __m128 b1 = _mm_loadu_ps(b + 4);
+  __m128 b2 = _mm_loadu_ps(b + 8);
+  __m128 b3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+  __m128 r[3];
+  for (int i = 0; i < 3; ++i) {
+    __m128 row = _mm_loadu_ps(a + i * 4);
+    __m128 acc = _mm_mul_ps(swizzle<0, 0, 0, 0>(row), b0);
+    acc = madd(swizzle<1, 1, 1, 1>(row), b1, acc);
+    acc = madd(swizzle<2, 2, 2, 2>(row), b2, acc);
+    r[i] = madd(swizzle<3, 3, 3, 3>(row), b3, acc);
+  }
+  for (int i = 0; i < 3; ++i) _mm_storeu_ps(out + i * 4, r[i]);
+}
+
+// rows * (x, y, z, w) for the three affine rows, as the columns scaled by the components: a
+// point with w = 1, a direction with w = 0. Lane 3 of the result is 0.
+inline __m128 mat34_transform(const float* rows, __m128 v) noexcept {
+  __m128 c0 = _mm_loadu_ps(rows + 0);
+  __m128 c1 = _mm_loadu_ps(rows + 4);
+  __m128 c2 = _mm_loadu_ps(rows + 8);
+  __m128 c3 = _mm_setzero_ps();
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  __m128 r = _mm_mul_ps(c0, swizzle<0, 0, 0, 0>(v));
+  r = madd(c1, swizzle<1, 1, 1, 1>(v), r);
+  r = madd(c2, swizzle<2, 2, 2, 2>(v), r);
+  return madd(c3, swizzle<3, 3, 3, 3>(v), r);
+}
+
+// Inverse of [R t] with orthonormal R: [R^T -R^T t]. out may alias in.
+inline void mat34_inverse_rigid(const float* in, float* out) noexcept {
+  __m128 r0 = _mm_loadu_ps(in + 0);
+  __m128 r1 = _mm_loadu_ps(in + 4);
+  __m128 r2 = _mm_loadu_ps(in + 8);
+
+  // Lane i of r0 t.x + r1 t.y + r2 t.z is (R^T t)_i
+  __m128 nt = _mm_mul_ps(r0, swizzle<3, 3, 3, 3>(r0));
+  nt = madd(r1, swizzle<3, 3, 3, 3>(r1), nt);
+  nt = madd(r2, swizzle<3, 3, 3, 3>(r2), nt);
+  nt = _mm_sub_ps(_mm_setzero_ps(), nt);
+
+  // The translations in lane 3 end up in the fourth row, which is not stored
+  _MM_TRANSPOSE4_PS(r0, r1, r2, nt);
+  _mm_storeu_ps(out + 0, r0);
+  _mm_storeu_ps(out + 4, r1);
+  _mm_storeu_ps(out + 8, r2);
+}
+
+} // namespace cgmath::simd
+
+#endif
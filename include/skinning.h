@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "soa.h"
+#include "matrix3x4.h"
+#include "dual_quaternion.h"
+
+#include <cstddef>
+
+namespace cgmath {
+
+constexpr size_t SKIN_MAX_INFLUENCES = 4;
+
+// Skinned vertex stream. joints and weights hold SKIN_MAX_INFLUENCES entries per vertex;
+// unused influences should carry a zero weight. Normals are skipped when either side is empty.
+struct skin_input {
+  const_float3_soa_view positions;
+  const_float3_soa_view normals;
+  const uint16_t* joints;
+  const float* weights;
+};
+
+struct skin_output {
+  float3_soa_view positions;
+  float3_soa_view normals;
+};
+
+// Linear blend skinning with a matrix3x4 bone palette. Normals are transformed by the
+// blended 3x3 block and renormalized, which assumes no non-uniform scale in the palette.
+// thread_count > 1 splits the vertex range across up to that many threads of the default
+// scheduler (parallel.h).
+void skin_linear(const skin_input& in, const matrix3x4* palette, skin_output out, size_t thread_count = 1) noexcept;
+
+// Dual quaternion skinning, preserves volume under twisting joints
+void skin_dual_quaternion(const skin_input& in, const dual_quaternion* palette, skin_output out,
+                          size_t thread_count = 1) noexcept;
+
+// Vertex sub-range [begin, end) for callers that schedule the work themselves
+void skin_linear(const skin_input& in, const matrix3x4* palette, skin_output out, size_t begin, size_t end) noexcept;
+void skin_dual_quaternion(const skin_input& in, const dual_quaternion* palette, skin_output out,
+                          size_t begin, size_t end) noexcept;
+
+// Converts a rigid matrix3x4 palette for skin_dual_quaternion
+void to_dual_quaternions(const matrix3x4* palette, dual_quaternion* out, size_t n) noexcept;
+
+} // namespace cgmath
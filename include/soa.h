@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "aligned_allocator.h"
+#include "float3.h"
+#include "float4.h"
+#include "vector3.h"
+#include "vector4.h"
+
+#include <vector>
+
+namespace cgmath {
+
+constexpr size_t SOA_ALIGNMENT = 64;
+
+using soa_stream = std::vector<float, aligned_allocator<float, SOA_ALIGNMENT>>;
+
+// Non-owning views over separate component arrays. Kernels take views so that
+// streams owned elsewhere (mapped files, GPU staging memory) can be used directly.
+struct float3_soa_view {
+  float* x;
+  float* y;
+  float* z;
+  size_t size;
+
+  // Elements [begin, end), e.g. the chunk of a parallel_for
+  constexpr float3_soa_view subview(size_t begin, size_t end) const noexcept {
+    return {x + begin, y + begin, z + begin, end - begin};
+  }
+};
+
+struct const_float3_soa_view {
+  const float* x;
+  const float* y;
+  const float* z;
+  size_t size;
+
+  constexpr const_float3_soa_view() noexcept : x(nullptr), y(nullptr), z(nullptr), size(0) {}
+  constexpr const_float3_soa_view(const float* _x, const float* _y, const float* _z, size_t _size) noexcept
+  : x(_x), y(_y), z(_z), size(_size) {}
+  constexpr const_float3_soa_view(const float3_soa_view& v) noexcept
+  : x(v.x), y(v.y), z(v.z), size(v.size) {}
+
+  constexpr const_float3_soa_view subview(size_t begin, size_t end) const noexcept {
+    return {x + begin, y + begin, z + begin, end - begin};
+  }
+};
+
+struct float4_soa_view {
+  float* x;
+  float* y;
+  float* z;
+  float* w;
+  size_t size;
+
+  constexpr float4_soa_view subview(size_t begin, size_t end) const noexcept {
+    return {x + begin, y + begin, z + begin, w + begin, end - begin};
+  }
+};
+
+struct const_float4_soa_view {
+  const float* x;
+  const float* y;
+  const float* z;
+  const float* w;
+  size_t size;
+
+  constexpr const_float4_soa_view(const float* _x, const float* _y, const float* _z, const float* _w, size_t _size) noexcept
+  : x(_x), y(_y), z(_z), w(_w), size(_size) {}
+  constexpr const_float4_soa_view(const float4_soa_view& v) noexcept
+  : x(v.x), y(v.y), z(v.z), w(v.w), size(v.size) {}
+
+  constexpr const_float4_soa_view subview(size_t begin, size_t end) const noexcept {
+    return {x + begin, y + begin, z + begin, w + begin, end - begin};
+  }
+};
+
+// Owning streams with SOA_ALIGNMENT aligned component arrays
+struct float3_soa {
+  soa_stream x, y, z;
+
+  float3_soa() = default;
+  explicit float3_soa(size_t n) : x(n), y(n), z(n) {}
+
+  size_t size() const noexcept { return x.size(); }
+  void resize(size_t n) { x.resize(n); y.resize(n); z.resize(n); }
+
+  float3 get(size_t i) const noexcept { return {x[i], y[i], z[i]}; }
+  void set(size_t i, const float3& v) noexcept { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+
+  operator float3_soa_view() noexcept { return {x.data(), y.data(), z.data(), size()}; }
+  operator const_float3_soa_view() const noexcept { return {x.data(), y.data(), z.data(), size()}; }
+};
+
+struct float4_soa {
+  soa_stream x, y, z, w;
+
+  float4_soa() = default;
+  explicit float4_soa(size_t n) : x(n), y(n), z(n), w(n) {}
+
+  size_t size() const noexcept { return x.size(); }
+  void resize(size_t n) { x.resize(n); y.resize(n); z.resize(n); w.resize(n); }
+
+  float4 get(size_t i) const noexcept { return {x[i], y[i], z[i], w[i]}; }
+  void set(size_t i, const float4& v) noexcept { x[i] = v.x; y[i] = v.y; z[i] = v.z; w[i] = v.w; }
+
+  operator float4_soa_view() noexcept { return {x.data(), y.data(), z.data(), w.data(), size()}; }
+  operator const_float4_soa_view() const noexcept { return {x.data(), y.data(), z.data(), w.data(), size()}; }
+};
+
+// AoS <-> SoA transposition, out must hold at least n elements
+void aos_to_soa(const float3* in, size_t n, float3_soa_view out) noexcept;
+void aos_to_soa(const vector3* in, size_t n, float3_soa_view out) noexcept;
+void aos_to_soa(const float4* in, size_t n, float4_soa_view out) noexcept;
+void aos_to_soa(const vector4* in, size_t n, float4_soa_view out) noexcept;
+
+void soa_to_aos(const_float3_soa_view in, float3* out) noexcept;
+void soa_to_aos(const_float3_soa_view in, vector3* out) noexcept;
+void soa_to_aos(const_float4_soa_view in, float4* out) noexcept;
+void soa_to_aos(const_float4_soa_view in, vector4* out) noexcept;
+
+// Element-wise kernels over a.size elements. Outputs may alias inputs.
+void dot(const_float3_soa_view a, const_float3_soa_view b, float* out) noexcept;
+void dot(const_float4_soa_view a, const_float4_soa_view b, float* out) noexcept;
+
+void cross(const_float3_soa_view a, const_float3_soa_view b, float3_soa_view out) noexcept;
+
+void length(const_float3_soa_view a, float* out) noexcept;
+void length(const_float4_soa_view a, float* out) noexcept;
+
+// Zero-length elements become zero, like vector3::normalized
+void normalize(const_float3_soa_view a, float3_soa_view out) noexcept;
+void normalize(const_float4_soa_view a, float4_soa_view out) noexcept;
+
+void lerp(const_float3_soa_view a, const_float3_soa_view b, float t, float3_soa_view out) noexcept;
+void lerp(const_float4_soa_view a, const_float4_soa_view b, float t, float4_soa_view out) noexcept;
+
+void clamp(const_float3_soa_view a, const float3& min, const float3& max, float3_soa_view out) noexcept;
+void clamp(const_float4_soa_view a, const float4& min, const float4& max, float4_soa_view out) noexcept;
+
+} // namespace cgmath
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "int3.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace cgmath {
+
+// Uniform grid over points hashed into a power-of-two table of buckets, rebuilt from scratch
+// whenever the points move. Points are counting-sorted by bucket into flat arrays, so bucket b
+// is entries [cell_start[b], cell_start[b + 1]) of indices and positions and no cell allocates.
+//
+// A cell (x, y, z) goes to bucket hash(0, y, z) + x, so the cells of a row along x sit in
+// consecutive buckets and their points in one contiguous run: a query around a point reads
+// 9 runs rather than 27 scattered cells. Cells that collide in a bucket are told apart by
+// recomputing the cell of each candidate, which only happens for points within the radius.
+//
+// Positions divided by the cell size must fit in int32, at most 2^32 - 1 points.
+struct spatial_hash {
+  float cell_size = 1.0f;
+  float inv_cell_size = 1.0f;
+  uint32_t bucket_mask = 0;           // bucket count - 1
+  std::vector<uint32_t> cell_start;   // bucket -> first entry, bucket count + 1 entries
+  std::vector<uint32_t> indices;      // entry -> source point index
+  std::vector<float3> positions;      // entry -> point, in bucket order
+
+  // At least as many buckets as points. thread_count 0 uses every thread of the default
+  // scheduler (parallel.h); the result does not depend on it, points keep their source
+  // order within a bucket.
+  void build(const float3* points, size_t n, float cell_size, size_t thread_count = 0);
+
+  bool empty() const noexcept { return positions.empty(); }
+  size_t size() const noexcept { return positions.size(); }
+  size_t bucket_count() const noexcept { return cell_start.empty() ? 0 : cell_start.size() - 1; }
+  uint32_t cell_count(uint32_t bucket) const noexcept { return cell_start[bucket + 1] - cell_start[bucket]; }
+
+  int3 cell(const float3& p) const noexcept {
+    return {cell_coordinate(p.x), cell_coordinate(p.y), cell_coordinate(p.z)};
+  }
+
+  // floor(v / cell_size) without the libm call floorf is below SSE4.1
+  int32_t cell_coordinate(float v) const noexcept {
+    const float s = v * inv_cell_size;
+    const int32_t i = static_cast<int32_t>(s);
+    return i - (s < static_cast<float>(i));
+  }
+
+  uint32_t bucket(const int3& c) const noexcept {
+    return (hash(int3(0, c.y, c.z)) + static_cast<uint32_t>(c.x)) & bucket_mask;
+  }
+
+  // Calls f(index, distance_squared) once for every point within radius of p, index into the
+  // array given to build. With radius <= cell_size that is the 27 cells around p; larger radii
+  // visit every cell the sphere's bounds touch. Rows are visited in z, y order.
+  template <typename F>
+  void for_each_within(const float3& p, float radius, F&& f) const {
+    if (empty()) return;
+    const float r2 = radius * radius;
+    const int3 lo = cell(p - float3(radius, radius, radius)), hi = cell(p + float3(radius, radius, radius));
+    const size_t buckets = bucket_count();
+    const size_t width = std::min<size_t>(size_t(int64_t(hi.x) - lo.x + 1), buckets);
+
+    // Candidates within the radius are first collected without branching on the distance,
+    // which would mispredict for most of the points that fall outside it
+    const auto visit = [&](uint32_t begin, uint32_t end, int32_t y, int32_t z) {
+      uint32_t hits[64];
+      float hit_d2[64];
+      while (begin < end) {
+        const uint32_t stop = end - begin > 64 ? begin + 64 : end;
+        size_t count = 0;
+        for (uint32_t e = begin; e < stop; ++e) {
+          const float3 d = positions[e] - p;
+          const float d2 = d.x * d.x + d.y * d.y + d.z * d.z;
+          hits[count] = e;
+          hit_d2[count] = d2;
+          count += d2 <= r2;
+        }
+        for (size_t k = 0; k < count; ++k) {
+          const uint32_t e = hits[k];
+          if (cell_coordinate(positions[e].y) != y || cell_coordinate(positions[e].z) != z) {
+            continue;  // another row hashed into the run
+          }
+          f(indices[e], hit_d2[k]);
+        }
+        begin = stop;
+      }
+    };
+
+    for (int32_t z = lo.z; z <= hi.z; ++z) {
+      for (int32_t y = lo.y; y <= hi.y; ++y) {
+        const size_t first = bucket(int3(lo.x, y, z)), last = first + width;
+        if (last <= buckets) {
+          visit(cell_start[first], cell_start[last], y, z);
+        } else {
+          visit(cell_start[first], cell_start[buckets], y, z);
+          visit(cell_start[0], cell_start[last - buckets], y, z);
+        }
+      }
+    }
+  }
+
+  // Source indices of the points within radius of p. Returns how many there are; only the
+  // first capacity are written to out.
+  size_t query(const float3& p, float radius, uint32_t* out, size_t capacity) const noexcept;
+
+private:
+  // Reused between builds, so a rebuild every frame does not allocate
+  std::vector<uint32_t> scratch_buckets;
+  std::vector<uint32_t> scratch_indices;
+  std::vector<float3> scratch_positions;
+};
+
+} // namespace cgmath
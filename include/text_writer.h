@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float2.h"
+#include "float3.h"
+#include "float4.h"
+#include "vector2.h"
+#include "vector3.h"
+#include "vector4.h"
+#include "quaternion.h"
+#include "matrix3x3.h"
+#include "matrix3x4.h"
+#include "matrix4x3.h"
+#include "matrix4x4.h"
+
+#include <cstddef>
+#include <string>
+
+namespace cgmath {
+
+enum class text_format {
+  csv,  // one "a,b,c" line per element
+  json  // array of per-element arrays, non-finite values as null
+};
+
+// Bulk serialization of float arrays with the same shortest round-trip digits as to_chars.
+// Element i is `components` floats starting at data + i * stride. Large arrays are formatted
+// in blocks with parallel_for and written in order; thread_count is that of parallel_options,
+// 0 for every thread of the scheduler.
+bool write_text(std::FILE* file, const float* data, size_t count, size_t components, size_t stride,
+                text_format format, size_t thread_count = 1);
+void write_text(std::string& out, const float* data, size_t count, size_t components, size_t stride,
+                text_format format, size_t thread_count = 1);
+
+// Components per element of the typed overloads below; matrices are written row-major
+template <typename T> struct text_layout;
+template <> struct text_layout<float2> { static constexpr size_t components = 2; };
+template <> struct text_layout<float3> { static constexpr size_t components = 3; };
+template <> struct text_layout<float4> { static constexpr size_t components = 4; };
+template <> struct text_layout<vector2> { static constexpr size_t components = 2; };
+template <> struct text_layout<vector3> { static constexpr size_t components = 3; };
+template <> struct text_layout<vector4> { static constexpr size_t components = 4; };
+template <> struct text_layout<quaternion> { static constexpr size_t components = 4; };
+template <> struct text_layout<matrix3x3> { static constexpr size_t components = 9; };
+template <> struct text_layout<matrix3x4> { static constexpr size_t components = 12; };
+template <> struct text_layout<matrix4x3> { static constexpr size_t components = 12; };
+template <> struct text_layout<matrix4x4> { static constexpr size_t components = 16; };
+
+template <typename T>
+bool write_text(std::FILE* file, const T* v, size_t n, text_format format, size_t thread_count = 1) {
+  return write_text(file, reinterpret_cast<const float*>(v), n, text_layout<T>::components,
+                    sizeof(T) / sizeof(float), format, thread_count);
+}
+
+template <typename T>
+void write_text(std::string& out, const T* v, size_t n, text_format format, size_t thread_count = 1) {
+  write_text(out, reinterpret_cast<const float*>(v), n, text_layout<T>::components,
+             sizeof(T) / sizeof(float), format, thread_count);
+}
+
+} // namespace cgmath
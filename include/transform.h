@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "vector4.h"
+#include "matrix3x4.h"
+#include "matrix4x4.h"
+#include "soa.h"
+
+#include <cstddef>
+
+namespace cgmath {
+
+enum class store_mode {
+  normal,
+  non_temporal  // streaming stores that bypass the cache, for outputs not read back soon
+};
+
+// Batch transforms over arrays. in and out must either be the same array or not overlap.
+// Points and directions use the affine part of the matrix, like matrix4x4::transform_point.
+void transform_points(const matrix4x4& m, const float3* in, float3* out, size_t n,
+                      store_mode mode = store_mode::normal) noexcept;
+
+void transform_directions(const matrix4x4& m, const float3* in, float3* out, size_t n,
+                          store_mode mode = store_mode::normal) noexcept;
+
+// SoA streams, in.size elements. Streaming stores need out.x, out.y and out.z to share
+// the same alignment offset, which holds for float3_soa.
+void transform_points(const matrix4x4& m, const_float3_soa_view in, float3_soa_view out,
+                      store_mode mode = store_mode::normal) noexcept;
+
+void transform_directions(const matrix4x4& m, const_float3_soa_view in, float3_soa_view out,
+                          store_mode mode = store_mode::normal) noexcept;
+
+// The same with an affine matrix3x4, through the same kernels
+void transform_points(const matrix3x4& m, const float3* in, float3* out, size_t n,
+                      store_mode mode = store_mode::normal) noexcept;
+
+void transform_directions(const matrix3x4& m, const float3* in, float3* out, size_t n,
+                          store_mode mode = store_mode::normal) noexcept;
+
+void transform_points(const matrix3x4& m, const_float3_soa_view in, float3_soa_view out,
+                      store_mode mode = store_mode::normal) noexcept;
+
+void transform_directions(const matrix3x4& m, const_float3_soa_view in, float3_soa_view out,
+                          store_mode mode = store_mode::normal) noexcept;
+
+// Full 4x4 product m * v for every element
+void transform_vectors(const matrix4x4& m, const vector4* in, vector4* out, size_t n,
+                       store_mode mode = store_mode::normal) noexcept;
+
+} // namespace cgmath
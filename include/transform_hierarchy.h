@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "matrix3x4.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace cgmath {
+
+constexpr uint32_t NO_PARENT = 0xffffffffu;
+
+// Scene graph transforms: world = parent world * local for every node, as affine matrix3x4.
+// Nodes are stored in separate arrays in depth-first order, so parents come before their
+// children and every subtree is the contiguous range [i, subtree_end[i]). Nodes keep the ids
+// they were built with; position maps an id to its place in the arrays.
+//
+// set_local only flags the node. update then walks the flags, skipping the subtree of every
+// flagged node once it has recomputed it, so the cost follows the number of nodes that moved
+// and their descendants rather than the size of the scene. Subtrees independent of each other
+// are recomputed in parallel (parallel.h).
+struct transform_hierarchy {
+  std::vector<uint32_t> parent;       // position of the parent, NO_PARENT for roots
+  std::vector<uint32_t> subtree_end;  // one past the last descendant
+  std::vector<matrix3x4> local;       // relative to the parent
+  std::vector<matrix3x4> world;       // valid after update
+  std::vector<uint8_t> dirty;         // local changed since the last update
+  std::vector<uint32_t> position;     // id -> position
+  std::vector<uint32_t> node;         // position -> id
+
+  // parents[id] is the parent id or NO_PARENT, in any order. Fails on an out of range parent
+  // or a cycle. Every node starts dirty.
+  bool build(const uint32_t* parents, const matrix3x4* locals, size_t n);
+
+  size_t size() const noexcept { return parent.size(); }
+
+  void set_local(uint32_t id, const matrix3x4& m) noexcept {
+    const uint32_t p = position[id];
+    local[p] = m;
+    dirty[p] = 1;
+  }
+
+  const matrix3x4& local_matrix(uint32_t id) const noexcept { return local[position[id]]; }
+  const matrix3x4& world_matrix(uint32_t id) const noexcept { return world[position[id]]; }
+
+  // Recomputes the world matrices of dirty nodes and their descendants and clears the flags.
+  // Returns the number of nodes recomputed. thread_count 0 uses every thread of the default
+  // scheduler; the result does not depend on it.
+  size_t update(size_t thread_count = 0);
+
+  // Recomputes every world matrix, e.g. for comparison with update
+  void update_all(size_t thread_count = 0);
+};
+
+} // namespace cgmath
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
 
 namespace cgmath {
 
@@ -24,11 +25,13 @@ struct uint2 {
   constexpr uint2& operator*=(uint32_t scalar) noexcept { x *= scalar; y *= scalar; return *this; }
   constexpr uint2& operator%=(uint32_t scalar) noexcept { x %= scalar; y %= scalar; return *this; }
 
-  const char* to_string() const noexcept {
-    static char buffer[32];
-    std::snprintf(buffer, sizeof(buffer), "uint2(%u, %u)", x, y);
-    return buffer;
+  // "uint2(x, y)", see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const uint32_t v[] = {x, y};
+    return format_tuple(first, last, "uint2", v, 2);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 } // namespace cgmath
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
 
 namespace cgmath {
 
@@ -24,11 +25,13 @@ struct uint3 {
   constexpr uint3& operator*=(uint32_t scalar) noexcept { x *= scalar; y *= scalar; z *= scalar; return *this; }
   constexpr uint3& operator%=(uint32_t scalar) noexcept { x %= scalar; y %= scalar; z %= scalar; return *this; }
 
-  const char* to_string() const noexcept {
-    static char buffer[48];
-    std::snprintf(buffer, sizeof(buffer), "uint3(%u, %u, %u)", x, y, z);
-    return buffer;
+  // "uint3(x, y, z)", see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const uint32_t v[] = {x, y, z};
+    return format_tuple(first, last, "uint3", v, 3);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 } // namespace cgmath
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
 
 namespace cgmath {
 
@@ -24,11 +25,13 @@ struct uint4 {
   constexpr uint4& operator*=(uint32_t scalar) noexcept { x *= scalar; y *= scalar; z *= scalar; w *= scalar; return *this; }
   constexpr uint4& operator%=(uint32_t scalar) noexcept { x %= scalar; y %= scalar; z %= scalar; w %= scalar; return *this; }
 
-  const char* to_string() const noexcept {
-    static char buffer[64];
-    std::snprintf(buffer, sizeof(buffer), "uint4(%u, %u, %u, %u)", x, y, z, w);
-    return buffer;
+  // "uint4(x, y, z, w)", see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const uint32_t v[] = {x, y, z, w};
+    return format_tuple(first, last, "uint4", v, 4);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 } // namespace cgmath
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "constexpr_math.h"
+#include "float2.h"
+#include "float3.h"
+#include "float4.h"
+#include "int2.h"
+#include "int3.h"
+#include "int4.h"
+#include "uint2.h"
+#include "uint3.h"
+#include "uint4.h"
+#include "vector2.h"
+#include "vector3.h"
+#include "vector4.h"
+
+#include <cstddef>
+#include <utility>
+
+// Generic vec<T, N> (and mat<T, R, C> in mat.h) with one operator set for every element type
+// and size. Element-wise operators build expression objects instead of results: a * s + b * t - c
+// is a single loop over the components when it lands in a vec, with no vec in between.
+// Expressions hold the vecs they read by reference, so keep them in a vec rather than in auto.
+//
+// The hand-written types (float3, int2, vector4, matrix4x4, ...) stay as they are and convert
+// both ways to the vec or mat of the same element type and shape.
+
+namespace cgmath {
+
+template <typename T, size_t N> struct vec;
+template <typename T, size_t R, size_t C> struct mat;
+
+// Element type and shape of a hand-written type; read() copies the elements out in row-major
+// order and make() builds one from them. Specialized below and in mat.h.
+template <typename X>
+struct layout_traits {
+  static constexpr bool defined = false;
+};
+
+namespace detail {
+
+template <typename T> struct identity { using type = T; };
+template <typename T> using identity_t = typename identity<T>::type;
+
+// The CRTP base of everything with R x C elements of T; at(i) is element i in row-major order
+template <typename E, typename T, size_t R, size_t C>
+struct expr {
+  using value_type = T;
+  static constexpr size_t rows = R;
+  static constexpr size_t cols = C;
+  static constexpr size_t size = R * C;
+
+  constexpr const E& self() const noexcept { return static_cast<const E&>(*this); }
+
+  // Evaluates straight into a hand-written type of the same element type and shape
+  template <typename X, typename Traits = layout_traits<X>,
+            typename = std::enable_if_t<Traits::defined && std::is_same_v<typename Traits::value_type, T> &&
+                                        Traits::rows == R && Traits::cols == C>>
+  constexpr operator X() const noexcept {
+    T a[R * C] = {};
+    for (size_t i = 0; i < R * C; ++i) a[i] = self().at(i);
+    return Traits::make(a);
+  }
+};
+
+// vec and mat are stored by reference inside expressions, other expressions by value
+template <typename E> struct is_leaf : std::false_type {};
+template <typename T, size_t N> struct is_leaf<vec<T, N>> : std::true_type {};
+template <typename T, size_t R, size_t C> struct is_leaf<mat<T, R, C>> : std::true_type {};
+
+template <typename E>
+using operand_t = std::conditional_t<is_leaf<E>::value, const E&, E>;
+
+struct add_op { template <typename T> static constexpr T apply(T a, T b) noexcept { return a + b; } };
+struct sub_op { template <typename T> static constexpr T apply(T a, T b) noexcept { return a - b; } };
+struct mul_op { template <typename T> static constexpr T apply(T a, T b) noexcept { return a * b; } };
+struct div_op { template <typename T> static constexpr T apply(T a, T b) noexcept { return a / b; } };
+struct mod_op { template <typename T> static constexpr T apply(T a, T b) noexcept { return a % b; } };
+struct min_op { template <typename T> static constexpr T apply(T a, T b) noexcept { return b < a ? b : a; } };
+struct max_op { template <typename T> static constexpr T apply(T a, T b) noexcept { return a < b ? b : a; } };
+struct neg_op { template <typename T> static constexpr T apply(T a) noexcept { return -a; } };
+struct abs_op { template <typename T> static constexpr T apply(T a) noexcept { return a < T(0) ? -a : a; } };
+
+template <typename Op, typename L, typename Rhs, typename T, size_t R, size_t C>
+struct binary_expr : expr<binary_expr<Op, L, Rhs, T, R, C>, T, R, C> {
+  operand_t<L> l;
+  operand_t<Rhs> r;
+
+  constexpr binary_expr(const L& _l, const Rhs& _r) noexcept : l(_l), r(_r) {}
+  constexpr T at(size_t i) const noexcept { return Op::apply(l.at(i), r.at(i)); }
+};
+
+// Expression and scalar, in that order unless ScalarFirst
+template <typename Op, typename E, bool ScalarFirst, typename T, size_t R, size_t C>
+struct scalar_expr : expr<scalar_expr<Op, E, ScalarFirst, T, R, C>, T, R, C> {
+  operand_t<E> e;
+  T s;
+
+  constexpr scalar_expr(const E& _e, T _s) noexcept : e(_e), s(_s) {}
+  constexpr T at(size_t i) const noexcept { return ScalarFirst ? Op::apply(s, e.at(i)) : Op::apply(e.at(i), s); }
+};
+
+template <typename Op, typename E, typename T, size_t R, size_t C>
+struct unary_expr : expr<unary_expr<Op, E, T, R, C>, T, R, C> {
+  operand_t<E> e;
+
+  constexpr explicit unary_expr(const E& _e) noexcept : e(_e) {}
+  constexpr T at(size_t i) const noexcept { return Op::apply(e.at(i)); }
+};
+
+template <typename Op, typename A, typename B, typename T, size_t R, size_t C>
+constexpr binary_expr<Op, A, B, T, R, C> make_binary(const expr<A, T, R, C>& a, const expr<B, T, R, C>& b) noexcept {
+  return {a.self(), b.self()};
+}
+
+} // namespace detail
+
+// Element-wise operators on any two expressions of the same shape, and with a scalar
+
+template <typename A, typename B, typename T, size_t R, size_t C>
+constexpr auto operator+(const detail::expr<A, T, R, C>& a, const detail::expr<B, T, R, C>& b) noexcept {
+  return detail::make_binary<detail::add_op>(a, b);
+}
+
+template <typename A, typename B, typename T, size_t R, size_t C>
+constexpr auto operator-(const detail::expr<A, T, R, C>& a, const detail::expr<B, T, R, C>& b) noexcept {
+  return detail::make_binary<detail::sub_op>(a, b);
+}
+
+template <typename E, typename T, size_t R, size_t C>
+constexpr auto operator-(const detail::expr<E, T, R, C>& e) noexcept {
+  return detail::unary_expr<detail::neg_op, E, T, R, C>(e.self());
+}
+
+// Component-wise product and quotient are for vectors only, * between matrices is the matrix
+// product in mat.h
+template <typename A, typename B, typename T, size_t N>
+constexpr auto operator*(const detail::expr<A, T, N, 1>& a, const detail::expr<B, T, N, 1>& b) noexcept {
+  return detail::make_binary<detail::mul_op>(a, b);
+}
+
+template <typename A, typename B, typename T, size_t N>
+constexpr auto operator/(const detail::expr<A, T, N, 1>& a, const detail::expr<B, T, N, 1>& b) noexcept {
+  return detail::make_binary<detail::div_op>(a, b);
+}
+
+template <typename E, typename T, size_t R, size_t C>
+constexpr auto operator*(const detail::expr<E, T, R, C>& e, detail::identity_t<T> s) noexcept {
+  return detail::scalar_expr<detail::mul_op, E, false, T, R, C>(e.self(), s);
+}
+
+template <typename E, typename T, size_t R, size_t C>
+constexpr auto operator*(detail::identity_t<T> s, const detail::expr<E, T, R, C>& e) noexcept {
+  return detail::scalar_expr<detail::mul_op, E, true, T, R, C>(e.self(), s);
+}
+
+template <typename E, typename T, size_t R, size_t C>
+constexpr auto operator/(const detail::expr<E, T, R, C>& e, detail::identity_t<T> s) noexcept {
+  return detail::scalar_expr<detail::div_op, E, false, T, R, C>(e.self(), s);
+}
+
+template <typename E, typename T, size_t R, size_t C, typename = std::enable_if_t<std::is_integral_v<T>>>
+constexpr auto operator%(const detail::expr<E, T, R, C>& e, detail::identity_t<T> s) noexcept {
+  return detail::scalar_expr<detail::mod_op, E, false, T, R, C>(e.self(), s);
+}
+
+template <typename A, typename B, typename T, size_t R, size_t C>
+constexpr auto min(const detail::expr<A, T, R, C>& a, const detail::expr<B, T, R, C>& b) noexcept {
+  return detail::make_binary<detail::min_op>(a, b);
+}
+
+template <typename A, typename B, typename T, size_t R, size_t C>
+constexpr auto max(const detail::expr<A, T, R, C>& a, const detail::expr<B, T, R, C>& b) noexcept {
+  return detail::make_binary<detail::max_op>(a, b);
+}
+
+template <typename E, typename T, size_t R, size_t C>
+constexpr auto abs(const detail::expr<E, T, R, C>& e) noexcept {
+  return detail::unary_expr<detail::abs_op, E, T, R, C>(e.self());
+}
+
+template <typename A, typename B, typename T, size_t R, size_t C>
+constexpr bool operator==(const detail::expr<A, T, R, C>& a, const detail::expr<B, T, R, C>& b) noexcept {
+  for (size_t i = 0; i < R * C; ++i) {
+    if (!(a.self().at(i) == b.self().at(i))) return false;
+  }
+  return true;
+}
+
+template <typename A, typename B, typename T, size_t R, size_t C>
+constexpr bool operator!=(const detail::expr<A, T, R, C>& a, const detail::expr<B, T, R, C>& b) noexcept {
+  return !(a == b);
+}
+
+// Column vector of N elements of T
+template <typename T, size_t N>
+struct vec : detail::expr<vec<T, N>, T, N, 1> {
+  static_assert(N >= 2, "vec needs at least two components");
+
+  T v[N];
+
+  constexpr vec() noexcept : v{} {}
+
+  template <typename... A, typename = std::enable_if_t<sizeof...(A) == N && (std::is_convertible_v<A, T> && ...)>>
+  constexpr vec(A... a) noexcept : v{static_cast<T>(a)...} {}
+
+  // Evaluates the whole expression in one pass
+  template <typename E>
+  constexpr vec(const detail::expr<E, T, N, 1>& e) noexcept : v{} {
+    for (size_t i = 0; i < N; ++i) v[i] = e.self().at(i);
+  }
+
+  template <typename X, typename Traits = layout_traits<X>,
+            typename = std::enable_if_t<Traits::defined && std::is_same_v<typename Traits::value_type, T> &&
+                                        Traits::rows == N && Traits::cols == 1>>
+  constexpr vec(const X& x) noexcept : v{} {
+    Traits::read(x, v);
+  }
+
+  static constexpr vec splat(T s) noexcept {
+    vec r;
+    for (size_t i = 0; i < N; ++i) r.v[i] = s;
+    return r;
+  }
+
+  constexpr T at(size_t i) const noexcept { return v[i]; }
+  constexpr T operator[](size_t i) const noexcept { return v[i]; }
+  constexpr T& operator[](size_t i) noexcept { return v[i]; }
+
+  constexpr T x() const noexcept { return v[0]; }
+  constexpr T y() const noexcept { return v[1]; }
+  constexpr T z() const noexcept { static_assert(N >= 3, "vec has no z"); return v[2]; }
+  constexpr T w() const noexcept { static_assert(N >= 4, "vec has no w"); return v[3]; }
+
+  // e is evaluated in full before v is written, so it may refer to *this. Elements of an
+  // expression need not map one to one onto ours (transpose reads across them).
+  template <typename E>
+  constexpr vec& operator=(const detail::expr<E, T, N, 1>& e) noexcept {
+    const vec r(e);
+    for (size_t i = 0; i < N; ++i) v[i] = r.v[i];
+    return *this;
+  }
+
+  template <typename E>
+  constexpr vec& operator+=(const detail::expr<E, T, N, 1>& e) noexcept {
+    const vec r(e);
+    for (size_t i = 0; i < N; ++i) v[i] += r.v[i];
+    return *this;
+  }
+
+  template <typename E>
+  constexpr vec& operator-=(const detail::expr<E, T, N, 1>& e) noexcept {
+    const vec r(e);
+    for (size_t i = 0; i < N; ++i) v[i] -= r.v[i];
+    return *this;
+  }
+
+  constexpr vec& operator*=(T s) noexcept {
+    for (size_t i = 0; i < N; ++i) v[i] *= s;
+    return *this;
+  }
+
+  constexpr vec& operator/=(T s) noexcept {
+    for (size_t i = 0; i < N; ++i) v[i] /= s;
+    return *this;
+  }
+};
+
+template <typename A, typename B, typename T, size_t N>
+constexpr T dot(const detail::expr<A, T, N, 1>& a, const detail::expr<B, T, N, 1>& b) noexcept {
+  T s = a.self().at(0) * b.self().at(0);
+  for (size_t i = 1; i < N; ++i) s += a.self().at(i) * b.self().at(i);
+  return s;
+}
+
+template <typename A, typename B, typename T>
+constexpr vec<T, 3> cross(const detail::expr<A, T, 3, 1>& a, const detail::expr<B, T, 3, 1>& b) noexcept {
+  const vec<T, 3> u = a, w = b;
+  return {u.v[1] * w.v[2] - u.v[2] * w.v[1], u.v[2] * w.v[0] - u.v[0] * w.v[2], u.v[0] * w.v[1] - u.v[1] * w.v[0]};
+}
+
+template <typename E, typename T, size_t N>
+constexpr T length_squared(const detail::expr<E, T, N, 1>& e) noexcept { return dot(e, e); }
+
+template <typename E, size_t N>
+constexpr float length(const detail::expr<E, float, N, 1>& e) noexcept { return sqrt(dot(e, e)); }
+
+// Zero stays zero like float3::normalized()
+template <typename E, size_t N>
+constexpr vec<float, N> normalize(const detail::expr<E, float, N, 1>& e) noexcept {
+  vec<float, N> r = e;
+  float len = length(r);
+  return len > 0.0f ? vec<float, N>(r / len) : vec<float, N>();
+}
+
+template <typename A, typename B, size_t N>
+constexpr auto lerp(const detail::expr<A, float, N, 1>& a, const detail::expr<B, float, N, 1>& b, float t) noexcept {
+  return a + (b - a) * t;
+}
+
+// Hand-written vectors. The plain structs keep x, y, z, w; vector2..4 keep them in a union.
+
+namespace detail {
+
+template <typename X, typename T, size_t N>
+struct plain_layout {
+  static constexpr bool defined = true;
+  using value_type = T;
+  static constexpr size_t rows = N;
+  static constexpr size_t cols = 1;
+
+  static constexpr void read(const X& x, T* out) noexcept {
+    out[0] = x.x;
+    out[1] = x.y;
+    if constexpr (N >= 3) out[2] = x.z;
+    if constexpr (N >= 4) out[3] = x.w;
+  }
+
+  static constexpr X make(const T* a) noexcept {
+    if constexpr (N == 2) return X(a[0], a[1]);
+    else if constexpr (N == 3) return X(a[0], a[1], a[2]);
+    else return X(a[0], a[1], a[2], a[3]);
+  }
+};
+
+template <typename X, size_t N>
+struct union_layout {
+  static constexpr bool defined = true;
+  using value_type = float;
+  static constexpr size_t rows = N;
+  static constexpr size_t cols = 1;
+
+  static constexpr void read(const X& x, float* out) noexcept {
+    out[0] = x.vec.x;
+    out[1] = x.vec.y;
+    if constexpr (N >= 3) out[2] = x.vec.z;
+    if constexpr (N >= 4) out[3] = x.vec.w;
+  }
+
+  static constexpr X make(const float* a) noexcept {
+    if constexpr (N == 2) return X(a[0], a[1]);
+    else if constexpr (N == 3) return X(a[0], a[1], a[2]);
+    else return X(a[0], a[1], a[2], a[3]);
+  }
+};
+
+} // namespace detail
+
+template <> struct layout_traits<float2> : detail::plain_layout<float2, float, 2> {};
+template <> struct layout_traits<float3> : detail::plain_layout<float3, float, 3> {};
+template <> struct layout_traits<float4> : detail::plain_layout<float4, float, 4> {};
+template <> struct layout_traits<int2> : detail::plain_layout<int2, int32_t, 2> {};
+template <> struct layout_traits<int3> : detail::plain_layout<int3, int32_t, 3> {};
+template <> struct layout_traits<int4> : detail::plain_layout<int4, int32_t, 4> {};
+template <> struct layout_traits<uint2> : detail::plain_layout<uint2, uint32_t, 2> {};
+template <> struct layout_traits<uint3> : detail::plain_layout<uint3, uint32_t, 3> {};
+template <> struct layout_traits<uint4> : detail::plain_layout<uint4, uint32_t, 4> {};
+template <> struct layout_traits<vector2> : detail::union_layout<vector2, 2> {};
+template <> struct layout_traits<vector3> : detail::union_layout<vector3, 3> {};
+template <> struct layout_traits<vector4> : detail::union_layout<vector4, 4> {};
+
+} // namespace cgmath
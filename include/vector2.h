@@ -5,6 +5,8 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
 
 namespace cgmath {
 
@@ -36,7 +38,7 @@ struct alignas(8) vector2
   constexpr vector2& operator*=(float scalar) noexcept { vec.x *= scalar; vec.y *= scalar; return *this; }
   constexpr vector2& operator/=(float scalar) noexcept { vec.x /= scalar; vec.y /= scalar; return *this; }
 
-  constexpr float length() const noexcept { return std::sqrt(vec.x * vec.x + vec.y * vec.y); }
+  constexpr float length() const noexcept { return sqrt(vec.x * vec.x + vec.y * vec.y); }
 
   constexpr vector2 normalized() const noexcept {
     float len = length();
@@ -54,21 +56,23 @@ struct alignas(8) vector2
   constexpr float distance(const vector2& v) const noexcept {
     float dx = vec.x - v.vec.x;
     float dy = vec.y - v.vec.y;
-    return std::sqrt(dx * dx + dy * dy);
+    return sqrt(dx * dx + dy * dy);
   }
 
   constexpr vector2 clamp(const vector2& min, const vector2& max) const noexcept {
     return { 
-      std::fmax(min.vec.x, std::fmin(vec.x, max.vec.x)), 
-      std::fmax(min.vec.y, std::fmin(vec.y, max.vec.y)) 
+      fmax(min.vec.x, fmin(vec.x, max.vec.x)), 
+      fmax(min.vec.y, fmin(vec.y, max.vec.y)) 
     };
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[32];
-    std::snprintf(buffer, sizeof(buffer), "vector2(%.6f, %.6f)", vec.x, vec.y);
-    return buffer;
+  // "vector2(x, y)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {vec.x, vec.y};
+    return format_tuple(first, last, "vector2", v, 2);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 static_assert(sizeof(vector2) == sizeof(float) * 2, "vector2 must be 8 bytes");
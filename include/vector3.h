@@ -5,6 +5,9 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
+#include "simd.h"
 
 namespace cgmath {
 
@@ -26,28 +29,83 @@ struct alignas(16) vector3
   __m128 to_m128() const noexcept { return _mm_load_ps(vector3_f32); }
 #endif
 
-  constexpr vector3 operator+(const vector3& v) const noexcept { return {vec.x + v.vec.x, vec.y + v.vec.y, vec.z + v.vec.z}; }
-  constexpr vector3 operator-(const vector3& v) const noexcept { return {vec.x - v.vec.x, vec.y - v.vec.y, vec.z - v.vec.z}; }
-  constexpr vector3 operator*(float scalar) const noexcept { return {vec.x * scalar, vec.y * scalar, vec.z * scalar}; }
-  constexpr vector3 operator/(float scalar) const noexcept { return {vec.x / scalar, vec.y / scalar, vec.z / scalar}; }
+  constexpr vector3 operator+(const vector3& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector3(_mm_add_ps(to_m128(), v.to_m128()));
+#endif
+    return {vec.x + v.vec.x, vec.y + v.vec.y, vec.z + v.vec.z};
+  }
 
-  constexpr vector3& operator+=(const vector3& v) noexcept { vec.x += v.vec.x; vec.y += v.vec.y; vec.z += v.vec.z; return *this; }
-  constexpr vector3& operator-=(const vector3& v) noexcept { vec.x -= v.vec.x; vec.y -= v.vec.y; vec.z -= v.vec.z; return *this; }
-  constexpr vector3& operator*=(float scalar) noexcept { vec.x *= scalar; vec.y *= scalar; vec.z *= scalar; return *this; }
-  constexpr vector3& operator/=(float scalar) noexcept { vec.x /= scalar; vec.y /= scalar; vec.z /= scalar; return *this; }
+  constexpr vector3 operator-(const vector3& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector3(_mm_sub_ps(to_m128(), v.to_m128()));
+#endif
+    return {vec.x - v.vec.x, vec.y - v.vec.y, vec.z - v.vec.z};
+  }
 
-  constexpr float length() const noexcept { return std::sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z); }
+  constexpr vector3 operator*(float scalar) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector3(_mm_mul_ps(to_m128(), _mm_set1_ps(scalar)));
+#endif
+    return {vec.x * scalar, vec.y * scalar, vec.z * scalar};
+  }
+
+  constexpr vector3 operator/(float scalar) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector3(_mm_div_ps(to_m128(), _mm_set1_ps(scalar)));
+#endif
+    return {vec.x / scalar, vec.y / scalar, vec.z / scalar};
+  }
+
+  constexpr vector3& operator+=(const vector3& v) noexcept { return *this = *this + v; }
+  constexpr vector3& operator-=(const vector3& v) noexcept { return *this = *this - v; }
+  constexpr vector3& operator*=(float scalar) noexcept { return *this = *this * scalar; }
+  constexpr vector3& operator/=(float scalar) noexcept { return *this = *this / scalar; }
+
+  constexpr float length() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      __m128 v = to_m128();
+      return _mm_cvtss_f32(_mm_sqrt_ss(simd::dot3(v, v)));
+    }
+#endif
+    return sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z);
+  }
 
   constexpr vector3 normalized() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      __m128 v = to_m128();
+      return vector3(simd::normalize(v, simd::dot3(v, v)));
+    }
+#endif
     float len = length();
     return len > 0 ? vector3{vec.x / len, vec.y / len, vec.z / len} : vector3{0.0f, 0.0f, 0.0f};
   }
 
+  // Reciprocal square root estimate refined by one Newton-Raphson step,
+  // relative error ~1e-7 instead of the exact division in normalized()
+  vector3 normalized_fast() const noexcept {
+#ifdef __SSE__
+    __m128 v = to_m128();
+    return vector3(simd::normalize_fast(v, simd::dot3(v, v)));
+#else
+    float len2 = dot(*this);
+    return len2 > 0 ? *this * (1.0f / sqrt(len2)) : vector3{0.0f, 0.0f, 0.0f};
+#endif
+  }
+
   constexpr float dot(const vector3& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return _mm_cvtss_f32(simd::dot3(to_m128(), v.to_m128()));
+#endif
     return vec.x * v.vec.x + vec.y * v.vec.y + vec.z * v.vec.z;
   }
 
   constexpr vector3 cross(const vector3& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector3(simd::cross3(to_m128(), v.to_m128()));
+#endif
     return {
       vec.y * v.vec.z - vec.z * v.vec.y,
       vec.z * v.vec.x - vec.x * v.vec.z,
@@ -56,28 +114,35 @@ struct alignas(16) vector3
   }
 
   constexpr float distance(const vector3& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return (*this - v).length();
+#endif
     float dx = vec.x - v.vec.x;
     float dy = vec.y - v.vec.y;
     float dz = vec.z - v.vec.z;
-    return std::sqrt(dx * dx + dy * dy + dz * dz);
+    return sqrt(dx * dx + dy * dy + dz * dz);
   }
 
   constexpr vector3 clamp(const vector3& min, const vector3& max) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector3(simd::clamp(to_m128(), min.to_m128(), max.to_m128()));
+#endif
     return {
-      std::fmax(min.vec.x, std::fmin(vec.x, max.vec.x)), 
-      std::fmax(min.vec.y, std::fmin(vec.y, max.vec.y)), 
-      std::fmax(min.vec.z, std::fmin(vec.z, max.vec.z))
+      fmax(min.vec.x, fmin(vec.x, max.vec.x)), 
+      fmax(min.vec.y, fmin(vec.y, max.vec.y)), 
+      fmax(min.vec.z, fmin(vec.z, max.vec.z))
     };
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[48];
-    std::snprintf(buffer, sizeof(buffer), "vector3(%.6f, %.6f, %.6f)", vec.x, vec.y, vec.z);
-    return buffer;
+  // "vector3(x, y, z)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {vec.x, vec.y, vec.z};
+    return format_tuple(first, last, "vector3", v, 3);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 static_assert(sizeof(vector3) == 16, "vector3 must be 16 bytes");
 
 } // namespace cgmath
-
@@ -5,6 +5,9 @@
 #pragma once
 
 #include "pch.h"
+#include "format.h"
+#include "constexpr_math.h"
+#include "simd.h"
 
 namespace cgmath {
 
@@ -26,46 +29,104 @@ struct alignas(16) vector4
   __m128 to_m128() const noexcept { return _mm_load_ps(vector4_f32); }
 #endif
 
-  constexpr vector4 operator+(const vector4& v) const noexcept { return {vec.x + v.vec.x, vec.y + v.vec.y, vec.z + v.vec.z, vec.w + v.vec.w}; }
-  constexpr vector4 operator-(const vector4& v) const noexcept { return {vec.x - v.vec.x, vec.y - v.vec.y, vec.z - v.vec.z, vec.w - v.vec.w}; }
-  constexpr vector4 operator*(float scalar) const noexcept { return {vec.x * scalar, vec.y * scalar, vec.z * scalar, vec.w * scalar}; }
-  constexpr vector4 operator/(float scalar) const noexcept { return {vec.x / scalar, vec.y / scalar, vec.z / scalar, vec.w / scalar}; }
+  constexpr vector4 operator+(const vector4& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector4(_mm_add_ps(to_m128(), v.to_m128()));
+#endif
+    return {vec.x + v.vec.x, vec.y + v.vec.y, vec.z + v.vec.z, vec.w + v.vec.w};
+  }
+
+  constexpr vector4 operator-(const vector4& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector4(_mm_sub_ps(to_m128(), v.to_m128()));
+#endif
+    return {vec.x - v.vec.x, vec.y - v.vec.y, vec.z - v.vec.z, vec.w - v.vec.w};
+  }
+
+  constexpr vector4 operator*(float scalar) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector4(_mm_mul_ps(to_m128(), _mm_set1_ps(scalar)));
+#endif
+    return {vec.x * scalar, vec.y * scalar, vec.z * scalar, vec.w * scalar};
+  }
+
+  constexpr vector4 operator/(float scalar) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector4(_mm_div_ps(to_m128(), _mm_set1_ps(scalar)));
+#endif
+    return {vec.x / scalar, vec.y / scalar, vec.z / scalar, vec.w / scalar};
+  }
 
-  constexpr vector4& operator+=(const vector4& v) noexcept { vec.x += v.vec.x; vec.y += v.vec.y; vec.z += v.vec.z; vec.w += v.vec.w; return *this; }
-  constexpr vector4& operator-=(const vector4& v) noexcept { vec.x -= v.vec.x; vec.y -= v.vec.y; vec.z -= v.vec.z; vec.w -= v.vec.w; return *this; }
-  constexpr vector4& operator*=(float scalar) noexcept { vec.x *= scalar; vec.y *= scalar; vec.z *= scalar; vec.w *= scalar; return *this; }
-  constexpr vector4& operator/=(float scalar) noexcept { vec.x /= scalar; vec.y /= scalar; vec.z /= scalar; vec.w /= scalar; return *this; }
+  constexpr vector4& operator+=(const vector4& v) noexcept { return *this = *this + v; }
+  constexpr vector4& operator-=(const vector4& v) noexcept { return *this = *this - v; }
+  constexpr vector4& operator*=(float scalar) noexcept { return *this = *this * scalar; }
+  constexpr vector4& operator/=(float scalar) noexcept { return *this = *this / scalar; }
 
   constexpr float dot(const vector4& v) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return _mm_cvtss_f32(simd::dot4(to_m128(), v.to_m128()));
+#endif
     return vec.x * v.vec.x + vec.y * v.vec.y + vec.z * v.vec.z + vec.w * v.vec.w;
   }
 
   constexpr float length() const noexcept {
-    return std::sqrt(dot(*this));
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      __m128 v = to_m128();
+      return _mm_cvtss_f32(_mm_sqrt_ss(simd::dot4(v, v)));
+    }
+#endif
+    return sqrt(dot(*this));
   }
 
   constexpr vector4 normalized() const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) {
+      __m128 v = to_m128();
+      return vector4(simd::normalize(v, simd::dot4(v, v)));
+    }
+#endif
     float len = length();
     return len > 0 ? vector4{vec.x / len, vec.y / len, vec.z / len, vec.w / len} : vector4{0.0f, 0.0f, 0.0f, 0.0f};
   }
 
+  // Reciprocal square root estimate refined by one Newton-Raphson step,
+  // relative error ~1e-7 instead of the exact division in normalized()
+  vector4 normalized_fast() const noexcept {
+#ifdef __SSE__
+    __m128 v = to_m128();
+    return vector4(simd::normalize_fast(v, simd::dot4(v, v)));
+#else
+    float len2 = dot(*this);
+    return len2 > 0 ? *this * (1.0f / sqrt(len2)) : vector4{0.0f, 0.0f, 0.0f, 0.0f};
+#endif
+  }
+
+  constexpr float distance(const vector4& v) const noexcept {
+    return (*this - v).length();
+  }
+
   constexpr vector4 clamp(const vector4& min, const vector4& max) const noexcept {
+#ifdef __SSE__
+    if (!CG_MATH_IS_CONSTANT_EVALUATED()) return vector4(simd::clamp(to_m128(), min.to_m128(), max.to_m128()));
+#endif
     return {
-      std::fmax(min.vec.x, std::fmin(vec.x, max.vec.x)),
-      std::fmax(min.vec.y, std::fmin(vec.y, max.vec.y)),
-      std::fmax(min.vec.z, std::fmin(vec.z, max.vec.z)),
-      std::fmax(min.vec.w, std::fmin(vec.w, max.vec.w))
+      fmax(min.vec.x, fmin(vec.x, max.vec.x)),
+      fmax(min.vec.y, fmin(vec.y, max.vec.y)),
+      fmax(min.vec.z, fmin(vec.z, max.vec.z)),
+      fmax(min.vec.w, fmin(vec.w, max.vec.w))
     };
   }
 
-  const char* to_string() const noexcept {
-    static char buffer[64];
-    std::snprintf(buffer, sizeof(buffer), "vector4(%.6f, %.6f, %.6f, %.6f)", vec.x, vec.y, vec.z, vec.w);
-    return buffer;
+  // "vector4(x, y, z, w)" with the shortest round-trip digits, see format.h
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    const float v[] = {vec.x, vec.y, vec.z, vec.w};
+    return format_tuple(first, last, "vector4", v, 4);
   }
+
+  const char* to_string() const noexcept { return format_to_string(*this); }
 };
 
 static_assert(sizeof(vector4) == 16, "vector4 must be 16 bytes");
 
 } // namespace cgmath
-
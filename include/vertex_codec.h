@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+#include "float3.h"
+#include "float4.h"
+#include "quaternion.h"
+
+#include <cstddef>
+
+// Compact encodings for vertex attributes and animation data. Every type has a scalar
+// encode/decode pair; the array overloads at the bottom run the batch kernels (SSE2 to
+// AVX-512, see cpu.h) and give the same results up to the last bit of rounding.
+//
+// Worst-case errors, measured by cgmath_bench --accuracy over random inputs:
+//   oct16 / oct24 / oct32   angle to the input   0.95 / 0.059 / 0.0037 degrees
+//   snorm8 / snorm16 / unorm16   half a step of the bounds: extent / 254, / 65534, / 131070
+//   packed_quaternion       component error      1.9e-3 (6.9e-4 per stored one, the dropped
+//                                                one amplifies it by up to 3)
+//   rgb10a2                 half a step          1 / 2046 for rgb, 1 / 6 for alpha
+//
+// The signed fields of the octahedral and quaternion encodings are stored with an offset
+// (q + max), so those are plain unsigned bit fields.
+
+namespace cgmath {
+
+namespace detail {
+
+inline float quantize(float v, float lo, float hi) noexcept { return std::nearbyint(fmin(fmax(v, lo), hi)); }
+
+// Unit vector folded onto the octahedron and unfolded into the unit square, `Bits` per component
+template <int Bits>
+inline uint32_t octahedral_encode(const float3& v) noexcept {
+  constexpr float M = float((1 << (Bits - 1)) - 1);
+  float inv = 1.0f / (std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z));
+  float px = v.x * inv, py = v.y * inv;
+  if (v.z < 0.0f) {
+    float fx = (1.0f - std::fabs(py)) * std::copysign(1.0f, px);
+    float fy = (1.0f - std::fabs(px)) * std::copysign(1.0f, py);
+    px = fx;
+    py = fy;
+  }
+  uint32_t ux = static_cast<uint32_t>(quantize(px * M, -M, M) + M);
+  uint32_t uy = static_cast<uint32_t>(quantize(py * M, -M, M) + M);
+  return ux | (uy << Bits);
+}
+
+template <int Bits>
+inline float3 octahedral_decode(uint32_t bits) noexcept {
+  constexpr uint32_t mask = (1u << Bits) - 1;
+  constexpr float M = float((1 << (Bits - 1)) - 1);
+  float x = (static_cast<float>(bits & mask) - M) * (1.0f / M);
+  float y = (static_cast<float>((bits >> Bits) & mask) - M) * (1.0f / M);
+  float z = 1.0f - std::fabs(x) - std::fabs(y);
+  float t = fmax(-z, 0.0f);
+  x -= std::copysign(t, x);
+  y -= std::copysign(t, y);
+  return float3(x, y, z).normalized();
+}
+
+} // namespace detail
+
+// Octahedral unit vectors, 8, 12 or 16 bits per component: x in the low bits, then y.
+// The input must be unit length (or at least non-zero, the direction is what is kept).
+struct oct16 {
+  uint16_t bits;
+
+  static oct16 encode(const float3& unit) noexcept { return {static_cast<uint16_t>(detail::octahedral_encode<8>(unit))}; }
+  float3 decode() const noexcept { return detail::octahedral_decode<8>(bits); }
+};
+
+struct oct24 {
+  uint8_t bytes[3];  // little endian
+
+  static oct24 encode(const float3& unit) noexcept {
+    uint32_t b = detail::octahedral_encode<12>(unit);
+    return {{static_cast<uint8_t>(b), static_cast<uint8_t>(b >> 8), static_cast<uint8_t>(b >> 16)}};
+  }
+
+  float3 decode() const noexcept {
+    return detail::octahedral_decode<12>(bytes[0] | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16));
+  }
+};
+
+struct oct32 {
+  uint32_t bits;
+
+  static oct32 encode(const float3& unit) noexcept { return {detail::octahedral_encode<16>(unit)}; }
+  float3 decode() const noexcept { return detail::octahedral_decode<16>(bits); }
+};
+
+static_assert(sizeof(oct24) == 3, "oct24 must be 3 bytes");
+
+// Axis-aligned box the fixed-point types below map their range onto, usually one per mesh
+struct quantization_bounds {
+  float3 min, max;
+
+  static quantization_bounds of(const float3* points, size_t n) noexcept {
+    if (n == 0) return {};
+    quantization_bounds b{points[0], points[0]};
+    for (size_t i = 1; i < n; ++i) {
+      b.min = {fmin(b.min.x, points[i].x), fmin(b.min.y, points[i].y), fmin(b.min.z, points[i].z)};
+      b.max = {fmax(b.max.x, points[i].x), fmax(b.max.y, points[i].y), fmax(b.max.z, points[i].z)};
+    }
+    return b;
+  }
+
+  // Fixed-point value q of a component decodes to q * scale + offset; unsigned formats start
+  // at min, signed ones are centered. Flat axes get a zero scale both ways.
+  void decode_transform(bool is_signed, float steps, float3& offset, float3& scale) const noexcept {
+    const float3 extent = max - min;
+    offset = is_signed ? (min + max) * 0.5f : min;
+    const float span = is_signed ? 2.0f * steps : steps;
+    scale = extent * (1.0f / span);
+  }
+
+  void encode_transform(bool is_signed, float steps, float3& offset, float3& scale) const noexcept {
+    float3 decode_scale;
+    decode_transform(is_signed, steps, offset, decode_scale);
+    scale = {decode_scale.x > 0.0f ? 1.0f / decode_scale.x : 0.0f, decode_scale.y > 0.0f ? 1.0f / decode_scale.y : 0.0f,
+             decode_scale.z > 0.0f ? 1.0f / decode_scale.z : 0.0f};
+  }
+};
+
+namespace detail {
+
+template <typename Q, bool Signed, int Steps>
+struct fixed3 {
+  static Q encode(const float3& p, const quantization_bounds& b) noexcept {
+    float3 o, s;
+    b.encode_transform(Signed, Steps, o, s);
+    using C = decltype(Q::x);
+    constexpr float lo = Signed ? -float(Steps) : 0.0f;
+    return {static_cast<C>(quantize((p.x - o.x) * s.x, lo, Steps)), static_cast<C>(quantize((p.y - o.y) * s.y, lo, Steps)),
+            static_cast<C>(quantize((p.z - o.z) * s.z, lo, Steps))};
+  }
+
+  static float3 decode(const Q& q, const quantization_bounds& b) noexcept {
+    float3 o, s;
+    b.decode_transform(Signed, Steps, o, s);
+    return {float(q.x) * s.x + o.x, float(q.y) * s.y + o.y, float(q.z) * s.z + o.z};
+  }
+};
+
+} // namespace detail
+
+// Fixed-point float3 inside quantization_bounds: unorm16 spans [min, max] with 0..65535,
+// snorm16 and snorm8 with -32767..32767 and -127..127 around the center
+struct unorm16x3 {
+  uint16_t x, y, z;
+
+  static unorm16x3 encode(const float3& p, const quantization_bounds& b) noexcept;
+  float3 decode(const quantization_bounds& b) const noexcept;
+};
+
+struct snorm16x3 {
+  int16_t x, y, z;
+
+  static snorm16x3 encode(const float3& p, const quantization_bounds& b) noexcept;
+  float3 decode(const quantization_bounds& b) const noexcept;
+};
+
+struct snorm8x3 {
+  int8_t x, y, z;
+
+  static snorm8x3 encode(const float3& p, const quantization_bounds& b) noexcept;
+  float3 decode(const quantization_bounds& b) const noexcept;
+};
+
+inline unorm16x3 unorm16x3::encode(const float3& p, const quantization_bounds& b) noexcept {
+  return detail::fixed3<unorm16x3, false, 65535>::encode(p, b);
+}
+
+inline float3 unorm16x3::decode(const quantization_bounds& b) const noexcept {
+  return detail::fixed3<unorm16x3, false, 65535>::decode(*this, b);
+}
+
+inline snorm16x3 snorm16x3::encode(const float3& p, const quantization_bounds& b) noexcept {
+  return detail::fixed3<snorm16x3, true, 32767>::encode(p, b);
+}
+
+inline float3 snorm16x3::decode(const quantization_bounds& b) const noexcept {
+  return detail::fixed3<snorm16x3, true, 32767>::decode(*this, b);
+}
+
+inline snorm8x3 snorm8x3::encode(const float3& p, const quantization_bounds& b) noexcept {
+  return detail::fixed3<snorm8x3, true, 127>::encode(p, b);
+}
+
+inline float3 snorm8x3::decode(const quantization_bounds& b) const noexcept {
+  return detail::fixed3<snorm8x3, true, 127>::decode(*this, b);
+}
+
+static_assert(sizeof(unorm16x3) == 6 && sizeof(snorm8x3) == 3, "fixed-point vectors must be tightly packed");
+
+// Smallest three: the largest component is dropped and rebuilt from unit length, the other
+// three are stored in order with 10 bits each over [-1/sqrt(2), 1/sqrt(2)].
+// Layout: index of the dropped component in bits 30-31, then a << 20 | b << 10 | c.
+// q and -q are the same rotation, the sign is chosen to make the dropped component positive.
+struct packed_quaternion {
+  uint32_t bits;
+
+  static constexpr float M = 511.0f;
+  static constexpr float SQRT2 = 1.41421356237309504880f;
+
+  static packed_quaternion encode(const quaternion& q) noexcept {
+    const float c[4] = {q.v.vec.x, q.v.vec.y, q.v.vec.z, q.v.vec.w};
+    // The last of several equal magnitudes is dropped, as in the batch kernels
+    uint32_t index = 3;
+    float largest = std::fabs(c[3]);
+    for (uint32_t i = 3; i-- > 0;) {
+      if (std::fabs(c[i]) > largest) {
+        largest = std::fabs(c[i]);
+        index = i;
+      }
+    }
+    const float sign = c[index] < 0.0f ? -1.0f : 1.0f;
+    uint32_t bits = index << 30;
+    for (uint32_t i = 0, shift = 20; i < 4; ++i) {
+      if (i == index) continue;
+      bits |= static_cast<uint32_t>(detail::quantize(c[i] * sign * (SQRT2 * M), -M, M) + M) << shift;
+      shift -= 10;
+    }
+    return {bits};
+  }
+
+  quaternion decode() const noexcept {
+    const uint32_t index = bits >> 30;
+    float c[4];
+    float sum = 0.0f;
+    for (uint32_t i = 0, shift = 20; i < 4; ++i) {
+      if (i == index) continue;
+      c[i] = (static_cast<float>((bits >> shift) & 1023) - M) * (1.0f / (SQRT2 * M));
+      sum += c[i] * c[i];
+      shift -= 10;
+    }
+    c[index] = std::sqrt(fmax(1.0f - sum, 0.0f));
+    return quaternion(c[0], c[1], c[2], c[3]);
+  }
+};
+
+// Unsigned normalized RGBA, 10 bits for r, g and b and 2 for a, r in the low bits
+// (DXGI_FORMAT_R10G10B10A2_UNORM, VK_FORMAT_A2B10G10R10_UNORM_PACK32). Inputs are clamped
+// to [0, 1]; map normals with n * 0.5 + 0.5 first.
+struct rgb10a2 {
+  uint32_t bits;
+
+  static rgb10a2 encode(const float4& c) noexcept {
+    uint32_t r = static_cast<uint32_t>(detail::quantize(c.x * 1023.0f, 0.0f, 1023.0f));
+    uint32_t g = static_cast<uint32_t>(detail::quantize(c.y * 1023.0f, 0.0f, 1023.0f));
+    uint32_t b = static_cast<uint32_t>(detail::quantize(c.z * 1023.0f, 0.0f, 1023.0f));
+    uint32_t a = static_cast<uint32_t>(detail::quantize(c.w * 3.0f, 0.0f, 3.0f));
+    return {r | (g << 10) | (b << 20) | (a << 30)};
+  }
+
+  float4 decode() const noexcept {
+    return {static_cast<float>(bits & 1023) * (1.0f / 1023.0f), static_cast<float>((bits >> 10) & 1023) * (1.0f / 1023.0f),
+            static_cast<float>((bits >> 20) & 1023) * (1.0f / 1023.0f), static_cast<float>(bits >> 30) * (1.0f / 3.0f)};
+  }
+};
+
+// Array versions of the encode/decode members above; in and out must not overlap
+void encode(const float3* in, oct16* out, size_t n) noexcept;
+void encode(const float3* in, oct24* out, size_t n) noexcept;
+void encode(const float3* in, oct32* out, size_t n) noexcept;
+void decode(const oct16* in, float3* out, size_t n) noexcept;
+void decode(const oct24* in, float3* out, size_t n) noexcept;
+void decode(const oct32* in, float3* out, size_t n) noexcept;
+
+void encode(const float3* in, const quantization_bounds& b, unorm16x3* out, size_t n) noexcept;
+void encode(const float3* in, const quantization_bounds& b, snorm16x3* out, size_t n) noexcept;
+void encode(const float3* in, const quantization_bounds& b, snorm8x3* out, size_t n) noexcept;
+void decode(const unorm16x3* in, const quantization_bounds& b, float3* out, size_t n) noexcept;
+void decode(const snorm16x3* in, const quantization_bounds& b, float3* out, size_t n) noexcept;
+void decode(const snorm8x3* in, const quantization_bounds& b, float3* out, size_t n) noexcept;
+
+void encode(const quaternion* in, packed_quaternion* out, size_t n) noexcept;
+void decode(const packed_quaternion* in, quaternion* out, size_t n) noexcept;
+
+void encode(const float4* in, rgb10a2* out, size_t n) noexcept;
+void decode(const rgb10a2* in, float4* out, size_t n) noexcept;
+
+} // namespace cgmath
@@ -0,0 +1,458 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "bvh.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace cgmath {
+
+namespace {
+
+constexpr int BIN_COUNT = 12;
+constexpr uint32_t MAX_LEAF_SIZE = 8;
+constexpr uint32_t PARALLEL_THRESHOLD = 4096;
+constexpr float TRAVERSAL_COST = 1.0f;  // relative to one triangle test
+constexpr int SAH_MAX_DEPTH = 32;       // below this nodes are halved, bounding the depth by 32 + log2(n)
+
+// Four-float lanes for the builder, xyz carry the coordinates and w is ignored
+#ifdef __SSE__
+using lane4 = __m128;
+inline lane4 load4(const float* p) noexcept { return _mm_load_ps(p); }
+// Clears w, which may hold integer bits that would be denormals in arithmetic
+inline lane4 load3(const float* p) noexcept {
+  __m128 v = _mm_load_ps(p);
+  return _mm_movelh_ps(v, _mm_unpackhi_ps(v, _mm_setzero_ps()));
+}
+inline lane4 set4(float v) noexcept { return _mm_set1_ps(v); }
+inline lane4 add4(lane4 a, lane4 b) noexcept { return _mm_add_ps(a, b); }
+inline lane4 sub4(lane4 a, lane4 b) noexcept { return _mm_sub_ps(a, b); }
+inline lane4 mul4(lane4 a, lane4 b) noexcept { return _mm_mul_ps(a, b); }
+inline lane4 min4(lane4 a, lane4 b) noexcept { return _mm_min_ps(a, b); }
+inline lane4 max4(lane4 a, lane4 b) noexcept { return _mm_max_ps(a, b); }
+inline void store4(float* p, lane4 v) noexcept { _mm_storeu_ps(p, v); }
+#else
+struct lane4 { float f[4]; };
+inline lane4 load4(const float* p) noexcept { return {{p[0], p[1], p[2], p[3]}}; }
+inline lane4 load3(const float* p) noexcept { return {{p[0], p[1], p[2], 0.0f}}; }
+inline lane4 set4(float v) noexcept { return {{v, v, v, v}}; }
+inline lane4 add4(lane4 a, lane4 b) noexcept { return {{a.f[0] + b.f[0], a.f[1] + b.f[1], a.f[2] + b.f[2], a.f[3] + b.f[3]}}; }
+inline lane4 sub4(lane4 a, lane4 b) noexcept { return {{a.f[0] - b.f[0], a.f[1] - b.f[1], a.f[2] - b.f[2], a.f[3] - b.f[3]}}; }
+inline lane4 mul4(lane4 a, lane4 b) noexcept { return {{a.f[0] * b.f[0], a.f[1] * b.f[1], a.f[2] * b.f[2], a.f[3] * b.f[3]}}; }
+inline lane4 min4(lane4 a, lane4 b) noexcept {
+  return {{std::min(a.f[0], b.f[0]), std::min(a.f[1], b.f[1]), std::min(a.f[2], b.f[2]), std::min(a.f[3], b.f[3])}};
+}
+inline lane4 max4(lane4 a, lane4 b) noexcept {
+  return {{std::max(a.f[0], b.f[0]), std::max(a.f[1], b.f[1]), std::max(a.f[2], b.f[2]), std::max(a.f[3], b.f[3])}};
+}
+inline void store4(float* p, lane4 v) noexcept { for (int i = 0; i < 4; ++i) p[i] = v.f[i]; }
+#endif
+
+struct bounds {
+  lane4 min = set4(INFINITY);
+  lane4 max = set4(-INFINITY);
+
+  void grow(lane4 p) noexcept {
+    min = min4(min, p);
+    max = max4(max, p);
+  }
+
+  void grow(const bounds& b) noexcept {
+    min = min4(min, b.min);
+    max = max4(max, b.max);
+  }
+
+  // Half the surface area, only ever compared
+  float area() const noexcept {
+    float e[4];
+    store4(e, sub4(max, min));
+    return e[0] < 0.0f ? 0.0f : e[0] * e[1] + e[1] * e[2] + e[2] * e[0];
+  }
+};
+
+// Triangle bounds during the build, laid out like bvh_node so each half is one load.
+// Refs are moved rather than indexed so that deep levels stream through memory.
+struct alignas(16) prim_ref {
+  float3 min;
+  uint32_t index;
+  float3 max;
+  float pad;
+
+  lane4 lo() const noexcept { return load3(&min.x); }
+  lane4 hi() const noexcept { return load4(&max.x); }
+  lane4 centroid() const noexcept { return mul4(add4(lo(), hi()), set4(0.5f)); }
+};
+
+inline void triangle_vertices(const float3* vertices, const uint32_t* indices, uint32_t t,
+                              float3& a, float3& b, float3& c) noexcept {
+  if (indices) {
+    a = vertices[indices[3 * t + 0]];
+    b = vertices[indices[3 * t + 1]];
+    c = vertices[indices[3 * t + 2]];
+  } else {
+    a = vertices[3 * t + 0];
+    b = vertices[3 * t + 1];
+    c = vertices[3 * t + 2];
+  }
+}
+
+// Node index with the refs in [begin, end) still to build. box bounds the refs and
+// centroid_box their centroids.
+struct build_task {
+  bounds box, centroid_box;
+  uint32_t index, begin, end;
+  int depth;
+};
+
+struct builder {
+  prim_ref* refs;
+  bvh_node* nodes;
+  std::atomic<uint32_t> node_count{1};
+
+  bool make_leaf(bvh_node& node, uint32_t begin, uint32_t end) noexcept {
+    node.first = begin;
+    node.count = end - begin;
+    return false;
+  }
+
+  void build(const build_task& t) noexcept {
+    build_task left, right;
+    if (!split(t, left, right)) return;
+    build(left);
+    build(right);
+  }
+
+  // Sets the bounds of node t.index and either makes it a leaf or partitions its refs and
+  // allocates two children, returning false for a leaf
+  bool split(const build_task& t, build_task& left, build_task& right) noexcept {
+    const uint32_t begin = t.begin, end = t.end;
+    const bounds& box = t.box;
+    const bounds& centroid_box = t.centroid_box;
+    bvh_node& node = nodes[t.index];
+    float lo[4], hi[4];
+    store4(lo, box.min);
+    store4(hi, box.max);
+    node.min = float3(lo[0], lo[1], lo[2]);
+    node.max = float3(hi[0], hi[1], hi[2]);
+
+    const uint32_t count = end - begin;
+    if (count == 1) return make_leaf(node, begin, end);
+
+    // Bin centroids along every axis and sweep for the cheapest SAH split
+    struct bin {
+      bounds box;
+      uint32_t count = 0;
+    };
+    bin bins[3][BIN_COUNT];
+    float cmin[4], cmax[4], scale[4] = {};
+    store4(cmin, centroid_box.min);
+    store4(cmax, centroid_box.max);
+    for (int a = 0; a < 3; ++a) {
+      float extent = cmax[a] - cmin[a];
+      scale[a] = extent > 0.0f ? BIN_COUNT / extent : 0.0f;
+    }
+    const lane4 origin = centroid_box.min, factor = load4(scale);
+    auto bin_index = [&](const prim_ref& r, int* b) {
+      float f[4];
+      store4(f, mul4(sub4(r.centroid(), origin), factor));
+      for (int a = 0; a < 3; ++a) b[a] = std::min(static_cast<int>(f[a]), BIN_COUNT - 1);
+    };
+    for (uint32_t i = begin; i < end; ++i) {
+      int b[3];
+      bin_index(refs[i], b);
+      const lane4 rlo = refs[i].lo(), rhi = refs[i].hi();
+      for (int a = 0; a < 3; ++a) {
+        bin& dst = bins[a][b[a]];
+        dst.box.min = min4(dst.box.min, rlo);
+        dst.box.max = max4(dst.box.max, rhi);
+        ++dst.count;
+      }
+    }
+
+    float best_cost = INFINITY;
+    int best_axis = -1, best_split = 0;
+    for (int a = 0; a < 3; ++a) {
+      if (scale[a] == 0.0f) continue;
+      float right_area[BIN_COUNT];
+      uint32_t right_count[BIN_COUNT];
+      bounds acc;
+      uint32_t n = 0;
+      for (int b = BIN_COUNT - 1; b > 0; --b) {
+        acc.grow(bins[a][b].box);
+        n += bins[a][b].count;
+        right_area[b] = acc.area();
+        right_count[b] = n;
+      }
+      acc = bounds();
+      n = 0;
+      for (int b = 1; b < BIN_COUNT; ++b) {
+        acc.grow(bins[a][b - 1].box);
+        n += bins[a][b - 1].count;
+        if (n == 0 || right_count[b] == 0) continue;
+        float cost = acc.area() * n + right_area[b] * right_count[b];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = a;
+          best_split = b;
+        }
+      }
+    }
+
+    bounds &left_box = left.box, &right_box = right.box;
+    bounds &left_centroids = left.centroid_box, &right_centroids = right.centroid_box;
+    left_box = right_box = left_centroids = right_centroids = bounds();
+    uint32_t middle;
+    if (best_axis < 0 || t.depth >= SAH_MAX_DEPTH) {
+      // Coincident centroids or a degenerate distribution. Split by position in the range if too big.
+      if (count <= MAX_LEAF_SIZE) return make_leaf(node, begin, end);
+      middle = begin + count / 2;
+      for (uint32_t i = begin; i < end; ++i) {
+        bounds& b = i < middle ? left_box : right_box;
+        bounds& c = i < middle ? left_centroids : right_centroids;
+        b.grow(refs[i].lo());
+        b.grow(refs[i].hi());
+        c.grow(refs[i].centroid());
+      }
+    } else {
+      float leaf_cost = static_cast<float>(count);
+      float split_cost = TRAVERSAL_COST + best_cost / box.area();
+      if (count <= MAX_LEAF_SIZE && leaf_cost <= split_cost) return make_leaf(node, begin, end);
+
+      // Hoare partition by bin, collecting the exact bounds of both halves on the way
+      auto goes_left = [&](const prim_ref& r) {
+        int b[3];
+        bin_index(r, b);
+        return b[best_axis] < best_split;
+      };
+      auto take = [](const prim_ref& r, bounds& b, bounds& c) {
+        b.grow(r.lo());
+        b.grow(r.hi());
+        c.grow(r.centroid());
+      };
+      uint32_t i = begin, j = end;
+      for (;;) {
+        while (i < j && goes_left(refs[i])) take(refs[i++], left_box, left_centroids);
+        while (i < j && !goes_left(refs[j - 1])) take(refs[--j], right_box, right_centroids);
+        if (i == j) break;
+        std::swap(refs[i], refs[j - 1]);
+      }
+      middle = i;
+    }
+
+    const uint32_t first = node_count.fetch_add(2, std::memory_order_relaxed);
+    node.first = first;
+    node.count = 0;
+    left.index = first;
+    left.begin = begin;
+    left.end = middle;
+    right.index = first + 1;
+    right.begin = middle;
+    right.end = end;
+    left.depth = right.depth = t.depth + 1;
+    return true;
+  }
+};
+
+// One axis of the slab test. With a zero direction component and the origin on a face, 0 * inf is NaN; the ray
+// then runs in that face's plane and the axis does not limit it
+inline void slab(float t0, float t1, float& enter, float& exit) noexcept {
+  if (t0 != t0 || t1 != t1) return;
+  enter = std::max(enter, std::min(t0, t1));
+  exit = std::min(exit, std::max(t0, t1));
+}
+
+// Slab test, returns the entry distance or INFINITY on a miss
+inline float intersect_box(const bvh_node& n, const float3& o, const float3& inv, float t_min, float t_max) noexcept {
+  float enter = t_min, exit = t_max;
+  slab((n.min.x - o.x) * inv.x, (n.max.x - o.x) * inv.x, enter, exit);
+  slab((n.min.y - o.y) * inv.y, (n.max.y - o.y) * inv.y, enter, exit);
+  slab((n.min.z - o.z) * inv.z, (n.max.z - o.z) * inv.z, enter, exit);
+  return enter <= exit ? enter : INFINITY;
+}
+
+// Möller-Trumbore, accepts both windings
+inline bool intersect_triangle(const bvh_triangle& tri, const ray& r, float t_max, float& t, float& u, float& v) noexcept {
+  float3 p = r.direction.cross(tri.e2);
+  float det = tri.e1.dot(p);
+  if (std::fabs(det) < 1e-12f) return false;
+  float inv_det = 1.0f / det;
+  float3 s = r.origin - tri.v0;
+  u = s.dot(p) * inv_det;
+  if (u < 0.0f || u > 1.0f) return false;
+  float3 q = s.cross(tri.e1);
+  v = r.direction.dot(q) * inv_det;
+  if (v < 0.0f || u + v > 1.0f) return false;
+  t = tri.e2.dot(q) * inv_det;
+  return t >= r.t_min && t <= t_max;
+}
+
+constexpr int STACK_SIZE = SAH_MAX_DEPTH + 32;
+
+// Front-to-back traversal; AnyHit stops at the first accepted triangle
+template <bool AnyHit>
+bool traverse(const bvh& tree, const ray& r, ray_hit& hit) noexcept {
+  if (tree.empty()) return false;
+  const float3 inv(1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z);
+  float t_max = std::min(r.t_max, hit.t);
+  if (intersect_box(tree.nodes[0], r.origin, inv, r.t_min, t_max) == INFINITY) return false;
+
+  uint32_t stack[STACK_SIZE];
+  int top = 0;
+  uint32_t index = 0;
+  bool found = false;
+  for (;;) {
+    const bvh_node& node = tree.nodes[index];
+    if (node.is_leaf()) {
+      for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+        float t, u, v;
+        if (!intersect_triangle(tree.triangles[i], r, t_max, t, u, v)) continue;
+        found = true;
+        if constexpr (AnyHit) return true;
+        t_max = t;
+        hit.t = t;
+        hit.u = u;
+        hit.v = v;
+        hit.primitive = tree.primitives[i];
+      }
+    } else {
+      float d0 = intersect_box(tree.nodes[node.first], r.origin, inv, r.t_min, t_max);
+      float d1 = intersect_box(tree.nodes[node.first + 1], r.origin, inv, r.t_min, t_max);
+      uint32_t near_child = node.first, far_child = node.first + 1;
+      if (d1 < d0) {
+        std::swap(d0, d1);
+        std::swap(near_child, far_child);
+      }
+      if (d0 != INFINITY) {
+        if (d1 != INFINITY) stack[top++] = far_child;
+        index = near_child;
+        continue;
+      }
+    }
+    // Pop, skipping nodes that the current closest hit already rules out
+    for (;;) {
+      if (top == 0) return found;
+      index = stack[--top];
+      if (AnyHit || intersect_box(tree.nodes[index], r.origin, inv, r.t_min, t_max) != INFINITY) break;
+    }
+  }
+}
+
+void bounds_from_triangles(bvh& tree) noexcept {
+  for (size_t i = tree.nodes.size(); i-- > 0;) {
+    bvh_node& node = tree.nodes[i];
+    float3 lo, hi;
+    if (node.is_leaf()) {
+      lo = float3(INFINITY, INFINITY, INFINITY);
+      hi = float3(-INFINITY, -INFINITY, -INFINITY);
+      for (uint32_t t = node.first; t < node.first + node.count; ++t) {
+        const bvh_triangle& tri = tree.triangles[t];
+        for (const float3& p : {tri.v0, tri.v0 + tri.e1, tri.v0 + tri.e2}) {
+          lo = float3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+          hi = float3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+        }
+      }
+    } else {
+      // Children always come after their parent, so they are already up to date
+      const bvh_node& l = tree.nodes[node.first];
+      const bvh_node& r = tree.nodes[node.first + 1];
+      lo = float3(std::min(l.min.x, r.min.x), std::min(l.min.y, r.min.y), std::min(l.min.z, r.min.z));
+      hi = float3(std::max(l.max.x, r.max.x), std::max(l.max.y, r.max.y), std::max(l.max.z, r.max.z));
+    }
+    node.min = lo;
+    node.max = hi;
+  }
+}
+
+} // namespace
+
+void bvh::build(const float3* vertices, const uint32_t* indices, size_t triangle_count, size_t thread_count) {
+  nodes.clear();
+  triangles.clear();
+  primitives.clear();
+  if (triangle_count == 0) return;
+
+  const uint32_t n = static_cast<uint32_t>(triangle_count);
+  std::vector<prim_ref> refs(n);
+  bounds box, centroid_box;
+  for (uint32_t t = 0; t < n; ++t) {
+    float3 a, b, c;
+    triangle_vertices(vertices, indices, t, a, b, c);
+    prim_ref& r = refs[t];
+    r.min = float3(std::min({a.x, b.x, c.x}), std::min({a.y, b.y, c.y}), std::min({a.z, b.z, c.z}));
+    r.max = float3(std::max({a.x, b.x, c.x}), std::max({a.y, b.y, c.y}), std::max({a.z, b.z, c.z}));
+    r.index = t;
+    r.pad = 0.0f;
+    box.grow(r.lo());
+    box.grow(r.hi());
+    centroid_box.grow(r.centroid());
+  }
+
+  nodes.resize(2 * size_t(n) - 1);
+  builder b{refs.data(), nodes.data()};
+
+  // The top levels are split one level per loop, every node of a level in parallel, until
+  // there are enough subtrees to keep the threads busy. Those are then built as one task each.
+  // Subtrees below PARALLEL_THRESHOLD refs are finished as soon as they come up.
+  parallel_options options;
+  options.thread_count = thread_count;
+  options.grain = 1;
+  options.element_size = 0;
+  const size_t threads = thread_count ? thread_count : default_scheduler().concurrency();
+  std::vector<build_task> level{build_task{box, centroid_box, 0, 0, n, 0}}, next;
+  while (threads > 1 && !level.empty() && level.size() < 2 * threads) {
+    next.resize(2 * level.size());
+    std::vector<uint8_t> halved(level.size());
+    parallel_for(0, level.size(), [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        const build_task& t = level[i];
+        if (t.end - t.begin >= PARALLEL_THRESHOLD) {
+          halved[i] = b.split(t, next[2 * i], next[2 * i + 1]);
+        } else {
+          b.build(t);
+        }
+      }
+    }, options);
+    size_t kept = 0;
+    for (size_t i = 0; i < level.size(); ++i) {
+      if (!halved[i]) continue;
+      next[kept++] = next[2 * i];
+      next[kept++] = next[2 * i + 1];
+    }
+    next.resize(kept);
+    level.swap(next);
+  }
+  parallel_for(0, level.size(), [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) b.build(level[i]);
+  }, options);
+  nodes.resize(b.node_count.load());
+  nodes.shrink_to_fit();
+
+  primitives.resize(n);
+  for (uint32_t i = 0; i < n; ++i) primitives[i] = refs[i].index;
+  triangles.resize(n);
+  refit(vertices, indices);
+}
+
+void bvh::refit(const float3* vertices, const uint32_t* indices) noexcept {
+  for (size_t i = 0; i < triangles.size(); ++i) {
+    float3 a, b, c;
+    triangle_vertices(vertices, indices, primitives[i], a, b, c);
+    triangles[i] = {a, b - a, c - a};
+  }
+  bounds_from_triangles(*this);
+}
+
+bool bvh::intersect(const ray& r, ray_hit& hit) const noexcept {
+  return traverse<false>(*this, r, hit);
+}
+
+bool bvh::occluded(const ray& r) const noexcept {
+  ray_hit hit;
+  return traverse<true>(*this, r, hit);
+}
+
+} // namespace cgmath
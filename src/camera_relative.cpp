@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "camera_relative.h"
+#include "kernels.h"
+
+namespace cgmath {
+
+void relative_to_camera(const double3* in, const double3& origin, float3* out, size_t n) noexcept {
+  const double o[3] = {origin.x, origin.y, origin.z};
+  size_t i = kernels().to_float_relative(&in->x, o, 3, &out->x, n);
+  for (; i < n; ++i) out[i] = (in[i] - origin).to_float3();
+}
+
+void relative_to_camera(const double3* in, const double3& origin, half3* out, size_t n) noexcept {
+  // Through a float block small enough to stay in L1
+  constexpr size_t BLOCK = 256;
+  float3 block[BLOCK];
+  for (size_t i = 0; i < n; i += BLOCK) {
+    const size_t count = n - i < BLOCK ? n - i : BLOCK;
+    relative_to_camera(in + i, origin, block, count);
+    to_half(block, out + i, count);
+  }
+}
+
+void relative_to_camera(const double4* in, const double3& origin, float4* out, size_t n) noexcept {
+  const double o[4] = {origin.x, origin.y, origin.z, 0.0};
+  size_t i = kernels().to_float_relative(&in->x, o, 4, &out->x, n);
+  for (; i < n; ++i) out[i] = (in[i] - double4(origin, 0.0)).to_float4();
+}
+
+void relative_to_camera(const dmatrix4x4* in, const double3& origin, matrix4x4* out, size_t n) noexcept {
+  for (size_t i = 0; i < n; ++i) out[i] = in[i].relative_to(origin);
+}
+
+} // namespace cgmath
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "cpu.h"
+#include "kernels.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CG_MATH_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace cgmath {
+
+namespace {
+
+#ifdef CG_MATH_X86
+
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t r[4]) noexcept {
+#ifdef _MSC_VER
+  int regs[4];
+  __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for (int i = 0; i < 4; ++i) r[i] = static_cast<uint32_t>(regs[i]);
+#else
+  if (!__get_cpuid_count(leaf, subleaf, &r[0], &r[1], &r[2], &r[3])) r[0] = r[1] = r[2] = r[3] = 0;
+#endif
+}
+
+// XCR0, the register state the OS saves on context switches
+uint64_t xgetbv0() noexcept {
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  uint32_t lo, hi;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return (uint64_t(hi) << 32) | lo;
+#endif
+}
+
+cpu_features detect() noexcept {
+  cpu_features f;
+  uint32_t r[4];
+  cpuid(0, 0, r);
+  const uint32_t max_leaf = r[0];
+  if (max_leaf < 1) return f;
+
+  cpuid(1, 0, r);
+  const uint32_t ecx1 = r[2], edx1 = r[3];
+  f.sse2 = (edx1 >> 26) & 1;
+  f.sse3 = ecx1 & 1;
+  f.ssse3 = (ecx1 >> 9) & 1;
+  f.sse41 = (ecx1 >> 19) & 1;
+  f.sse42 = (ecx1 >> 20) & 1;
+
+  const bool osxsave = (ecx1 >> 27) & 1;
+  const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+  const bool ymm_state = (xcr0 & 0x6) == 0x6;     // XMM and YMM
+  const bool zmm_state = (xcr0 & 0xe6) == 0xe6;   // plus opmask and both ZMM halves
+
+  f.avx = ymm_state && ((ecx1 >> 28) & 1);
+  f.fma = f.avx && ((ecx1 >> 12) & 1);
+  f.f16c = f.avx && ((ecx1 >> 29) & 1);
+
+  if (max_leaf >= 7) {
+    cpuid(7, 0, r);
+    const uint32_t ebx7 = r[1];
+    f.avx2 = f.avx && ((ebx7 >> 5) & 1);
+    f.avx512f = zmm_state && ((ebx7 >> 16) & 1);
+  }
+  return f;
+}
+
+#else
+
+cpu_features detect() noexcept { return {}; }
+
+#endif
+
+// Entries that handle nothing, leaving every element to the scalar code in the callers
+template <typename F> struct no_kernel;
+template <typename... A>
+struct no_kernel<size_t (*)(A...) noexcept> {
+  static size_t run(A...) noexcept { return 0; }
+};
+
+#define CG_MATH_NO_KERNEL(entry) no_kernel<decltype(kernel_table::entry)>::run
+
+const kernel_table kernels_scalar = {
+  cpu_isa::scalar,
+  alignof(float),
+  CG_MATH_NO_KERNEL(aos_to_soa),
+  CG_MATH_NO_KERNEL(soa_to_aos),
+  CG_MATH_NO_KERNEL(dot),
+  CG_MATH_NO_KERNEL(cross),
+  CG_MATH_NO_KERNEL(length),
+  CG_MATH_NO_KERNEL(normalize),
+  CG_MATH_NO_KERNEL(lerp),
+  CG_MATH_NO_KERNEL(clamp),
+  CG_MATH_NO_KERNEL(transform_float3),
+  CG_MATH_NO_KERNEL(transform_soa),
+  CG_MATH_NO_KERNEL(transform_vector4),
+  CG_MATH_NO_KERNEL(rotations_to_rows),
+  CG_MATH_NO_KERNEL(nlerp),
+  CG_MATH_NO_KERNEL(classify_spheres),
+  CG_MATH_NO_KERNEL(classify_aabbs),
+  CG_MATH_NO_KERNEL(cull_spheres),
+  CG_MATH_NO_KERNEL(cull_aabbs),
+  CG_MATH_NO_KERNEL(cull_sphere_masks),
+  CG_MATH_NO_KERNEL(cull_aabb_masks),
+  CG_MATH_NO_KERNEL(float_to_half),
+  CG_MATH_NO_KERNEL(half_to_float),
+  CG_MATH_NO_KERNEL(to_float_relative),
+  CG_MATH_NO_KERNEL(encode_octahedral),
+  CG_MATH_NO_KERNEL(decode_octahedral),
+  CG_MATH_NO_KERNEL(encode_fixed3),
+  CG_MATH_NO_KERNEL(decode_fixed3),
+  CG_MATH_NO_KERNEL(encode_quaternions),
+  CG_MATH_NO_KERNEL(decode_quaternions),
+  CG_MATH_NO_KERNEL(encode_rgb10a2),
+  CG_MATH_NO_KERNEL(decode_rgb10a2),
+  CG_MATH_NO_KERNEL(morton_keys3),
+  CG_MATH_NO_KERNEL(hilbert_keys3),
+  CG_MATH_NO_KERNEL(eigen3x3),
+  CG_MATH_NO_KERNEL(svd3x3),
+  CG_MATH_NO_KERNEL(polar3x3),
+  CG_MATH_NO_KERNEL(triangle_packet8),
+  CG_MATH_NO_KERNEL(triangle_packet16),
+  CG_MATH_NO_KERNEL(aabb_packet8),
+  CG_MATH_NO_KERNEL(aabb_packet16),
+  CG_MATH_NO_KERNEL(traverse_packet8),
+  CG_MATH_NO_KERNEL(traverse_packet16),
+};
+
+#undef CG_MATH_NO_KERNEL
+
+// Widest first. The baseline table is always usable, the host already runs code built with its flags.
+const kernel_table* const tables[] = {
+#ifdef CG_MATH_DISPATCH
+  &kernels_avx512,
+  &kernels_avx2,
+  &kernels_sse41,
+#endif
+#ifdef __SSE__
+  &kernels_baseline,
+#endif
+  &kernels_scalar,
+};
+
+const kernel_table* select(cpu_isa max) noexcept {
+  const cpu_isa host = host_isa();
+  for (const kernel_table* t : tables) {
+    if (t == &kernels_scalar || (t->isa <= max && (t->isa <= host || t->isa <= CG_MATH_COMPILED_ISA))) return t;
+  }
+  return &kernels_scalar;
+}
+
+cpu_isa env_cap() noexcept {
+  const char* v = std::getenv("CG_MATH_ISA");
+  if (v) {
+    for (cpu_isa isa : {cpu_isa::scalar, cpu_isa::sse2, cpu_isa::sse41, cpu_isa::avx2, cpu_isa::avx512}) {
+      if (std::strcmp(v, isa_name(isa)) == 0) return isa;
+    }
+    if (std::strcmp(v, "sse41") == 0) return cpu_isa::sse41;
+  }
+  return cpu_isa::avx512;
+}
+
+std::atomic<const kernel_table*>& active() noexcept {
+  static std::atomic<const kernel_table*> table{select(env_cap())};
+  return table;
+}
+
+} // namespace
+
+const cpu_features& cpu_detect() noexcept {
+  static const cpu_features features = detect();
+  return features;
+}
+
+cpu_isa host_isa() noexcept {
+  const cpu_features& f = cpu_detect();
+  if (f.avx512f && f.avx2 && f.fma && f.f16c) return cpu_isa::avx512;
+  if (f.avx2 && f.fma && f.f16c) return cpu_isa::avx2;
+  if (f.sse41) return cpu_isa::sse41;
+  if (f.sse2) return cpu_isa::sse2;
+  return cpu_isa::scalar;
+}
+
+cpu_isa active_isa() noexcept { return kernels().isa; }
+
+cpu_isa set_isa(cpu_isa max) noexcept {
+  const kernel_table* t = select(max);
+  active().store(t, std::memory_order_release);
+  return t->isa;
+}
+
+const char* isa_name(cpu_isa isa) noexcept {
+  switch (isa) {
+    case cpu_isa::scalar: return "scalar";
+    case cpu_isa::sse2: return "sse2";
+    case cpu_isa::sse41: return "sse4.1";
+    case cpu_isa::avx2: return "avx2";
+    case cpu_isa::avx512: return "avx512";
+  }
+  return "unknown";
+}
+
+const kernel_table& kernels() noexcept { return *active().load(std::memory_order_acquire); }
+
+} // namespace cgmath
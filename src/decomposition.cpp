@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "decomposition.h"
+#include "decomposition_impl.h"
+#include "kernels.h"
+
+#include <cmath>
+
+namespace cgmath {
+
+namespace {
+
+// One matrix per "register", for single calls and the tails of the batch kernels
+struct scalar_lanes {
+  using reg = float;
+  using mask = bool;
+
+  static float set1(float v) noexcept { return v; }
+  static float zero() noexcept { return 0.0f; }
+  static float add(float a, float b) noexcept { return a + b; }
+  static float sub(float a, float b) noexcept { return a - b; }
+  static float mul(float a, float b) noexcept { return a * b; }
+  static float div(float a, float b) noexcept { return a / b; }
+  static float madd(float a, float b, float c) noexcept { return a * b + c; }
+  static float max(float a, float b) noexcept { return a < b ? b : a; }
+  static float sqrt(float a) noexcept { return std::sqrt(a); }
+  static float abs(float a) noexcept { return std::fabs(a); }
+  static bool lt(float a, float b) noexcept { return a < b; }
+  static float select(bool m, float a, float b) noexcept { return m ? a : b; }
+};
+
+using mat3 = decomposition_detail::mat3<scalar_lanes>;
+
+inline mat3 load(const matrix3x3& m) noexcept {
+  mat3 r;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) r.m[i][j] = m.m[i][j];
+  }
+  return r;
+}
+
+inline mat3 load(const_matrix3x3_soa_view m, size_t k) noexcept {
+  mat3 r;
+  for (int i = 0; i < 9; ++i) r.m[i / 3][i % 3] = m.m[i][k];
+  return r;
+}
+
+inline matrix3x3 store(const mat3& m) noexcept {
+  return matrix3x3(m.m[0][0], m.m[0][1], m.m[0][2], m.m[1][0], m.m[1][1], m.m[1][2], m.m[2][0], m.m[2][1], m.m[2][2]);
+}
+
+inline void store(matrix3x3_soa_view out, size_t k, const mat3& m) noexcept {
+  for (int i = 0; i < 9; ++i) out.m[i][k] = m.m[i / 3][i % 3];
+}
+
+inline void store(float3_soa_view out, size_t k, const float (&v)[3]) noexcept {
+  out.x[k] = v[0];
+  out.y[k] = v[1];
+  out.z[k] = v[2];
+}
+
+} // namespace
+
+eigen3 eigen_symmetric(const matrix3x3& m) noexcept {
+  float values[3];
+  mat3 vectors;
+  decomposition_detail::eigen_symmetric<scalar_lanes>(load(m), values, vectors);
+  return {float3(values[0], values[1], values[2]), store(vectors)};
+}
+
+svd3 svd(const matrix3x3& m) noexcept {
+  mat3 u, v;
+  float sigma[3];
+  decomposition_detail::svd<scalar_lanes>(load(m), u, sigma, v);
+  return {store(u), float3(sigma[0], sigma[1], sigma[2]), store(v)};
+}
+
+polar3 polar(const matrix3x3& m) noexcept {
+  mat3 rotation, stretch;
+  decomposition_detail::polar<scalar_lanes>(load(m), rotation, stretch);
+  return {store(rotation), store(stretch)};
+}
+
+void eigen_symmetric(const_matrix3x3_soa_view m, float3_soa_view values, matrix3x3_soa_view vectors) noexcept {
+  float* const v[3] = {values.x, values.y, values.z};
+  size_t i = kernels().eigen3x3(m.m, v, vectors.m, m.size);
+  for (; i < m.size; ++i) {
+    float w[3];
+    mat3 e;
+    decomposition_detail::eigen_symmetric<scalar_lanes>(load(m, i), w, e);
+    store(values, i, w);
+    store(vectors, i, e);
+  }
+}
+
+void svd(const_matrix3x3_soa_view m, matrix3x3_soa_view u, float3_soa_view sigma, matrix3x3_soa_view v) noexcept {
+  float* const s[3] = {sigma.x, sigma.y, sigma.z};
+  size_t i = kernels().svd3x3(m.m, u.m, s, v.m, m.size);
+  for (; i < m.size; ++i) {
+    float w[3];
+    mat3 a, b;
+    decomposition_detail::svd<scalar_lanes>(load(m, i), a, w, b);
+    store(u, i, a);
+    store(sigma, i, w);
+    store(v, i, b);
+  }
+}
+
+void polar(const_matrix3x3_soa_view m, matrix3x3_soa_view rotation, matrix3x3_soa_view stretch) noexcept {
+  size_t i = kernels().polar3x3(m.m, rotation.m, stretch.m, m.size);
+  for (; i < m.size; ++i) {
+    mat3 r, s;
+    decomposition_detail::polar<scalar_lanes>(load(m, i), r, s);
+    store(rotation, i, r);
+    store(stretch, i, s);
+  }
+}
+
+} // namespace cgmath
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+// 3x3 decompositions written once over a lane type (simd_lanes.h, or the plain float lanes of
+// decomposition.cpp). Every branch is a select, so all lanes of a batch kernel follow the same
+// instruction stream. Each translation unit instantiates these with lanes of its own
+// namespace, which keeps the copies built with wider ISA flags apart like the rest of
+// kernels_impl.h.
+//
+// The SVD follows McAdams et al., "Computing the Singular Value Decomposition of 3x3 matrices
+// with minimal branching and elementary floating point operations" (2011): cyclic Jacobi on
+// A^T A gives V, the columns of A V sorted by length and a Givens QR give U and sigma. Unlike
+// the paper, the Jacobi angles are exact rather than approximate Givens angles, which
+// converge too slowly for rank-deficient inputs in a fixed number of sweeps, and a one-sided
+// sweep on A V makes up for the rounding of A^T A. Inputs are first divided by their largest
+// entry, so the squares neither overflow nor flush to zero.
+
+namespace cgmath::decomposition_detail {
+
+// Jacobi sweeps on a symmetric matrix, and on a^T a before the one-sided sweep of svd
+constexpr int EIGEN_SWEEPS = 4;
+constexpr int SVD_SWEEPS = 3;
+
+// Givens rotations of shorter vectors keep the identity
+constexpr float QR_EPSILON = 1e-30f;
+
+// Jacobi rotations with a smaller tangent are skipped: they change nothing a float can hold,
+// and later sweeps would drive the off-diagonal into denormals, which are slow on x86
+constexpr float JACOBI_MIN_TAN = 1e-12f;
+
+template <typename O>
+struct mat3 {
+  typename O::reg m[3][3];
+};
+
+template <typename O>
+inline mat3<O> identity() noexcept {
+  const typename O::reg z = O::zero(), one = O::set1(1.0f);
+  return {{{one, z, z}, {z, one, z}, {z, z, one}}};
+}
+
+// Divides a by its largest |a_ij| and returns that, or 1 for a zero matrix
+template <typename O>
+inline typename O::reg normalize(mat3<O>& a) noexcept {
+  using R = typename O::reg;
+  R k = O::zero();
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) k = O::max(k, O::abs(a.m[r][c]));
+  }
+  k = O::select(O::lt(O::zero(), k), k, O::set1(1.0f));
+  const R inv = O::div(O::set1(1.0f), k);
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) a.m[r][c] = O::mul(a.m[r][c], inv);
+  }
+  return k;
+}
+
+// cos and sin of the angle t that diagonalizes the symmetric pair, tan(2 t) = 2 spq / (sqq - spp),
+// with tan(t) in the form that stays accurate for small angles; a diagonal pair keeps t = 0
+template <typename O>
+inline void jacobi_angle(typename O::reg spp, typename O::reg sqq, typename O::reg spq, typename O::reg& c,
+                         typename O::reg& sn) noexcept {
+  using R = typename O::reg;
+  const R d = O::sub(sqq, spp), pq2 = O::add(spq, spq);
+  const R len = O::sqrt(O::madd(d, d, O::mul(pq2, pq2)));
+  const R num = O::select(O::lt(d, O::zero()), O::sub(O::zero(), pq2), pq2);
+  const R den = O::add(O::abs(d), len);
+  R t = O::div(num, den);
+  t = O::select(O::lt(O::set1(JACOBI_MIN_TAN), O::abs(t)), t, O::zero());
+  c = O::div(O::set1(1.0f), O::sqrt(O::madd(t, t, O::set1(1.0f))));
+  sn = O::mul(t, c);
+}
+
+// a = a G, G the rotation by (c, sn) in the (P, Q) plane
+template <typename O, int P, int Q>
+inline void rotate_columns(mat3<O>& a, typename O::reg c, typename O::reg sn) noexcept {
+  for (int r = 0; r < 3; ++r) {
+    const typename O::reg ap = a.m[r][P], aq = a.m[r][Q];
+    a.m[r][P] = O::sub(O::mul(c, ap), O::mul(sn, aq));
+    a.m[r][Q] = O::madd(sn, ap, O::mul(c, aq));
+  }
+}
+
+// One Jacobi step in the (P, Q) plane of the symmetric s: s = G^T s G and v = v G
+template <typename O, int P, int Q>
+inline void jacobi_rotate(mat3<O>& s, mat3<O>& v) noexcept {
+  using R = typename O::reg;
+  constexpr int K = 3 - P - Q;
+  const R spp = s.m[P][P], sqq = s.m[Q][Q], spq = s.m[P][Q], spk = s.m[P][K], sqk = s.m[Q][K];
+  R c, sn;
+  jacobi_angle<O>(spp, sqq, spq, c, sn);
+
+  const R cc = O::mul(c, c), ss = O::mul(sn, sn), cs = O::mul(c, sn);
+  const R cs_pq = O::mul(O::set1(2.0f), O::mul(cs, spq));
+  s.m[P][P] = O::sub(O::madd(cc, spp, O::mul(ss, sqq)), cs_pq);
+  s.m[Q][Q] = O::add(O::madd(ss, spp, O::mul(cc, sqq)), cs_pq);
+  s.m[P][Q] = s.m[Q][P] = O::madd(O::sub(cc, ss), spq, O::mul(cs, O::sub(spp, sqq)));
+  s.m[P][K] = s.m[K][P] = O::sub(O::mul(c, spk), O::mul(sn, sqk));
+  s.m[Q][K] = s.m[K][Q] = O::madd(sn, spk, O::mul(c, sqk));
+  rotate_columns<O, P, Q>(v, c, sn);
+}
+
+// One-sided Jacobi step: b = b G and v = v G for the G that makes columns P and Q of b
+// orthogonal. The dot products come from b itself, not from the rounded b^T b.
+template <typename O, int P, int Q>
+inline void orthogonalize(mat3<O>& b, mat3<O>& v) noexcept {
+  using R = typename O::reg;
+  R pp = O::mul(b.m[0][P], b.m[0][P]), qq = O::mul(b.m[0][Q], b.m[0][Q]), pq = O::mul(b.m[0][P], b.m[0][Q]);
+  for (int r = 1; r < 3; ++r) {
+    pp = O::madd(b.m[r][P], b.m[r][P], pp);
+    qq = O::madd(b.m[r][Q], b.m[r][Q], qq);
+    pq = O::madd(b.m[r][P], b.m[r][Q], pq);
+  }
+  R c, sn;
+  jacobi_angle<O>(pp, qq, pq, c, sn);
+  rotate_columns<O, P, Q>(b, c, sn);
+  rotate_columns<O, P, Q>(v, c, sn);
+}
+
+template <typename O>
+inline void jacobi(mat3<O>& s, mat3<O>& v, int sweeps) noexcept {
+  for (int sweep = 0; sweep < sweeps; ++sweep) {
+    jacobi_rotate<O, 0, 1>(s, v);
+    jacobi_rotate<O, 0, 2>(s, v);
+    jacobi_rotate<O, 1, 2>(s, v);
+  }
+}
+
+// Orders key[I] >= key[J] and returns the lanes that swapped
+template <typename O, int I, int J>
+inline typename O::mask sort_keys(typename O::reg (&key)[3]) noexcept {
+  const auto swap = O::lt(key[I], key[J]);
+  const typename O::reg ki = key[I];
+  key[I] = O::select(swap, key[J], ki);
+  key[J] = O::select(swap, ki, key[J]);
+  return swap;
+}
+
+// Swaps columns I and J of a where swap is set, negating the new column J so that a rotation
+// stays one
+template <typename O, int I, int J>
+inline void swap_columns(typename O::mask swap, mat3<O>& a) noexcept {
+  for (int r = 0; r < 3; ++r) {
+    const typename O::reg x = a.m[r][I], y = a.m[r][J];
+    a.m[r][I] = O::select(swap, y, x);
+    a.m[r][J] = O::select(swap, O::sub(O::zero(), x), y);
+  }
+}
+
+// Rotates rows P and Q of b so that b[Q][P] becomes zero and b[P][P] non-negative, u = u G.
+// Columns left of P are already zero in both rows.
+template <typename O, int P, int Q>
+inline void qr_rotate(mat3<O>& b, mat3<O>& u) noexcept {
+  using R = typename O::reg;
+  const R x = b.m[P][P], y = b.m[Q][P];
+  const R len = O::sqrt(O::madd(x, x, O::mul(y, y)));
+  const auto valid = O::lt(O::set1(QR_EPSILON), len);
+  const R inv = O::div(O::set1(1.0f), len);
+  const R c = O::select(valid, O::mul(x, inv), O::set1(1.0f));
+  const R s = O::select(valid, O::mul(y, inv), O::zero());
+  for (int k = P; k < 3; ++k) {
+    const R bp = b.m[P][k], bq = b.m[Q][k];
+    b.m[P][k] = O::madd(c, bp, O::mul(s, bq));
+    b.m[Q][k] = O::sub(O::mul(c, bq), O::mul(s, bp));
+  }
+  for (int r = 0; r < 3; ++r) {
+    const R up = u.m[r][P], uq = u.m[r][Q];
+    u.m[r][P] = O::madd(c, up, O::mul(s, uq));
+    u.m[r][Q] = O::sub(O::mul(c, uq), O::mul(s, up));
+  }
+}
+
+// a = vectors * diag(values) * vectors^T for the symmetric part of a, values decreasing
+template <typename O>
+inline void eigen_symmetric(mat3<O> a, typename O::reg (&values)[3], mat3<O>& vectors) noexcept {
+  const typename O::reg half = O::set1(0.5f);
+  for (int r = 0; r < 3; ++r) {
+    for (int c = r + 1; c < 3; ++c) a.m[r][c] = a.m[c][r] = O::mul(half, O::add(a.m[r][c], a.m[c][r]));
+  }
+  const typename O::reg k = normalize<O>(a);
+  vectors = identity<O>();
+  jacobi<O>(a, vectors, EIGEN_SWEEPS);
+  for (int i = 0; i < 3; ++i) values[i] = O::mul(a.m[i][i], k);
+  swap_columns<O, 0, 1>(sort_keys<O, 0, 1>(values), vectors);
+  swap_columns<O, 0, 2>(sort_keys<O, 0, 2>(values), vectors);
+  swap_columns<O, 1, 2>(sort_keys<O, 1, 2>(values), vectors);
+}
+
+// a = u * diag(sigma) * v^T with u and v rotations and |sigma| decreasing; sigma[2] carries
+// the sign of det(a)
+template <typename O>
+inline void svd(mat3<O> a, mat3<O>& u, typename O::reg (&sigma)[3], mat3<O>& v) noexcept {
+  using R = typename O::reg;
+  const R k = normalize<O>(a);
+
+  mat3<O> s;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = i; j < 3; ++j) {
+      s.m[i][j] = s.m[j][i] =
+          O::madd(a.m[0][i], a.m[0][j], O::madd(a.m[1][i], a.m[1][j], O::mul(a.m[2][i], a.m[2][j])));
+    }
+  }
+  v = identity<O>();
+  jacobi<O>(s, v, SVD_SWEEPS);
+
+  // b = a v has columns as long as the singular values. They are only as orthogonal as the
+  // rounding of a^T a allows, which is not enough for close small singular values; a one-sided
+  // sweep on b itself settles them.
+  mat3<O> b;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      b.m[r][c] = O::madd(a.m[r][0], v.m[0][c], O::madd(a.m[r][1], v.m[1][c], O::mul(a.m[r][2], v.m[2][c])));
+    }
+  }
+  orthogonalize<O, 0, 1>(b, v);
+  orthogonalize<O, 0, 2>(b, v);
+  orthogonalize<O, 1, 2>(b, v);
+  R length[3];
+  for (int c = 0; c < 3; ++c) {
+    length[c] = O::madd(b.m[0][c], b.m[0][c], O::madd(b.m[1][c], b.m[1][c], O::mul(b.m[2][c], b.m[2][c])));
+  }
+  const auto swap01 = sort_keys<O, 0, 1>(length);
+  swap_columns<O, 0, 1>(swap01, b);
+  swap_columns<O, 0, 1>(swap01, v);
+  const auto swap02 = sort_keys<O, 0, 2>(length);
+  swap_columns<O, 0, 2>(swap02, b);
+  swap_columns<O, 0, 2>(swap02, v);
+  const auto swap12 = sort_keys<O, 1, 2>(length);
+  swap_columns<O, 1, 2>(swap12, b);
+  swap_columns<O, 1, 2>(swap12, v);
+
+  u = identity<O>();
+  qr_rotate<O, 0, 1>(b, u);
+  qr_rotate<O, 0, 2>(b, u);
+  qr_rotate<O, 1, 2>(b, u);
+  for (int i = 0; i < 3; ++i) sigma[i] = O::mul(b.m[i][i], k);
+}
+
+// a = rotation * stretch, rotation = u v^T and stretch = v diag(sigma) v^T symmetric. For
+// det(a) < 0 the rotation stays proper and stretch takes the reflection.
+template <typename O>
+inline void polar(const mat3<O>& a, mat3<O>& rotation, mat3<O>& stretch) noexcept {
+  using R = typename O::reg;
+  mat3<O> u, v;
+  R sigma[3];
+  svd<O>(a, u, sigma, v);
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      rotation.m[r][c] = O::madd(u.m[r][0], v.m[c][0], O::madd(u.m[r][1], v.m[c][1], O::mul(u.m[r][2], v.m[c][2])));
+    }
+  }
+  for (int r = 0; r < 3; ++r) {
+    const R w[3] = {O::mul(v.m[r][0], sigma[0]), O::mul(v.m[r][1], sigma[1]), O::mul(v.m[r][2], sigma[2])};
+    for (int c = r; c < 3; ++c) {
+      stretch.m[r][c] = stretch.m[c][r] = O::madd(w[0], v.m[c][0], O::madd(w[1], v.m[c][1], O::mul(w[2], v.m[c][2])));
+    }
+  }
+}
+
+} // namespace cgmath::decomposition_detail
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "format.h"
+
+#include <cstring>
+#include <system_error>
+
+namespace cgmath {
+
+namespace {
+
+inline std::to_chars_result too_large(char* last) noexcept { return {last, std::errc::value_too_large}; }
+
+inline char* put(char* first, char* last, const char* s, size_t n) noexcept {
+  if (static_cast<size_t>(last - first) < n) return nullptr;
+  std::memcpy(first, s, n);
+  return first + n;
+}
+
+template <typename T>
+std::to_chars_result tuple(char* first, char* last, const char* name, const T* v, size_t n) noexcept {
+  char* p = put(first, last, name, std::strlen(name));
+  if (p) p = put(p, last, "(", 1);
+  for (size_t i = 0; p && i < n; ++i) {
+    if (i) p = put(p, last, ", ", 2);
+    if (!p) break;
+    std::to_chars_result r = std::to_chars(p, last, v[i]);
+    p = r.ec == std::errc() ? r.ptr : nullptr;
+  }
+  if (p) p = put(p, last, ")", 1);
+  return p ? std::to_chars_result{p, std::errc()} : too_large(last);
+}
+
+template <typename T>
+std::to_chars_result row_lines(char* first, char* last, const T* m, size_t rows, size_t cols) noexcept {
+  char* p = first;
+  for (size_t r = 0; p && r < rows; ++r) {
+    if (r) p = put(p, last, "\n", 1);
+    if (p) p = put(p, last, "|", 1);
+    for (size_t c = 0; p && c < cols; ++c) {
+      p = put(p, last, " ", 1);
+      if (!p) break;
+      std::to_chars_result res = std::to_chars(p, last, m[r * cols + c]);
+      p = res.ec == std::errc() ? res.ptr : nullptr;
+    }
+    if (p) p = put(p, last, " |", 2);
+  }
+  return p ? std::to_chars_result{p, std::errc()} : too_large(last);
+}
+
+} // namespace
+
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const float* v, size_t n) noexcept {
+  return tuple(first, last, name, v, n);
+}
+
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const double* v, size_t n) noexcept {
+  return tuple(first, last, name, v, n);
+}
+
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const int32_t* v, size_t n) noexcept {
+  return tuple(first, last, name, v, n);
+}
+
+std::to_chars_result format_tuple(char* first, char* last, const char* name, const uint32_t* v, size_t n) noexcept {
+  return tuple(first, last, name, v, n);
+}
+
+std::to_chars_result format_rows(char* first, char* last, const float* m, size_t rows, size_t cols) noexcept {
+  return row_lines(first, last, m, rows, cols);
+}
+
+std::to_chars_result format_rows(char* first, char* last, const double* m, size_t rows, size_t cols) noexcept {
+  return row_lines(first, last, m, rows, cols);
+}
+
+} // namespace cgmath
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "frustum.h"
+#include "kernels.h"
+
+#include <cstring>
+
+namespace cgmath {
+
+namespace {
+
+// Scalar tails after the vector kernels in kernels_impl.h
+struct sphere_bounds {
+  const_float4_soa_view s;
+
+  size_t size() const noexcept { return s.size; }
+
+  cull_result test(const frustum& f, size_t i) const noexcept {
+    return f.test_sphere(float3(s.x[i], s.y[i], s.z[i]), s.w[i]);
+  }
+};
+
+struct aabb_bounds {
+  const_float3_soa_view c, e;
+
+  size_t size() const noexcept { return c.size; }
+
+  cull_result test(const frustum& f, size_t i) const noexcept {
+    return f.test_aabb(float3(c.x[i], c.y[i], c.z[i]), float3(e.x[i], e.y[i], e.z[i]));
+  }
+};
+
+template <typename B>
+void classify_tail(const frustum& f, const B& bounds, size_t i, cull_result* out) noexcept {
+  for (; i < bounds.size(); ++i) out[i] = bounds.test(f, i);
+}
+
+template <typename B>
+size_t cull_tail(const frustum& f, const B& bounds, size_t i, uint32_t* visible, size_t count) noexcept {
+  for (; i < bounds.size(); ++i) {
+    if (bounds.test(f, i) != cull_result::outside) visible[count++] = static_cast<uint32_t>(i);
+  }
+  return count;
+}
+
+template <typename B>
+void mask_tail(const frustum* views, size_t view_count, const B& bounds, size_t i, uint64_t* const* masks) noexcept {
+  for (; i < bounds.size(); ++i) {
+    for (size_t v = 0; v < view_count; ++v) {
+      if (bounds.test(views[v], i) != cull_result::outside) masks[v][i / 64] |= uint64_t(1) << (i % 64);
+    }
+  }
+}
+
+void clear_masks(size_t view_count, size_t n, uint64_t* const* masks) noexcept {
+  for (size_t v = 0; v < view_count; ++v) std::memset(masks[v], 0, cull_mask_words(n) * sizeof(uint64_t));
+}
+
+} // namespace
+
+void classify_spheres(const frustum& f, const_float4_soa_view spheres, cull_result* out) noexcept {
+  classify_tail(f, sphere_bounds{spheres}, kernels().classify_spheres(f, spheres, out), out);
+}
+
+void classify_aabbs(const frustum& f, const_float3_soa_view centers, const_float3_soa_view extents,
+                    cull_result* out) noexcept {
+  classify_tail(f, aabb_bounds{centers, extents}, kernels().classify_aabbs(f, centers, extents, out), out);
+}
+
+size_t cull_spheres(const frustum& f, const_float4_soa_view spheres, uint32_t* visible) noexcept {
+  size_t count = 0;
+  size_t i = kernels().cull_spheres(f, spheres, visible, count);
+  return cull_tail(f, sphere_bounds{spheres}, i, visible, count);
+}
+
+size_t cull_aabbs(const frustum& f, const_float3_soa_view centers, const_float3_soa_view extents,
+                  uint32_t* visible) noexcept {
+  size_t count = 0;
+  size_t i = kernels().cull_aabbs(f, centers, extents, visible, count);
+  return cull_tail(f, aabb_bounds{centers, extents}, i, visible, count);
+}
+
+void cull_spheres(const frustum* views, size_t view_count, const_float4_soa_view spheres,
+                  uint64_t* const* masks) noexcept {
+  clear_masks(view_count, spheres.size, masks);
+  size_t i = kernels().cull_sphere_masks(views, view_count, spheres, masks);
+  mask_tail(views, view_count, sphere_bounds{spheres}, i, masks);
+}
+
+void cull_aabbs(const frustum* views, size_t view_count, const_float3_soa_view centers,
+                const_float3_soa_view extents, uint64_t* const* masks) noexcept {
+  clear_masks(view_count, centers.size, masks);
+  size_t i = kernels().cull_aabb_masks(views, view_count, centers, extents, masks);
+  mask_tail(views, view_count, aabb_bounds{centers, extents}, i, masks);
+}
+
+} // namespace cgmath
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "gpu_layout.h"
+#include "parallel.h"
+
+#include <cstring>
+
+namespace cgmath {
+
+namespace {
+
+static_assert(sizeof(matrix3x3) >= 10 * sizeof(float), "matrix3x3 rows are loaded four floats at a time");
+
+#ifdef __SSE__
+template <bool Stream>
+inline void store(float* p, __m128 v) noexcept {
+  if constexpr (Stream) {
+    _mm_stream_ps(p, v);
+  } else {
+    _mm_storeu_ps(p, v);
+  }
+}
+
+// (v.x, v.y, v.z, 0)
+inline __m128 zero_w(__m128 v) noexcept {
+  return _mm_shuffle_ps(v, _mm_unpackhi_ps(v, _mm_setzero_ps()), _MM_SHUFFLE(1, 0, 1, 0));
+}
+
+// (p[0], p[1], p[2], 0) without reading past p[2]
+inline __m128 load_float3(const float* p) noexcept {
+  const __m128 xy = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p));
+  return _mm_movelh_ps(xy, _mm_load_ss(p + 2));
+}
+#endif
+
+// Elements [begin, end) of in to out, which points at element 0 of the buffer
+
+template <bool Stream>
+void write_range(const float2* in, float* out, size_t begin, size_t end, const gpu_layout_options& o) noexcept {
+  if (o.layout == gpu_layout::std430) {
+    size_t i = begin;
+#ifdef __SSE__
+    // Two elements per store; chunks start on cache lines, so pairs stay 16-byte aligned
+    if constexpr (Stream) {
+      for (; i + 2 <= end; i += 2) store<true>(out + i * 2, _mm_loadu_ps(&in[i].x));
+    }
+#endif
+    std::memcpy(out + i * 2, in + i, (end - i) * sizeof(float2));
+    return;
+  }
+  for (size_t i = begin; i < end; ++i) {
+    float* d = out + i * 4;
+#ifdef __SSE__
+    store<Stream>(d, _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&in[i].x)));
+#else
+    d[0] = in[i].x;
+    d[1] = in[i].y;
+    d[2] = d[3] = 0.0f;
+#endif
+  }
+}
+
+template <bool Stream>
+void write_range(const float3* in, float* out, size_t begin, size_t end, const gpu_layout_options&) noexcept {
+  for (size_t i = begin; i < end; ++i) {
+    float* d = out + i * 4;
+#ifdef __SSE__
+    store<Stream>(d, load_float3(&in[i].x));
+#else
+    d[0] = in[i].x;
+    d[1] = in[i].y;
+    d[2] = in[i].z;
+    d[3] = 0.0f;
+#endif
+  }
+}
+
+template <bool Stream>
+void write_range(const matrix3x3* in, float* out, size_t begin, size_t end, const gpu_layout_options& o) noexcept {
+  const bool columns = o.order == matrix_order::column_major;
+  for (size_t i = begin; i < end; ++i) {
+    const float* m = in[i].m[0];
+    float* d = out + i * 12;
+#ifdef __SSE__
+    // Rows are 3 floats apart, the fourth lane of each load is the next row or padding
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 3);
+    __m128 r2 = _mm_loadu_ps(m + 6);
+    if (columns) {
+      __m128 r3 = _mm_setzero_ps();
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    } else {
+      r0 = zero_w(r0);
+      r1 = zero_w(r1);
+      r2 = zero_w(r2);
+    }
+    store<Stream>(d + 0, r0);
+    store<Stream>(d + 4, r1);
+    store<Stream>(d + 8, r2);
+#else
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 3; ++c) d[r * 4 + c] = columns ? m[c * 3 + r] : m[r * 3 + c];
+      d[r * 4 + 3] = 0.0f;
+    }
+#endif
+  }
+}
+
+template <bool Stream>
+void write_range(const matrix3x4* in, float* out, size_t begin, size_t end, const gpu_layout_options& o) noexcept {
+  if (o.order == matrix_order::row_major) {
+    for (size_t i = begin; i < end; ++i) {
+      const float* m = in[i].m[0];
+      float* d = out + i * 12;
+#ifdef __SSE__
+      store<Stream>(d + 0, _mm_loadu_ps(m + 0));
+      store<Stream>(d + 4, _mm_loadu_ps(m + 4));
+      store<Stream>(d + 8, _mm_loadu_ps(m + 8));
+#else
+      std::memcpy(d, m, 12 * sizeof(float));
+#endif
+    }
+    return;
+  }
+  for (size_t i = begin; i < end; ++i) {
+    const float* m = in[i].m[0];
+    float* d = out + i * 16;
+#ifdef __SSE__
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    store<Stream>(d + 0, r0);
+    store<Stream>(d + 4, r1);
+    store<Stream>(d + 8, r2);
+    store<Stream>(d + 12, r3);
+#else
+    for (int c = 0; c < 4; ++c) {
+      for (int r = 0; r < 3; ++r) d[c * 4 + r] = m[r * 4 + c];
+      d[c * 4 + 3] = 0.0f;
+    }
+#endif
+  }
+}
+
+template <bool Stream>
+void write_range(const matrix4x4* in, float* out, size_t begin, size_t end, const gpu_layout_options& o) noexcept {
+  const bool columns = o.order == matrix_order::column_major;
+  for (size_t i = begin; i < end; ++i) {
+    const float* m = in[i].m[0];
+    float* d = out + i * 16;
+#ifdef __SSE__
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+    if (columns) _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    store<Stream>(d + 0, r0);
+    store<Stream>(d + 4, r1);
+    store<Stream>(d + 8, r2);
+    store<Stream>(d + 12, r3);
+#else
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) d[r * 4 + c] = columns ? m[c * 4 + r] : m[r * 4 + c];
+    }
+#endif
+  }
+}
+
+template <typename T>
+size_t write_array(const T* in, void* out, size_t n, const gpu_layout_options& o) noexcept {
+  const size_t stride = gpu_stride<T>(o);
+  float* dst = static_cast<float*>(out);
+#ifdef __SSE__
+  const bool stream = o.mode == store_mode::non_temporal && (reinterpret_cast<uintptr_t>(out) & 15) == 0;
+#else
+  const bool stream = false;
+#endif
+  const auto range = [&](size_t begin, size_t end) {
+    if (stream) {
+      write_range<true>(in, dst, begin, end, o);
+#ifdef __SSE__
+      // Every thread orders its own streaming stores before the loop returns
+      _mm_sfence();
+#endif
+    } else {
+      write_range<false>(in, dst, begin, end, o);
+    }
+  };
+
+  if (o.thread_count == 1) {
+    range(size_t(0), n);
+  } else {
+    // Chunks start on cache lines of the output
+    parallel_options p;
+    p.thread_count = o.thread_count;
+    p.element_size = stride;
+    parallel_for(0, n, range, p);
+  }
+  return n * stride;
+}
+
+} // namespace
+
+size_t to_gpu_layout(const float2* in, void* out, size_t n, const gpu_layout_options& o) noexcept {
+  return write_array(in, out, n, o);
+}
+
+size_t to_gpu_layout(const float3* in, void* out, size_t n, const gpu_layout_options& o) noexcept {
+  return write_array(in, out, n, o);
+}
+
+size_t to_gpu_layout(const matrix3x3* in, void* out, size_t n, const gpu_layout_options& o) noexcept {
+  return write_array(in, out, n, o);
+}
+
+size_t to_gpu_layout(const matrix3x4* in, void* out, size_t n, const gpu_layout_options& o) noexcept {
+  return write_array(in, out, n, o);
+}
+
+size_t to_gpu_layout(const matrix4x4* in, void* out, size_t n, const gpu_layout_options& o) noexcept {
+  return write_array(in, out, n, o);
+}
+
+} // namespace cgmath
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "half.h"
+#include "kernels.h"
+
+namespace cgmath {
+
+namespace {
+
+// Every half vector is a run of plain halves, so all overloads share one flat conversion
+void floats_to_halves(const float* in, half* out, size_t n) noexcept {
+  size_t i = kernels().float_to_half(in, &out->bits, n);
+  for (; i < n; ++i) out[i].bits = detail::float_to_half_bits(in[i]);
+}
+
+void halves_to_floats(const half* in, float* out, size_t n) noexcept {
+  size_t i = kernels().half_to_float(&in->bits, out, n);
+  for (; i < n; ++i) out[i] = detail::half_bits_to_float(in[i].bits);
+}
+
+} // namespace
+
+void to_half(const float* in, half* out, size_t n) noexcept { floats_to_halves(in, out, n); }
+void to_half(const float2* in, half2* out, size_t n) noexcept { floats_to_halves(&in->x, &out->x, n * 2); }
+void to_half(const float3* in, half3* out, size_t n) noexcept { floats_to_halves(&in->x, &out->x, n * 3); }
+void to_half(const float4* in, half4* out, size_t n) noexcept { floats_to_halves(&in->x, &out->x, n * 4); }
+
+void to_float(const half* in, float* out, size_t n) noexcept { halves_to_floats(in, out, n); }
+void to_float(const half2* in, float2* out, size_t n) noexcept { halves_to_floats(&in->x, &out->x, n * 2); }
+void to_float(const half3* in, float3* out, size_t n) noexcept { halves_to_floats(&in->x, &out->x, n * 3); }
+void to_float(const half4* in, float4* out, size_t n) noexcept { halves_to_floats(&in->x, &out->x, n * 4); }
+
+} // namespace cgmath
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "cpu.h"
+#include "frustum.h"
+#include "ray_packet.h"
+#include "soa.h"
+
+#include <cstddef>
+
+// Vector bodies of the batch kernels, one table per instruction set. Every entry handles a
+// leading run of whole SIMD steps and returns where it stopped; the caller in the public
+// translation unit finishes the remainder with scalar code and the regular member functions.
+//
+// Streams are arrays of `components` (3 or 4) pointers, AoS elements are `stride` floats
+// apart and matrices are row-major 4x4.
+
+namespace cgmath {
+
+// Component formats of the fixed-point vertex streams, see vertex_codec.h
+enum class fixed_format { unorm16, snorm16, snorm8 };
+
+struct kernel_table {
+  cpu_isa isa;
+  size_t align;  // bytes, for the non-temporal store paths
+
+  // soa.cpp
+  size_t (*aos_to_soa)(const float* in, size_t stride, size_t n, float* const* out, size_t components) noexcept;
+  size_t (*soa_to_aos)(const float* const* in, size_t components, size_t n, float* out, size_t stride) noexcept;
+  size_t (*dot)(const float* const* a, const float* const* b, size_t components, size_t n, float* out) noexcept;
+  size_t (*cross)(const float* const* a, const float* const* b, size_t n, float* const* out) noexcept;
+  size_t (*length)(const float* const* a, size_t components, size_t n, float* out) noexcept;
+  size_t (*normalize)(const float* const* a, size_t components, size_t n, float* const* out) noexcept;
+  size_t (*lerp)(const float* const* a, const float* const* b, float t, size_t components, size_t n,
+                 float* const* out) noexcept;
+  size_t (*clamp)(const float* const* a, const float* lo, const float* hi, size_t components, size_t n,
+                  float* const* out) noexcept;
+
+  // transform.cpp, transform_soa starts at element `begin`
+  size_t (*transform_float3)(const float* m, bool point, bool stream, const float* in, float* out, size_t n) noexcept;
+  size_t (*transform_soa)(const float* m, bool point, bool stream, const float* const* in, float* const* out,
+                          size_t begin, size_t n) noexcept;
+  size_t (*transform_vector4)(const float* m, bool stream, const float* in, float* out, size_t n) noexcept;
+
+  // quaternion.cpp: rotation rows (and translations, when t is not null) of matrices `stride` floats apart
+  size_t (*rotations_to_rows)(const float* q, const float* t, float* out, size_t stride, size_t n) noexcept;
+  size_t (*nlerp)(const float* a, const float* b, float t, float* out, size_t n) noexcept;
+
+  // frustum.cpp: cull_* write visible indices from zero and report how many through count;
+  // the mask variants OR into masks the caller has cleared
+  size_t (*classify_spheres)(const frustum& f, const_float4_soa_view s, cull_result* out) noexcept;
+  size_t (*classify_aabbs)(const frustum& f, const_float3_soa_view c, const_float3_soa_view e,
+                           cull_result* out) noexcept;
+  size_t (*cull_spheres)(const frustum& f, const_float4_soa_view s, uint32_t* visible, size_t& count) noexcept;
+  size_t (*cull_aabbs)(const frustum& f, const_float3_soa_view c, const_float3_soa_view e, uint32_t* visible,
+                       size_t& count) noexcept;
+  size_t (*cull_sphere_masks)(const frustum* views, size_t view_count, const_float4_soa_view s,
+                              uint64_t* const* masks) noexcept;
+  size_t (*cull_aabb_masks)(const frustum* views, size_t view_count, const_float3_soa_view c,
+                            const_float3_soa_view e, uint64_t* const* masks) noexcept;
+
+  // half.cpp: n values, halves as raw bits
+  size_t (*float_to_half)(const float* in, uint16_t* out, size_t n) noexcept;
+  size_t (*half_to_float)(const uint16_t* in, float* out, size_t n) noexcept;
+
+  // camera_relative.cpp: n elements of `components` (3 or 4) doubles minus origin, to float
+  size_t (*to_float_relative)(const double* in, const double* origin, size_t components, float* out,
+                              size_t n) noexcept;
+
+  // vertex_codec.cpp: octahedral vectors with `bits` (8, 12 or 16) per component take 2, 3 or 4
+  // bytes each; fixed-point streams are n * 3 components, value = q * scale + offset per component
+  size_t (*encode_octahedral)(const float* in, int bits, void* out, size_t n) noexcept;
+  size_t (*decode_octahedral)(const void* in, int bits, float* out, size_t n) noexcept;
+  size_t (*encode_fixed3)(const float* in, fixed_format format, const float* offset, const float* scale, void* out,
+                          size_t n) noexcept;
+  size_t (*decode_fixed3)(const void* in, fixed_format format, const float* offset, const float* scale, float* out,
+                          size_t n) noexcept;
+  size_t (*encode_quaternions)(const float* in, uint32_t* out, size_t n) noexcept;
+  size_t (*decode_quaternions)(const uint32_t* in, float* out, size_t n) noexcept;
+  size_t (*encode_rgb10a2)(const float* in, uint32_t* out, size_t n) noexcept;
+  size_t (*decode_rgb10a2)(const uint32_t* in, float* out, size_t n) noexcept;
+
+  // morton.cpp: float3 points to 3D curve keys, cell = clamp((p - offset) * scale, 0, 2^21 - 1)
+  size_t (*morton_keys3)(const float* in, const float* offset, const float* scale, uint64_t* out, size_t n) noexcept;
+  size_t (*hilbert_keys3)(const float* in, const float* offset, const float* scale, uint64_t* out, size_t n) noexcept;
+
+  // decomposition.cpp: matrices as nine row-major streams, float3 results as three
+  size_t (*eigen3x3)(const float* const* m, float* const* values, float* const* vectors, size_t n) noexcept;
+  size_t (*svd3x3)(const float* const* m, float* const* u, float* const* sigma, float* const* v, size_t n) noexcept;
+  size_t (*polar3x3)(const float* const* m, float* const* rotation, float* const* stretch, size_t n) noexcept;
+
+  // ray_packet.cpp: the packet tests and traversals handle all of a packet or, returning 0,
+  // none of it, and OR the lanes they hit into mask. Traversals take the arrays of a non-empty bvh.
+  size_t (*triangle_packet8)(ray8& r, const bvh_triangle& tri, uint32_t primitive, hit8& hit, uint32_t& mask) noexcept;
+  size_t (*triangle_packet16)(ray16& r, const bvh_triangle& tri, uint32_t primitive, hit16& hit,
+                              uint32_t& mask) noexcept;
+  size_t (*aabb_packet8)(const ray8& r, const float3& min, const float3& max, float* t_enter, uint32_t& mask) noexcept;
+  size_t (*aabb_packet16)(const ray16& r, const float3& min, const float3& max, float* t_enter,
+                          uint32_t& mask) noexcept;
+  size_t (*traverse_packet8)(const bvh_node* nodes, const bvh_triangle* triangles, const uint32_t* primitives, ray8& r,
+                             hit8& hit, bool any_hit, uint32_t& mask) noexcept;
+  size_t (*traverse_packet16)(const bvh_node* nodes, const bvh_triangle* triangles, const uint32_t* primitives,
+                              ray16& r, hit16& hit, bool any_hit, uint32_t& mask) noexcept;
+};
+
+// Table for the active level, see set_isa
+const kernel_table& kernels() noexcept;
+
+// Built from kernels_impl.h by kernels_*.cpp. Only kernels_baseline exists in every build;
+// the others depend on CG_MATH_DISPATCH and the compiler.
+extern const kernel_table kernels_baseline;
+extern const kernel_table kernels_sse41;
+extern const kernel_table kernels_avx2;
+extern const kernel_table kernels_avx512;
+
+} // namespace cgmath
+
+// Level the current translation unit is compiled for
+#if defined(__AVX512F__)
+#define CG_MATH_COMPILED_ISA ::cgmath::cpu_isa::avx512
+#elif defined(__AVX2__)
+#define CG_MATH_COMPILED_ISA ::cgmath::cpu_isa::avx2
+#elif defined(__SSE4_1__)
+#define CG_MATH_COMPILED_ISA ::cgmath::cpu_isa::sse41
+#elif defined(__SSE2__) || defined(__SSE__)
+#define CG_MATH_COMPILED_ISA ::cgmath::cpu_isa::sse2
+#else
+#define CG_MATH_COMPILED_ISA ::cgmath::cpu_isa::scalar
+#endif
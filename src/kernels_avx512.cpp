@@ -0,0 +1,13 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+// Built with -mavx512f -mavx2 -mfma -mf16c when CG_MATH_DISPATCH is set, see CMakeLists.txt
+
+#include "pch.h"
+
+#ifdef CG_MATH_DISPATCH
+#define CG_MATH_LANES_NAMESPACE avx512f
+#define CG_MATH_KERNEL_TABLE kernels_avx512
+#include "kernels_impl.h"
+#endif
@@ -0,0 +1,12 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+// Kernels at the library's own compile flags, always present
+
+#include "pch.h"
+
+#ifdef __SSE__
+#define CG_MATH_KERNEL_TABLE kernels_baseline
+#include "kernels_impl.h"
+#endif
@@ -0,0 +1,1282 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+// Batch kernel bodies, compiled once per instruction set by kernels_*.cpp. Each of those
+// translation units defines CG_MATH_LANES_NAMESPACE and CG_MATH_KERNEL_TABLE before
+// including this file; lanes::native then resolves to the widest lanes the unit's flags allow.
+//
+// Code here may be built with flags the host lacks, so it keeps to its own namespace and to
+// plain data of the library types. Calling an inline function from the shared headers (member
+// functions, std::array, std::sqrt ...) would emit an out-of-line copy the linker might pick
+// for the whole program.
+
+#include "kernels.h"
+#include "simd_lanes.h"
+#include "decomposition_impl.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace cgmath {
+namespace CG_MATH_LANES_NAMESPACE {
+namespace {
+
+using L = lanes::native;
+using reg = L::reg;
+
+// soa.cpp
+
+size_t aos_to_soa(const float* in, size_t stride, size_t n, float* const* out, size_t components) noexcept {
+  size_t i = 0;
+  if (stride == 3) {
+    for (; i + L::width <= n; i += L::width) {
+      reg x, y, z;
+      L::load_xyz(in + i * 3, x, y, z);
+      L::store(out[0] + i, x);
+      L::store(out[1] + i, y);
+      L::store(out[2] + i, z);
+    }
+  } else {
+    for (; i + L::width <= n; i += L::width) {
+      reg x, y, z, w;
+      L::load_xyzw(in + i * stride, x, y, z, w, stride);
+      L::store(out[0] + i, x);
+      L::store(out[1] + i, y);
+      L::store(out[2] + i, z);
+      if (components == 4) L::store(out[3] + i, w);
+    }
+  }
+  return i;
+}
+
+size_t soa_to_aos(const float* const* in, size_t components, size_t n, float* out, size_t stride) noexcept {
+  size_t i = 0;
+  if (stride == 3) {
+    for (; i + L::width <= n; i += L::width) {
+      L::template store_xyz<false>(out + i * 3, L::load(in[0] + i), L::load(in[1] + i), L::load(in[2] + i));
+    }
+  } else {
+    for (; i + L::width <= n; i += L::width) {
+      reg w = components == 4 ? L::load(in[3] + i) : L::zero();
+      L::store_xyzw(out + i * stride, L::load(in[0] + i), L::load(in[1] + i), L::load(in[2] + i), w, stride);
+    }
+  }
+  return i;
+}
+
+template <size_t N>
+size_t dot_n(const float* const* a, const float* const* b, size_t n, float* out) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg acc = L::mul(L::load(a[0] + i), L::load(b[0] + i));
+    for (size_t c = 1; c < N; ++c) acc = L::madd(L::load(a[c] + i), L::load(b[c] + i), acc);
+    L::store(out + i, acc);
+  }
+  return i;
+}
+
+size_t dot(const float* const* a, const float* const* b, size_t components, size_t n, float* out) noexcept {
+  return components == 3 ? dot_n<3>(a, b, n, out) : dot_n<4>(a, b, n, out);
+}
+
+size_t cross(const float* const* a, const float* const* b, size_t n, float* const* out) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg ax = L::load(a[0] + i), ay = L::load(a[1] + i), az = L::load(a[2] + i);
+    reg bx = L::load(b[0] + i), by = L::load(b[1] + i), bz = L::load(b[2] + i);
+    L::store(out[0] + i, L::sub(L::mul(ay, bz), L::mul(az, by)));
+    L::store(out[1] + i, L::sub(L::mul(az, bx), L::mul(ax, bz)));
+    L::store(out[2] + i, L::sub(L::mul(ax, by), L::mul(ay, bx)));
+  }
+  return i;
+}
+
+template <size_t N>
+size_t length_n(const float* const* a, size_t n, float* out) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg v = L::load(a[0] + i);
+    reg acc = L::mul(v, v);
+    for (size_t c = 1; c < N; ++c) {
+      v = L::load(a[c] + i);
+      acc = L::madd(v, v, acc);
+    }
+    L::store(out + i, L::sqrt(acc));
+  }
+  return i;
+}
+
+size_t length(const float* const* a, size_t components, size_t n, float* out) noexcept {
+  return components == 3 ? length_n<3>(a, n, out) : length_n<4>(a, n, out);
+}
+
+template <size_t N>
+size_t normalize_n(const float* const* a, size_t n, float* const* out) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg v[N];
+    for (size_t c = 0; c < N; ++c) v[c] = L::load(a[c] + i);
+    reg len2 = L::mul(v[0], v[0]);
+    for (size_t c = 1; c < N; ++c) len2 = L::madd(v[c], v[c], len2);
+    reg len = L::sqrt(len2);
+    for (size_t c = 0; c < N; ++c) L::store(out[c] + i, L::select_gt_zero(len2, L::div(v[c], len)));
+  }
+  return i;
+}
+
+size_t normalize(const float* const* a, size_t components, size_t n, float* const* out) noexcept {
+  return components == 3 ? normalize_n<3>(a, n, out) : normalize_n<4>(a, n, out);
+}
+
+size_t lerp(const float* const* a, const float* const* b, float t, size_t components, size_t n,
+            float* const* out) noexcept {
+  size_t i = 0;
+  const reg vt = L::set1(t);
+  for (; i + L::width <= n; i += L::width) {
+    for (size_t c = 0; c < components; ++c) {
+      reg va = L::load(a[c] + i);
+      L::store(out[c] + i, L::madd(vt, L::sub(L::load(b[c] + i), va), va));
+    }
+  }
+  return i;
+}
+
+size_t clamp(const float* const* a, const float* lo, const float* hi, size_t components, size_t n,
+             float* const* out) noexcept {
+  size_t i = 0;
+  reg vlo[4], vhi[4];
+  for (size_t c = 0; c < components; ++c) {
+    vlo[c] = L::set1(lo[c]);
+    vhi[c] = L::set1(hi[c]);
+  }
+  for (; i + L::width <= n; i += L::width) {
+    for (size_t c = 0; c < components; ++c) L::store(out[c] + i, L::max(vlo[c], L::min(L::load(a[c] + i), vhi[c])));
+  }
+  return i;
+}
+
+// transform.cpp
+
+// Broadcast rows of the affine 3x4 part
+struct affine_rows {
+  reg m11, m12, m13, m14, m21, m22, m23, m24, m31, m32, m33, m34;
+
+  explicit affine_rows(const float* m) noexcept
+    : m11(L::set1(m[0])), m12(L::set1(m[1])), m13(L::set1(m[2])), m14(L::set1(m[3])),
+      m21(L::set1(m[4])), m22(L::set1(m[5])), m23(L::set1(m[6])), m24(L::set1(m[7])),
+      m31(L::set1(m[8])), m32(L::set1(m[9])), m33(L::set1(m[10])), m34(L::set1(m[11])) {}
+
+  template <bool IsPoint>
+  void apply(reg x, reg y, reg z, reg& rx, reg& ry, reg& rz) const noexcept {
+    rx = L::madd(m13, z, L::madd(m12, y, IsPoint ? L::madd(m11, x, m14) : L::mul(m11, x)));
+    ry = L::madd(m23, z, L::madd(m22, y, IsPoint ? L::madd(m21, x, m24) : L::mul(m21, x)));
+    rz = L::madd(m33, z, L::madd(m32, y, IsPoint ? L::madd(m31, x, m34) : L::mul(m31, x)));
+  }
+};
+
+// Packed float3 in, packed float3 out
+template <bool IsPoint, bool Stream>
+size_t transform_float3_n(const float* m, const float* in, float* out, size_t n) noexcept {
+  const affine_rows rows(m);
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width, in += 3 * L::width, out += 3 * L::width) {
+    reg x, y, z, rx, ry, rz;
+    L::load_xyz(in, x, y, z);
+    rows.template apply<IsPoint>(x, y, z, rx, ry, rz);
+    L::template store_xyz<Stream>(out, rx, ry, rz);
+  }
+  return i;
+}
+
+size_t transform_float3(const float* m, bool point, bool stream, const float* in, float* out, size_t n) noexcept {
+  if (point) {
+    return stream ? transform_float3_n<true, true>(m, in, out, n) : transform_float3_n<true, false>(m, in, out, n);
+  }
+  return stream ? transform_float3_n<false, true>(m, in, out, n) : transform_float3_n<false, false>(m, in, out, n);
+}
+
+template <bool IsPoint, bool Stream>
+size_t transform_soa_n(const float* m, const float* const* in, float* const* out, size_t i, size_t n) noexcept {
+  const affine_rows rows(m);
+  for (; i + L::width <= n; i += L::width) {
+    reg rx, ry, rz;
+    rows.template apply<IsPoint>(L::load(in[0] + i), L::load(in[1] + i), L::load(in[2] + i), rx, ry, rz);
+    if constexpr (Stream) {
+      L::stream(out[0] + i, rx);
+      L::stream(out[1] + i, ry);
+      L::stream(out[2] + i, rz);
+    } else {
+      L::store(out[0] + i, rx);
+      L::store(out[1] + i, ry);
+      L::store(out[2] + i, rz);
+    }
+  }
+  return i;
+}
+
+size_t transform_soa(const float* m, bool point, bool stream, const float* const* in, float* const* out,
+                     size_t begin, size_t n) noexcept {
+  if (point) {
+    return stream ? transform_soa_n<true, true>(m, in, out, begin, n) : transform_soa_n<true, false>(m, in, out, begin, n);
+  }
+  return stream ? transform_soa_n<false, true>(m, in, out, begin, n) : transform_soa_n<false, false>(m, in, out, begin, n);
+}
+
+// m * v as a sum of matrix columns scaled by the components, width / 4 vectors per register
+// and four registers per step.
+template <bool Stream>
+size_t transform_vector4_n(const float* m, const float* in, float* out, size_t n) noexcept {
+  float columns[4][4];
+  for (size_t r = 0; r < 4; ++r) {
+    for (size_t c = 0; c < 4; ++c) columns[c][r] = m[r * 4 + c];
+  }
+  const reg c0 = L::broadcast4(columns[0]);
+  const reg c1 = L::broadcast4(columns[1]);
+  const reg c2 = L::broadcast4(columns[2]);
+  const reg c3 = L::broadcast4(columns[3]);
+
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width, in += 4 * L::width, out += 4 * L::width) {
+    for (size_t j = 0; j < 4; ++j) {
+      reg v = L::load(in + j * L::width);
+      reg r = L::mul(c0, L::template splat4<0>(v));
+      r = L::madd(c1, L::template splat4<1>(v), r);
+      r = L::madd(c2, L::template splat4<2>(v), r);
+      r = L::madd(c3, L::template splat4<3>(v), r);
+      if constexpr (Stream) L::stream(out + j * L::width, r);
+      else L::store(out + j * L::width, r);
+    }
+  }
+  return i;
+}
+
+size_t transform_vector4(const float* m, bool stream, const float* in, float* out, size_t n) noexcept {
+  return stream ? transform_vector4_n<true>(m, in, out, n) : transform_vector4_n<false>(m, in, out, n);
+}
+
+// quaternion.cpp
+
+size_t rotations_to_rows(const float* q, const float* t, float* out, size_t stride, size_t n) noexcept {
+  const reg one = L::set1(1.0f);
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg x, y, z, w;
+    L::load_xyzw(q + i * 4, x, y, z, w);
+    reg x2 = L::add(x, x), y2 = L::add(y, y), z2 = L::add(z, z);
+    reg xx = L::mul(x, x2), yy = L::mul(y, y2), zz = L::mul(z, z2);
+    reg xy = L::mul(x, y2), xz = L::mul(x, z2), yz = L::mul(y, z2);
+    reg wx = L::mul(w, x2), wy = L::mul(w, y2), wz = L::mul(w, z2);
+    reg tx = L::zero(), ty = L::zero(), tz = L::zero();
+    if (t) L::load_xyz(t + i * 3, tx, ty, tz);
+    float* o = out + i * stride;
+    L::store_xyzw(o + 0, L::sub(one, L::add(yy, zz)), L::sub(xy, wz), L::add(xz, wy), tx, stride);
+    L::store_xyzw(o + 4, L::add(xy, wz), L::sub(one, L::add(xx, zz)), L::sub(yz, wx), ty, stride);
+    L::store_xyzw(o + 8, L::sub(xz, wy), L::add(yz, wx), L::sub(one, L::add(xx, yy)), tz, stride);
+  }
+  return i;
+}
+
+size_t nlerp(const float* a, const float* b, float t, float* out, size_t n) noexcept {
+  const reg vt = L::set1(t);
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg ax, ay, az, aw, bx, by, bz, bw;
+    L::load_xyzw(a + i * 4, ax, ay, az, aw);
+    L::load_xyzw(b + i * 4, bx, by, bz, bw);
+    // Shortest arc: flip b where dot(a, b) < 0
+    reg d = L::madd(aw, bw, L::madd(az, bz, L::madd(ay, by, L::mul(ax, bx))));
+    bx = L::xor_sign(bx, d); by = L::xor_sign(by, d); bz = L::xor_sign(bz, d); bw = L::xor_sign(bw, d);
+    reg rx = L::madd(vt, L::sub(bx, ax), ax);
+    reg ry = L::madd(vt, L::sub(by, ay), ay);
+    reg rz = L::madd(vt, L::sub(bz, az), az);
+    reg rw = L::madd(vt, L::sub(bw, aw), aw);
+    reg len = L::sqrt(L::madd(rw, rw, L::madd(rz, rz, L::madd(ry, ry, L::mul(rx, rx)))));
+    L::store_xyzw(out + i * 4, L::div(rx, len), L::div(ry, len), L::div(rz, len), L::div(rw, len));
+  }
+  return i;
+}
+
+// frustum.cpp
+
+inline unsigned lowest_bit(unsigned m) noexcept {
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward(&i, m);
+  return static_cast<unsigned>(i);
+#else
+  return static_cast<unsigned>(__builtin_ctz(m));
+#endif
+}
+
+// Each bounds type loads `width` objects into registers once and then classifies them
+// against any number of frustums. classify sets bit k of outside when object k lies fully
+// behind some plane and bit k of straddle when it crosses at least one.
+struct sphere_bounds {
+  const_float4_soa_view s;
+
+  size_t size() const noexcept { return s.size; }
+
+  struct regs { reg x, y, z, r, neg_r; };
+
+  regs load(size_t i) const noexcept {
+    reg r = L::load(s.w + i);
+    return {L::load(s.x + i), L::load(s.y + i), L::load(s.z + i), r, L::sub(L::zero(), r)};
+  }
+
+  static void classify(const frustum& f, const regs& b, unsigned& outside, unsigned& straddle) noexcept {
+    outside = straddle = 0;
+    for (const float4& p : f.planes) {
+      reg d = L::madd(L::set1(p.z), b.z, L::madd(L::set1(p.y), b.y, L::madd(L::set1(p.x), b.x, L::set1(p.w))));
+      outside |= L::mask_lt(d, b.neg_r);
+      straddle |= L::mask_lt(d, b.r);
+    }
+  }
+};
+
+struct aabb_bounds {
+  const_float3_soa_view c, e;
+
+  size_t size() const noexcept { return c.size; }
+
+  struct regs { reg x, y, z, ex, ey, ez; };
+
+  regs load(size_t i) const noexcept {
+    return {L::load(c.x + i), L::load(c.y + i), L::load(c.z + i), L::load(e.x + i), L::load(e.y + i), L::load(e.z + i)};
+  }
+
+  static void classify(const frustum& f, const regs& b, unsigned& outside, unsigned& straddle) noexcept {
+    outside = straddle = 0;
+    for (const float4& p : f.planes) {
+      reg nx = L::set1(p.x), ny = L::set1(p.y), nz = L::set1(p.z);
+      reg d = L::madd(nz, b.z, L::madd(ny, b.y, L::madd(nx, b.x, L::set1(p.w))));
+      reg r = L::madd(L::xor_sign(nz, nz), b.ez, L::madd(L::xor_sign(ny, ny), b.ey, L::mul(L::xor_sign(nx, nx), b.ex)));
+      outside |= L::mask_lt(d, L::sub(L::zero(), r));
+      straddle |= L::mask_lt(d, r);
+    }
+  }
+};
+
+constexpr unsigned ALL_LANES = (1u << L::width) - 1;
+
+template <typename B>
+size_t classify_all(const frustum& view, const B& bounds, cull_result* out) noexcept {
+  const frustum f = view;
+  const size_t n = bounds.size();
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    unsigned outside, straddle;
+    B::classify(f, bounds.load(i), outside, straddle);
+    for (size_t k = 0; k < L::width; ++k) {
+      out[i + k] = (outside >> k) & 1 ? cull_result::outside
+                 : (straddle >> k) & 1 ? cull_result::intersect
+                 : cull_result::inside;
+    }
+  }
+  return i;
+}
+
+template <typename B>
+size_t cull_indices(const frustum& view, const B& bounds, uint32_t* visible, size_t& count) noexcept {
+  const frustum f = view;
+  const size_t n = bounds.size();
+  size_t i = 0;
+  count = 0;
+  for (; i + L::width <= n; i += L::width) {
+    unsigned outside, straddle;
+    B::classify(f, bounds.load(i), outside, straddle);
+    for (unsigned m = ~outside & ALL_LANES; m; m &= m - 1) visible[count++] = static_cast<uint32_t>(i + lowest_bit(m));
+  }
+  return i;
+}
+
+// width divides 64, so every step lands inside a single mask word
+template <typename B>
+size_t cull_masks(const frustum* views, size_t view_count, const B& bounds, uint64_t* const* masks) noexcept {
+  const size_t n = bounds.size();
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    const auto b = bounds.load(i);
+    for (size_t v = 0; v < view_count; ++v) {
+      unsigned outside, straddle;
+      B::classify(views[v], b, outside, straddle);
+      masks[v][i / 64] |= uint64_t(~outside & ALL_LANES) << (i % 64);
+    }
+  }
+  return i;
+}
+
+size_t classify_spheres(const frustum& f, const_float4_soa_view s, cull_result* out) noexcept {
+  return classify_all(f, sphere_bounds{s}, out);
+}
+
+size_t classify_aabbs(const frustum& f, const_float3_soa_view c, const_float3_soa_view e, cull_result* out) noexcept {
+  return classify_all(f, aabb_bounds{c, e}, out);
+}
+
+size_t cull_spheres(const frustum& f, const_float4_soa_view s, uint32_t* visible, size_t& count) noexcept {
+  return cull_indices(f, sphere_bounds{s}, visible, count);
+}
+
+size_t cull_aabbs(const frustum& f, const_float3_soa_view c, const_float3_soa_view e, uint32_t* visible,
+                  size_t& count) noexcept {
+  return cull_indices(f, aabb_bounds{c, e}, visible, count);
+}
+
+size_t cull_sphere_masks(const frustum* views, size_t view_count, const_float4_soa_view s,
+                         uint64_t* const* masks) noexcept {
+  return cull_masks(views, view_count, sphere_bounds{s}, masks);
+}
+
+size_t cull_aabb_masks(const frustum* views, size_t view_count, const_float3_soa_view c, const_float3_soa_view e,
+                       uint64_t* const* masks) noexcept {
+  return cull_masks(views, view_count, aabb_bounds{c, e}, masks);
+}
+
+// half.cpp
+
+#if defined(__AVX512F__)
+
+size_t float_to_half(const float* in, uint16_t* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), h);
+  }
+  return i;
+}
+
+size_t half_to_float(const uint16_t* in, float* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(out + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))));
+  }
+  return i;
+}
+
+#elif defined(__F16C__)
+
+size_t float_to_half(const float* in, uint16_t* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+  }
+  return i;
+}
+
+size_t half_to_float(const uint16_t* in, float* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+  }
+  return i;
+}
+
+#elif defined(__SSE2__)
+
+// The scalar conversions of half.h on four 32-bit lanes, with the branches turned into selects
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b) noexcept {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline __m128i set1(uint32_t v) noexcept { return _mm_set1_epi32(static_cast<int>(v)); }
+
+// Halves in the low 16 bits of each lane
+inline __m128i float_to_half4(__m128 v) noexcept {
+  const __m128i sign = _mm_and_si128(_mm_castps_si128(v), set1(0x80000000));
+  const __m128i f = _mm_xor_si128(_mm_castps_si128(v), sign);
+
+  const __m128i nan = _mm_cmpgt_epi32(f, set1(0x7f800000));
+  const __m128i overflow = _mm_cmpgt_epi32(f, set1(0x477fefff));  // inf and NaN too
+  const __m128i below_normal = _mm_cmplt_epi32(f, set1(0x38800000));
+
+  const __m128i mantissa = _mm_and_si128(_mm_srli_epi32(f, 13), set1(0x3ff));
+  const __m128i inf_nan = _mm_or_si128(set1(0x7c00), _mm_and_si128(nan, _mm_or_si128(set1(0x200), mantissa)));
+
+  const __m128 aligned = _mm_add_ps(_mm_castsi128_ps(f), _mm_set1_ps(0.5f));
+  const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(aligned), set1(0x3f000000));
+
+  const __m128i odd = _mm_and_si128(_mm_srli_epi32(f, 13), set1(1));
+  const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(f, set1(0xc8000fff)), odd), 13);
+
+  const __m128i r = select(overflow, inf_nan, select(below_normal, subnormal, normal));
+  return _mm_or_si128(r, _mm_srli_epi32(sign, 16));
+}
+
+// Takes halves zero-extended to 32 bits
+inline __m128 half4_to_float(__m128i h) noexcept {
+  __m128i f = _mm_slli_epi32(_mm_and_si128(h, set1(0x7fff)), 13);
+  const __m128i exponent = _mm_and_si128(f, set1(0x0f800000));
+  f = _mm_add_epi32(f, set1(0x38000000));
+
+  const __m128i inf_nan = _mm_cmpeq_epi32(exponent, set1(0x0f800000));
+  const __m128i zero_mantissa = _mm_cmpeq_epi32(_mm_and_si128(h, set1(0x3ff)), _mm_setzero_si128());
+  f = _mm_add_epi32(f, _mm_and_si128(inf_nan, set1(0x38000000)));
+  f = _mm_or_si128(f, _mm_and_si128(_mm_andnot_si128(zero_mantissa, inf_nan), set1(0x00400000)));
+
+  // Zero and subnormals: renormalize as 2^-14 * (1 + m / 1024) and take 2^-14 away again
+  const __m128 renormalized = _mm_castsi128_ps(_mm_add_epi32(f, set1(0x00800000)));
+  const __m128i subnormal = _mm_castps_si128(_mm_sub_ps(renormalized, _mm_set1_ps(6.103515625e-05f)));
+  f = select(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()), subnormal, f);
+
+  return _mm_castsi128_ps(_mm_or_si128(f, _mm_slli_epi32(_mm_and_si128(h, set1(0x8000)), 16)));
+}
+
+// Sign-extends the low 16 bits first so the signed saturating pack keeps them as they are
+inline __m128i pack_halves(__m128i a, __m128i b) noexcept {
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+}
+
+size_t float_to_half(const float* in, uint16_t* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = pack_halves(float_to_half4(_mm_loadu_ps(in + i)), float_to_half4(_mm_loadu_ps(in + i + 4)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+  }
+  return i;
+}
+
+size_t half_to_float(const uint16_t* in, float* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm_storeu_ps(out + i, half4_to_float(_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+    _mm_storeu_ps(out + i + 4, half4_to_float(_mm_unpackhi_epi16(h, _mm_setzero_si128())));
+  }
+  return i;
+}
+
+#else
+
+size_t float_to_half(const float*, uint16_t*, size_t) noexcept { return 0; }
+size_t half_to_float(const uint16_t*, float*, size_t) noexcept { return 0; }
+
+#endif
+
+// camera_relative.cpp
+
+#if defined(__AVX512F__)
+
+struct double_lanes {
+  using reg = __m512d;
+  static constexpr size_t width = 8;
+  static reg load(const double* p) noexcept { return _mm512_loadu_pd(p); }
+  static reg sub(reg a, reg b) noexcept { return _mm512_sub_pd(a, b); }
+  static void store_float(float* p, reg v) noexcept { _mm256_storeu_ps(p, _mm512_cvtpd_ps(v)); }
+};
+
+#elif defined(__AVX__)
+
+struct double_lanes {
+  using reg = __m256d;
+  static constexpr size_t width = 4;
+  static reg load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+  static reg sub(reg a, reg b) noexcept { return _mm256_sub_pd(a, b); }
+  static void store_float(float* p, reg v) noexcept { _mm_storeu_ps(p, _mm256_cvtpd_ps(v)); }
+};
+
+#elif defined(__SSE2__)
+
+// Register pairs, so that each store writes four whole floats
+struct double_lanes {
+  struct reg { __m128d lo, hi; };
+  static constexpr size_t width = 4;
+  static reg load(const double* p) noexcept { return {_mm_loadu_pd(p), _mm_loadu_pd(p + 2)}; }
+  static reg sub(reg a, reg b) noexcept { return {_mm_sub_pd(a.lo, b.lo), _mm_sub_pd(a.hi, b.hi)}; }
+  static void store_float(float* p, reg v) noexcept {
+    _mm_storeu_ps(p, _mm_movelh_ps(_mm_cvtpd_ps(v.lo), _mm_cvtpd_ps(v.hi)));
+  }
+};
+
+#endif
+
+#ifdef __SSE2__
+
+// N registers hold `width` whole elements, so the origin repeats with the same N-register
+// pattern and the packed data needs no shuffles
+template <size_t N>
+size_t to_float_relative_n(const double* in, const double* origin, float* out, size_t n) noexcept {
+  using D = double_lanes;
+  double pattern[N * D::width];
+  for (size_t k = 0; k < N * D::width; ++k) pattern[k] = origin[k % N];
+  typename D::reg o[N];
+  for (size_t r = 0; r < N; ++r) o[r] = D::load(pattern + r * D::width);
+
+  size_t i = 0;
+  for (; i + D::width <= n; i += D::width) {
+    const double* src = in + i * N;
+    float* dst = out + i * N;
+    for (size_t r = 0; r < N; ++r) D::store_float(dst + r * D::width, D::sub(D::load(src + r * D::width), o[r]));
+  }
+  return i;
+}
+
+size_t to_float_relative(const double* in, const double* origin, size_t components, float* out, size_t n) noexcept {
+  return components == 3 ? to_float_relative_n<3>(in, origin, out, n) : to_float_relative_n<4>(in, origin, out, n);
+}
+
+#else
+
+size_t to_float_relative(const double*, const double*, size_t, float*, size_t) noexcept { return 0; }
+
+#endif
+
+// vertex_codec.cpp
+
+#ifdef __SSE2__
+
+using ireg = L::ireg;
+
+// Clamped and rounded to nearest even, as detail::quantize
+inline ireg quantize(reg v, float lo, float hi) noexcept { return L::to_int(L::min(L::max(v, L::set1(lo)), L::set1(hi))); }
+
+template <int Bits>
+inline ireg octahedral_words(reg x, reg y, reg z) noexcept {
+  constexpr float M = float((1 << (Bits - 1)) - 1);
+  const reg one = L::set1(1.0f);
+  const reg inv = L::div(one, L::add(L::add(L::abs(x), L::abs(y)), L::abs(z)));
+  reg px = L::mul(x, inv);
+  reg py = L::mul(y, inv);
+  const auto lower = L::lt(z, L::zero());
+  const reg fx = L::xor_sign(L::sub(one, L::abs(py)), px);
+  const reg fy = L::xor_sign(L::sub(one, L::abs(px)), py);
+  px = L::select(lower, fx, px);
+  py = L::select(lower, fy, py);
+  const ireg bias = L::iset1(int32_t(M));
+  const ireg ux = L::iadd(quantize(L::mul(px, L::set1(M)), -M, M), bias);
+  const ireg uy = L::iadd(quantize(L::mul(py, L::set1(M)), -M, M), bias);
+  return L::ior(ux, L::shl<Bits>(uy));
+}
+
+template <int Bits>
+inline void octahedral_vectors(ireg words, reg& x, reg& y, reg& z) noexcept {
+  constexpr float M = float((1 << (Bits - 1)) - 1);
+  const ireg mask = L::iset1((1 << Bits) - 1);
+  const reg one = L::set1(1.0f);
+  x = L::mul(L::sub(L::to_float(L::iand(words, mask)), L::set1(M)), L::set1(1.0f / M));
+  y = L::mul(L::sub(L::to_float(L::iand(L::shr<Bits>(words), mask)), L::set1(M)), L::set1(1.0f / M));
+  z = L::sub(L::sub(one, L::abs(x)), L::abs(y));
+  const reg t = L::max(L::sub(L::zero(), z), L::zero());
+  x = L::sub(x, L::xor_sign(t, x));
+  y = L::sub(y, L::xor_sign(t, y));
+  const reg length = L::sqrt(L::madd(x, x, L::madd(y, y, L::mul(z, z))));
+  x = L::div(x, length);
+  y = L::div(y, length);
+  z = L::div(z, length);
+}
+
+// 2, 3 or 4 bytes per vector; the 3-byte form goes through a word buffer
+template <int Bits>
+size_t encode_octahedral_n(const float* in, uint8_t* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg x, y, z;
+    L::load_xyz(in + 3 * i, x, y, z);
+    const ireg words = octahedral_words<Bits>(x, y, z);
+    uint8_t* dst = out + Bits / 4 * i;
+    if constexpr (Bits == 8) {
+      L::store_16(dst, words);
+    } else if constexpr (Bits == 16) {
+      L::istore(reinterpret_cast<uint32_t*>(dst), words);
+    } else {
+      alignas(64) uint32_t buffer[L::width];
+      L::istore(buffer, words);
+      // Overlapping 4-byte stores, each top byte overwritten by the next word; the last word
+      // is written bytewise so nothing lands past the end of the vector
+      for (size_t k = 0; k + 1 < L::width; ++k) std::memcpy(dst + 3 * k, buffer + k, 4);
+      const uint32_t last = buffer[L::width - 1];
+      dst[3 * L::width - 3] = uint8_t(last);
+      dst[3 * L::width - 2] = uint8_t(last >> 8);
+      dst[3 * L::width - 1] = uint8_t(last >> 16);
+    }
+  }
+  return i;
+}
+
+template <int Bits>
+size_t decode_octahedral_n(const uint8_t* in, float* out, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    const uint8_t* src = in + Bits / 4 * i;
+    ireg words;
+    if constexpr (Bits == 8) {
+      words = L::load_u16(reinterpret_cast<const uint16_t*>(src));
+    } else if constexpr (Bits == 16) {
+      words = L::iload(reinterpret_cast<const uint32_t*>(src));
+    } else {
+      alignas(64) uint32_t buffer[L::width];
+      // The stray top byte of the 4-byte loads is masked off with the fields
+      for (size_t k = 0; k + 1 < L::width; ++k) std::memcpy(buffer + k, src + 3 * k, 4);
+      const uint8_t* last = src + 3 * L::width - 3;
+      buffer[L::width - 1] = last[0] | (uint32_t(last[1]) << 8) | (uint32_t(last[2]) << 16);
+      words = L::iload(buffer);
+    }
+    reg x, y, z;
+    octahedral_vectors<Bits>(words, x, y, z);
+    L::store_xyz<false>(out + 3 * i, x, y, z);
+  }
+  return i;
+}
+
+size_t encode_octahedral(const float* in, int bits, void* out, size_t n) noexcept {
+  uint8_t* dst = static_cast<uint8_t*>(out);
+  if (bits == 8) return encode_octahedral_n<8>(in, dst, n);
+  if (bits == 12) return encode_octahedral_n<12>(in, dst, n);
+  return encode_octahedral_n<16>(in, dst, n);
+}
+
+size_t decode_octahedral(const void* in, int bits, float* out, size_t n) noexcept {
+  const uint8_t* src = static_cast<const uint8_t*>(in);
+  if (bits == 8) return decode_octahedral_n<8>(src, out, n);
+  if (bits == 12) return decode_octahedral_n<12>(src, out, n);
+  return decode_octahedral_n<16>(src, out, n);
+}
+
+// The components run x y z x y z ..., so three registers of repeated offsets and scales line
+// up with every three registers of input, as in to_float_relative
+inline void fixed3_pattern(const float* v, reg* r) noexcept {
+  alignas(64) float pattern[3 * L::width];
+  for (size_t k = 0; k < 3 * L::width; ++k) pattern[k] = v[k % 3];
+  for (size_t j = 0; j < 3; ++j) r[j] = L::load(pattern + j * L::width);
+}
+
+template <fixed_format F>
+size_t encode_fixed3_n(const float* in, const float* offset, const float* scale, uint8_t* out, size_t n) noexcept {
+  constexpr float hi = F == fixed_format::unorm16 ? 65535.0f : F == fixed_format::snorm16 ? 32767.0f : 127.0f;
+  constexpr float lo = F == fixed_format::unorm16 ? 0.0f : -hi;
+  constexpr size_t size = F == fixed_format::snorm8 ? 1 : 2;
+  reg o[3], s[3];
+  fixed3_pattern(offset, o);
+  fixed3_pattern(scale, s);
+
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    for (size_t j = 0; j < 3; ++j) {
+      const size_t k = 3 * i + j * L::width;
+      const ireg q = quantize(L::mul(L::sub(L::load(in + k), o[j]), s[j]), lo, hi);
+      if constexpr (size == 1) {
+        L::store_8(out + k, q);
+      } else {
+        L::store_16(out + 2 * k, q);
+      }
+    }
+  }
+  return i;
+}
+
+template <fixed_format F>
+size_t decode_fixed3_n(const uint8_t* in, const float* offset, const float* scale, float* out, size_t n) noexcept {
+  reg o[3], s[3];
+  fixed3_pattern(offset, o);
+  fixed3_pattern(scale, s);
+
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    for (size_t j = 0; j < 3; ++j) {
+      const size_t k = 3 * i + j * L::width;
+      ireg q;
+      if constexpr (F == fixed_format::unorm16) {
+        q = L::load_u16(reinterpret_cast<const uint16_t*>(in + 2 * k));
+      } else if constexpr (F == fixed_format::snorm16) {
+        q = L::load_i16(reinterpret_cast<const int16_t*>(in + 2 * k));
+      } else {
+        q = L::load_i8(reinterpret_cast<const int8_t*>(in + k));
+      }
+      L::store(out + k, L::madd(L::to_float(q), s[j], o[j]));
+    }
+  }
+  return i;
+}
+
+size_t encode_fixed3(const float* in, fixed_format format, const float* offset, const float* scale, void* out,
+                     size_t n) noexcept {
+  uint8_t* dst = static_cast<uint8_t*>(out);
+  switch (format) {
+    case fixed_format::unorm16: return encode_fixed3_n<fixed_format::unorm16>(in, offset, scale, dst, n);
+    case fixed_format::snorm16: return encode_fixed3_n<fixed_format::snorm16>(in, offset, scale, dst, n);
+    case fixed_format::snorm8: return encode_fixed3_n<fixed_format::snorm8>(in, offset, scale, dst, n);
+  }
+  return 0;
+}
+
+size_t decode_fixed3(const void* in, fixed_format format, const float* offset, const float* scale, float* out,
+                     size_t n) noexcept {
+  const uint8_t* src = static_cast<const uint8_t*>(in);
+  switch (format) {
+    case fixed_format::unorm16: return decode_fixed3_n<fixed_format::unorm16>(src, offset, scale, out, n);
+    case fixed_format::snorm16: return decode_fixed3_n<fixed_format::snorm16>(src, offset, scale, out, n);
+    case fixed_format::snorm8: return decode_fixed3_n<fixed_format::snorm8>(src, offset, scale, out, n);
+  }
+  return 0;
+}
+
+// packed_quaternion with the component choice turned into selects, the last of equal
+// magnitudes winning like the scalar loop
+size_t encode_quaternions(const float* in, uint32_t* out, size_t n) noexcept {
+  constexpr float M = 511.0f;
+  const reg scale = L::set1(1.41421356237309504880f * M);
+  const ireg bias = L::iset1(int32_t(M));
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg x, y, z, w;
+    L::load_xyzw(in + 4 * i, x, y, z, w);
+    const reg ax = L::abs(x), ay = L::abs(y), az = L::abs(z), aw = L::abs(w);
+    const reg largest = L::max(L::max(ax, ay), L::max(az, aw));
+    const auto is_w = L::eq(aw, largest), is_z = L::eq(az, largest), is_y = L::eq(ay, largest);
+    const reg index = L::select(is_w, L::set1(3.0f), L::select(is_z, L::set1(2.0f), L::select(is_y, L::set1(1.0f), L::zero())));
+    const reg sign = L::select(is_w, w, L::select(is_z, z, L::select(is_y, y, x)));
+
+    const reg a = L::select(L::lt(index, L::set1(0.5f)), y, x);
+    const reg b = L::select(L::lt(index, L::set1(1.5f)), z, y);
+    const reg c = L::select(L::lt(index, L::set1(2.5f)), w, z);
+    const ireg qa = L::iadd(quantize(L::mul(L::xor_sign(a, sign), scale), -M, M), bias);
+    const ireg qb = L::iadd(quantize(L::mul(L::xor_sign(b, sign), scale), -M, M), bias);
+    const ireg qc = L::iadd(quantize(L::mul(L::xor_sign(c, sign), scale), -M, M), bias);
+    const ireg words = L::ior(L::ior(L::shl<30>(L::to_int(index)), L::shl<20>(qa)), L::ior(L::shl<10>(qb), qc));
+    L::istore(out + i, words);
+  }
+  return i;
+}
+
+size_t decode_quaternions(const uint32_t* in, float* out, size_t n) noexcept {
+  constexpr float M = 511.0f;
+  const ireg mask = L::iset1(1023);
+  const reg bias = L::set1(M);
+  const reg scale = L::set1(1.0f / (1.41421356237309504880f * M));
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    const ireg words = L::iload(in + i);
+    const reg index = L::to_float(L::shr<30>(words));
+    const reg a = L::mul(L::sub(L::to_float(L::iand(L::shr<20>(words), mask)), bias), scale);
+    const reg b = L::mul(L::sub(L::to_float(L::iand(L::shr<10>(words), mask)), bias), scale);
+    const reg c = L::mul(L::sub(L::to_float(L::iand(words, mask)), bias), scale);
+    const reg d = L::sqrt(L::max(L::sub(L::set1(1.0f), L::madd(a, a, L::madd(b, b, L::mul(c, c)))), L::zero()));
+
+    const auto is_x = L::eq(index, L::zero()), is_y = L::eq(index, L::set1(1.0f));
+    const auto is_z = L::eq(index, L::set1(2.0f)), is_w = L::eq(index, L::set1(3.0f));
+    const reg x = L::select(is_x, d, a);
+    const reg y = L::select(is_x, a, L::select(is_y, d, b));
+    const reg z = L::select(L::lt(index, L::set1(1.5f)), b, L::select(is_z, d, c));
+    const reg w = L::select(is_w, d, c);
+    L::store_xyzw(out + 4 * i, x, y, z, w);
+  }
+  return i;
+}
+
+size_t encode_rgb10a2(const float* in, uint32_t* out, size_t n) noexcept {
+  const reg scale = L::set1(1023.0f);
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg r, g, b, a;
+    L::load_xyzw(in + 4 * i, r, g, b, a);
+    const ireg qr = quantize(L::mul(r, scale), 0.0f, 1023.0f);
+    const ireg qg = quantize(L::mul(g, scale), 0.0f, 1023.0f);
+    const ireg qb = quantize(L::mul(b, scale), 0.0f, 1023.0f);
+    const ireg qa = quantize(L::mul(a, L::set1(3.0f)), 0.0f, 3.0f);
+    L::istore(out + i, L::ior(L::ior(qr, L::shl<10>(qg)), L::ior(L::shl<20>(qb), L::shl<30>(qa))));
+  }
+  return i;
+}
+
+size_t decode_rgb10a2(const uint32_t* in, float* out, size_t n) noexcept {
+  const ireg mask = L::iset1(1023);
+  const reg scale = L::set1(1.0f / 1023.0f);
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    const ireg words = L::iload(in + i);
+    const reg r = L::mul(L::to_float(L::iand(words, mask)), scale);
+    const reg g = L::mul(L::to_float(L::iand(L::shr<10>(words), mask)), scale);
+    const reg b = L::mul(L::to_float(L::iand(L::shr<20>(words), mask)), scale);
+    const reg a = L::mul(L::to_float(L::shr<30>(words)), L::set1(1.0f / 3.0f));
+    L::store_xyzw(out + 4 * i, r, g, b, a);
+  }
+  return i;
+}
+
+#else
+
+size_t encode_octahedral(const float*, int, void*, size_t) noexcept { return 0; }
+size_t decode_octahedral(const void*, int, float*, size_t) noexcept { return 0; }
+size_t encode_fixed3(const float*, fixed_format, const float*, const float*, void*, size_t) noexcept { return 0; }
+size_t decode_fixed3(const void*, fixed_format, const float*, const float*, float*, size_t) noexcept { return 0; }
+size_t encode_quaternions(const float*, uint32_t*, size_t) noexcept { return 0; }
+size_t decode_quaternions(const uint32_t*, float*, size_t) noexcept { return 0; }
+size_t encode_rgb10a2(const float*, uint32_t*, size_t) noexcept { return 0; }
+size_t decode_rgb10a2(const uint32_t*, float*, size_t) noexcept { return 0; }
+
+#endif
+
+// morton.cpp
+
+#ifdef __SSE2__
+
+// Cells of [offset, offset + 2^21 / scale), clamped like morton.cpp's scalar tail
+inline ireg curve_cells(reg v, reg offset, reg scale) noexcept {
+  return L::truncate(L::min(L::max(L::mul(L::sub(v, offset), scale), L::zero()), L::set1(2097151.0f)));
+}
+
+// detail::spread_by_2 on 64-bit lanes
+inline ireg spread_by_2(ireg x) noexcept {
+  x = L::iand(L::ior(x, L::qshl<32>(x)), L::qset1(0x001f00000000ffffull));
+  x = L::iand(L::ior(x, L::qshl<16>(x)), L::qset1(0x001f0000ff0000ffull));
+  x = L::iand(L::ior(x, L::qshl<8>(x)), L::qset1(0x100f00f00f00f00full));
+  x = L::iand(L::ior(x, L::qshl<4>(x)), L::qset1(0x10c30c30c30c30c3ull));
+  return L::iand(L::ior(x, L::qshl<2>(x)), L::qset1(0x1249249249249249ull));
+}
+
+// Interleaves 21-bit x, y and z lanes into L::width keys, x in the lowest bit
+inline void store_morton(uint64_t* out, ireg x, ireg y, ireg z) noexcept {
+  ireg xl, xh, yl, yh, zl, zh;
+  L::widen(x, xl, xh);
+  L::widen(y, yl, yh);
+  L::widen(z, zl, zh);
+  L::qstore(out, L::ior(L::ior(spread_by_2(xl), L::qshl<1>(spread_by_2(yl))), L::qshl<2>(spread_by_2(zl))));
+  L::qstore(out + L::width / 2,
+            L::ior(L::ior(spread_by_2(xh), L::qshl<1>(spread_by_2(yh))), L::qshl<2>(spread_by_2(zh))));
+}
+
+size_t morton_keys3(const float* in, const float* offset, const float* scale, uint64_t* out, size_t n) noexcept {
+  const reg ox = L::set1(offset[0]), oy = L::set1(offset[1]), oz = L::set1(offset[2]);
+  const reg sx = L::set1(scale[0]), sy = L::set1(scale[1]), sz = L::set1(scale[2]);
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg x, y, z;
+    L::load_xyz(in + 3 * i, x, y, z);
+    store_morton(out + i, curve_cells(x, ox, sx), curve_cells(y, oy, sy), curve_cells(z, oz, sz));
+  }
+  return i;
+}
+
+// One exchange-or-invert step of hilbert_encode for bit K of xi, without branches: the lanes
+// with the bit set invert the low bits of x0, the others swap them with xi
+template <int K>
+inline void hilbert_exchange(ireg& x0, ireg& xi, ireg low) noexcept {
+  const ireg set = L::sra<31>(L::shl<31 - K>(xi));
+  const ireg t = L::iandnot(set, L::iand(L::ixor(x0, xi), low));
+  x0 = L::ixor(x0, L::ior(L::iand(set, low), t));
+  xi = L::ixor(xi, t);
+}
+
+template <int K>
+inline void hilbert_undo(ireg& x0, ireg& x1, ireg& x2) noexcept {
+  if constexpr (K > 0) {
+    const ireg low = L::iset1((1 << K) - 1);
+    x0 = L::ixor(x0, L::iand(L::sra<31>(L::shl<31 - K>(x0)), low));
+    hilbert_exchange<K>(x0, x1, low);
+    hilbert_exchange<K>(x0, x2, low);
+    hilbert_undo<K - 1>(x0, x1, x2);
+  }
+}
+
+size_t hilbert_keys3(const float* in, const float* offset, const float* scale, uint64_t* out, size_t n) noexcept {
+  const reg ox = L::set1(offset[0]), oy = L::set1(offset[1]), oz = L::set1(offset[2]);
+  const reg sx = L::set1(scale[0]), sy = L::set1(scale[1]), sz = L::set1(scale[2]);
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg x, y, z;
+    L::load_xyz(in + 3 * i, x, y, z);
+    ireg x0 = curve_cells(x, ox, sx), x1 = curve_cells(y, oy, sy), x2 = curve_cells(z, oz, sz);
+    hilbert_undo<20>(x0, x1, x2);
+
+    // Gray encode; bit j of t is the parity of the bits of x2 above j
+    x1 = L::ixor(x1, x0);
+    x2 = L::ixor(x2, x1);
+    ireg t = L::shr<1>(x2);
+    t = L::ixor(t, L::shr<1>(t));
+    t = L::ixor(t, L::shr<2>(t));
+    t = L::ixor(t, L::shr<4>(t));
+    t = L::ixor(t, L::shr<8>(t));
+    t = L::ixor(t, L::shr<16>(t));
+    store_morton(out + i, L::ixor(x2, t), L::ixor(x1, t), L::ixor(x0, t));
+  }
+  return i;
+}
+
+#else
+
+size_t morton_keys3(const float*, const float*, const float*, uint64_t*, size_t) noexcept { return 0; }
+size_t hilbert_keys3(const float*, const float*, const float*, uint64_t*, size_t) noexcept { return 0; }
+
+#endif
+
+// decomposition.cpp
+
+#ifdef __SSE2__
+
+using mat3 = decomposition_detail::mat3<L>;
+
+inline mat3 load_mat3(const float* const* m, size_t i) noexcept {
+  mat3 r;
+  for (int k = 0; k < 9; ++k) r.m[k / 3][k % 3] = L::load(m[k] + i);
+  return r;
+}
+
+inline void store_mat3(float* const* out, size_t i, const mat3& m) noexcept {
+  for (int k = 0; k < 9; ++k) L::store(out[k] + i, m.m[k / 3][k % 3]);
+}
+
+size_t eigen3x3(const float* const* m, float* const* values, float* const* vectors, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg w[3];
+    mat3 e;
+    decomposition_detail::eigen_symmetric<L>(load_mat3(m, i), w, e);
+    for (int k = 0; k < 3; ++k) L::store(values[k] + i, w[k]);
+    store_mat3(vectors, i, e);
+  }
+  return i;
+}
+
+size_t svd3x3(const float* const* m, float* const* u, float* const* sigma, float* const* v, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    reg s[3];
+    mat3 a, b;
+    decomposition_detail::svd<L>(load_mat3(m, i), a, s, b);
+    store_mat3(u, i, a);
+    for (int k = 0; k < 3; ++k) L::store(sigma[k] + i, s[k]);
+    store_mat3(v, i, b);
+  }
+  return i;
+}
+
+size_t polar3x3(const float* const* m, float* const* rotation, float* const* stretch, size_t n) noexcept {
+  size_t i = 0;
+  for (; i + L::width <= n; i += L::width) {
+    mat3 r, s;
+    decomposition_detail::polar<L>(load_mat3(m, i), r, s);
+    store_mat3(rotation, i, r);
+    store_mat3(stretch, i, s);
+  }
+  return i;
+}
+
+#else
+
+size_t eigen3x3(const float* const*, float* const*, float* const*, size_t) noexcept { return 0; }
+size_t svd3x3(const float* const*, float* const*, float* const*, float* const*, size_t) noexcept { return 0; }
+size_t polar3x3(const float* const*, float* const*, float* const*, size_t) noexcept { return 0; }
+
+#endif
+
+// ray_packet.cpp
+
+// The single ray tests of bvh.cpp, over whole registers of a packet. 8-ray packets take the
+// 8-wide lanes when the native ones are 16 wide.
+constexpr float PACKET_DET_EPSILON = 1e-12f;
+constexpr int PACKET_STACK_SIZE = 128;
+
+template <size_t N> struct packet_lanes { using type = L; };
+#if defined(__AVX512F__)
+template <> struct packet_lanes<8> { using type = lanes::avx2; };
+#endif
+
+template <size_t N>
+uint32_t triangle_packet(ray_packet<N>& r, const bvh_triangle& tri, uint32_t primitive, packet_hit<N>& hit) noexcept {
+  using P = typename packet_lanes<N>::type;
+  using preg = typename P::reg;
+  static_assert(N % P::width == 0, "packets are whole registers");
+  const preg e1x = P::set1(tri.e1.x), e1y = P::set1(tri.e1.y), e1z = P::set1(tri.e1.z);
+  const preg e2x = P::set1(tri.e2.x), e2y = P::set1(tri.e2.y), e2z = P::set1(tri.e2.z);
+  const preg zero = P::zero(), one = P::set1(1.0f), eps = P::set1(PACKET_DET_EPSILON);
+  uint32_t result = 0;
+  for (size_t k = 0; k < N; k += P::width) {
+    preg dx = P::load(r.dx + k), dy = P::load(r.dy + k), dz = P::load(r.dz + k);
+    preg px = P::sub(P::mul(dy, e2z), P::mul(dz, e2y));
+    preg py = P::sub(P::mul(dz, e2x), P::mul(dx, e2z));
+    preg pz = P::sub(P::mul(dx, e2y), P::mul(dy, e2x));
+    preg det = P::madd(e1z, pz, P::madd(e1y, py, P::mul(e1x, px)));
+    preg inv_det = P::div(one, det);
+    preg sx = P::sub(P::load(r.ox + k), P::set1(tri.v0.x));
+    preg sy = P::sub(P::load(r.oy + k), P::set1(tri.v0.y));
+    preg sz = P::sub(P::load(r.oz + k), P::set1(tri.v0.z));
+    preg u = P::mul(P::madd(sz, pz, P::madd(sy, py, P::mul(sx, px))), inv_det);
+    preg qx = P::sub(P::mul(sy, e1z), P::mul(sz, e1y));
+    preg qy = P::sub(P::mul(sz, e1x), P::mul(sx, e1z));
+    preg qz = P::sub(P::mul(sx, e1y), P::mul(sy, e1x));
+    preg v = P::mul(P::madd(dz, qz, P::madd(dy, qy, P::mul(dx, qx))), inv_det);
+    preg t = P::mul(P::madd(e2z, qz, P::madd(e2y, qy, P::mul(e2x, qx))), inv_det);
+
+    unsigned reject = P::mask_lt(u, zero) | P::mask_lt(v, zero) | P::mask_lt(one, P::add(u, v)) |
+                      P::mask_lt(t, P::load(r.t_min + k)) | P::mask_lt(P::load(r.t_max + k), t);
+    unsigned m = P::mask_lt(eps, P::xor_sign(det, det)) & ~reject;
+    if (!m) continue;
+
+    alignas(64) float ts[P::width], us[P::width], vs[P::width];
+    P::store(ts, t);
+    P::store(us, u);
+    P::store(vs, v);
+    for (unsigned bits = m; bits; bits &= bits - 1) {
+      const unsigned j = lowest_bit(bits);
+      hit.t[k + j] = r.t_max[k + j] = ts[j];
+      hit.u[k + j] = us[j];
+      hit.v[k + j] = vs[j];
+      hit.primitive[k + j] = primitive;
+    }
+    result |= uint32_t(m) << k;
+  }
+  return result;
+}
+
+// One axis of the slab test: widens [enter, exit] to [-inf, inf] where t0 or t1 is NaN, a ray
+// with a zero direction component starting on a face, which that axis does not limit
+template <typename P>
+inline void slab(typename P::reg t0, typename P::reg t1, typename P::reg& enter, typename P::reg& exit) noexcept {
+  const typename P::mask free = P::unordered(t0, t1);
+  enter = P::max(enter, P::select(free, P::set1(-INFINITY), P::min(t0, t1)));
+  exit = P::min(exit, P::select(free, P::set1(INFINITY), P::max(t0, t1)));
+}
+
+template <size_t N>
+uint32_t aabb_packet(const ray_packet<N>& r, const float3& min, const float3& max, float* t_enter) noexcept {
+  using P = typename packet_lanes<N>::type;
+  using preg = typename P::reg;
+  const preg minx = P::set1(min.x), miny = P::set1(min.y), minz = P::set1(min.z);
+  const preg maxx = P::set1(max.x), maxy = P::set1(max.y), maxz = P::set1(max.z);
+  uint32_t result = 0;
+  for (size_t k = 0; k < N; k += P::width) {
+    preg ox = P::load(r.ox + k), oy = P::load(r.oy + k), oz = P::load(r.oz + k);
+    preg ix = P::load(r.inv_dx + k), iy = P::load(r.inv_dy + k), iz = P::load(r.inv_dz + k);
+    preg enter = P::load(r.t_min + k), exit = P::load(r.t_max + k);
+    slab<P>(P::mul(P::sub(minx, ox), ix), P::mul(P::sub(maxx, ox), ix), enter, exit);
+    slab<P>(P::mul(P::sub(miny, oy), iy), P::mul(P::sub(maxy, oy), iy), enter, exit);
+    slab<P>(P::mul(P::sub(minz, oz), iz), P::mul(P::sub(maxz, oz), iz), enter, exit);
+    if (t_enter) P::store(t_enter + k, enter);
+    result |= uint32_t(~P::mask_lt(exit, enter) & ((1u << P::width) - 1)) << k;
+  }
+  return result;
+}
+
+// ray_packet.cpp's traversal on the arrays of a non-empty bvh
+template <size_t N, bool AnyHit>
+uint32_t traverse_packet(const bvh_node* nodes, const bvh_triangle* triangles, const uint32_t* primitives,
+                         ray_packet<N>& r, packet_hit<N>& hit) noexcept {
+  uint32_t result = 0;
+  uint32_t stack[PACKET_STACK_SIZE];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const bvh_node& node = nodes[stack[--top]];
+    const uint32_t active = aabb_packet(r, node.min, node.max, nullptr);
+    if (!active) continue;
+
+    if (node.count != 0) {
+      for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+        uint32_t m = triangle_packet(r, triangles[i], primitives[i], hit);
+        result |= m;
+        if constexpr (AnyHit) {
+          for (; m; m &= m - 1) {
+            const unsigned j = lowest_bit(m);
+            r.t_min[j] = INFINITY;
+            r.t_max[j] = -INFINITY;
+          }
+          bool any_active = false;
+          for (size_t k = 0; k < N; ++k) any_active |= r.t_min[k] <= r.t_max[k];
+          if (!any_active) return result;
+        }
+      }
+      continue;
+    }
+
+    const bvh_node& left = nodes[node.first];
+    const bvh_node& right = nodes[node.first + 1];
+    const unsigned k = lowest_bit(active);
+    const float sx = (right.min.x + right.max.x) - (left.min.x + left.max.x);
+    const float sy = (right.min.y + right.max.y) - (left.min.y + left.max.y);
+    const float sz = (right.min.z + right.max.z) - (left.min.z + left.max.z);
+    const bool left_first = sx * r.dx[k] + sy * r.dy[k] + sz * r.dz[k] >= 0.0f;
+    stack[top++] = left_first ? node.first + 1 : node.first;
+    stack[top++] = left_first ? node.first : node.first + 1;
+  }
+  return result;
+}
+
+size_t triangle_packet8(ray8& r, const bvh_triangle& tri, uint32_t primitive, hit8& hit, uint32_t& mask) noexcept {
+  mask |= triangle_packet(r, tri, primitive, hit);
+  return 8;
+}
+
+size_t triangle_packet16(ray16& r, const bvh_triangle& tri, uint32_t primitive, hit16& hit, uint32_t& mask) noexcept {
+  mask |= triangle_packet(r, tri, primitive, hit);
+  return 16;
+}
+
+size_t aabb_packet8(const ray8& r, const float3& min, const float3& max, float* t_enter, uint32_t& mask) noexcept {
+  mask |= aabb_packet(r, min, max, t_enter);
+  return 8;
+}
+
+size_t aabb_packet16(const ray16& r, const float3& min, const float3& max, float* t_enter, uint32_t& mask) noexcept {
+  mask |= aabb_packet(r, min, max, t_enter);
+  return 16;
+}
+
+size_t traverse_packet8(const bvh_node* nodes, const bvh_triangle* triangles, const uint32_t* primitives, ray8& r,
+                        hit8& hit, bool any_hit, uint32_t& mask) noexcept {
+  mask |= any_hit ? traverse_packet<8, true>(nodes, triangles, primitives, r, hit)
+                  : traverse_packet<8, false>(nodes, triangles, primitives, r, hit);
+  return 8;
+}
+
+size_t traverse_packet16(const bvh_node* nodes, const bvh_triangle* triangles, const uint32_t* primitives, ray16& r,
+                         hit16& hit, bool any_hit, uint32_t& mask) noexcept {
+  mask |= any_hit ? traverse_packet<16, true>(nodes, triangles, primitives, r, hit)
+                  : traverse_packet<16, false>(nodes, triangles, primitives, r, hit);
+  return 16;
+}
+
+} // namespace
+} // namespace CG_MATH_LANES_NAMESPACE
+
+const kernel_table CG_MATH_KERNEL_TABLE = {
+  CG_MATH_COMPILED_ISA,
+  lanes::native::align,
+  CG_MATH_LANES_NAMESPACE::aos_to_soa,
+  CG_MATH_LANES_NAMESPACE::soa_to_aos,
+  CG_MATH_LANES_NAMESPACE::dot,
+  CG_MATH_LANES_NAMESPACE::cross,
+  CG_MATH_LANES_NAMESPACE::length,
+  CG_MATH_LANES_NAMESPACE::normalize,
+  CG_MATH_LANES_NAMESPACE::lerp,
+  CG_MATH_LANES_NAMESPACE::clamp,
+  CG_MATH_LANES_NAMESPACE::transform_float3,
+  CG_MATH_LANES_NAMESPACE::transform_soa,
+  CG_MATH_LANES_NAMESPACE::transform_vector4,
+  CG_MATH_LANES_NAMESPACE::rotations_to_rows,
+  CG_MATH_LANES_NAMESPACE::nlerp,
+  CG_MATH_LANES_NAMESPACE::classify_spheres,
+  CG_MATH_LANES_NAMESPACE::classify_aabbs,
+  CG_MATH_LANES_NAMESPACE::cull_spheres,
+  CG_MATH_LANES_NAMESPACE::cull_aabbs,
+  CG_MATH_LANES_NAMESPACE::cull_sphere_masks,
+  CG_MATH_LANES_NAMESPACE::cull_aabb_masks,
+  CG_MATH_LANES_NAMESPACE::float_to_half,
+  CG_MATH_LANES_NAMESPACE::half_to_float,
+  CG_MATH_LANES_NAMESPACE::to_float_relative,
+  CG_MATH_LANES_NAMESPACE::encode_octahedral,
+  CG_MATH_LANES_NAMESPACE::decode_octahedral,
+  CG_MATH_LANES_NAMESPACE::encode_fixed3,
+  CG_MATH_LANES_NAMESPACE::decode_fixed3,
+  CG_MATH_LANES_NAMESPACE::encode_quaternions,
+  CG_MATH_LANES_NAMESPACE::decode_quaternions,
+  CG_MATH_LANES_NAMESPACE::encode_rgb10a2,
+  CG_MATH_LANES_NAMESPACE::decode_rgb10a2,
+  CG_MATH_LANES_NAMESPACE::morton_keys3,
+  CG_MATH_LANES_NAMESPACE::hilbert_keys3,
+  CG_MATH_LANES_NAMESPACE::eigen3x3,
+  CG_MATH_LANES_NAMESPACE::svd3x3,
+  CG_MATH_LANES_NAMESPACE::polar3x3,
+  CG_MATH_LANES_NAMESPACE::triangle_packet8,
+  CG_MATH_LANES_NAMESPACE::triangle_packet16,
+  CG_MATH_LANES_NAMESPACE::aabb_packet8,
+  CG_MATH_LANES_NAMESPACE::aabb_packet16,
+  CG_MATH_LANES_NAMESPACE::traverse_packet8,
+  CG_MATH_LANES_NAMESPACE::traverse_packet16,
+};
+
+} // namespace cgmath
@@ -0,0 +1,13 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+// Built with -msse4.1 when CG_MATH_DISPATCH is set, see CMakeLists.txt
+
+#include "pch.h"
+
+#ifdef CG_MATH_DISPATCH
+#define CG_MATH_LANES_NAMESPACE sse41
+#define CG_MATH_KERNEL_TABLE kernels_sse41
+#include "kernels_impl.h"
+#endif
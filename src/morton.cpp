@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "morton.h"
+#include "kernels.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace cgmath {
+
+namespace {
+
+// Elements below which another radix sort thread costs more than it saves
+constexpr size_t SORT_GRAIN = size_t(1) << 16;
+
+// One loop index per task, the chunks do not need to be cache lines apart
+parallel_options task_options(size_t thread_count) noexcept {
+  parallel_options o;
+  o.thread_count = thread_count;
+  o.grain = 1;
+  o.element_size = 0;
+  return o;
+}
+
+// Splits [0, n) into thread_count contiguous ranges and calls f(t, begin, end) for range t
+// in parallel. The ranges only depend on n and thread_count.
+template <typename F>
+void split_chunks(size_t n, size_t thread_count, F&& f) {
+  const size_t chunk = (n + thread_count - 1) / thread_count;
+  parallel_for(0, thread_count, [&](size_t first, size_t last) {
+    for (size_t t = first; t < last; ++t) f(t, std::min(t * chunk, n), std::min(t * chunk + chunk, n));
+  }, task_options(thread_count));
+}
+
+inline uint32_t curve_cell(float v, float offset, float scale) noexcept {
+  return static_cast<uint32_t>(fmin(fmax((v - offset) * scale, 0.0f), 2097151.0f));
+}
+
+using keys_kernel = size_t (*)(const float*, const float*, const float*, uint64_t*, size_t) noexcept;
+
+template <typename Encode>
+void curve_keys(keys_kernel kernel, Encode encode, const float3* points, size_t n, const float3& min, const float3& max,
+                uint64_t* keys) noexcept {
+  constexpr float cells = float(1u << MORTON3_BITS);
+  const float3 extent = max - min;
+  const float offset[3] = {min.x, min.y, min.z};
+  const float scale[3] = {extent.x > 0.0f ? cells / extent.x : 0.0f, extent.y > 0.0f ? cells / extent.y : 0.0f,
+                          extent.z > 0.0f ? cells / extent.z : 0.0f};
+  size_t i = kernel(&points->x, offset, scale, keys, n);
+  for (; i < n; ++i) {
+    keys[i] = encode(uint3(curve_cell(points[i].x, offset[0], scale[0]), curve_cell(points[i].y, offset[1], scale[1]),
+                           curve_cell(points[i].z, offset[2], scale[2])));
+  }
+}
+
+// Bits that differ between some of the keys
+uint64_t varying_bits(const uint64_t* keys, size_t n) noexcept {
+  uint64_t any = 0, all = ~uint64_t(0);
+  for (size_t i = 0; i < n; ++i) {
+    any |= keys[i];
+    all &= keys[i];
+  }
+  return any ^ all;
+}
+
+// Stable LSD passes over the bytes below `top` that vary within the bucket; the bucket
+// starts in (keys, values) and ends in (out_keys, out_values). The histograms of all the
+// bytes come from one read, a byte with all keys in one digit is skipped.
+void sort_bucket(uint64_t* keys, uint32_t* values, uint64_t* out_keys, uint32_t* out_values, size_t n,
+                 int top) noexcept {
+  if (n == 0) return;
+  const int passes = top / 8;
+  size_t counts[7][256] = {};
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t k = keys[i];
+    for (int p = 0; p < passes; ++p) ++counts[p][(k >> (8 * p)) & 0xff];
+  }
+
+  uint64_t* src_keys = keys;
+  uint32_t* src_values = values;
+  uint64_t* dst_keys = out_keys;
+  uint32_t* dst_values = out_values;
+  for (int p = 0; p < passes; ++p) {
+    const int shift = 8 * p;
+    size_t* offsets = counts[p];
+    if (offsets[(keys[0] >> shift) & 0xff] == n) continue;
+    size_t sum = 0;
+    for (size_t digit = 0; digit < 256; ++digit) {
+      const size_t c = offsets[digit];
+      offsets[digit] = sum;
+      sum += c;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      const size_t j = offsets[(src_keys[i] >> shift) & 0xff]++;
+      dst_keys[j] = src_keys[i];
+      dst_values[j] = src_values[i];
+    }
+    std::swap(src_keys, dst_keys);
+    std::swap(src_values, dst_values);
+  }
+  if (src_keys != out_keys) {
+    std::memcpy(out_keys, src_keys, n * sizeof(uint64_t));
+    std::memcpy(out_values, src_values, n * sizeof(uint32_t));
+  }
+}
+
+} // namespace
+
+void morton_keys(const float3* points, size_t n, const float3& min, const float3& max, uint64_t* keys) noexcept {
+  curve_keys(kernels().morton_keys3, [](const uint3& c) { return morton_encode(c); }, points, n, min, max, keys);
+}
+
+void hilbert_keys(const float3* points, size_t n, const float3& min, const float3& max, uint64_t* keys) noexcept {
+  curve_keys(kernels().hilbert_keys3, [](const uint3& c) { return hilbert_encode(c); }, points, n, min, max, keys);
+}
+
+void radix_sort(uint64_t* keys, uint32_t* values, size_t n, size_t thread_count) {
+  if (n < 2) return;
+  if (thread_count == 0) thread_count = default_scheduler().concurrency();
+  thread_count = std::max<size_t>(1, std::min(thread_count, n / SORT_GRAIN));
+
+  const uint64_t varying = varying_bits(keys, n);
+  if (varying == 0) return;
+  int top = 56;
+  while (((varying >> top) & 0xff) == 0) top -= 8;
+
+  // One pass over the whole array on the most significant varying byte, into the buffers.
+  // counts[t * 256 + digit]: first histograms per range, then where each range writes that digit.
+  std::vector<uint64_t> key_buffer(n);
+  std::vector<uint32_t> value_buffer(n);
+  std::vector<size_t> counts(thread_count * 256);
+  split_chunks(n, thread_count, [&](size_t t, size_t begin, size_t end) {
+    size_t* c = counts.data() + t * 256;
+    for (size_t i = begin; i < end; ++i) ++c[(keys[i] >> top) & 0xff];
+  });
+
+  // Digit-major, range-minor prefix sum keeps equal keys in their original order
+  size_t buckets[257];
+  size_t sum = 0;
+  for (size_t digit = 0; digit < 256; ++digit) {
+    buckets[digit] = sum;
+    for (size_t t = 0; t < thread_count; ++t) {
+      const size_t c = counts[t * 256 + digit];
+      counts[t * 256 + digit] = sum;
+      sum += c;
+    }
+  }
+  buckets[256] = n;
+
+  split_chunks(n, thread_count, [&](size_t t, size_t begin, size_t end) {
+    size_t* offsets = counts.data() + t * 256;
+    for (size_t i = begin; i < end; ++i) {
+      const size_t j = offsets[(keys[i] >> top) & 0xff]++;
+      key_buffer[j] = keys[i];
+      value_buffer[j] = values[i];
+    }
+  });
+
+  // The buckets are small enough to stay in cache for their remaining passes, which is where
+  // the time goes otherwise: each pass over an array larger than the cache scatters to 256
+  // places in memory. Threads steal buckets from each other.
+  parallel_for(0, 256, [&](size_t first, size_t last) {
+    for (size_t b = first; b < last; ++b) {
+      sort_bucket(key_buffer.data() + buckets[b], value_buffer.data() + buckets[b], keys + buckets[b],
+                  values + buckets[b], buckets[b + 1] - buckets[b], top);
+    }
+  }, task_options(thread_count));
+}
+
+void spatial_order(const float3* points, size_t n, uint32_t* order, space_curve curve, size_t thread_count) {
+  if (n == 0) return;
+  struct box {
+    float3 min, max;
+  };
+  // Like fmin and fmax, NaN coordinates lose, without the libm calls
+  const auto merge = [](const box& a, const box& b) {
+    const auto lo = [](float u, float v) { return v < u || u != u ? v : u; };
+    const auto hi = [](float u, float v) { return v > u || u != u ? v : u; };
+    return box{{lo(a.min.x, b.min.x), lo(a.min.y, b.min.y), lo(a.min.z, b.min.z)},
+               {hi(a.max.x, b.max.x), hi(a.max.y, b.max.y), hi(a.max.z, b.max.z)}};
+  };
+  parallel_options o;
+  o.thread_count = thread_count;
+  o.element_size = sizeof(float3);
+  const box bounds = parallel_reduce(size_t(0), n, box{points[0], points[0]}, [&](size_t begin, size_t end) {
+    box b{points[begin], points[begin]};
+    for (size_t i = begin + 1; i < end; ++i) b = merge(b, box{points[i], points[i]});
+    return b;
+  }, merge, o);
+  const float3 min = bounds.min, max = bounds.max;
+
+  std::vector<uint64_t> keys(n);
+  if (curve == space_curve::hilbert) {
+    hilbert_keys(points, n, min, max, keys.data());
+  } else {
+    morton_keys(points, n, min, max, keys.data());
+  }
+  for (size_t i = 0; i < n; ++i) order[i] = static_cast<uint32_t>(i);
+  radix_sort(keys.data(), order, n, thread_count);
+}
+
+} // namespace cgmath
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "pack.h"
+
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cgmath {
+
+namespace {
+
+constexpr char PACK_MAGIC[8] = {'C', 'G', 'M', 'P', 'A', 'C', 'K', '\0'};
+constexpr uint32_t PACK_BYTE_ORDER = 0x01020304;
+
+constexpr uint64_t PRIME1 = 0x9e3779b185ebca87ull;
+constexpr uint64_t PRIME2 = 0xc2b2ae3d27d4eb4full;
+constexpr uint64_t PRIME3 = 0x165667b19e3779f9ull;
+
+inline uint64_t rotl(uint64_t v, int r) noexcept { return (v << r) | (v >> (64 - r)); }
+
+inline uint64_t read64(const unsigned char* p) noexcept {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t mix(uint64_t acc, uint64_t v) noexcept { return rotl(acc + v * PRIME2, 31) * PRIME1; }
+
+inline uint64_t align_up(uint64_t v, uint64_t a) noexcept { return (v + a - 1) / a * a; }
+
+} // namespace
+
+// Four independent multiply-rotate lanes over 32-byte stripes, then a scalar tail and an
+// avalanche step. Same structure as xxHash64 without claiming compatible output.
+uint64_t pack_checksum(const void* data, size_t size) noexcept {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  const unsigned char* end = p + size;
+  uint64_t a0 = PRIME1 + PRIME2, a1 = PRIME2, a2 = 0, a3 = 0 - PRIME1;
+  for (; end - p >= 32; p += 32) {
+    a0 = mix(a0, read64(p + 0));
+    a1 = mix(a1, read64(p + 8));
+    a2 = mix(a2, read64(p + 16));
+    a3 = mix(a3, read64(p + 24));
+  }
+  uint64_t h = rotl(a0, 1) + rotl(a1, 7) + rotl(a2, 12) + rotl(a3, 18) + size;
+  for (; end - p >= 8; p += 8) h = rotl(h ^ mix(0, read64(p)), 27) * PRIME1 + PRIME3;
+  for (; p < end; ++p) h = rotl(h ^ (*p * PRIME3), 11) * PRIME1;
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  return h ^ (h >> 32);
+}
+
+bool pack_writer::add_raw(const char* name, uint32_t type, uint32_t stride, uint32_t alignment, const void* data,
+                          size_t count) {
+  size_t len = std::strlen(name);
+  if (len == 0 || len >= PACK_NAME_SIZE) return false;
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) return false;
+  for (const pending& a : arrays) {
+    if (std::strncmp(a.entry.name, name, PACK_NAME_SIZE) == 0) return false;
+  }
+  pending a{};
+  std::memcpy(a.entry.name, name, len);
+  a.entry.type = type;
+  a.entry.stride = stride;
+  a.entry.alignment = alignment;
+  a.entry.count = count;
+  a.entry.size = uint64_t(count) * stride;
+  a.data = data;
+  arrays.push_back(a);
+  return true;
+}
+
+bool pack_writer::save(const char* path, bool checksum) const {
+  std::FILE* file = std::fopen(path, "wb");
+  if (!file) return false;
+
+  std::vector<pack_entry> directory;
+  directory.reserve(arrays.size());
+  uint64_t offset = sizeof(pack_header);
+  for (const pending& a : arrays) {
+    pack_entry e = a.entry;
+    e.offset = align_up(offset, a.entry.alignment > PACK_DATA_ALIGNMENT ? a.entry.alignment : PACK_DATA_ALIGNMENT);
+    if (checksum) {
+      e.flags |= PACK_ENTRY_CHECKSUM;
+      e.checksum = pack_checksum(a.data, e.size);
+    }
+    offset = e.offset + e.size;
+    directory.push_back(e);
+  }
+
+  pack_header header{};
+  std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+  header.version = PACK_VERSION;
+  header.byte_order = PACK_BYTE_ORDER;
+  header.array_count = static_cast<uint32_t>(arrays.size());
+  header.directory_offset = align_up(offset, PACK_DATA_ALIGNMENT);
+  header.file_size = header.directory_offset + directory.size() * sizeof(pack_entry);
+
+  // Gaps before arrays aligned past PACK_DATA_ALIGNMENT are longer than zeros
+  static const unsigned char zeros[PACK_DATA_ALIGNMENT] = {};
+  const auto pad = [file](uint64_t size) {
+    while (size > 0) {
+      const size_t chunk = size < sizeof(zeros) ? static_cast<size_t>(size) : sizeof(zeros);
+      if (std::fwrite(zeros, 1, chunk, file) != chunk) return false;
+      size -= chunk;
+    }
+    return true;
+  };
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+  uint64_t pos = sizeof(header);
+  for (size_t i = 0; ok && i < arrays.size(); ++i) {
+    const pack_entry& e = directory[i];
+    ok = pad(e.offset - pos) && std::fwrite(arrays[i].data, 1, e.size, file) == e.size;
+    pos = e.offset + e.size;
+  }
+  ok = ok && pad(header.directory_offset - pos);
+  ok = ok && std::fwrite(directory.data(), sizeof(pack_entry), directory.size(), file) == directory.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+pack_file::pack_file(pack_file&& other) noexcept { *this = std::move(other); }
+
+pack_file& pack_file::operator=(pack_file&& other) noexcept {
+  if (this != &other) {
+    close();
+    base = other.base;
+    mapped_size = other.mapped_size;
+    other.base = nullptr;
+    other.mapped_size = 0;
+#ifdef _WIN32
+    file_handle = other.file_handle;
+    mapping_handle = other.mapping_handle;
+    other.file_handle = other.mapping_handle = nullptr;
+#endif
+  }
+  return *this;
+}
+
+pack_file::~pack_file() { close(); }
+
+bool pack_file::open(const char* path) noexcept {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER size;
+  HANDLE mapping = nullptr;
+  const void* view = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (!view) {
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  file_handle = file;
+  mapping_handle = mapping;
+  base = static_cast<const unsigned char*>(view);
+  mapped_size = static_cast<size_t>(size.QuadPart);
+#else
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  void* view = MAP_FAILED;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+    view = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (view == MAP_FAILED) return false;
+  base = static_cast<const unsigned char*>(view);
+  mapped_size = static_cast<size_t>(st.st_size);
+#endif
+
+  // Everything a view hands out later is bounds checked here once
+  const pack_header& h = header();
+  bool valid = mapped_size >= sizeof(pack_header) && std::memcmp(h.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) == 0 &&
+               h.version == PACK_VERSION && h.byte_order == PACK_BYTE_ORDER && h.file_size == mapped_size &&
+               h.directory_offset % alignof(pack_entry) == 0 && h.directory_offset <= mapped_size &&
+               (mapped_size - h.directory_offset) / sizeof(pack_entry) >= h.array_count;
+  for (uint32_t i = 0; valid && i < h.array_count; ++i) {
+    const pack_entry& e = directory()[i];
+    valid = e.name[PACK_NAME_SIZE - 1] == '\0' && e.stride != 0 && e.count <= UINT64_MAX / e.stride &&
+            e.size == e.count * e.stride && e.offset <= mapped_size && e.size <= mapped_size - e.offset;
+  }
+  if (!valid) close();
+  return valid;
+}
+
+void pack_file::close() noexcept {
+  if (!base) return;
+#ifdef _WIN32
+  UnmapViewOfFile(base);
+  CloseHandle(mapping_handle);
+  CloseHandle(file_handle);
+  file_handle = mapping_handle = nullptr;
+#else
+  ::munmap(const_cast<unsigned char*>(base), mapped_size);
+#endif
+  base = nullptr;
+  mapped_size = 0;
+}
+
+const pack_entry* pack_file::find(const char* name) const noexcept {
+  for (size_t i = 0; i < array_count(); ++i) {
+    if (std::strncmp(directory()[i].name, name, PACK_NAME_SIZE) == 0) return &directory()[i];
+  }
+  return nullptr;
+}
+
+bool pack_file::verify(const pack_entry& e) const noexcept {
+  return !(e.flags & PACK_ENTRY_CHECKSUM) || pack_checksum(base + e.offset, e.size) == e.checksum;
+}
+
+} // namespace cgmath
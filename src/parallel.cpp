@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+namespace cgmath {
+
+namespace {
+
+// Default chunk, small enough to split 1M floats 64 ways and large enough that taking a
+// chunk costs nothing next to working through it
+constexpr size_t DEFAULT_GRAIN_BYTES = 16384;
+
+// Chunks per thread in dynamic mode, what stealing has to even out uneven work with
+constexpr size_t CHUNKS_PER_THREAD = 8;
+
+// Chunk indices are packed in pairs into 64-bit words
+constexpr size_t MAX_CHUNKS = size_t(1) << 31;
+
+// Set while the thread runs a loop body; loops started there run on the thread itself
+thread_local bool inside_loop = false;
+
+class thread_pool final : public scheduler {
+public:
+  thread_pool() : hardware(std::max(1u, std::thread::hardware_concurrency())) {}
+
+  ~thread_pool() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+  }
+
+  size_t concurrency() const noexcept override { return hardware; }
+
+  void run(size_t count, void (*work)(void*, size_t), void* context) override {
+    // One loop at a time; a loop started on another thread meanwhile runs there
+    std::unique_lock<std::mutex> busy(run_mutex, std::try_to_lock);
+    if (!busy.owns_lock() || count <= 1) {
+      for (size_t i = 0; i < count; ++i) work(context, i);
+      return;
+    }
+    std::call_once(started, [this] { start(); });
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      // Workers that woke up too late for the previous loop must be gone before next resets
+      finished.wait(lock, [this] { return active == 0; });
+      job = work;
+      job_context = context;
+      job_count = count;
+      next.store(0, std::memory_order_relaxed);
+      ++generation;
+    }
+    wake.notify_all();
+
+    for (size_t i; (i = next.fetch_add(1)) < count;) work(context, i);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return active == 0; });
+  }
+
+private:
+  void start() {
+    threads.reserve(hardware - 1);
+    for (size_t t = 0; t + 1 < hardware; ++t) {
+      try {
+        threads.emplace_back([this] { worker(); });
+      } catch (...) {
+        break;  // fewer workers, the calling thread still runs everything left
+      }
+    }
+  }
+
+  void worker() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+      void (*work)(void*, size_t) = job;
+      void* context = job_context;
+      const size_t count = job_count;
+      ++active;
+      lock.unlock();
+      for (size_t i; (i = next.fetch_add(1)) < count;) work(context, i);
+      lock.lock();
+      if (--active == 0) finished.notify_all();
+    }
+  }
+
+  const size_t hardware;
+  std::once_flag started;
+  std::vector<std::thread> threads;
+  std::mutex run_mutex;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  void (*job)(void*, size_t) = nullptr;
+  void* job_context = nullptr;
+  size_t job_count = 0;
+  std::atomic<size_t> next{0};
+  size_t active = 0;  // workers inside the current loop
+  uint64_t generation = 0;
+  bool stopping = false;
+};
+
+thread_pool& pool() {
+  static thread_pool p;
+  return p;
+}
+
+std::atomic<scheduler*> custom_scheduler{nullptr};
+
+// Chunks [begin, end) still to run by one thread, begin in the low half. The owner takes
+// chunks from the front, thieves take the upper half, both by compare-and-swap.
+struct alignas(CACHE_LINE_SIZE) chunk_range {
+  std::atomic<uint64_t> chunks;
+};
+
+constexpr uint64_t pack(size_t begin, size_t end) noexcept { return uint64_t(begin) | (uint64_t(end) << 32); }
+
+struct loop_state {
+  const detail::chunking* c;
+  void (*body)(void*, size_t, size_t, size_t);
+  void* context;
+  chunk_range* ranges;
+  size_t thread_count;
+
+  void run_chunk(size_t chunk) const {
+    const size_t b = c->begin + chunk * c->size;
+    body(context, chunk, b, std::min(b + c->size, c->end));
+  }
+
+  bool pop(size_t w, size_t& chunk) const noexcept {
+    uint64_t s = ranges[w].chunks.load(std::memory_order_acquire);
+    for (;;) {
+      const size_t b = size_t(s & 0xffffffffu), e = size_t(s >> 32);
+      if (b >= e) return false;
+      if (ranges[w].chunks.compare_exchange_weak(s, pack(b + 1, e), std::memory_order_acq_rel)) {
+        chunk = b;
+        return true;
+      }
+    }
+  }
+
+  // Takes the upper half of the first other thread with chunks left, runs its first chunk
+  // next and keeps the rest
+  bool steal(size_t w, size_t& chunk) const noexcept {
+    for (size_t k = 1; k < thread_count; ++k) {
+      chunk_range& victim = ranges[(w + k) % thread_count];
+      uint64_t s = victim.chunks.load(std::memory_order_acquire);
+      for (;;) {
+        const size_t b = size_t(s & 0xffffffffu), e = size_t(s >> 32);
+        if (b >= e) break;
+        const size_t middle = b + (e - b) / 2;
+        if (victim.chunks.compare_exchange_weak(s, pack(b, middle), std::memory_order_acq_rel)) {
+          ranges[w].chunks.store(pack(middle + 1, e), std::memory_order_release);
+          chunk = middle;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void work(size_t w) const {
+    const bool outer = inside_loop;
+    inside_loop = true;
+    size_t chunk;
+    for (;;) {
+      while (pop(w, chunk)) run_chunk(chunk);
+      if (!steal(w, chunk)) break;
+      run_chunk(chunk);
+    }
+    inside_loop = outer;
+  }
+};
+
+} // namespace
+
+scheduler& default_scheduler() noexcept {
+  scheduler* s = custom_scheduler.load(std::memory_order_acquire);
+  return s ? *s : pool();
+}
+
+void set_default_scheduler(scheduler* s) noexcept { custom_scheduler.store(s, std::memory_order_release); }
+
+namespace detail {
+
+chunking make_chunks(size_t begin, size_t end, const parallel_options& options) noexcept {
+  chunking c{begin, end, 1, 0};
+  if (end <= begin) return c;
+  const size_t n = end - begin;
+
+  size_t size = options.grain;
+  if (size == 0) size = options.element_size ? std::max<size_t>(1, DEFAULT_GRAIN_BYTES / options.element_size) : 1;
+  if (options.mode == partition::dynamic) {
+    const size_t threads =
+        options.thread_count ? options.thread_count : (options.executor ? *options.executor : default_scheduler()).concurrency();
+    size = std::max(size, n / (threads * CHUNKS_PER_THREAD));
+  }
+  size = std::max(size, (n - 1) / MAX_CHUNKS + 1);
+
+  // Whole cache lines of the arrays written, so neighbouring chunks never share one
+  if (options.element_size) {
+    const size_t align = CACHE_LINE_SIZE / std::gcd(CACHE_LINE_SIZE, options.element_size);
+    size = (size + align - 1) / align * align;
+  }
+  c.size = size;
+  c.count = (n - 1) / size + 1;
+  return c;
+}
+
+void run_chunks(const chunking& c, const parallel_options& options, void (*body)(void*, size_t, size_t, size_t),
+                void* context) {
+  if (c.count == 0) return;
+  scheduler& s = options.executor ? *options.executor : default_scheduler();
+  size_t threads = std::min(options.thread_count ? options.thread_count : s.concurrency(), s.concurrency());
+  threads = std::min(threads, c.count);
+  if (threads <= 1 || inside_loop) {
+    for (size_t chunk = 0; chunk < c.count; ++chunk) {
+      const size_t b = c.begin + chunk * c.size;
+      body(context, chunk, b, std::min(b + c.size, c.end));
+    }
+    return;
+  }
+
+  // Every thread starts on an equal share of the chunks
+  std::unique_ptr<chunk_range[]> ranges(new chunk_range[threads]);
+  for (size_t t = 0; t < threads; ++t) {
+    ranges[t].chunks.store(pack(t * c.count / threads, (t + 1) * c.count / threads), std::memory_order_relaxed);
+  }
+  loop_state state{&c, body, context, ranges.get(), threads};
+  s.run(threads, [](void* p, size_t w) { static_cast<loop_state*>(p)->work(w); }, &state);
+}
+
+} // namespace detail
+
+} // namespace cgmath
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "quaternion.h"
+#include "kernels.h"
+
+namespace cgmath {
+
+void to_matrix3x4(const quaternion* rotations, const float3* translations, matrix3x4* out, size_t n) noexcept {
+  static_assert(sizeof(matrix3x4) == 12 * sizeof(float), "matrix3x4 must be tightly packed");
+  size_t i = kernels().rotations_to_rows(reinterpret_cast<const float*>(rotations),
+                                         reinterpret_cast<const float*>(translations), reinterpret_cast<float*>(out), 12, n);
+  for (; i < n; ++i) out[i] = rotations[i].to_matrix3x4(translations ? translations[i] : float3{});
+}
+
+void to_matrix4x4(const quaternion* rotations, const float3* translations, matrix4x4* out, size_t n) noexcept {
+  static_assert(sizeof(matrix4x4) == 16 * sizeof(float), "matrix4x4 must be tightly packed");
+  size_t i = kernels().rotations_to_rows(reinterpret_cast<const float*>(rotations),
+                                         reinterpret_cast<const float*>(translations), reinterpret_cast<float*>(out), 16, n);
+#ifdef __SSE__
+  const __m128 last_row = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+  for (size_t j = 0; j < i; ++j) _mm_storeu_ps(out[j].m[3], last_row);
+#endif
+  for (; i < n; ++i) out[i] = rotations[i].to_matrix4x4(translations ? translations[i] : float3{});
+}
+
+void nlerp(const quaternion* a, const quaternion* b, float t, quaternion* out, size_t n) noexcept {
+  size_t i = kernels().nlerp(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), t,
+                             reinterpret_cast<float*>(out), n);
+  for (; i < n; ++i) out[i] = nlerp(a[i], b[i], t);
+}
+
+} // namespace cgmath
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "ray_packet.h"
+#include "kernels.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace cgmath {
+
+namespace {
+
+constexpr float DET_EPSILON = 1e-12f;
+constexpr int STACK_SIZE = 128;  // two pushes per level of a depth-bounded bvh
+
+// Same test as the single ray traversal, for packets the kernels leave to scalar code
+inline bool triangle_lane(const bvh_triangle& tri, const float3& o, const float3& d, float t_min, float t_max,
+                          float& t, float& u, float& v) noexcept {
+  float3 p = d.cross(tri.e2);
+  float det = tri.e1.dot(p);
+  if (!(std::fabs(det) > DET_EPSILON)) return false;
+  float inv_det = 1.0f / det;
+  float3 s = o - tri.v0;
+  u = s.dot(p) * inv_det;
+  if (u < 0.0f || u > 1.0f) return false;
+  float3 q = s.cross(tri.e1);
+  v = d.dot(q) * inv_det;
+  if (v < 0.0f || u + v > 1.0f) return false;
+  t = tri.e2.dot(q) * inv_det;
+  return t >= t_min && t <= t_max;
+}
+
+// Lanes [k, N) of a packet
+template <size_t N>
+uint32_t triangle_packet(ray_packet<N>& r, const bvh_triangle& tri, uint32_t primitive, packet_hit<N>& hit,
+                         size_t k = 0) noexcept {
+  uint32_t result = 0;
+  for (; k < N; ++k) {
+    float t, u, v;
+    if (!triangle_lane(tri, float3(r.ox[k], r.oy[k], r.oz[k]), float3(r.dx[k], r.dy[k], r.dz[k]), r.t_min[k], r.t_max[k], t, u, v)) {
+      continue;
+    }
+    hit.t[k] = r.t_max[k] = t;
+    hit.u[k] = u;
+    hit.v[k] = v;
+    hit.primitive[k] = primitive;
+    result |= uint32_t(1) << k;
+  }
+  return result;
+}
+
+// One axis of the slab test. With a zero direction component and the origin on a face, 0 * inf is NaN; the ray
+// then runs in that face's plane and the axis does not limit it
+inline void slab(float t0, float t1, float& enter, float& exit) noexcept {
+  if (t0 != t0 || t1 != t1) return;
+  enter = std::max(enter, std::min(t0, t1));
+  exit = std::min(exit, std::max(t0, t1));
+}
+
+template <size_t N>
+uint32_t aabb_packet(const ray_packet<N>& r, const float3& min, const float3& max, float* t_enter,
+                     size_t k = 0) noexcept {
+  uint32_t result = 0;
+  for (; k < N; ++k) {
+    float enter = r.t_min[k], exit = r.t_max[k];
+    slab((min.x - r.ox[k]) * r.inv_dx[k], (max.x - r.ox[k]) * r.inv_dx[k], enter, exit);
+    slab((min.y - r.oy[k]) * r.inv_dy[k], (max.y - r.oy[k]) * r.inv_dy[k], enter, exit);
+    slab((min.z - r.oz[k]) * r.inv_dz[k], (max.z - r.oz[k]) * r.inv_dz[k], enter, exit);
+    if (t_enter) t_enter[k] = enter;
+    if (!(exit < enter)) result |= uint32_t(1) << k;
+  }
+  return result;
+}
+
+inline unsigned first_lane(uint32_t m) noexcept {
+  unsigned j = 0;
+  while (!((m >> j) & 1)) ++j;
+  return j;
+}
+
+// Nodes are culled against the whole packet; children are visited nearest first along the
+// direction of the first active lane. AnyHit retires lanes as soon as they are blocked. The
+// kernels in kernels_impl.h traverse the same way.
+template <size_t N, bool AnyHit>
+uint32_t traverse_packet(const bvh& tree, ray_packet<N>& r, packet_hit<N>& hit) noexcept {
+  uint32_t result = 0;
+  if (tree.empty()) return result;
+
+  uint32_t stack[STACK_SIZE];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const bvh_node& node = tree.nodes[stack[--top]];
+    const uint32_t active = aabb_packet(r, node.min, node.max, nullptr);
+    if (!active) continue;
+
+    if (node.is_leaf()) {
+      for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+        uint32_t m = triangle_packet(r, tree.triangles[i], tree.primitives[i], hit);
+        result |= m;
+        if constexpr (AnyHit) {
+          for (; m; m &= m - 1) r.set_inactive(first_lane(m));
+          if (!r.active_mask()) return result;
+        }
+      }
+      continue;
+    }
+
+    const bvh_node& left = tree.nodes[node.first];
+    const bvh_node& right = tree.nodes[node.first + 1];
+    const unsigned k = first_lane(active);
+    float3 split = (right.min + right.max) - (left.min + left.max);
+    bool left_first = split.x * r.dx[k] + split.y * r.dy[k] + split.z * r.dz[k] >= 0.0f;
+    stack[top++] = left_first ? node.first + 1 : node.first;
+    stack[top++] = left_first ? node.first : node.first + 1;
+  }
+  return result;
+}
+
+// Spreads the low 10 bits of v three bits apart
+inline uint32_t spread_bits(uint32_t v) noexcept {
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+} // namespace
+
+uint32_t intersect_triangle(ray8& r, const bvh_triangle& tri, uint32_t primitive, hit8& hit) noexcept {
+  uint32_t mask = 0;
+  const size_t k = kernels().triangle_packet8(r, tri, primitive, hit, mask);
+  return mask | triangle_packet(r, tri, primitive, hit, k);
+}
+
+uint32_t intersect_triangle(ray16& r, const bvh_triangle& tri, uint32_t primitive, hit16& hit) noexcept {
+  uint32_t mask = 0;
+  const size_t k = kernels().triangle_packet16(r, tri, primitive, hit, mask);
+  return mask | triangle_packet(r, tri, primitive, hit, k);
+}
+
+uint32_t intersect_aabb(const ray8& r, const float3& min, const float3& max, float* t_enter) noexcept {
+  uint32_t mask = 0;
+  const size_t k = kernels().aabb_packet8(r, min, max, t_enter, mask);
+  return mask | aabb_packet(r, min, max, t_enter, k);
+}
+
+uint32_t intersect_aabb(const ray16& r, const float3& min, const float3& max, float* t_enter) noexcept {
+  uint32_t mask = 0;
+  const size_t k = kernels().aabb_packet16(r, min, max, t_enter, mask);
+  return mask | aabb_packet(r, min, max, t_enter, k);
+}
+
+uint32_t intersect(const bvh& tree, ray8& r, hit8& hit) noexcept {
+  uint32_t mask = 0;
+  if (tree.empty()) return mask;
+  if (kernels().traverse_packet8(tree.nodes.data(), tree.triangles.data(), tree.primitives.data(), r, hit, false, mask)) {
+    return mask;
+  }
+  return traverse_packet<8, false>(tree, r, hit);
+}
+
+uint32_t intersect(const bvh& tree, ray16& r, hit16& hit) noexcept {
+  uint32_t mask = 0;
+  if (tree.empty()) return mask;
+  if (kernels().traverse_packet16(tree.nodes.data(), tree.triangles.data(), tree.primitives.data(), r, hit, false,
+                                  mask)) {
+    return mask;
+  }
+  return traverse_packet<16, false>(tree, r, hit);
+}
+
+uint32_t occluded(const bvh& tree, const ray8& r) noexcept {
+  ray8 tmp = r;
+  hit8 hit;
+  uint32_t mask = 0;
+  if (tree.empty()) return mask;
+  if (kernels().traverse_packet8(tree.nodes.data(), tree.triangles.data(), tree.primitives.data(), tmp, hit, true, mask)) {
+    return mask;
+  }
+  return traverse_packet<8, true>(tree, tmp, hit);
+}
+
+uint32_t occluded(const bvh& tree, const ray16& r) noexcept {
+  ray16 tmp = r;
+  hit16 hit;
+  uint32_t mask = 0;
+  if (tree.empty()) return mask;
+  if (kernels().traverse_packet16(tree.nodes.data(), tree.triangles.data(), tree.primitives.data(), tmp, hit, true,
+                                  mask)) {
+    return mask;
+  }
+  return traverse_packet<16, true>(tree, tmp, hit);
+}
+
+void sort_rays(const ray* rays, size_t n, uint32_t* order) {
+  if (n == 0) return;
+  float3 lo = rays[0].origin, hi = rays[0].origin;
+  for (size_t i = 1; i < n; ++i) {
+    const float3& o = rays[i].origin;
+    lo = float3(std::min(lo.x, o.x), std::min(lo.y, o.y), std::min(lo.z, o.z));
+    hi = float3(std::max(hi.x, o.x), std::max(hi.y, o.y), std::max(hi.z, o.z));
+  }
+  auto scale = [](float extent) { return extent > 0.0f ? 1023.0f / extent : 0.0f; };
+  const float3 s(scale(hi.x - lo.x), scale(hi.y - lo.y), scale(hi.z - lo.z));
+
+  // 3 octant bits above a 29-bit Morton code, sorted together with the ray index
+  std::vector<uint64_t> keys(n);
+  for (size_t i = 0; i < n; ++i) {
+    const ray& r = rays[i];
+    uint32_t octant = uint32_t(r.direction.x < 0.0f) | uint32_t(r.direction.y < 0.0f) << 1 | uint32_t(r.direction.z < 0.0f) << 2;
+    uint32_t morton = spread_bits(static_cast<uint32_t>((r.origin.x - lo.x) * s.x)) |
+                      spread_bits(static_cast<uint32_t>((r.origin.y - lo.y) * s.y)) << 1 |
+                      spread_bits(static_cast<uint32_t>((r.origin.z - lo.z) * s.z)) << 2;
+    uint32_t key = octant << 29 | morton >> 1;
+    keys[i] = uint64_t(key) << 32 | i;
+  }
+  std::sort(keys.begin(), keys.end());
+  for (size_t i = 0; i < n; ++i) order[i] = static_cast<uint32_t>(keys[i]);
+}
+
+} // namespace cgmath
@@ -0,0 +1,632 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#pragma once
+
+#include "pch.h"
+
+#include <cstddef>
+#include <cstring>
+
+// Fixed-width float vectors shared by the batch kernels. Each type exposes the same
+// static interface so a kernel is written once as a template over the lane type.
+//
+// load_xyz/store_xyz convert between `width` packed float3 (x0 y0 z0 x1 ...) and
+// three SoA registers using in-register shuffles only.
+// load_xyzw/store_xyzw do the same for the first four floats of elements `stride` floats
+// apart (float4, vector3/vector4, matrix rows).
+// splat4(v, k) broadcasts component k of every packed float4 within its 128-bit lane.
+//
+// Kernel translation units built with wider ISA flags (kernels_*.cpp) define
+// CG_MATH_LANES_NAMESPACE to a name of their own, so their copies of these inline
+// functions can never be merged with the baseline ones at link time.
+
+#ifndef CG_MATH_LANES_NAMESPACE
+#define CG_MATH_LANES_NAMESPACE baseline
+#endif
+
+namespace cgmath::lanes {
+inline namespace CG_MATH_LANES_NAMESPACE {
+
+#ifdef __SSE__
+
+struct sse {
+  using reg = __m128;
+  static constexpr size_t width = 4;
+  static constexpr size_t align = 16;
+
+  static reg set1(float v) noexcept { return _mm_set1_ps(v); }
+  static reg zero() noexcept { return _mm_setzero_ps(); }
+  static reg load(const float* p) noexcept { return _mm_loadu_ps(p); }
+  static reg load_aligned(const float* p) noexcept { return _mm_load_ps(p); }
+  static void store(float* p, reg v) noexcept { _mm_storeu_ps(p, v); }
+  static void stream(float* p, reg v) noexcept { _mm_stream_ps(p, v); }
+
+  static reg add(reg a, reg b) noexcept { return _mm_add_ps(a, b); }
+  static reg sub(reg a, reg b) noexcept { return _mm_sub_ps(a, b); }
+  static reg mul(reg a, reg b) noexcept { return _mm_mul_ps(a, b); }
+  static reg div(reg a, reg b) noexcept { return _mm_div_ps(a, b); }
+  static reg min(reg a, reg b) noexcept { return _mm_min_ps(a, b); }
+  static reg max(reg a, reg b) noexcept { return _mm_max_ps(a, b); }
+  static reg sqrt(reg a) noexcept { return _mm_sqrt_ps(a); }
+
+  static reg madd(reg a, reg b, reg c) noexcept {
+#ifdef __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+  }
+
+  static reg broadcast4(const float* p) noexcept { return _mm_loadu_ps(p); }
+
+  template <int k>
+  static reg splat4(reg v) noexcept { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(k, k, k, k)); }
+
+  // Zero wherever cond is not greater than zero
+  static reg select_gt_zero(reg cond, reg v) noexcept { return _mm_and_ps(v, _mm_cmpgt_ps(cond, _mm_setzero_ps())); }
+
+  // v with its sign flipped wherever s is negative
+  static reg xor_sign(reg v, reg s) noexcept { return _mm_xor_ps(v, _mm_and_ps(s, _mm_set1_ps(-0.0f))); }
+
+  // Bit k set where a[k] < b[k]
+  static unsigned mask_lt(reg a, reg b) noexcept { return static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(a, b))); }
+
+#ifdef __SSE2__
+  // Comparison masks and 32-bit integer lanes, for the quantizing codecs. Narrow loads widen
+  // with sign or zero extension; narrow stores keep the low bits of each lane, so values must
+  // already be in range.
+  using mask = __m128;
+  using ireg = __m128i;
+
+  static reg abs(reg v) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+  static mask lt(reg a, reg b) noexcept { return _mm_cmplt_ps(a, b); }
+  static mask eq(reg a, reg b) noexcept { return _mm_cmpeq_ps(a, b); }
+  static mask unordered(reg a, reg b) noexcept { return _mm_cmpunord_ps(a, b); }  // a or b is NaN
+
+  // a where m is set, b elsewhere
+  static reg select(mask m, reg a, reg b) noexcept {
+#ifdef __SSE4_1__
+    return _mm_blendv_ps(b, a, m);
+#else
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+#endif
+  }
+
+  static ireg to_int(reg v) noexcept { return _mm_cvtps_epi32(v); }  // nearest, ties to even
+  static ireg truncate(reg v) noexcept { return _mm_cvttps_epi32(v); }
+  static reg to_float(ireg v) noexcept { return _mm_cvtepi32_ps(v); }
+  static ireg iset1(int32_t v) noexcept { return _mm_set1_epi32(v); }
+  static ireg iand(ireg a, ireg b) noexcept { return _mm_and_si128(a, b); }
+  static ireg ior(ireg a, ireg b) noexcept { return _mm_or_si128(a, b); }
+  static ireg iadd(ireg a, ireg b) noexcept { return _mm_add_epi32(a, b); }
+  static ireg ixor(ireg a, ireg b) noexcept { return _mm_xor_si128(a, b); }
+  static ireg iandnot(ireg a, ireg b) noexcept { return _mm_andnot_si128(a, b); }  // ~a & b
+
+  template <int n>
+  static ireg shl(ireg v) noexcept { return _mm_slli_epi32(v, n); }
+
+  template <int n>
+  static ireg shr(ireg v) noexcept { return _mm_srli_epi32(v, n); }
+
+  template <int n>
+  static ireg sra(ireg v) noexcept { return _mm_srai_epi32(v, n); }
+
+  // Zero-extends the 32-bit lanes to 64 bits, lo taking the first half
+  static void widen(ireg v, ireg& lo, ireg& hi) noexcept {
+    lo = _mm_unpacklo_epi32(v, _mm_setzero_si128());
+    hi = _mm_unpackhi_epi32(v, _mm_setzero_si128());
+  }
+
+  // 64-bit lanes, for keys built from widened values
+  static ireg qset1(uint64_t v) noexcept { return _mm_set1_epi64x(int64_t(v)); }
+
+  template <int n>
+  static ireg qshl(ireg v) noexcept { return _mm_slli_epi64(v, n); }
+
+  static void qstore(uint64_t* p, ireg v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+  static ireg iload(const uint32_t* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+  static void istore(uint32_t* p, ireg v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+  static ireg load_u16(const uint16_t* p) noexcept {
+    return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128());
+  }
+
+  static ireg load_i16(const int16_t* p) noexcept {
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+  }
+
+  static ireg load_i8(const int8_t* p) noexcept {
+    int32_t bytes;
+    std::memcpy(&bytes, p, sizeof(bytes));
+    __m128i v = _mm_cvtsi32_si128(bytes);
+    v = _mm_unpacklo_epi8(v, v);
+    return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 24);
+  }
+
+  // Sign-extending the low half first lets the saturating packs pass it through unchanged
+  static __m128i narrow_16(ireg v) noexcept {
+    v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+    return _mm_packs_epi32(v, v);
+  }
+
+  static void store_16(void* p, ireg v) noexcept { _mm_storel_epi64(static_cast<__m128i*>(p), narrow_16(v)); }
+
+  static void store_8(void* p, ireg v) noexcept {
+    __m128i h = narrow_16(v);
+    h = _mm_srai_epi16(_mm_slli_epi16(h, 8), 8);
+    int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(h, h));
+    std::memcpy(p, &bytes, sizeof(bytes));
+  }
+#endif
+
+  static void load_xyzw(const float* p, reg& x, reg& y, reg& z, reg& w, size_t stride = 4) noexcept {
+    x = _mm_loadu_ps(p + 0 * stride);
+    y = _mm_loadu_ps(p + 1 * stride);
+    z = _mm_loadu_ps(p + 2 * stride);
+    w = _mm_loadu_ps(p + 3 * stride);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+  }
+
+  static void store_xyzw(float* p, reg x, reg y, reg z, reg w, size_t stride = 4) noexcept {
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(p + 0 * stride, x);
+    _mm_storeu_ps(p + 1 * stride, y);
+    _mm_storeu_ps(p + 2 * stride, z);
+    _mm_storeu_ps(p + 3 * stride, w);
+  }
+
+  static void load_xyz(const float* p, reg& x, reg& y, reg& z) noexcept {
+    __m128 m0 = _mm_loadu_ps(p + 0);  // x0 y0 z0 x1
+    __m128 m1 = _mm_loadu_ps(p + 4);  // y1 z1 x2 y2
+    __m128 m2 = _mm_loadu_ps(p + 8);  // z2 x3 y3 z3
+    __m128 xy = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 1, 3, 2));  // x2 y2 x3 y3
+    __m128 yz = _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(1, 0, 2, 1));  // y0 z0 y1 z1
+    x = _mm_shuffle_ps(m0, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(yz, m2, _MM_SHUFFLE(3, 0, 3, 1));
+  }
+
+  template <bool Stream>
+  static void store_xyz(float* p, reg x, reg y, reg z) noexcept {
+    __m128 xy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));  // x0 x2 y0 y2
+    __m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));  // y1 y3 z1 z3
+    __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));  // z0 z2 x1 x3
+    __m128 m0 = _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 m1 = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    __m128 m2 = _mm_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+    if constexpr (Stream) {
+      _mm_stream_ps(p + 0, m0);
+      _mm_stream_ps(p + 4, m1);
+      _mm_stream_ps(p + 8, m2);
+    } else {
+      _mm_storeu_ps(p + 0, m0);
+      _mm_storeu_ps(p + 4, m1);
+      _mm_storeu_ps(p + 8, m2);
+    }
+  }
+};
+
+#endif
+
+#ifdef __AVX2__
+
+struct avx2 {
+  using reg = __m256;
+  static constexpr size_t width = 8;
+  static constexpr size_t align = 32;
+
+  static reg set1(float v) noexcept { return _mm256_set1_ps(v); }
+  static reg zero() noexcept { return _mm256_setzero_ps(); }
+  static reg load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+  static reg load_aligned(const float* p) noexcept { return _mm256_load_ps(p); }
+  static void store(float* p, reg v) noexcept { _mm256_storeu_ps(p, v); }
+  static void stream(float* p, reg v) noexcept { _mm256_stream_ps(p, v); }
+
+  static reg add(reg a, reg b) noexcept { return _mm256_add_ps(a, b); }
+  static reg sub(reg a, reg b) noexcept { return _mm256_sub_ps(a, b); }
+  static reg mul(reg a, reg b) noexcept { return _mm256_mul_ps(a, b); }
+  static reg div(reg a, reg b) noexcept { return _mm256_div_ps(a, b); }
+  static reg min(reg a, reg b) noexcept { return _mm256_min_ps(a, b); }
+  static reg max(reg a, reg b) noexcept { return _mm256_max_ps(a, b); }
+  static reg sqrt(reg a) noexcept { return _mm256_sqrt_ps(a); }
+
+  static reg madd(reg a, reg b, reg c) noexcept {
+#ifdef __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+  }
+
+  static reg broadcast4(const float* p) noexcept { return _mm256_broadcast_ps(reinterpret_cast<const __m128*>(p)); }
+
+  template <int k>
+  static reg splat4(reg v) noexcept { return _mm256_permute_ps(v, _MM_SHUFFLE(k, k, k, k)); }
+
+  static reg select_gt_zero(reg cond, reg v) noexcept {
+    return _mm256_and_ps(v, _mm256_cmp_ps(cond, _mm256_setzero_ps(), _CMP_GT_OQ));
+  }
+
+  static reg xor_sign(reg v, reg s) noexcept { return _mm256_xor_ps(v, _mm256_and_ps(s, _mm256_set1_ps(-0.0f))); }
+
+  static unsigned mask_lt(reg a, reg b) noexcept {
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)));
+  }
+
+  using mask = __m256;
+  using ireg = __m256i;
+
+  static reg abs(reg v) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+  static mask lt(reg a, reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static mask eq(reg a, reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+  static mask unordered(reg a, reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_UNORD_Q); }
+  static reg select(mask m, reg a, reg b) noexcept { return _mm256_blendv_ps(b, a, m); }
+
+  static ireg to_int(reg v) noexcept { return _mm256_cvtps_epi32(v); }
+  static ireg truncate(reg v) noexcept { return _mm256_cvttps_epi32(v); }
+  static reg to_float(ireg v) noexcept { return _mm256_cvtepi32_ps(v); }
+  static ireg iset1(int32_t v) noexcept { return _mm256_set1_epi32(v); }
+  static ireg iand(ireg a, ireg b) noexcept { return _mm256_and_si256(a, b); }
+  static ireg ior(ireg a, ireg b) noexcept { return _mm256_or_si256(a, b); }
+  static ireg iadd(ireg a, ireg b) noexcept { return _mm256_add_epi32(a, b); }
+  static ireg ixor(ireg a, ireg b) noexcept { return _mm256_xor_si256(a, b); }
+  static ireg iandnot(ireg a, ireg b) noexcept { return _mm256_andnot_si256(a, b); }  // ~a & b
+
+  template <int n>
+  static ireg shl(ireg v) noexcept { return _mm256_slli_epi32(v, n); }
+
+  template <int n>
+  static ireg shr(ireg v) noexcept { return _mm256_srli_epi32(v, n); }
+
+  template <int n>
+  static ireg sra(ireg v) noexcept { return _mm256_srai_epi32(v, n); }
+
+  // Zero-extends the 32-bit lanes to 64 bits, lo taking the first half
+  static void widen(ireg v, ireg& lo, ireg& hi) noexcept {
+    lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v));
+    hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1));
+  }
+
+  // 64-bit lanes, for keys built from widened values
+  static ireg qset1(uint64_t v) noexcept { return _mm256_set1_epi64x(int64_t(v)); }
+
+  template <int n>
+  static ireg qshl(ireg v) noexcept { return _mm256_slli_epi64(v, n); }
+
+  static void qstore(uint64_t* p, ireg v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+  static ireg iload(const uint32_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  static void istore(uint32_t* p, ireg v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+  static ireg load_u16(const uint16_t* p) noexcept {
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+
+  static ireg load_i16(const int16_t* p) noexcept {
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+
+  static ireg load_i8(const int8_t* p) noexcept {
+    return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+  }
+
+  static __m128i narrow_16(ireg v) noexcept {
+    v = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+    return _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  }
+
+  static void store_16(void* p, ireg v) noexcept { _mm_storeu_si128(static_cast<__m128i*>(p), narrow_16(v)); }
+
+  static void store_8(void* p, ireg v) noexcept {
+    __m128i h = narrow_16(v);
+    h = _mm_srai_epi16(_mm_slli_epi16(h, 8), 8);
+    _mm_storel_epi64(static_cast<__m128i*>(p), _mm_packs_epi16(h, h));
+  }
+
+  // In-lane 4x4 transpose, elements 0-3 in the low lane and 4-7 in the high lane
+  static void transpose4(reg& r0, reg& r1, reg& r2, reg& r3) noexcept {
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+
+  // Elements k and k + 4 of a stream with `stride` floats per element
+  static reg load_pair(const float* p, size_t stride) noexcept {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 4 * stride), 1);
+  }
+
+  static void store_pair(float* p, reg v, size_t stride) noexcept {
+    _mm_storeu_ps(p, _mm256_castps256_ps128(v));
+    _mm_storeu_ps(p + 4 * stride, _mm256_extractf128_ps(v, 1));
+  }
+
+  static void load_xyzw(const float* p, reg& x, reg& y, reg& z, reg& w, size_t stride = 4) noexcept {
+    x = load_pair(p + 0 * stride, stride);
+    y = load_pair(p + 1 * stride, stride);
+    z = load_pair(p + 2 * stride, stride);
+    w = load_pair(p + 3 * stride, stride);
+    transpose4(x, y, z, w);
+  }
+
+  static void store_xyzw(float* p, reg x, reg y, reg z, reg w, size_t stride = 4) noexcept {
+    transpose4(x, y, z, w);
+    store_pair(p + 0 * stride, x, stride);
+    store_pair(p + 1 * stride, y, stride);
+    store_pair(p + 2 * stride, z, stride);
+    store_pair(p + 3 * stride, w, stride);
+  }
+
+  // Same in-lane pattern as sse::load_xyz, points 0-3 in the low lane and 4-7 in the high lane
+  static void load_xyz(const float* p, reg& x, reg& y, reg& z) noexcept {
+    __m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 0)), _mm_loadu_ps(p + 12), 1);
+    __m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+    __m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+    __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+    __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+    x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+  }
+
+  template <bool Stream>
+  static void store_xyz(float* p, reg x, reg y, reg z) noexcept {
+    __m256 xy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+    __m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+    __m256 m03 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 m14 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    __m256 m25 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+    __m256 o0 = _mm256_permute2f128_ps(m03, m14, 0x20);
+    __m256 o1 = _mm256_permute2f128_ps(m25, m03, 0x30);
+    __m256 o2 = _mm256_permute2f128_ps(m14, m25, 0x31);
+    if constexpr (Stream) {
+      _mm256_stream_ps(p + 0, o0);
+      _mm256_stream_ps(p + 8, o1);
+      _mm256_stream_ps(p + 16, o2);
+    } else {
+      _mm256_storeu_ps(p + 0, o0);
+      _mm256_storeu_ps(p + 8, o1);
+      _mm256_storeu_ps(p + 16, o2);
+    }
+  }
+};
+
+#endif
+
+#ifdef __AVX512F__
+
+struct avx512 {
+  using reg = __m512;
+  static constexpr size_t width = 16;
+  static constexpr size_t align = 64;
+
+  static reg set1(float v) noexcept { return _mm512_set1_ps(v); }
+  static reg zero() noexcept { return _mm512_setzero_ps(); }
+  static reg load(const float* p) noexcept { return _mm512_loadu_ps(p); }
+  static reg load_aligned(const float* p) noexcept { return _mm512_load_ps(p); }
+  static void store(float* p, reg v) noexcept { _mm512_storeu_ps(p, v); }
+  static void stream(float* p, reg v) noexcept { _mm512_stream_ps(p, v); }
+
+  static reg add(reg a, reg b) noexcept { return _mm512_add_ps(a, b); }
+  static reg sub(reg a, reg b) noexcept { return _mm512_sub_ps(a, b); }
+  static reg mul(reg a, reg b) noexcept { return _mm512_mul_ps(a, b); }
+  static reg div(reg a, reg b) noexcept { return _mm512_div_ps(a, b); }
+  static reg min(reg a, reg b) noexcept { return _mm512_min_ps(a, b); }
+  static reg max(reg a, reg b) noexcept { return _mm512_max_ps(a, b); }
+  static reg sqrt(reg a) noexcept { return _mm512_sqrt_ps(a); }
+  static reg madd(reg a, reg b, reg c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+
+  static reg broadcast4(const float* p) noexcept { return _mm512_broadcast_f32x4(_mm_loadu_ps(p)); }
+
+  template <int k>
+  static reg splat4(reg v) noexcept { return _mm512_permute_ps(v, _MM_SHUFFLE(k, k, k, k)); }
+
+  static reg select_gt_zero(reg cond, reg v) noexcept {
+    return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(cond, _mm512_setzero_ps(), _CMP_GT_OQ), v);
+  }
+
+  static reg xor_sign(reg v, reg s) noexcept {
+    __m512i sign = _mm512_and_si512(_mm512_castps_si512(s), _mm512_set1_epi32(static_cast<int>(0x80000000u)));
+    return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(v), sign));
+  }
+
+  static unsigned mask_lt(reg a, reg b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+
+  using mask = __mmask16;
+  using ireg = __m512i;
+
+  static reg abs(reg v) noexcept { return _mm512_abs_ps(v); }
+  static mask lt(reg a, reg b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+  static mask eq(reg a, reg b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+  static mask unordered(reg a, reg b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_UNORD_Q); }
+  static reg select(mask m, reg a, reg b) noexcept { return _mm512_mask_blend_ps(m, b, a); }
+
+  static ireg to_int(reg v) noexcept { return _mm512_cvtps_epi32(v); }
+  static ireg truncate(reg v) noexcept { return _mm512_cvttps_epi32(v); }
+  static reg to_float(ireg v) noexcept { return _mm512_cvtepi32_ps(v); }
+  static ireg iset1(int32_t v) noexcept { return _mm512_set1_epi32(v); }
+  static ireg iand(ireg a, ireg b) noexcept { return _mm512_and_si512(a, b); }
+  static ireg ior(ireg a, ireg b) noexcept { return _mm512_or_si512(a, b); }
+  static ireg iadd(ireg a, ireg b) noexcept { return _mm512_add_epi32(a, b); }
+  static ireg ixor(ireg a, ireg b) noexcept { return _mm512_xor_si512(a, b); }
+  static ireg iandnot(ireg a, ireg b) noexcept { return _mm512_andnot_si512(a, b); }  // ~a & b
+
+  template <int n>
+  static ireg shl(ireg v) noexcept { return _mm512_slli_epi32(v, n); }
+
+  template <int n>
+  static ireg shr(ireg v) noexcept { return _mm512_srli_epi32(v, n); }
+
+  template <int n>
+  static ireg sra(ireg v) noexcept { return _mm512_srai_epi32(v, n); }
+
+  // Zero-extends the 32-bit lanes to 64 bits, lo taking the first half
+  static void widen(ireg v, ireg& lo, ireg& hi) noexcept {
+    lo = _mm512_cvtepu32_epi64(_mm512_castsi512_si256(v));
+    hi = _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(v, 1));
+  }
+
+  // 64-bit lanes, for keys built from widened values
+  static ireg qset1(uint64_t v) noexcept { return _mm512_set1_epi64(int64_t(v)); }
+
+  template <int n>
+  static ireg qshl(ireg v) noexcept { return _mm512_slli_epi64(v, n); }
+
+  static void qstore(uint64_t* p, ireg v) noexcept { _mm512_storeu_si512(p, v); }
+
+  static ireg iload(const uint32_t* p) noexcept { return _mm512_loadu_si512(p); }
+  static void istore(uint32_t* p, ireg v) noexcept { _mm512_storeu_si512(p, v); }
+
+  static ireg load_u16(const uint16_t* p) noexcept {
+    return _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+  }
+
+  static ireg load_i16(const int16_t* p) noexcept {
+    return _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+  }
+
+  static ireg load_i8(const int8_t* p) noexcept {
+    return _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+
+  static void store_16(void* p, ireg v) noexcept {
+    _mm256_storeu_si256(static_cast<__m256i*>(p), _mm512_cvtepi32_epi16(v));
+  }
+
+  static void store_8(void* p, ireg v) noexcept { _mm_storeu_si128(static_cast<__m128i*>(p), _mm512_cvtepi32_epi8(v)); }
+
+  static void transpose4(reg& r0, reg& r1, reg& r2, reg& r3) noexcept {
+    __m512 t0 = _mm512_unpacklo_ps(r0, r1);
+    __m512 t1 = _mm512_unpackhi_ps(r0, r1);
+    __m512 t2 = _mm512_unpacklo_ps(r2, r3);
+    __m512 t3 = _mm512_unpackhi_ps(r2, r3);
+    r0 = _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+
+  // Elements k, k + 4, k + 8, k + 12 of a stream with `stride` floats per element, one per 128-bit lane
+  static reg load_quad(const float* p, size_t stride) noexcept {
+    __m512 r = _mm512_castps128_ps512(_mm_loadu_ps(p));
+    r = _mm512_insertf32x4(r, _mm_loadu_ps(p + 4 * stride), 1);
+    r = _mm512_insertf32x4(r, _mm_loadu_ps(p + 8 * stride), 2);
+    return _mm512_insertf32x4(r, _mm_loadu_ps(p + 12 * stride), 3);
+  }
+
+  static void store_quad(float* p, reg v, size_t stride) noexcept {
+    _mm_storeu_ps(p, _mm512_castps512_ps128(v));
+    _mm_storeu_ps(p + 4 * stride, _mm512_extractf32x4_ps(v, 1));
+    _mm_storeu_ps(p + 8 * stride, _mm512_extractf32x4_ps(v, 2));
+    _mm_storeu_ps(p + 12 * stride, _mm512_extractf32x4_ps(v, 3));
+  }
+
+  static void load_xyzw(const float* p, reg& x, reg& y, reg& z, reg& w, size_t stride = 4) noexcept {
+    x = load_quad(p + 0 * stride, stride);
+    y = load_quad(p + 1 * stride, stride);
+    z = load_quad(p + 2 * stride, stride);
+    w = load_quad(p + 3 * stride, stride);
+    transpose4(x, y, z, w);
+  }
+
+  static void store_xyzw(float* p, reg x, reg y, reg z, reg w, size_t stride = 4) noexcept {
+    transpose4(x, y, z, w);
+    store_quad(p + 0 * stride, x, stride);
+    store_quad(p + 1 * stride, y, stride);
+    store_quad(p + 2 * stride, z, stride);
+    store_quad(p + 3 * stride, w, stride);
+  }
+
+  struct index { alignas(64) int32_t i[16]; };
+
+  // Two-step vpermt2ps indices picking component c of 16 packed float3 out of three registers
+  static constexpr index gather_first(int c) noexcept {
+    index r{};
+    for (int i = 0; i < 16; ++i) r.i[i] = 3 * i + c < 32 ? 3 * i + c : 0;
+    return r;
+  }
+
+  static constexpr index gather_second(int c) noexcept {
+    index r{};
+    for (int i = 0; i < 16; ++i) r.i[i] = 3 * i + c < 32 ? i : 16 + 3 * i + c - 32;
+    return r;
+  }
+
+  // Inverse: output register k of the packed stream from x, y (first step) and z (second step)
+  static constexpr index scatter_first(int k) noexcept {
+    index r{};
+    for (int j = 0; j < 16; ++j) {
+      int g = 16 * k + j;
+      r.i[j] = g % 3 == 1 ? 16 + g / 3 : g / 3;
+    }
+    return r;
+  }
+
+  static constexpr index scatter_second(int k) noexcept {
+    index r{};
+    for (int j = 0; j < 16; ++j) {
+      int g = 16 * k + j;
+      r.i[j] = g % 3 == 2 ? 16 + g / 3 : j;
+    }
+    return r;
+  }
+
+  static __m512i load_index(const index& idx) noexcept { return _mm512_load_si512(idx.i); }
+
+  static reg pick(reg a, reg b, reg c, const index& first, const index& second) noexcept {
+    return _mm512_permutex2var_ps(_mm512_permutex2var_ps(a, load_index(first), b), load_index(second), c);
+  }
+
+  static void load_xyz(const float* p, reg& x, reg& y, reg& z) noexcept {
+    static constexpr index fx = gather_first(0), sx = gather_second(0);
+    static constexpr index fy = gather_first(1), sy = gather_second(1);
+    static constexpr index fz = gather_first(2), sz = gather_second(2);
+    __m512 l0 = _mm512_loadu_ps(p + 0);
+    __m512 l1 = _mm512_loadu_ps(p + 16);
+    __m512 l2 = _mm512_loadu_ps(p + 32);
+    x = pick(l0, l1, l2, fx, sx);
+    y = pick(l0, l1, l2, fy, sy);
+    z = pick(l0, l1, l2, fz, sz);
+  }
+
+  template <bool Stream>
+  static void store_xyz(float* p, reg x, reg y, reg z) noexcept {
+    static constexpr index f0 = scatter_first(0), s0 = scatter_second(0);
+    static constexpr index f1 = scatter_first(1), s1 = scatter_second(1);
+    static constexpr index f2 = scatter_first(2), s2 = scatter_second(2);
+    __m512 o0 = pick(x, y, z, f0, s0);
+    __m512 o1 = pick(x, y, z, f1, s1);
+    __m512 o2 = pick(x, y, z, f2, s2);
+    if constexpr (Stream) {
+      _mm512_stream_ps(p + 0, o0);
+      _mm512_stream_ps(p + 16, o1);
+      _mm512_stream_ps(p + 32, o2);
+    } else {
+      _mm512_storeu_ps(p + 0, o0);
+      _mm512_storeu_ps(p + 16, o1);
+      _mm512_storeu_ps(p + 32, o2);
+    }
+  }
+};
+
+#endif
+
+#if defined(__AVX512F__)
+using native = avx512;
+#elif defined(__AVX2__)
+using native = avx2;
+#elif defined(__SSE__)
+using native = sse;
+#endif
+
+} // namespace CG_MATH_LANES_NAMESPACE
+} // namespace cgmath::lanes
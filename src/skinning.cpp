@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "skinning.h"
+#include "parallel.h"
+
+namespace cgmath {
+
+namespace {
+
+// Splits [0, n) across up to thread_count threads of the default scheduler
+template <typename F>
+void split_range(size_t n, size_t thread_count, F&& f) {
+  if (thread_count <= 1) {
+    f(size_t(0), n);
+    return;
+  }
+  parallel_options o;
+  o.thread_count = thread_count;
+  parallel_for(0, n, f, o);
+}
+
+inline void write(float3_soa_view out, size_t i, const float3& v) noexcept {
+  out.x[i] = v.x;
+  out.y[i] = v.y;
+  out.z[i] = v.z;
+}
+
+} // namespace
+
+void skin_linear(const skin_input& in, const matrix3x4* palette, skin_output out, size_t begin, size_t end) noexcept {
+  const bool normals = in.normals.size != 0 && out.normals.size != 0;
+  for (size_t i = begin; i < end; ++i) {
+    const uint16_t* joint = in.joints + i * SKIN_MAX_INFLUENCES;
+    const float* weight = in.weights + i * SKIN_MAX_INFLUENCES;
+#ifdef __SSE__
+    // Blend the three rows of every influence, then transform position and normal together
+    __m128 r0 = _mm_setzero_ps(), r1 = _mm_setzero_ps(), r2 = _mm_setzero_ps();
+    for (size_t k = 0; k < SKIN_MAX_INFLUENCES; ++k) {
+      const float* m = palette[joint[k]].m[0];
+      __m128 w = _mm_set1_ps(weight[k]);
+      r0 = simd::madd(w, _mm_loadu_ps(m + 0), r0);
+      r1 = simd::madd(w, _mm_loadu_ps(m + 4), r1);
+      r2 = simd::madd(w, _mm_loadu_ps(m + 8), r2);
+    }
+    const __m128 r3 = _mm_setzero_ps();
+    alignas(16) float p[4];
+    _mm_store_ps(p, simd::mat4_transform(r0, r1, r2, r3,
+                                         _mm_setr_ps(in.positions.x[i], in.positions.y[i], in.positions.z[i], 1.0f)));
+    write(out.positions, i, float3(p[0], p[1], p[2]));
+    if (normals) {
+      __m128 n = simd::mat4_transform(r0, r1, r2, r3, _mm_setr_ps(in.normals.x[i], in.normals.y[i], in.normals.z[i], 0.0f));
+      _mm_store_ps(p, simd::normalize(n, simd::dot3(n, n)));
+      write(out.normals, i, float3(p[0], p[1], p[2]));
+    }
+#else
+    matrix3x4 b = palette[joint[0]] * weight[0];
+    for (size_t k = 1; k < SKIN_MAX_INFLUENCES; ++k) b = b + palette[joint[k]] * weight[k];
+    float3 p(in.positions.x[i], in.positions.y[i], in.positions.z[i]);
+    write(out.positions, i, float3(
+      b._m._11 * p.x + b._m._12 * p.y + b._m._13 * p.z + b._m._14,
+      b._m._21 * p.x + b._m._22 * p.y + b._m._23 * p.z + b._m._24,
+      b._m._31 * p.x + b._m._32 * p.y + b._m._33 * p.z + b._m._34));
+    if (normals) {
+      float3 n(in.normals.x[i], in.normals.y[i], in.normals.z[i]);
+      write(out.normals, i, float3(
+        b._m._11 * n.x + b._m._12 * n.y + b._m._13 * n.z,
+        b._m._21 * n.x + b._m._22 * n.y + b._m._23 * n.z,
+        b._m._31 * n.x + b._m._32 * n.y + b._m._33 * n.z).normalized());
+    }
+#endif
+  }
+}
+
+void skin_dual_quaternion(const skin_input& in, const dual_quaternion* palette, skin_output out,
+                          size_t begin, size_t end) noexcept {
+  const bool normals = in.normals.size != 0 && out.normals.size != 0;
+  for (size_t i = begin; i < end; ++i) {
+    const uint16_t* joint = in.joints + i * SKIN_MAX_INFLUENCES;
+    const float* weight = in.weights + i * SKIN_MAX_INFLUENCES;
+
+    // Influences on the far hemisphere of the first one are negated to blend along the short arc
+    const quaternion& pivot = palette[joint[0]].real;
+    dual_quaternion b = palette[joint[0]] * weight[0];
+    for (size_t k = 1; k < SKIN_MAX_INFLUENCES; ++k) {
+      const dual_quaternion& q = palette[joint[k]];
+      b = b + q * (pivot.dot(q.real) < 0.0f ? -weight[k] : weight[k]);
+    }
+    b = b.normalized();
+
+    float3 t = b.translation();
+    vector3 p = b.real.rotate(vector3(in.positions.x[i], in.positions.y[i], in.positions.z[i])) + vector3(t.x, t.y, t.z);
+    write(out.positions, i, float3(p.vec.x, p.vec.y, p.vec.z));
+    if (normals) {
+      vector3 n = b.real.rotate(vector3(in.normals.x[i], in.normals.y[i], in.normals.z[i]));
+      write(out.normals, i, float3(n.vec.x, n.vec.y, n.vec.z));
+    }
+  }
+}
+
+void skin_linear(const skin_input& in, const matrix3x4* palette, skin_output out, size_t thread_count) noexcept {
+  split_range(in.positions.size, thread_count, [&](size_t begin, size_t end) {
+    skin_linear(in, palette, out, begin, end);
+  });
+}
+
+void skin_dual_quaternion(const skin_input& in, const dual_quaternion* palette, skin_output out,
+                          size_t thread_count) noexcept {
+  split_range(in.positions.size, thread_count, [&](size_t begin, size_t end) {
+    skin_dual_quaternion(in, palette, out, begin, end);
+  });
+}
+
+void to_dual_quaternions(const matrix3x4* palette, dual_quaternion* out, size_t n) noexcept {
+  for (size_t i = 0; i < n; ++i) out[i] = dual_quaternion::from_matrix(palette[i]);
+}
+
+} // namespace cgmath
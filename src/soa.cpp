@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "soa.h"
+#include "kernels.h"
+
+#include <array>
+
+namespace cgmath {
+
+namespace {
+
+// Kernels take N component pointers; every SIMD step is purely vertical.
+template <size_t N> using in_streams = std::array<const float*, N>;
+template <size_t N> using out_streams = std::array<float*, N>;
+
+inline in_streams<3> streams(const_float3_soa_view v) noexcept { return {v.x, v.y, v.z}; }
+inline in_streams<4> streams(const_float4_soa_view v) noexcept { return {v.x, v.y, v.z, v.w}; }
+inline out_streams<3> streams(float3_soa_view v) noexcept { return {v.x, v.y, v.z}; }
+inline out_streams<4> streams(float4_soa_view v) noexcept { return {v.x, v.y, v.z, v.w}; }
+
+template <size_t N>
+void dot_n(in_streams<N> a, in_streams<N> b, float* out, size_t n) noexcept {
+  size_t i = kernels().dot(a.data(), b.data(), N, n, out);
+  for (; i < n; ++i) {
+    float acc = a[0][i] * b[0][i];
+    for (size_t c = 1; c < N; ++c) acc += a[c][i] * b[c][i];
+    out[i] = acc;
+  }
+}
+
+template <size_t N>
+void length_n(in_streams<N> a, float* out, size_t n) noexcept {
+  size_t i = kernels().length(a.data(), N, n, out);
+  for (; i < n; ++i) {
+    float acc = a[0][i] * a[0][i];
+    for (size_t c = 1; c < N; ++c) acc += a[c][i] * a[c][i];
+    out[i] = std::sqrt(acc);
+  }
+}
+
+template <size_t N>
+void normalize_n(in_streams<N> a, out_streams<N> out, size_t n) noexcept {
+  size_t i = kernels().normalize(a.data(), N, n, out.data());
+  for (; i < n; ++i) {
+    float len2 = 0.0f;
+    for (size_t c = 0; c < N; ++c) len2 += a[c][i] * a[c][i];
+    float len = std::sqrt(len2);
+    for (size_t c = 0; c < N; ++c) out[c][i] = len2 > 0.0f ? a[c][i] / len : 0.0f;
+  }
+}
+
+template <size_t N>
+void lerp_n(in_streams<N> a, in_streams<N> b, float t, out_streams<N> out, size_t n) noexcept {
+  size_t i = kernels().lerp(a.data(), b.data(), t, N, n, out.data());
+  for (; i < n; ++i) {
+    for (size_t c = 0; c < N; ++c) out[c][i] = a[c][i] + t * (b[c][i] - a[c][i]);
+  }
+}
+
+template <size_t N>
+void clamp_n(in_streams<N> a, const float* lo, const float* hi, out_streams<N> out, size_t n) noexcept {
+  size_t i = kernels().clamp(a.data(), lo, hi, N, n, out.data());
+  for (; i < n; ++i) {
+    for (size_t c = 0; c < N; ++c) out[c][i] = std::fmax(lo[c], std::fmin(a[c][i], hi[c]));
+  }
+}
+
+} // namespace
+
+void aos_to_soa(const float3* in, size_t n, float3_soa_view out) noexcept {
+  size_t i = kernels().aos_to_soa(reinterpret_cast<const float*>(in), 3, n, streams(out).data(), 3);
+  for (; i < n; ++i) {
+    out.x[i] = in[i].x;
+    out.y[i] = in[i].y;
+    out.z[i] = in[i].z;
+  }
+}
+
+void aos_to_soa(const vector3* in, size_t n, float3_soa_view out) noexcept {
+  size_t i = kernels().aos_to_soa(reinterpret_cast<const float*>(in), 4, n, streams(out).data(), 3);
+  for (; i < n; ++i) {
+    out.x[i] = in[i].vec.x;
+    out.y[i] = in[i].vec.y;
+    out.z[i] = in[i].vec.z;
+  }
+}
+
+void aos_to_soa(const float4* in, size_t n, float4_soa_view out) noexcept {
+  size_t i = kernels().aos_to_soa(reinterpret_cast<const float*>(in), 4, n, streams(out).data(), 4);
+  for (; i < n; ++i) {
+    out.x[i] = in[i].x;
+    out.y[i] = in[i].y;
+    out.z[i] = in[i].z;
+    out.w[i] = in[i].w;
+  }
+}
+
+void aos_to_soa(const vector4* in, size_t n, float4_soa_view out) noexcept {
+  static_assert(sizeof(vector4) == sizeof(float4), "vector4 and float4 share the packed layout");
+  aos_to_soa(reinterpret_cast<const float4*>(in), n, out);
+}
+
+void soa_to_aos(const_float3_soa_view in, float3* out) noexcept {
+  const size_t n = in.size;
+  size_t i = kernels().soa_to_aos(streams(in).data(), 3, n, reinterpret_cast<float*>(out), 3);
+  for (; i < n; ++i) out[i] = float3(in.x[i], in.y[i], in.z[i]);
+}
+
+void soa_to_aos(const_float3_soa_view in, vector3* out) noexcept {
+  const size_t n = in.size;
+  size_t i = kernels().soa_to_aos(streams(in).data(), 3, n, reinterpret_cast<float*>(out), 4);
+  for (; i < n; ++i) out[i] = vector3(in.x[i], in.y[i], in.z[i]);
+}
+
+void soa_to_aos(const_float4_soa_view in, float4* out) noexcept {
+  const size_t n = in.size;
+  size_t i = kernels().soa_to_aos(streams(in).data(), 4, n, reinterpret_cast<float*>(out), 4);
+  for (; i < n; ++i) out[i] = float4(in.x[i], in.y[i], in.z[i], in.w[i]);
+}
+
+void soa_to_aos(const_float4_soa_view in, vector4* out) noexcept {
+  soa_to_aos(in, reinterpret_cast<float4*>(out));
+}
+
+void dot(const_float3_soa_view a, const_float3_soa_view b, float* out) noexcept { dot_n<3>(streams(a), streams(b), out, a.size); }
+void dot(const_float4_soa_view a, const_float4_soa_view b, float* out) noexcept { dot_n<4>(streams(a), streams(b), out, a.size); }
+
+void cross(const_float3_soa_view a, const_float3_soa_view b, float3_soa_view out) noexcept {
+  const size_t n = a.size;
+  size_t i = kernels().cross(streams(a).data(), streams(b).data(), n, streams(out).data());
+  for (; i < n; ++i) {
+    float3 r = float3(a.x[i], a.y[i], a.z[i]).cross(float3(b.x[i], b.y[i], b.z[i]));
+    out.x[i] = r.x;
+    out.y[i] = r.y;
+    out.z[i] = r.z;
+  }
+}
+
+void length(const_float3_soa_view a, float* out) noexcept { length_n<3>(streams(a), out, a.size); }
+void length(const_float4_soa_view a, float* out) noexcept { length_n<4>(streams(a), out, a.size); }
+
+void normalize(const_float3_soa_view a, float3_soa_view out) noexcept { normalize_n<3>(streams(a), streams(out), a.size); }
+void normalize(const_float4_soa_view a, float4_soa_view out) noexcept { normalize_n<4>(streams(a), streams(out), a.size); }
+
+void lerp(const_float3_soa_view a, const_float3_soa_view b, float t, float3_soa_view out) noexcept {
+  lerp_n<3>(streams(a), streams(b), t, streams(out), a.size);
+}
+
+void lerp(const_float4_soa_view a, const_float4_soa_view b, float t, float4_soa_view out) noexcept {
+  lerp_n<4>(streams(a), streams(b), t, streams(out), a.size);
+}
+
+void clamp(const_float3_soa_view a, const float3& min, const float3& max, float3_soa_view out) noexcept {
+  const float lo[3] = {min.x, min.y, min.z}, hi[3] = {max.x, max.y, max.z};
+  clamp_n<3>(streams(a), lo, hi, streams(out), a.size);
+}
+
+void clamp(const_float4_soa_view a, const float4& min, const float4& max, float4_soa_view out) noexcept {
+  const float lo[4] = {min.x, min.y, min.z, min.w}, hi[4] = {max.x, max.y, max.z, max.w};
+  clamp_n<4>(streams(a), lo, hi, streams(out), a.size);
+}
+
+} // namespace cgmath
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "spatial_hash.h"
+#include "parallel.h"
+
+namespace cgmath {
+
+namespace {
+
+// Points below which another build thread costs more than it saves
+constexpr size_t BUILD_GRAIN = size_t(1) << 15;
+
+// The sort first splits the points into this many slices of the table by the top bucket bits
+constexpr size_t SLICE_COUNT = 256;
+
+// One loop index per task, the chunks do not need to be cache lines apart
+parallel_options task_options(size_t thread_count) noexcept {
+  parallel_options o;
+  o.thread_count = thread_count;
+  o.grain = 1;
+  o.element_size = 0;
+  return o;
+}
+
+// Splits [0, n) into thread_count contiguous ranges and calls f(t, begin, end) for range t
+// in parallel. The ranges only depend on n and thread_count.
+template <typename F>
+void split_chunks(size_t n, size_t thread_count, F&& f) {
+  const size_t chunk = (n + thread_count - 1) / thread_count;
+  parallel_for(0, thread_count, [&](size_t first, size_t last) {
+    for (size_t t = first; t < last; ++t) f(t, std::min(t * chunk, n), std::min(t * chunk + chunk, n));
+  }, task_options(thread_count));
+}
+
+} // namespace
+
+void spatial_hash::build(const float3* points, size_t n, float size, size_t thread_count) {
+  cell_size = size;
+  inv_cell_size = 1.0f / size;
+  size_t buckets = SLICE_COUNT;
+  int slice_shift = 0;
+  while (buckets < n) {
+    buckets <<= 1;
+    ++slice_shift;
+  }
+  bucket_mask = static_cast<uint32_t>(buckets - 1);
+  cell_start.assign(buckets + 1, 0);
+  indices.resize(n);
+  positions.resize(n);
+  if (n == 0) return;
+
+  if (thread_count == 0) thread_count = default_scheduler().concurrency();
+  thread_count = std::max<size_t>(1, std::min(thread_count, n / BUILD_GRAIN));
+
+  // Bucket of every point, kept in indices until the last pass overwrites them, and per range
+  // histograms of the slices: counts[t * SLICE_COUNT + slice]
+  std::vector<size_t> counts(thread_count * SLICE_COUNT);
+  split_chunks(n, thread_count, [&](size_t t, size_t begin, size_t end) {
+    size_t* c = counts.data() + t * SLICE_COUNT;
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t b = bucket(cell(points[i]));
+      indices[i] = b;
+      ++c[b >> slice_shift];
+    }
+  });
+
+  // Slice-major, range-minor prefix sum keeps the source order within each slice
+  size_t slices[SLICE_COUNT + 1];
+  size_t sum = 0;
+  for (size_t s = 0; s < SLICE_COUNT; ++s) {
+    slices[s] = sum;
+    for (size_t t = 0; t < thread_count; ++t) {
+      const size_t c = counts[t * SLICE_COUNT + s];
+      counts[t * SLICE_COUNT + s] = sum;
+      sum += c;
+    }
+  }
+  slices[SLICE_COUNT] = n;
+
+  // Points move to their slice together with bucket and index, so the second pass reads a
+  // slice that fits in cache instead of gathering from all of points
+  scratch_buckets.resize(n);
+  scratch_indices.resize(n);
+  scratch_positions.resize(n);
+  split_chunks(n, thread_count, [&](size_t t, size_t begin, size_t end) {
+    size_t* offsets = counts.data() + t * SLICE_COUNT;
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t b = indices[i];
+      const size_t j = offsets[b >> slice_shift]++;
+      scratch_buckets[j] = b;
+      scratch_indices[j] = static_cast<uint32_t>(i);
+      scratch_positions[j] = points[i];
+    }
+  });
+
+  // Each slice owns buckets [s << slice_shift, (s + 1) << slice_shift) of cell_start and is
+  // counting-sorted on its own; threads steal slices from each other
+  parallel_for(0, SLICE_COUNT, [&](size_t first, size_t last) {
+    for (size_t s = first; s < last; ++s) {
+      const size_t begin = slices[s], end = slices[s + 1];
+      uint32_t* start = cell_start.data() + (s << slice_shift);
+      const size_t width = size_t(1) << slice_shift;
+      for (size_t j = begin; j < end; ++j) ++start[scratch_buckets[j] & (width - 1)];
+      uint32_t offset = static_cast<uint32_t>(begin);
+      for (size_t b = 0; b < width; ++b) {
+        const uint32_t c = start[b];
+        start[b] = offset;
+        offset += c;
+      }
+      for (size_t j = begin; j < end; ++j) {
+        const uint32_t e = start[scratch_buckets[j] & (width - 1)]++;
+        indices[e] = scratch_indices[j];
+        positions[e] = scratch_positions[j];
+      }
+      // The scatter left every start at the next bucket's start
+      for (size_t b = width - 1; b > 0; --b) start[b] = start[b - 1];
+      start[0] = static_cast<uint32_t>(begin);
+    }
+  }, task_options(thread_count));
+  cell_start[buckets] = static_cast<uint32_t>(n);
+}
+
+size_t spatial_hash::query(const float3& p, float radius, uint32_t* out, size_t capacity) const noexcept {
+  size_t count = 0;
+  for_each_within(p, radius, [&](uint32_t index, float) {
+    if (count < capacity) out[count] = index;
+    ++count;
+  });
+  return count;
+}
+
+} // namespace cgmath
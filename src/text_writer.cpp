@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "text_writer.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace cgmath {
+
+namespace {
+
+constexpr size_t BLOCK_ELEMENTS = 16384;
+
+struct layout {
+  const float* data;
+  size_t count;
+  size_t components;
+  size_t stride;
+  text_format format;
+};
+
+// Formats elements [begin, end) into out. The JSON brackets are added by the caller.
+void format_block(const layout& l, size_t begin, size_t end, std::string& out) {
+  const size_t element_chars = l.components * (FORMAT_FLOAT_CHARS + 1) + 4;
+  out.resize((end - begin) * element_chars);
+  char* p = out.data();
+  char* last = p + out.size();
+  for (size_t i = begin; i < end; ++i) {
+    const float* e = l.data + i * l.stride;
+    if (l.format == text_format::json) {
+      if (i) *p++ = ',';
+      *p++ = '\n';
+      *p++ = '[';
+    }
+    for (size_t c = 0; c < l.components; ++c) {
+      if (c) *p++ = ',';
+      if (l.format == text_format::json && !std::isfinite(e[c])) {
+        std::memcpy(p, "null", 4);
+        p += 4;
+      } else {
+        p = std::to_chars(p, last, e[c]).ptr;
+      }
+    }
+    *p++ = l.format == text_format::json ? ']' : '\n';
+  }
+  out.resize(p - out.data());
+}
+
+// Formats super-blocks of one BLOCK_ELEMENTS block per thread with parallel_for and hands each
+// block to sink in order. Returns false as soon as the sink does.
+template <typename Sink>
+bool format_all(const layout& l, size_t thread_count, Sink&& sink) {
+  if (l.format == text_format::json && !sink("[", 1)) return false;
+
+  parallel_options options;
+  options.thread_count = thread_count;
+  options.grain = 1;
+  options.element_size = 0;
+  const size_t threads = thread_count ? thread_count : default_scheduler().concurrency();
+  std::vector<std::string> blocks(threads);
+  for (size_t base = 0; base < l.count; base += threads * BLOCK_ELEMENTS) {
+    const size_t used = std::min(threads, (l.count - base + BLOCK_ELEMENTS - 1) / BLOCK_ELEMENTS);
+    parallel_for(0, used, [&](size_t first, size_t last) {
+      for (size_t t = first; t < last; ++t) {
+        const size_t begin = base + t * BLOCK_ELEMENTS;
+        format_block(l, begin, std::min(begin + BLOCK_ELEMENTS, l.count), blocks[t]);
+      }
+    }, options);
+    for (size_t t = 0; t < used; ++t) {
+      if (!sink(blocks[t].data(), blocks[t].size())) return false;
+    }
+  }
+
+  return l.format != text_format::json || sink("\n]\n", 3);
+}
+
+} // namespace
+
+bool write_text(std::FILE* file, const float* data, size_t count, size_t components, size_t stride,
+                text_format format, size_t thread_count) {
+  return format_all(layout{data, count, components, stride, format}, thread_count, [file](const char* s, size_t n) {
+    return std::fwrite(s, 1, n, file) == n;
+  });
+}
+
+void write_text(std::string& out, const float* data, size_t count, size_t components, size_t stride,
+                text_format format, size_t thread_count) {
+  format_all(layout{data, count, components, stride, format}, thread_count, [&out](const char* s, size_t n) {
+    out.append(s, n);
+    return true;
+  });
+}
+
+} // namespace cgmath
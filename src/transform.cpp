@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "transform.h"
+#include "kernels.h"
+
+namespace cgmath {
+
+namespace {
+
+inline bool is_aligned(const void* p, size_t alignment) noexcept {
+  return (reinterpret_cast<uintptr_t>(p) & (alignment - 1)) == 0;
+}
+
+// The kernels read the three affine rows of m, which matrix3x4 and matrix4x4 lay out alike
+template <bool IsPoint, typename M>
+inline float3 transform_one(const M& m, const float3& v) noexcept {
+  return IsPoint ? m.transform_point(v) : m.transform_direction(v);
+}
+
+template <bool IsPoint, typename M>
+void transform_float3(const M& m, const float3* in, float3* out, size_t n, store_mode mode) noexcept {
+  const kernel_table& k = kernels();
+  const bool stream = mode == store_mode::non_temporal;
+  size_t i = 0;
+  if (stream) {
+    // 12-byte elements reach any 4-byte aligned boundary within align / 4 steps
+    for (; i < n && !is_aligned(out + i, k.align); ++i) out[i] = transform_one<IsPoint>(m, in[i]);
+  }
+  i += k.transform_float3(&m.m[0][0], IsPoint, stream, reinterpret_cast<const float*>(in + i), reinterpret_cast<float*>(out + i), n - i);
+  for (; i < n; ++i) out[i] = transform_one<IsPoint>(m, in[i]);
+#ifdef __SSE__
+  if (stream) _mm_sfence();
+#endif
+}
+
+template <bool IsPoint, typename M>
+void transform_soa(const M& m, const_float3_soa_view in, float3_soa_view out, store_mode mode) noexcept {
+  auto scalar = [&](size_t i) {
+    float3 r = transform_one<IsPoint>(m, float3(in.x[i], in.y[i], in.z[i]));
+    out.x[i] = r.x;
+    out.y[i] = r.y;
+    out.z[i] = r.z;
+  };
+
+  const kernel_table& k = kernels();
+  const float* const src[3] = {in.x, in.y, in.z};
+  float* const dst[3] = {out.x, out.y, out.z};
+  const bool stream = mode == store_mode::non_temporal;
+  size_t i = 0;
+  if (stream) {
+    for (; i < in.size && !is_aligned(out.x + i, k.align); ++i) scalar(i);
+    if (is_aligned(out.y + i, k.align) && is_aligned(out.z + i, k.align)) {
+      i = k.transform_soa(&m.m[0][0], IsPoint, true, src, dst, i, in.size);
+    }
+  }
+  i = k.transform_soa(&m.m[0][0], IsPoint, false, src, dst, i, in.size);
+  for (; i < in.size; ++i) scalar(i);
+#ifdef __SSE__
+  if (stream) _mm_sfence();
+#endif
+}
+
+} // namespace
+
+void transform_points(const matrix4x4& m, const float3* in, float3* out, size_t n, store_mode mode) noexcept {
+  transform_float3<true>(m, in, out, n, mode);
+}
+
+void transform_directions(const matrix4x4& m, const float3* in, float3* out, size_t n, store_mode mode) noexcept {
+  transform_float3<false>(m, in, out, n, mode);
+}
+
+void transform_points(const matrix4x4& m, const_float3_soa_view in, float3_soa_view out, store_mode mode) noexcept {
+  transform_soa<true>(m, in, out, mode);
+}
+
+void transform_directions(const matrix4x4& m, const_float3_soa_view in, float3_soa_view out, store_mode mode) noexcept {
+  transform_soa<false>(m, in, out, mode);
+}
+
+void transform_points(const matrix3x4& m, const float3* in, float3* out, size_t n, store_mode mode) noexcept {
+  transform_float3<true>(m, in, out, n, mode);
+}
+
+void transform_directions(const matrix3x4& m, const float3* in, float3* out, size_t n, store_mode mode) noexcept {
+  transform_float3<false>(m, in, out, n, mode);
+}
+
+void transform_points(const matrix3x4& m, const_float3_soa_view in, float3_soa_view out, store_mode mode) noexcept {
+  transform_soa<true>(m, in, out, mode);
+}
+
+void transform_directions(const matrix3x4& m, const_float3_soa_view in, float3_soa_view out, store_mode mode) noexcept {
+  transform_soa<false>(m, in, out, mode);
+}
+
+void transform_vectors(const matrix4x4& m, const vector4* in, vector4* out, size_t n, store_mode mode) noexcept {
+  const kernel_table& k = kernels();
+  const bool stream = mode == store_mode::non_temporal;
+  size_t i = 0;
+  if (stream) {
+    for (; i < n && !is_aligned(out + i, k.align); ++i) out[i] = m * in[i];
+  }
+  i += k.transform_vector4(&m.m[0][0], stream, reinterpret_cast<const float*>(in + i), reinterpret_cast<float*>(out + i), n - i);
+  for (; i < n; ++i) out[i] = m * in[i];
+#ifdef __SSE__
+  if (stream) _mm_sfence();
+#endif
+}
+
+} // namespace cgmath
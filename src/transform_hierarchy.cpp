@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "transform_hierarchy.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cgmath {
+
+namespace {
+
+// Subtrees up to this many nodes are recomputed by one task rather than split further
+constexpr size_t TASK_NODES = 2048;
+
+// Ranges ahead of the current one whose matrices are prefetched
+constexpr size_t PREFETCH_RANGES = 8;
+
+inline void prefetch(const void* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
+struct node_range {
+  size_t first, last;
+};
+
+// Nodes in [first, last) in order; the parent of first is up to date
+void recompute(transform_hierarchy& h, size_t first, size_t last) noexcept {
+  for (size_t i = first; i < last; ++i) {
+    const uint32_t p = h.parent[i];
+    if (p == NO_PARENT) {
+      h.world[i] = h.local[i];
+    } else {
+      h.world[i] = h.world[p] * h.local[i];
+    }
+  }
+}
+
+// Splits the sibling subtrees in [first, last), whose parents are up to date, into ranges of
+// about TASK_NODES nodes. The roots of larger subtrees are computed right away so that their
+// children can be split in turn; runs of small siblings are merged into one range.
+void plan(transform_hierarchy& h, size_t first, size_t last, std::vector<node_range>& ranges,
+          std::vector<node_range>& pending) {
+  pending.push_back({first, last});
+  while (!pending.empty()) {
+    const node_range r = pending.back();
+    pending.pop_back();
+    size_t run = r.first;
+    for (size_t c = r.first; c < r.last; c = h.subtree_end[c]) {
+      const size_t end = h.subtree_end[c];
+      if (end - c > TASK_NODES) {
+        if (run < c) ranges.push_back({run, c});
+        recompute(h, c, c + 1);
+        if (c + 1 < end) pending.push_back({c + 1, end});
+        run = end;
+      } else if (end - run > TASK_NODES) {
+        ranges.push_back({run, c});
+        run = c;
+      }
+    }
+    if (run < r.last) ranges.push_back({run, r.last});
+  }
+}
+
+// Recomputes the ranges, consecutive ones grouped into tasks of about TASK_NODES nodes so
+// that scattered small subtrees do not cost a task each
+void run_ranges(transform_hierarchy& h, const std::vector<node_range>& ranges, size_t thread_count) {
+  std::vector<size_t> tasks;
+  size_t nodes = TASK_NODES;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (nodes >= TASK_NODES) {
+      tasks.push_back(i);
+      nodes = 0;
+    }
+    nodes += ranges[i].last - ranges[i].first;
+  }
+  tasks.push_back(ranges.size());
+
+  parallel_options o;
+  o.thread_count = thread_count;
+  o.grain = 1;
+  o.element_size = 0;
+  parallel_for(0, tasks.size() - 1, [&](size_t begin, size_t end) {
+    const size_t last = tasks[end];
+    for (size_t r = tasks[begin]; r < last; ++r) {
+      // Scattered ranges miss the cache on every node, so the loads of later ones are started early
+      if (r + PREFETCH_RANGES < last) {
+        const size_t next = ranges[r + PREFETCH_RANGES].first;
+        prefetch(&h.local[next]);
+        prefetch(&h.world[next]);
+        if (h.parent[next] != NO_PARENT) prefetch(&h.world[h.parent[next]]);
+      }
+      recompute(h, ranges[r].first, ranges[r].last);
+    }
+  }, o);
+}
+
+inline size_t lowest_bit(uint64_t m) noexcept {
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward64(&i, m);
+  return i;
+#else
+  return size_t(__builtin_ctzll(m));
+#endif
+}
+
+// First flagged node at or after i, n when there is none; flags are looked at 8 at a time
+size_t next_dirty(const uint8_t* flags, size_t i, size_t n) noexcept {
+  for (; i + 8 <= n; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, flags + i, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    if (word != 0) break;
+#else
+    if (word != 0) return i + lowest_bit(word) / 8;
+#endif
+  }
+  for (; i < n; ++i) {
+    if (flags[i]) return i;
+  }
+  return n;
+}
+
+} // namespace
+
+bool transform_hierarchy::build(const uint32_t* parents, const matrix3x4* locals, size_t n) {
+  if (n >= NO_PARENT) return false;
+
+  // Children of every node in id order; the roots are the children of a virtual node n
+  std::vector<uint32_t> offsets(n + 2, 0), children(n);
+  for (size_t id = 0; id < n; ++id) {
+    const uint32_t p = parents[id];
+    if (p != NO_PARENT && p >= n) return false;
+    ++offsets[(p == NO_PARENT ? n : p) + 1];
+  }
+  for (size_t i = 1; i < n + 2; ++i) offsets[i] += offsets[i - 1];
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t id = 0; id < n; ++id) children[fill[parents[id] == NO_PARENT ? n : parents[id]]++] = uint32_t(id);
+  }
+
+  // Depth-first order, lower ids first; nodes on a cycle are never reached
+  std::vector<uint32_t> new_position(n, NO_PARENT), new_node(n), stack;
+  stack.reserve(n);
+  for (size_t c = offsets[n + 1]; c > offsets[n]; --c) stack.push_back(children[c - 1]);
+  size_t count = 0;
+  while (!stack.empty()) {
+    const uint32_t id = stack.back();
+    stack.pop_back();
+    new_position[id] = uint32_t(count);
+    new_node[count++] = id;
+    for (size_t c = offsets[id + 1]; c > offsets[id]; --c) stack.push_back(children[c - 1]);
+  }
+  if (count != n) return false;
+
+  position = std::move(new_position);
+  node = std::move(new_node);
+  parent.resize(n);
+  subtree_end.resize(n);
+  local.resize(n);
+  world.resize(n);
+  dirty.assign(n, 1);
+  const matrix3x4 identity(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    const uint32_t id = node[i];
+    parent[i] = parents[id] == NO_PARENT ? NO_PARENT : position[parents[id]];
+    subtree_end[i] = uint32_t(i + 1);
+    local[i] = locals ? locals[id] : identity;
+  }
+  for (size_t i = n; i-- > 1;) {
+    if (parent[i] != NO_PARENT) subtree_end[parent[i]] = std::max(subtree_end[parent[i]], subtree_end[i]);
+  }
+  return true;
+}
+
+size_t transform_hierarchy::update(size_t thread_count) {
+  const size_t n = size();
+  std::vector<node_range> ranges, pending;
+  size_t count = 0;
+  for (size_t i = next_dirty(dirty.data(), 0, n); i < n; i = next_dirty(dirty.data(), i, n)) {
+    // Flags inside the subtree are covered by this one
+    const size_t end = subtree_end[i];
+    if (end == i + 1) {
+      dirty[i] = 0;
+    } else {
+      std::memset(dirty.data() + i, 0, end - i);
+    }
+    count += end - i;
+    if (end - i > TASK_NODES) {
+      plan(*this, i, end, ranges, pending);
+    } else {
+      ranges.push_back({i, end});
+    }
+    i = end;
+  }
+  run_ranges(*this, ranges, thread_count);
+  return count;
+}
+
+void transform_hierarchy::update_all(size_t thread_count) {
+  std::fill(dirty.begin(), dirty.end(), uint8_t(0));
+  std::vector<node_range> ranges, pending;
+  plan(*this, 0, size(), ranges, pending);
+  run_ranges(*this, ranges, thread_count);
+}
+
+} // namespace cgmath
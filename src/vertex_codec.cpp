@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) Yakiv Matiash
+ */
+
+#include "vertex_codec.h"
+#include "kernels.h"
+
+namespace cgmath {
+
+namespace {
+
+template <typename Oct>
+void encode_octahedral(const float3* in, int bits, Oct* out, size_t n) noexcept {
+  size_t i = kernels().encode_octahedral(&in->x, bits, out, n);
+  for (; i < n; ++i) out[i] = Oct::encode(in[i]);
+}
+
+template <typename Oct>
+void decode_octahedral(const Oct* in, int bits, float3* out, size_t n) noexcept {
+  size_t i = kernels().decode_octahedral(in, bits, &out->x, n);
+  for (; i < n; ++i) out[i] = in[i].decode();
+}
+
+// The kernels take the per-component transforms of quantization_bounds as plain arrays
+template <typename Q>
+void encode_fixed3(const float3* in, const quantization_bounds& b, fixed_format format, bool is_signed, float steps,
+                   Q* out, size_t n) noexcept {
+  float3 offset, scale;
+  b.encode_transform(is_signed, steps, offset, scale);
+  size_t i = kernels().encode_fixed3(&in->x, format, &offset.x, &scale.x, out, n);
+  for (; i < n; ++i) out[i] = Q::encode(in[i], b);
+}
+
+template <typename Q>
+void decode_fixed3(const Q* in, const quantization_bounds& b, fixed_format format, bool is_signed, float steps,
+                   float3* out, size_t n) noexcept {
+  float3 offset, scale;
+  b.decode_transform(is_signed, steps, offset, scale);
+  size_t i = kernels().decode_fixed3(in, format, &offset.x, &scale.x, &out->x, n);
+  for (; i < n; ++i) out[i] = in[i].decode(b);
+}
+
+} // namespace
+
+void encode(const float3* in, oct16* out, size_t n) noexcept { encode_octahedral(in, 8, out, n); }
+void encode(const float3* in, oct24* out, size_t n) noexcept { encode_octahedral(in, 12, out, n); }
+void encode(const float3* in, oct32* out, size_t n) noexcept { encode_octahedral(in, 16, out, n); }
+void decode(const oct16* in, float3* out, size_t n) noexcept { decode_octahedral(in, 8, out, n); }
+void decode(const oct24* in, float3* out, size_t n) noexcept { decode_octahedral(in, 12, out, n); }
+void decode(const oct32* in, float3* out, size_t n) noexcept { decode_octahedral(in, 16, out, n); }
+
+void encode(const float3* in, const quantization_bounds& b, unorm16x3* out, size_t n) noexcept {
+  encode_fixed3(in, b, fixed_format::unorm16, false, 65535.0f, out, n);
+}
+
+void encode(const float3* in, const quantization_bounds& b, snorm16x3* out, size_t n) noexcept {
+  encode_fixed3(in, b, fixed_format::snorm16, true, 32767.0f, out, n);
+}
+
+void encode(const float3* in, const quantization_bounds& b, snorm8x3* out, size_t n) noexcept {
+  encode_fixed3(in, b, fixed_format::snorm8, true, 127.0f, out, n);
+}
+
+void decode(const unorm16x3* in, const quantization_bounds& b, float3* out, size_t n) noexcept {
+  decode_fixed3(in, b, fixed_format::unorm16, false, 65535.0f, out, n);
+}
+
+void decode(const snorm16x3* in, const quantization_bounds& b, float3* out, size_t n) noexcept {
+  decode_fixed3(in, b, fixed_format::snorm16, true, 32767.0f, out, n);
+}
+
+void decode(const snorm8x3* in, const quantization_bounds& b, float3* out, size_t n) noexcept {
+  decode_fixed3(in, b, fixed_format::snorm8, true, 127.0f, out, n);
+}
+
+void encode(const quaternion* in, packed_quaternion* out, size_t n) noexcept {
+  size_t i = kernels().encode_quaternions(&in->v.vec.x, &out->bits, n);
+  for (; i < n; ++i) out[i] = packed_quaternion::encode(in[i]);
+}
+
+void decode(const packed_quaternion* in, quaternion* out, size_t n) noexcept {
+  size_t i = kernels().decode_quaternions(&in->bits, &out->v.vec.x, n);
+  for (; i < n; ++i) out[i] = in[i].decode();
+}
+
+void encode(const float4* in, rgb10a2* out, size_t n) noexcept {
+  size_t i = kernels().encode_rgb10a2(&in->x, &out->bits, n);
+  for (; i < n; ++i) out[i] = rgb10a2::encode(in[i]);
+}
+
+void decode(const rgb10a2* in, float4* out, size_t n) noexcept {
+  size_t i = kernels().decode_rgb10a2(&in->bits, &out->x, n);
+  for (; i < n; ++i) out[i] = in[i].decode();
+}
+
+} // namespace cgmath